@@ -80,6 +80,9 @@ public:
 			glm::scale(_trans._sca);	// And the scale
 	}
 
+	// Locates the actor's uniforms in 'shader_program', called again when a reload relinks it
+	inline virtual void GetUniforms(unsigned int shader_program) {}
+
 	// Set virtual functions for deriving classes
 	inline virtual void Update(double& delta) = 0;
 	inline virtual void Render() = 0;
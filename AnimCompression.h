@@ -0,0 +1,174 @@
+#ifndef __ANIM_COMPRESSION_H__
+#define __ANIM_COMPRESSION_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <cmath>	// Get sqrt / acos
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get min / max
+#include <glm/glm.hpp>	// Get glm variables
+#include "SkmFormat.h"	// Get the packed key layout
+#include "AnimRuntime.h"	// Interpolate exactly like the sampler
+
+#define ANIM_COMPRESSION_ERROR	0.0005f		// Largest error a bone may add, as a fraction of the skeleton's size
+#define ANIM_COMPRESSION_LEVER	0.1f	// Shortest lever arm assumed for rotations, as a fraction of the skeleton's size
+
+// The cooker side of clip compression. Imported keys are quantised to the packed layout in SkmFormat.h, then keys
+// that linear interpolation (slerp for rotations) can rebuild from their neighbours are dropped. Each bone gets its
+// own tolerance from the skeleton: translations may move a joint by ANIM_COMPRESSION_ERROR of the skeleton's size,
+// rotations and scales may move the bone's farthest descendant by the same distance, so a finger keeps fewer keys
+// than a hip. The checks run on the decoded keys, so the bound includes the quantisation
+namespace AnimCompression
+{
+	// The imported keys of one animated node
+	struct Track
+	{
+		std::vector<Skm::Vec3Key>	positions;	// Translation keys
+		std::vector<Skm::QuatKey>	rotations;	// Rotation keys
+		std::vector<Skm::Vec3Key>	scalings;	// Scale keys
+	};
+
+	// What compression saved
+	struct Stats
+	{
+		size_t		source_keys;	// Keys imported
+		size_t		packed_keys;	// Keys kept
+		size_t		source_bytes;	// Their full precision size
+		size_t		packed_bytes;	// Their packed size
+	};
+
+	// Returns the bind pose distance from each node to its farthest descendant
+	inline std::vector<float> Reach(const std::vector<Skm::Node> &nodes)
+	{
+		std::vector<glm::vec3> origins(nodes.size());	// Bind pose origin of each node
+		std::vector<glm::mat4> globals(nodes.size());	// Bind pose transform of each node
+		for (size_t i = 0; i < nodes.size(); i++)	// Parents come first...
+		{
+			globals[i] = nodes[i].parent == SKM_NO_PARENT ? nodes[i].local.ToGlm() : AnimRuntime::MulAffine(globals[nodes[i].parent], nodes[i].local.ToGlm());
+			origins[i] = glm::vec3(globals[i][3].x, globals[i][3].y, globals[i][3].z);
+		}
+
+		std::vector<float> reach(nodes.size(), 0.0f);	// The result
+		for (size_t i = 0; i < nodes.size(); i++)	// For each node, widen the reach of its ancestors
+			for (int32_t a = nodes[i].parent; a != SKM_NO_PARENT; a = nodes[a].parent)
+				reach[a] = std::max(reach[a], glm::length(origins[i] - origins[a]));
+		return reach;	// Return it
+	}
+
+	// Quantises and reduces a translation / scale track. 'relative' measures the error against the value's size
+	inline void CompressVec3(const std::vector<Skm::Vec3Key> &keys, float duration, float tolerance, bool relative,
+		std::vector<Skm::PackedKey> &out, uint32_t &first, uint32_t &count, float min[3], float step[3])
+	{
+		for (int c = 0; c < 3; c++)		// Find the channel's range
+		{
+			float lo = keys.empty() ? 0.0f : keys[0].value[c], hi = lo;
+			for (const Skm::Vec3Key &k : keys)
+			{
+				lo = std::min(lo, k.value[c]);
+				hi = std::max(hi, k.value[c]);
+			}
+			min[c] = lo;
+			step[c] = (hi - lo) / 65535.0f;
+		}
+
+		uint32_t n = (uint32_t)keys.size();		// The key count
+		std::vector<Skm::PackedKey> packed(n);	// Every key quantised
+		std::vector<glm::vec3> decoded(n);	// ... and decoded again
+		for (uint32_t k = 0; k < n; k++)
+		{
+			packed[k].time = Skm::EncodeTime(keys[k].time, duration);
+			for (int c = 0; c < 3; c++)
+			{
+				packed[k].value[c] = Skm::EncodeRange(keys[k].value[c], min[c], step[c]);
+				decoded[k][c] = min[c] + packed[k].value[c] * step[c];
+			}
+		}
+
+		std::vector<uint32_t> keep = AnimRuntime::Reduce(n, tolerance, [&](uint32_t a, uint32_t e, uint32_t k)
+		{
+			float f = AnimRuntime::KeyFactor(packed[k].time, packed[a].time, packed[e].time);	// Where k falls between them
+			glm::vec3 source(keys[k].value[0], keys[k].value[1], keys[k].value[2]);
+			float err = glm::length(decoded[a] + (decoded[e] - decoded[a]) * f - source);
+			return relative ? err / std::max(glm::length(source), 1.0f) : err;
+		});
+
+		first = (uint32_t)out.size();	// Store the kept keys
+		count = (uint32_t)keep.size();
+		for (uint32_t k : keep)
+			out.push_back(packed[k]);
+	}
+
+	// Quantises and reduces a rotation track, the tolerance is an angle in radians
+	inline void CompressQuat(const std::vector<Skm::QuatKey> &keys, float duration, float tolerance,
+		std::vector<Skm::PackedKey> &out, uint32_t &first, uint32_t &count)
+	{
+		uint32_t n = (uint32_t)keys.size();		// The key count
+		std::vector<Skm::PackedKey> packed(n);	// Every key quantised
+		std::vector<glm::quat> decoded(n);	// ... and decoded again
+		for (uint32_t k = 0; k < n; k++)
+		{
+			float q[4], length = 0.0f;	// The key, normalised first
+			for (int c = 0; c < 4; c++)
+				length += keys[k].value[c] * keys[k].value[c];
+			for (int c = 0; c < 4; c++)
+				q[c] = keys[k].value[c] / std::sqrt(std::max(length, 1e-12f));
+			packed[k].time = Skm::EncodeTime(keys[k].time, duration);
+			Skm::EncodeQuat(q, packed[k].value);
+			Skm::DecodeQuat(packed[k].value, q);
+			decoded[k] = glm::quat(q[0], q[1], q[2], q[3]);
+		}
+
+		std::vector<uint32_t> keep = AnimRuntime::Reduce(n, tolerance, [&](uint32_t a, uint32_t e, uint32_t k)
+		{
+			float f = AnimRuntime::KeyFactor(packed[k].time, packed[a].time, packed[e].time);	// Where k falls between them
+			glm::quat r = AnimRuntime::Slerp(decoded[a], decoded[e], f);
+			const float* s = keys[k].value;
+			float d = std::fabs(r.w * s[0] + r.x * s[1] + r.y * s[2] + r.z * s[3]) /
+				std::sqrt(std::max(s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3], 1e-12f));
+			return 2.0f * std::acos(std::min(d, 1.0f));		// The angle between them
+		});
+
+		first = (uint32_t)out.size();	// Store the kept keys
+		count = (uint32_t)keep.size();
+		for (uint32_t k : keep)
+			out.push_back(packed[k]);
+	}
+
+	// Compresses one track per channel into 'out' (whose nodes must already be flattened), returns the savings
+	inline Stats Compress(const std::vector<Track> &tracks, Skm::Data &out, float error = ANIM_COMPRESSION_ERROR)
+	{
+		std::vector<float> reach = Reach(out.nodes);	// Lever arm of every node
+		float size = 0.0f;	// The skeleton's size
+		for (size_t i = 0; i < out.nodes.size(); i++)
+			if (out.nodes[i].parent == SKM_NO_PARENT)
+				size = std::max(size, reach[i]);
+		size = size > 0.0f ? size : 1.0f;
+		float tolerance = error * size;		// How far a bone may move a joint
+
+		Stats stats = { 0, 0, 0, 0 };	// The savings
+		out.channels.assign(tracks.size(), Skm::Channel());
+		out.position_keys.clear();
+		out.rotation_keys.clear();
+		out.scaling_keys.clear();
+		for (size_t i = 0; i < out.nodes.size(); i++)	// For each animated node...
+		{
+			if (out.nodes[i].channel == SKM_NO_CHANNEL)
+				continue;
+
+			const Track &track = tracks[out.nodes[i].channel];	// Its keys
+			Skm::Channel &ch = out.channels[out.nodes[i].channel];	// Its packed channel
+			float lever = std::max(reach[i], ANIM_COMPRESSION_LEVER * size);	// How far its rotation / scale carries
+			CompressVec3(track.positions, out.duration, tolerance, false, out.position_keys, ch.first_position, ch.num_positions, ch.position_min, ch.position_step);
+			CompressQuat(track.rotations, out.duration, tolerance / lever, out.rotation_keys, ch.first_rotation, ch.num_rotations);
+			CompressVec3(track.scalings, out.duration, tolerance / lever, true, out.scaling_keys, ch.first_scaling, ch.num_scalings, ch.scaling_min, ch.scaling_step);
+
+			stats.source_keys += track.positions.size() + track.rotations.size() + track.scalings.size();
+			stats.source_bytes += (track.positions.size() + track.scalings.size()) * sizeof(Skm::Vec3Key) + track.rotations.size() * sizeof(Skm::QuatKey);
+		}
+
+		stats.packed_keys = out.position_keys.size() + out.rotation_keys.size() + out.scaling_keys.size();
+		stats.packed_bytes = stats.packed_keys * sizeof(Skm::PackedKey);
+		return stats;	// Return the savings
+	}
+}
+
+#endif
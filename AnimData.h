@@ -4,13 +4,21 @@
 #include "Joint.h"	// Include the joint struct
 #include "JointAnim.h"	// Include joint anim data
 
+#define JOINT_NONE	0xFFFFFFFF	// Joint id for hierarchy nodes that no vertex is skinned to
+
 // The main anim data struct
 struct AnimData
 {
-	Joint	_root_joint;	// The root joint of heriarchy
+	Joint						_root_joint;	// The root joint of heriarchy
+	glm::mat4x4					_bind_shape_matrix;		// Transforms the mesh into the skeleton's bind space
+	std::vector<std::string>	_joint_names;	// Joint names in skin order (the joint id is the index)
+	std::vector<glm::mat4x4>	_inverse_bind_matrices;		// Inverse bind matrix for each joint id
+	std::vector<glm::ivec3>		_joint_ids;		// The joints affecting each output vertex
+	std::vector<glm::vec3>		_weights;	// The normalised weights matching _joint_ids
+	std::vector<JointAnim>		_joint_anims;	// The animation channels, one per animated joint
 
 	// Default constructor
-	inline AnimData() {}
+	inline AnimData() : _bind_shape_matrix(1.0f) {}
 };
 
 #endif
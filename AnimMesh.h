@@ -3,18 +3,17 @@
 
 #include "Mesh.h"	// Derive from
 #include "SkinnedMesh.h"
-#include "Timer.h"
+#include "AnimSystem.h"
 
 class AnimMesh : public Mesh
 {
 private:
-	GLuint    _loc_bones[100];
-	
-	Timer* _timer;
+	BonePalette::Uniform	_u_bones;	// The gBones array, resolved once
 
 	unsigned int prog;
 
 	SkinnedMesh	_riggedMesh;
+	uint32_t	_anim;	// This mesh's handle in the animation update
 public:
 	inline AnimMesh(unsigned int shader_program, std::string name, const std::string& filename)
 	{
@@ -22,6 +21,7 @@ public:
 	}
 	inline ~AnimMesh() 
 	{
+		AnimSystem::Remove(_anim);
 		_riggedMesh.Clear();
 	}
 
@@ -33,19 +33,30 @@ public:
 		//SetMaterials();
 		UpdateModel();
 
-		_timer = new Timer(1.0f);
-
 		_vis = true;
 
-		_u_mod = glGetUniformLocation(shader_program, "mod");	// Get our model matrix uniform
-		_u_rig = glGetUniformLocation(shader_program, "isRigged");
+		GetUniforms(shader_program);	// Locate our uniforms
 
 		_riggedMesh.LoadAnimatedMesh(filename);
+		_anim = AnimSystem::Add(&_riggedMesh.GetSkeleton());	// Posed with every other character in AnimSystem::Update
 	}
 
+	// Locates the model, rig and palette uniforms (again after the shader is relinked)
+	inline virtual void GetUniforms(unsigned int shader_program)
+	{
+		prog = shader_program;
+		_u_mod = glGetUniformLocation(shader_program, "mod");	// Get our model matrix uniform
+		_u_rig = glGetUniformLocation(shader_program, "isRigged");
+		_u_bones.Resolve(shader_program);	// Find the palette array
+	}
+
+	// Shares this mesh's pose with others playing the clip within 'quantum' seconds of it (crowds), 0 stops
+	inline void SetPoseSharing(float quantum, float phase = 0.0f) { AnimSystem::SetSharing(_anim, quantum, phase); }
+
 	// Virtual functions
 	inline virtual void Update(double &delta)
 	{
+		AnimSystem::SetPosition(_anim, _trans._pos);	// Its level of detail follows the distance to the camera
 	}
 	inline virtual void Render()
 	{
@@ -56,11 +67,7 @@ public:
 		glUniform1i(_u_rig, true);	// Bind our selected uniform data
 		glUniformMatrix4fv(_u_mod, 1, GL_FALSE, glm::value_ptr(_trans._mod));	// Bind our uniform data
 		
-		std::vector<glm::mat4> _bone_transforms;
-		_riggedMesh.BoneTransform(_timer->seconds(), _bone_transforms);
-
-		for (unsigned int i = 0; i < _bone_transforms.size(); i++)
-			glUniformMatrix4fv(glGetUniformLocation(prog, ("gBones[" + std::to_string(i) + "]").c_str()), 1, GL_FALSE, glm::value_ptr(_bone_transforms[i]));
+		_u_bones.Upload(AnimSystem::GetPackedPalette(_anim), _riggedMesh.GetSkeleton().NumPaletteSlots());	// One call for the whole palette
 
 		Content::_materials[0]->Bind();
 
@@ -0,0 +1,546 @@
+#ifndef __ANIM_RUNTIME_H__
+#define __ANIM_RUNTIME_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <cmath>	// Get fmod / acos / sin
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get min / max
+#include <iostream>		// Get cout
+#include <glm/glm.hpp>	// Get glm variables
+#include <glm/gtx/quaternion.hpp>	// Get quaternions
+#include "SkmFormat.h"	// Get the cooked skeleton and keys
+
+#define ANIM_MAX_CURSOR_STEPS	4	// Keys a cursor walks forward before it falls back to a binary search
+#define ANIM_LOD_COARSE			2	// The level of detail from which simplified curves are sampled and leaf bones freeze
+#define ANIM_LOD_ERROR			0.01f	// Error the simplified curves may add per bone, as a fraction of the skeleton's size
+#define ANIM_LOD_LEVER			0.1f	// Shortest lever arm assumed for rotations, as a fraction of the skeleton's size
+#define ANIM_LOD_LEAF_HEIGHT	2	// Bones fewer than this many levels above a leaf freeze at coarse detail
+
+// The compiled animation runtime. A Skeleton is built once from a cooked .skm: a flat bone array in parent-first
+// order with every channel's key ranges resolved, the bind pose of unanimated subtrees baked and the global
+// inverse folded into the roots. Each animated character owns an Instance holding its keyframe cursors and
+// output buffers, so evaluating a pose is one forward loop with no lookups, no strings and no allocation.
+// Cursors remember the key each channel sampled last time; as time moves forward they step at most a key or two,
+// making sampling amortised O(1) (a loop or a backwards jump falls back to a binary search). Evaluation runs in two
+// steps, so batches of characters can be split across threads: Sample writes the animated bones' local pose as
+// separate translation / rotation / scale arrays, Compose walks the hierarchy into model space and the palette.
+// Distant characters can be evaluated at a coarser level of detail: from ANIM_LOD_COARSE the sampler reads
+// simplified copies of the curves built at compile time and leaves the bones nearest the leaves at their last pose
+namespace AnimRuntime
+{
+	// A range of keys inside one of the key sections
+	struct KeyRange
+	{
+		uint32_t	first;	// First key
+		uint32_t	count;	// Number of keys (0 if the node isn't animated)
+	};
+
+	// A node of the compiled skeleton
+	struct Bone
+	{
+		int32_t		parent;		// Parent index (always lower than this bone's) or SKM_NO_PARENT
+		int32_t		bone;	// Palette slot or SKM_NO_BONE
+		KeyRange	position;	// Translation keys
+		KeyRange	rotation;	// Rotation keys
+		KeyRange	scaling;	// Scale keys
+		uint32_t	animated;	// Whether the keys drive this bone (all three tracks must have keys)
+		uint32_t	fixed;	// Whether neither this bone nor any ancestor is animated, so its global transform is baked
+		uint32_t	slot;	// Index into the local pose and cursors if animated
+		uint32_t	height;		// Levels below this bone (0 for a leaf)
+		KeyRange	coarse_position;	// Simplified translation keys
+		KeyRange	coarse_rotation;	// Simplified rotation keys
+		KeyRange	coarse_scaling;		// Simplified scale keys
+		glm::vec3	position_min;	// Translation dequantisation: min + value * step
+		glm::vec3	position_step;
+		glm::vec3	scaling_min;	// Scale dequantisation: min + value * step
+		glm::vec3	scaling_step;
+	};
+
+	// Where each track of one bone sampled last
+	struct Cursor
+	{
+		uint32_t	position;	// Translation key
+		uint32_t	rotation;	// Rotation key
+		uint32_t	scaling;	// Scale key
+	};
+
+	// Returns the key at or before 'time' in keys[lo, hi] by binary search, clamped so the next key always exists
+	template <typename Key>
+	inline uint32_t FindKey(float time, const Key* keys, uint32_t lo, uint32_t hi)
+	{
+		while (hi - lo > 1)		// While the range holds more than one interval...
+		{
+			uint32_t mid = (lo + hi) / 2;	// Split it
+			if (time < keys[mid].time)
+				hi = mid;
+			else
+				lo = mid;
+		}
+		return lo;	// Return the key
+	}
+
+	// Moves a cursor to the key at or before 'time' (count must be at least 2). Playing forward it only steps over
+	// the keys that passed since the last sample, otherwise it searches the keys that are left
+	template <typename Key>
+	inline uint32_t Seek(float time, const Key* keys, uint32_t count, uint32_t &cursor)
+	{
+		uint32_t last = count - 2;	// The last key that has a next key
+		if (cursor > last || time < keys[cursor].time)	// If time went backwards (a loop or a scrub)...
+			return cursor = FindKey(time, keys, 0, count - 1);	// Search all of them
+
+		for (unsigned int step = 0; step < ANIM_MAX_CURSOR_STEPS; step++)	// Step forward a few keys...
+		{
+			if (cursor == last || time < keys[cursor + 1].time)		// If the next key is still ahead...
+				return cursor;	// Return the cursor
+			cursor++;
+		}
+		return cursor = FindKey(time, keys, cursor, count - 1);		// A big jump, search the rest
+	}
+
+	// Picks the keys of a track to keep. Segments grow greedily from the last kept key while error(a, e, k) stays
+	// within the tolerance for every key k they skip. A track that its first key reproduces everywhere collapses to it
+	template <typename Error>
+	inline std::vector<uint32_t> Reduce(uint32_t count, float tolerance, Error error)
+	{
+		std::vector<uint32_t> keep;		// The kept keys
+		if (count == 0)		// If the track is empty...
+			return keep;	// Return nothing
+
+		bool constant = true;	// Whether one key will do
+		for (uint32_t k = 1; constant && k < count; k++)
+			constant = error(0, 0, k) <= tolerance;
+		keep.push_back(0);
+		if (constant)	// If it never moves...
+			return keep;	// Return the first key
+
+		uint32_t a = 0;		// The segment start
+		while (a + 1 < count)	// Until the last key is kept...
+		{
+			uint32_t e = a + 1;		// The segment end
+			while (e + 1 < count)	// Try one key further
+			{
+				bool fits = true;
+				for (uint32_t k = a + 1; fits && k <= e; k++)	// Every skipped key must still be reproduced
+					fits = error(a, e + 1, k) <= tolerance;
+				if (!fits)
+					break;
+				e++;
+			}
+			keep.push_back(e);
+			a = e;
+		}
+		return keep;	// Return the kept keys
+	}
+
+	// Returns the interpolation factor between two keys, clamped to [0, 1]
+	inline float KeyFactor(float time, float start, float end)
+	{
+		float delta = end - start;	// The interval
+		float factor = delta > 0.0f ? (time - start) / delta : 0.0f;	// How far through it we are
+		return factor < 0.0f ? 0.0f : (factor > 1.0f ? 1.0f : factor);
+	}
+
+	// Spherical interpolation along the shortest arc, nlerp when the rotations are nearly equal
+	inline glm::quat Slerp(const glm::quat &a, const glm::quat &b, float t)
+	{
+		float cos_theta = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z;	// The angle between them
+		float sign = cos_theta < 0.0f ? -1.0f : 1.0f;	// Flip b onto a's hemisphere
+		cos_theta *= sign;
+
+		float wa = 1.0f - t, wb = t;	// The weights
+		if (cos_theta < 0.9995f)	// If they're far enough apart for the division to be stable...
+		{
+			float theta = std::acos(cos_theta), inv_sin = 1.0f / std::sin(theta);
+			wa = std::sin(wa * theta) * inv_sin;
+			wb = std::sin(wb * theta) * inv_sin;
+		}
+		wb *= sign;
+
+		glm::quat r(wa * a.w + wb * b.w, wa * a.x + wb * b.x, wa * a.y + wb * b.y, wa * a.z + wb * b.z);	// Blend them
+		float inv_length = 1.0f / std::sqrt(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);	// Renormalise
+		return glm::quat(r.w * inv_length, r.x * inv_length, r.y * inv_length, r.z * inv_length);
+	}
+
+	// Samples a packed translation / scale track through its cursor ('time' is in key units, see Skm::EncodeTime)
+	inline glm::vec3 SampleVec3(float time, const Skm::PackedKey* keys, uint32_t count, uint32_t &cursor, const glm::vec3 &min, const glm::vec3 &step)
+	{
+		const uint16_t* s = keys[0].value;	// The first key
+		if (count == 1)		// If it's constant...
+			return glm::vec3(min.x + s[0] * step.x, min.y + s[1] * step.y, min.z + s[2] * step.z);
+
+		uint32_t i = Seek(time, keys, count, cursor);	// The key before
+		float t = KeyFactor(time, keys[i].time, keys[i + 1].time);
+		s = keys[i].value;
+		const uint16_t* e = keys[i + 1].value;
+		float q[3];		// Interpolate the quantised values, then scale once
+		for (int c = 0; c < 3; c++)
+			q[c] = s[c] + ((float)e[c] - (float)s[c]) * t;
+		return glm::vec3(min.x + q[0] * step.x, min.y + q[1] * step.y, min.z + q[2] * step.z);
+	}
+
+	// Samples a packed rotation track through its cursor ('time' is in key units)
+	inline glm::quat SampleQuat(float time, const Skm::PackedKey* keys, uint32_t count, uint32_t &cursor)
+	{
+		float s[4], e[4];	// The keys either side (w, x, y, z)
+		if (count == 1)		// If it's constant...
+		{
+			Skm::DecodeQuat(keys[0].value, s);
+			return glm::quat(s[0], s[1], s[2], s[3]);
+		}
+
+		uint32_t i = Seek(time, keys, count, cursor);	// The key before
+		float t = KeyFactor(time, keys[i].time, keys[i + 1].time);
+		Skm::DecodeQuat(keys[i].value, s);
+		Skm::DecodeQuat(keys[i + 1].value, e);
+		return Slerp(glm::quat(s[0], s[1], s[2], s[3]), glm::quat(e[0], e[1], e[2], e[3]), t);
+	}
+
+	// Builds translate(t) * rotate(q) * scale(s) directly
+	inline glm::mat4 Compose(const glm::vec3 &t, const glm::quat &q, const glm::vec3 &s)
+	{
+		float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		glm::mat4 m;	// The result
+		m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy + wz) * s.x, 2.0f * (xz - wy) * s.x, 0.0f);
+		m[1] = glm::vec4(2.0f * (xy - wz) * s.y, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz + wx) * s.y, 0.0f);
+		m[2] = glm::vec4(2.0f * (xz + wy) * s.z, 2.0f * (yz - wx) * s.z, (1.0f - 2.0f * (xx + yy)) * s.z, 0.0f);
+		m[3] = glm::vec4(t.x, t.y, t.z, 1.0f);
+		return m;	// Return it
+	}
+
+	// Multiplies two affine matrices (the bottom rows are known to be 0, 0, 0, 1)
+	inline glm::mat4 MulAffine(const glm::mat4 &a, const glm::mat4 &b)
+	{
+		glm::mat4 r;	// The result
+		for (int c = 0; c < 4; c++)		// For each column of b...
+		{
+			const glm::vec4 &v = b[c];
+			r[c] = a[0] * v.x + a[1] * v.y + a[2] * v.z;
+			r[c].w = 0.0f;
+		}
+		r[3] += a[3];	// Add the translation
+		r[3].w = 1.0f;
+		return r;	// Return it
+	}
+
+	class Skeleton;
+
+	// The per character state: keyframe cursors and the output buffers, sized once when first evaluated
+	class Instance
+	{
+	private:
+		friend class Skeleton;
+
+		const Skeleton*			_skeleton;	// The skeleton the buffers were sized for
+		std::vector<Cursor>		_cursors;	// One per animated bone
+		std::vector<glm::vec3>	_translations;	// Local pose of the animated bones...
+		std::vector<glm::quat>	_rotations;
+		std::vector<glm::vec3>	_scales;
+		std::vector<glm::mat4>	_globals;	// Model space transform per bone
+		std::vector<glm::mat4>	_palette;	// Skinning matrix per palette slot (unless evaluated into a caller's buffer)
+		bool					_complete;	// Whether every bone has been sampled since the buffers were sized
+
+	public:
+		inline Instance() : _skeleton(NULL), _complete(false) {}
+
+		inline const std::vector<glm::mat4>& GetPalette() const { return _palette; }	// Return the skinning matrices
+		inline const glm::vec3* GetTranslations() const { return _translations.data(); }	// Return the local pose...
+		inline const glm::quat* GetRotations() const { return _rotations.data(); }
+		inline const glm::vec3* GetScales() const { return _scales.data(); }
+		inline const std::vector<glm::mat4>& GetGlobals() const { return _globals; }	// Return the model space transforms
+
+		// Rewinds the cursors (the next sample searches once)
+		inline void Reset()
+		{
+			for (Cursor &c : _cursors)
+				c = Cursor{ 0, 0, 0 };
+		}
+	};
+
+	// A skeleton compiled from a cooked mesh. The keys are read in place, so the view's data must outlive it
+	class Skeleton
+	{
+	private:
+		std::vector<Bone>		_bones;		// Parent-first hierarchy
+		std::vector<uint32_t>	_animated;	// Bone index per local pose slot
+		std::vector<glm::mat4>	_locals;	// Bind pose transform per bone, relative to its parent
+		std::vector<glm::mat4>	_fixed;		// Baked global transform of the fixed bones (global inverse included)
+		std::vector<glm::mat4>	_offsets;	// Inverse bind pose per palette slot
+		std::vector<Skm::PackedKey>	_coarse_keys;	// The simplified curves of every track
+		const Skm::PackedKey*	_position_keys;		// All translation keys
+		const Skm::PackedKey*	_rotation_keys;		// All rotation keys
+		const Skm::PackedKey*	_scaling_keys;	// All scale keys
+		float					_ticks_per_second;	// Animation clock rate
+		float					_duration;	// Animation length in ticks
+		float					_key_scale;		// Ticks to key time units
+
+	public:
+		inline Skeleton() : _position_keys(NULL), _rotation_keys(NULL), _scaling_keys(NULL), _ticks_per_second(25.0f), _duration(0.0f), _key_scale(0.0f) {}
+
+		inline uint32_t NumBones() const { return (uint32_t)_bones.size(); }	// Return the node count
+		inline uint32_t NumPaletteSlots() const { return (uint32_t)_offsets.size(); }	// Return the skinned bone count
+		inline uint32_t NumAnimated() const { return (uint32_t)_animated.size(); }	// Return the local pose size
+		inline const Bone* Bones() const { return _bones.data(); }	// Return the hierarchy
+		inline float GetDuration() const { return _duration; }	// Return the length in ticks
+		inline float GetTicksPerSecond() const { return _ticks_per_second; }	// Return the clock rate
+
+		// Resolves every node of a validated view into the flat runtime form
+		inline bool Compile(const Skm::View &skm)
+		{
+			Clear();	// Forget the last skeleton
+			if (!skm.IsValid())		// If there's nothing to compile...
+			{
+				std::cout << "Anim Error: Can't compile a skeleton from an invalid mesh!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+
+			const Skm::Header &header = skm.GetHeader();	// The header
+			uint32_t num_nodes = skm.Count(Skm::SECTION_NODES);		// The node count
+			glm::mat4 global_inverse = header.global_inverse.ToGlm();	// Folded into the roots
+
+			_bones.resize(num_nodes);
+			_locals.resize(num_nodes);
+			_fixed.resize(num_nodes);
+			for (uint32_t i = 0; i < num_nodes; i++)	// For each node...
+			{
+				const Skm::Node &node = skm.Nodes()[i];		// The cooked node
+				Bone &b = _bones[i];	// The compiled bone
+				b.parent = node.parent;
+				b.bone = node.bone;
+				b.position = b.rotation = b.scaling = KeyRange{ 0, 0 };
+				b.position_min = b.position_step = b.scaling_min = b.scaling_step = glm::vec3(0.0f);
+
+				if (node.channel != SKM_NO_CHANNEL)		// If it has keys...
+				{
+					const Skm::Channel &ch = skm.Channels()[node.channel];
+					b.position = KeyRange{ ch.first_position, ch.num_positions };
+					b.rotation = KeyRange{ ch.first_rotation, ch.num_rotations };
+					b.scaling = KeyRange{ ch.first_scaling, ch.num_scalings };
+					b.position_min = glm::vec3(ch.position_min[0], ch.position_min[1], ch.position_min[2]);
+					b.position_step = glm::vec3(ch.position_step[0], ch.position_step[1], ch.position_step[2]);
+					b.scaling_min = glm::vec3(ch.scaling_min[0], ch.scaling_min[1], ch.scaling_min[2]);
+					b.scaling_step = glm::vec3(ch.scaling_step[0], ch.scaling_step[1], ch.scaling_step[2]);
+				}
+				b.animated = b.position.count && b.rotation.count && b.scaling.count;	// A partial channel keeps the bind pose, as before
+				b.fixed = !b.animated && (b.parent == SKM_NO_PARENT || _bones[b.parent].fixed);
+				b.slot = b.animated ? (uint32_t)_animated.size() : 0;
+				if (b.animated)		// If it has keys, give it a local pose slot
+					_animated.push_back(i);
+
+				_locals[i] = node.local.ToGlm();
+				if (b.fixed)	// If nothing above it moves, bake its global transform now
+					_fixed[i] = b.parent == SKM_NO_PARENT ? global_inverse * _locals[i] : MulAffine(_fixed[b.parent], _locals[i]);
+				if (b.parent == SKM_NO_PARENT && !b.fixed)	// Fold the global inverse into animated roots
+					_locals[i] = global_inverse;
+			}
+
+			_offsets.resize(header.num_bones);
+			for (uint32_t i = 0; i < header.num_bones; i++)		// For each palette slot...
+				_offsets[i] = skm.BoneOffsets()[i].ToGlm();
+
+			_position_keys = skm.PositionKeys();	// Bind the key sections
+			_rotation_keys = skm.RotationKeys();
+			_scaling_keys = skm.ScalingKeys();
+			_ticks_per_second = header.ticks_per_second;
+			_duration = header.duration;
+			_key_scale = _duration > 0.0f ? SKM_KEY_TIME_STEPS / _duration : 0.0f;
+
+			Simplify(skm);	// Build the coarse level of detail
+			return true;	// Return success
+		}
+
+		// Measures the hierarchy (heights and bind pose reach) and builds simplified copies of every track, so
+		// each bone may move its farthest descendant by ANIM_LOD_ERROR of the skeleton's size
+		inline void Simplify(const Skm::View &skm)
+		{
+			uint32_t num_nodes = (uint32_t)_bones.size();	// The node count
+			std::vector<glm::mat4> bind(num_nodes);		// Bind pose globals
+			std::vector<float> reach(num_nodes, 0.0f);	// Distance to the farthest descendant
+			for (uint32_t i = 0; i < num_nodes; i++)
+			{
+				glm::mat4 local = skm.Nodes()[i].local.ToGlm();
+				bind[i] = _bones[i].parent == SKM_NO_PARENT ? local : MulAffine(bind[_bones[i].parent], local);
+				_bones[i].height = 0;
+			}
+			for (uint32_t i = num_nodes; i-- > 0;)	// Children come after parents, so walk backwards...
+			{
+				int32_t p = _bones[i].parent;
+				if (p != SKM_NO_PARENT)
+					_bones[p].height = std::max(_bones[p].height, _bones[i].height + 1);
+				for (; p != SKM_NO_PARENT; p = _bones[p].parent)	// Widen every ancestor's reach
+				{
+					glm::vec4 d = bind[i][3] - bind[p][3];
+					reach[p] = std::max(reach[p], std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z));
+				}
+			}
+
+			float size = 0.0f;	// The skeleton's size
+			for (uint32_t i = 0; i < num_nodes; i++)
+				if (_bones[i].parent == SKM_NO_PARENT)
+					size = std::max(size, reach[i]);
+			float tolerance = ANIM_LOD_ERROR * (size > 0.0f ? size : 1.0f);	// How far a bone may move a joint
+
+			auto vec3 = [](const Skm::PackedKey &k, const glm::vec3 &min, const glm::vec3 &step)	// Decodes a translation / scale
+			{
+				return glm::vec3(min.x + k.value[0] * step.x, min.y + k.value[1] * step.y, min.z + k.value[2] * step.z);
+			};
+			auto quat = [](const Skm::PackedKey &k)		// Decodes a rotation
+			{
+				float q[4];
+				Skm::DecodeQuat(k.value, q);
+				return glm::quat(q[0], q[1], q[2], q[3]);
+			};
+			auto keep = [&](const Skm::PackedKey* keys, const std::vector<uint32_t> &kept)	// Stores the kept keys
+			{
+				KeyRange range = { (uint32_t)_coarse_keys.size(), (uint32_t)kept.size() };
+				for (uint32_t k : kept)
+					_coarse_keys.push_back(keys[k]);
+				return range;
+			};
+
+			for (uint32_t i : _animated)	// For each animated bone...
+			{
+				Bone &b = _bones[i];
+				float lever = std::max(reach[i], ANIM_LOD_LEVER * size);	// How far its rotation / scale carries
+				const Skm::PackedKey* p = _position_keys + b.position.first, *r = _rotation_keys + b.rotation.first, *s = _scaling_keys + b.scaling.first;
+
+				b.coarse_position = keep(p, Reduce(b.position.count, tolerance, [&](uint32_t a, uint32_t e, uint32_t k)
+				{
+					float f = KeyFactor(p[k].time, p[a].time, p[e].time);
+					glm::vec3 va = vec3(p[a], b.position_min, b.position_step), d = vec3(p[k], b.position_min, b.position_step) - (va + (vec3(p[e], b.position_min, b.position_step) - va) * f);
+					return std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+				}));
+				b.coarse_rotation = keep(r, Reduce(b.rotation.count, tolerance / lever, [&](uint32_t a, uint32_t e, uint32_t k)
+				{
+					glm::quat q = Slerp(quat(r[a]), quat(r[e]), KeyFactor(r[k].time, r[a].time, r[e].time)), t = quat(r[k]);
+					float d = std::fabs(q.w * t.w + q.x * t.x + q.y * t.y + q.z * t.z);
+					return 2.0f * std::acos(std::min(d, 1.0f));
+				}));
+				b.coarse_scaling = keep(s, Reduce(b.scaling.count, tolerance / lever, [&](uint32_t a, uint32_t e, uint32_t k)
+				{
+					float f = KeyFactor(s[k].time, s[a].time, s[e].time);
+					glm::vec3 va = vec3(s[a], b.scaling_min, b.scaling_step), d = vec3(s[k], b.scaling_min, b.scaling_step) - (va + (vec3(s[e], b.scaling_min, b.scaling_step) - va) * f);
+					return std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+				}));
+			}
+		}
+
+		// Forgets the skeleton
+		inline void Clear()
+		{
+			_bones.clear();
+			_animated.clear();
+			_locals.clear();
+			_fixed.clear();
+			_offsets.clear();
+			_coarse_keys.clear();
+			_position_keys = NULL;
+			_scaling_keys = NULL;
+			_rotation_keys = NULL;
+		}
+
+		// Sizes an instance's buffers for this skeleton (the only allocation an instance makes)
+		inline void Bind(Instance &instance) const
+		{
+			instance._skeleton = this;
+			instance._cursors.assign(_animated.size(), Cursor{ 0, 0, 0 });
+			instance._translations.resize(_animated.size());
+			instance._rotations.resize(_animated.size());
+			instance._scales.resize(_animated.size());
+			instance._globals.resize(_bones.size());
+			instance._palette.assign(_offsets.size(), glm::mat4(1.0f));
+			instance._complete = false;
+			for (size_t i = 0; i < _bones.size(); i++)	// Fixed bones never change, write them once
+				if (_bones[i].fixed)
+					instance._globals[i] = _fixed[i];
+		}
+
+		// Wraps a clock in seconds into the clip, in ticks
+		inline float ClipTime(float seconds) const
+		{
+			float ticks = seconds * _ticks_per_second;	// The clock in ticks
+			float time = _duration > 0.0f ? std::fmod(ticks, _duration) : 0.0f;		// Wrapped into the clip
+			return time < 0.0f ? time + _duration : time;	// Negative times loop backwards
+		}
+
+		// Sizes the instance if it was last used with another skeleton
+		inline void Prepare(Instance &instance) const
+		{
+			if (instance._skeleton != this || instance._globals.size() != _bones.size())	// If it was sized for another skeleton...
+				Bind(instance);
+		}
+
+		// Samples the animated bones' keys at 'time' (in ticks) into the instance's local pose. From ANIM_LOD_COARSE
+		// the simplified curves are read and the bones near the leaves keep their last pose
+		inline void Sample(float time, Instance &instance, uint32_t lod = 0) const
+		{
+			time *= _key_scale;		// Compare against the packed key times directly
+			bool coarse = lod >= ANIM_LOD_COARSE;	// Whether to read the simplified curves
+			bool freeze = coarse && instance._complete;		// Leaves can only freeze once they've been sampled
+			const Skm::PackedKey* coarse_keys = _coarse_keys.data();
+			Cursor* cursors = instance._cursors.data();		// Hoist the buffers
+			glm::vec3* translations = instance._translations.data();
+			glm::quat* rotations = instance._rotations.data();
+			glm::vec3* scales = instance._scales.data();
+			const uint32_t* animated = _animated.data();
+			uint32_t num_animated = (uint32_t)_animated.size();
+
+			for (uint32_t k = 0; k < num_animated; k++)		// For each animated bone...
+			{
+				const Bone &b = _bones[animated[k]];	// The bone
+				Cursor &c = cursors[k];		// Its cursors (a switch between curves just costs a search)
+				if (!coarse)	// Full detail...
+				{
+					translations[k] = SampleVec3(time, _position_keys + b.position.first, b.position.count, c.position, b.position_min, b.position_step);
+					rotations[k] = SampleQuat(time, _rotation_keys + b.rotation.first, b.rotation.count, c.rotation);
+					scales[k] = SampleVec3(time, _scaling_keys + b.scaling.first, b.scaling.count, c.scaling, b.scaling_min, b.scaling_step);
+				}
+				else if (!freeze || b.height >= ANIM_LOD_LEAF_HEIGHT)	// Simplified curves, unless it's a frozen leaf
+				{
+					translations[k] = SampleVec3(time, coarse_keys + b.coarse_position.first, b.coarse_position.count, c.position, b.position_min, b.position_step);
+					rotations[k] = SampleQuat(time, coarse_keys + b.coarse_rotation.first, b.coarse_rotation.count, c.rotation);
+					scales[k] = SampleVec3(time, coarse_keys + b.coarse_scaling.first, b.coarse_scaling.count, c.scaling, b.scaling_min, b.scaling_step);
+				}
+			}
+			instance._complete = true;	// Every bone has a pose now
+		}
+
+		// Walks the hierarchy from the instance's local pose, writing NumPaletteSlots() matrices to 'palette'
+		inline void Compose(Instance &instance, glm::mat4* palette) const
+		{
+			const glm::vec3* translations = instance._translations.data();	// Hoist the buffers
+			const glm::quat* rotations = instance._rotations.data();
+			const glm::vec3* scales = instance._scales.data();
+			glm::mat4* globals = instance._globals.data();
+			const Bone* bones = _bones.data();
+			uint32_t num_bones = (uint32_t)_bones.size();
+
+			for (uint32_t i = 0; i < num_bones; i++)	// For each bone, parents first...
+			{
+				const Bone &b = bones[i];	// The bone
+				if (!b.fixed)	// If it can move...
+				{
+					if (!b.animated)	// If it keeps its bind pose...
+						globals[i] = MulAffine(globals[b.parent], _locals[i]);
+					else	// An animated root carries the global inverse in _locals
+						globals[i] = MulAffine(b.parent == SKM_NO_PARENT ? _locals[i] : globals[b.parent], AnimRuntime::Compose(translations[b.slot], rotations[b.slot], scales[b.slot]));
+				}
+
+				if (b.bone != SKM_NO_BONE)	// If vertices are skinned to it...
+					palette[b.bone] = MulAffine(globals[i], _offsets[b.bone]);
+			}
+		}
+
+		// Evaluates the pose at 'seconds' (looping) at a level of detail into 'palette', or the instance's own palette if it's NULL
+		inline void Evaluate(float seconds, Instance &instance, glm::mat4* palette = NULL, uint32_t lod = 0) const
+		{
+			Prepare(instance);	// Size it
+			Sample(ClipTime(seconds), instance, lod);
+			Compose(instance, palette ? palette : instance._palette.data());
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,378 @@
+#ifndef __ANIM_SYSTEM_H__
+#define __ANIM_SYSTEM_H__
+
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get sort
+#include <chrono>	// Time the update
+#include <cstring>	// Get memcpy
+#include <cmath>	// Get floor
+#include <glm/glm.hpp>	// Get glm variables
+#include <glm/gtc/quaternion.hpp>	// Extrapolate bone rotations
+#include "AnimRuntime.h"	// Get skeletons and instances
+#include "Parallel.h"	// Get the job pool
+#include "BonePalette.h"	// Pack palettes for upload
+
+#define ANIM_BATCH_GRAIN	4	// Characters per job
+#define ANIM_LOD_NEAR		15.0f	// Closer than this a character is sampled every frame at full detail
+#define ANIM_LOD_MID		40.0f	// Closer than this every second frame
+#define ANIM_LOD_FAR		100.0f	// Closer than this every fourth frame with simplified curves, beyond every eighth
+#define ANIM_FRAME_BUDGET	1.0		// Milliseconds of sampling allowed per frame (near characters always run)
+#define ANIM_COST_SMOOTHING	0.1		// How quickly the measured cost per bone follows the latest frame
+#define ANIM_MAX_MISSED		2.0f	// Sample intervals a character can wait before it's sampled over the budget
+
+// The animation update phase. Every animated character registers here once and Update() poses all of them
+// together after the game logic has run: the clocks advance, each character gets a range of one contiguous palette
+// buffer, then the job pool samples and composes the characters in grain sized batches. Characters never share
+// state, so the batches need no locks and crowds scale with the core count instead of the render thread. Each job
+// also packs its characters' palettes as 3x4 rows into a second persistent buffer, so renderers upload them with
+// one call (GetPackedPalette) and the full matrices stay available through GetPalette().
+// Characters are given a level of detail by their distance to the viewer. Near ones are sampled every frame; the
+// rest every 2, 4 or 8 frames (staggered by handle) and from ANIM_LOD_COARSE with simplified curves and frozen leaf
+// bones. Between samples a palette is extrapolated from its last two samples (rotation, scale and translation carried
+// on separately, so spinning bones don't shear). The due characters beyond the near ring are also held to a per
+// frame budget, most overdue first, priced with the measured cost per bone. The most overdue one always runs, as does
+// any that has waited ANIM_MAX_MISSED intervals, so a busy frame delays characters but never freezes them.
+// Crowd characters can share poses instead (SetSharing): each frame those playing the same skeleton at the same
+// quantised clip time (their clock plus a phase offset) form a group, one of them samples the pose and the rest
+// read its palette, so an ambient crowd costs about one evaluation per distinct pose rather than per character
+class AnimSystem
+{
+private:
+	// A registered character
+	struct Entry
+	{
+		const AnimRuntime::Skeleton*	skeleton;	// What it animates (NULL if the slot is free)
+		AnimRuntime::Instance			instance;	// Its cursors and local pose
+		glm::vec3						position;	// Where it is, for its level of detail
+		float							time;	// Its clock in seconds
+		float							speed;	// Playback rate
+		float							sample_time;	// Clock at the last sample
+		float							previous_time;	// Clock at the sample before
+		uint32_t						offset;		// First matrix in the palette buffers
+		uint32_t						lod;	// Level of detail this frame
+		uint64_t						last_frame;		// Frame of the last sample
+		uint32_t						samples;	// Samples since the layout changed (extrapolation needs two)
+		bool							sample;		// Whether it's sampled this frame
+		float							quantum;	// Pose sharing step in seconds (0 keeps its own pose)
+		float							phase;	// Added to its clock when sharing
+		float							pose_time;	// Clock the pose is sampled at this frame
+		uint32_t						source;		// Handle whose palette it shows this frame
+	};
+
+	// A sharing character's place in the pose cache
+	struct SharedKey
+	{
+		const AnimRuntime::Skeleton*	skeleton;	// What it animates
+		float							quantum;	// Its step
+		int64_t							step;	// Its quantised clip time
+		uint32_t						handle;		// Who it is
+
+		inline bool operator<(const SharedKey &o) const
+		{
+			if (skeleton != o.skeleton) return skeleton < o.skeleton;
+			if (quantum != o.quantum) return quantum < o.quantum;
+			return step != o.step ? step < o.step : handle < o.handle;
+		}
+		inline bool SamePose(const SharedKey &o) const { return skeleton == o.skeleton && quantum == o.quantum && step == o.step; }
+	};
+
+	static std::vector<Entry>		_entries;	// All characters, indexed by handle
+	static std::vector<uint32_t>	_free;	// Released handles
+	static std::vector<uint32_t>	_active;	// Handles to pose this frame
+	static std::vector<std::pair<float, uint32_t>>	_due;	// Characters due a sample beyond the near ring, by priority
+	static std::vector<SharedKey>	_shared;	// Sharing characters, sorted into poses
+	static std::vector<glm::mat4>	_sampled;	// Every character's last sampled palette, back to back
+	static std::vector<glm::mat4>	_previous;	// ... the sample before that
+	static std::vector<glm::mat4>	_palettes;	// ... and this frame's palette (sampled or extrapolated)
+	static std::vector<float>		_packed;	// This frame's palettes packed for upload (BONE_PALETTE_FLOATS each)
+	static glm::vec3				_viewer;	// Where levels of detail are measured from
+	static double					_budget;	// Milliseconds of sampling per frame
+	static double					_cost_per_bone;		// Measured milliseconds per sampled bone
+	static uint64_t					_frame;		// Frames updated
+	static bool						_layout_changed;	// Whether characters were added / removed
+	static uint32_t					_num_sampled;	// Characters sampled last frame
+	static uint32_t					_num_extrapolated;	// Characters extrapolated last frame
+	static uint32_t					_num_shared;	// Characters that reused another's pose last frame
+
+	// Returns the level of detail for a distance
+	static inline uint32_t LevelOfDetail(float distance)
+	{
+		return distance < ANIM_LOD_NEAR ? 0 : (distance < ANIM_LOD_MID ? 1 : (distance < ANIM_LOD_FAR ? 2 : 3));
+	}
+
+	// Splits a bone matrix into rotation, scale and translation, returns false if it's degenerate
+	static inline bool Decompose(const glm::mat4 &m, glm::quat &rotation, glm::vec3 &scale, glm::vec3 &translation)
+	{
+		glm::vec3 x(m[0]), y(m[1]), z(m[2]);	// The axes
+		scale = glm::vec3(glm::length(x), glm::length(y), glm::length(z));
+		if (scale.x < 1e-6f || scale.y < 1e-6f || scale.z < 1e-6f)	// If an axis collapsed...
+			return false;	// Return false as failed
+		if (glm::dot(glm::cross(x, y), z) < 0.0f)	// Mirrored bones keep a proper rotation
+			scale.x = -scale.x;
+		rotation = glm::quat_cast(glm::mat3(x / scale.x, y / scale.y, z / scale.z));
+		translation = glm::vec3(m[3]);
+		return true;	// Return success
+	}
+
+	// Extrapolates a palette from its last two samples, 't' is how many sample intervals past the last one. Rotations
+	// are carried on along the arc between the samples (an nlerp at 1 + t), scale and translation linearly; bones that
+	// can't be decomposed hold their last sample
+	static inline void Extrapolate(const glm::mat4* sampled, const glm::mat4* previous, uint32_t count, float t, glm::mat4* out)
+	{
+		for (uint32_t i = 0; i < count; i++)	// For each bone...
+		{
+			glm::quat r0, r1;	// Rotations of the two samples
+			glm::vec3 s0, s1, p0, p1;	// Scales and translations
+			if (!Decompose(previous[i], r0, s0, p0) || !Decompose(sampled[i], r1, s1, p1) || s0.x * s1.x < 0.0f)
+			{
+				out[i] = sampled[i];	// Hold it
+				continue;
+			}
+			if (glm::dot(r0, r1) < 0.0f)	// Take the short way round
+				r0 = -r0;
+			glm::mat3 r = glm::mat3_cast(glm::normalize(r1 + (r1 - r0) * t));
+			glm::vec3 s = s1 + (s1 - s0) * t;
+			out[i] = glm::mat4(glm::vec4(r[0] * s.x, 0.0f), glm::vec4(r[1] * s.y, 0.0f), glm::vec4(r[2] * s.z, 0.0f), glm::vec4(p1 + (p1 - p0) * t, 1.0f));
+		}
+	}
+
+public:
+	// Registers a character, returns its handle
+	static inline uint32_t Add(const AnimRuntime::Skeleton* skeleton, float speed = 1.0f)
+	{
+		uint32_t handle;	// The slot
+		if (!_free.empty())		// If a slot was released...
+		{
+			handle = _free.back();	// Reuse it
+			_free.pop_back();
+		}
+		else
+		{
+			handle = (uint32_t)_entries.size();		// Otherwise add one
+			_entries.push_back(Entry());
+		}
+
+		Entry &e = _entries[handle];	// The entry
+		e.skeleton = skeleton;
+		e.instance = AnimRuntime::Instance();
+		e.position = glm::vec3(0.0f);
+		e.time = e.sample_time = e.previous_time = 0.0f;
+		e.speed = speed;
+		e.offset = e.lod = e.samples = 0;
+		e.last_frame = 0;
+		e.sample = true;
+		e.quantum = e.phase = e.pose_time = 0.0f;
+		e.source = handle;
+		_layout_changed = true;		// Hand out the palette ranges again
+		return handle;	// Return the handle
+	}
+
+	// Releases a character
+	static inline void Remove(uint32_t handle)
+	{
+		if (handle >= _entries.size() || !_entries[handle].skeleton)	// If it isn't registered...
+			return;		// Return as normal
+		_entries[handle].skeleton = NULL;	// Free the slot
+		_entries[handle].instance = AnimRuntime::Instance();	// Release its buffers
+		_free.push_back(handle);
+		_layout_changed = true;		// Hand out the palette ranges again
+	}
+
+	inline static void SetTime(uint32_t handle, float seconds) { _entries[handle].time = seconds; _entries[handle].samples = 0; }	// Jump a character's clock
+	inline static void SetSpeed(uint32_t handle, float speed) { _entries[handle].speed = speed; }	// Assign a playback rate
+	inline static void SetPosition(uint32_t handle, const glm::vec3 &position) { _entries[handle].position = position; }	// Assign where a character is
+	inline static void SetSharing(uint32_t handle, float quantum, float phase = 0.0f) { _entries[handle].quantum = quantum; _entries[handle].phase = phase; }	// Share poses in steps of 'quantum' seconds (0 stops)
+	inline static void SetViewer(const glm::vec3 &position) { _viewer = position; }		// Assign where detail is measured from
+	inline static void SetBudget(double milliseconds) { _budget = milliseconds; }	// Assign the sampling budget per frame
+	inline static float GetTime(uint32_t handle) { return _entries[handle].time; }		// Return a character's clock
+	inline static uint32_t GetLevelOfDetail(uint32_t handle) { return _entries[handle].lod; }	// Return a character's detail
+	inline static uint32_t GetNumSampled() { return _num_sampled; }		// Return the characters sampled last frame
+	inline static uint32_t GetNumExtrapolated() { return _num_extrapolated; }	// Return the characters extrapolated last frame
+	inline static uint32_t GetNumShared() { return _num_shared; }	// Return the characters that reused a pose last frame
+
+	// Returns a character's skinning matrices from the last Update (NumPaletteSlots() of them)
+	static inline const glm::mat4* GetPalette(uint32_t handle)
+	{
+		const Entry &e = _entries[_entries[handle].source];		// Whoever posed it
+		return e.skeleton && e.offset + e.skeleton->NumPaletteSlots() <= _palettes.size() ? &_palettes[e.offset] : NULL;
+	}
+
+	// Returns a character's palette packed for BonePalette::Uniform::Upload
+	static inline const float* GetPackedPalette(uint32_t handle)
+	{
+		const Entry &e = _entries[_entries[handle].source];		// Whoever posed it
+		return GetPalette(handle) && (size_t)(e.offset + e.skeleton->NumPaletteSlots()) * BONE_PALETTE_FLOATS <= _packed.size() ? &_packed[(size_t)e.offset * BONE_PALETTE_FLOATS] : NULL;
+	}
+
+	// Returns the contiguous buffer every palette lives in
+	inline static const std::vector<glm::mat4>& GetPalettes() { return _palettes; }
+
+	// Advances every clock by 'delta' seconds, picks who is sampled this frame and poses all characters
+	static inline void Update(double delta)
+	{
+		_frame++;	// A new frame
+		_active.clear();	// Gather this frame's characters
+		_due.clear();
+		_shared.clear();
+		uint32_t total = 0;		// Matrices needed
+		double cost = 0.0;	// Estimated milliseconds of sampling so far
+		for (uint32_t h = 0; h < _entries.size(); h++)	// For each slot...
+		{
+			Entry &e = _entries[h];		// The entry
+			if (!e.skeleton)	// If it's free...
+				continue;
+			e.time += (float)delta * e.speed;	// Advance its clock
+			if (_layout_changed)	// If the ranges moved, the history is gone
+			{
+				e.offset = total;	// Give it a range of the buffers
+				e.samples = 0;
+			}
+			total += e.skeleton->NumPaletteSlots();
+			_active.push_back(h);
+
+			e.lod = LevelOfDetail(glm::length(e.position - _viewer));	// Its detail
+			e.source = h;
+			e.pose_time = e.time;
+			if (e.quantum > 0.0f)	// If it shares, the pose cache decides below
+			{
+				float clip = e.skeleton->ClipTime(e.time + e.phase) / std::max(e.skeleton->GetTicksPerSecond(), 1e-6f);	// Seconds into the clip
+				SharedKey key = { e.skeleton, e.quantum, (int64_t)std::floor(clip / e.quantum), h };
+				_shared.push_back(key);
+				e.sample = false;
+				continue;
+			}
+			uint64_t interval = 1ull << e.lod;	// Frames between samples
+			uint64_t waited = _frame - e.last_frame;	// Frames since the last one
+			e.sample = e.lod == 0 || e.samples < 2;		// Near or without history: always
+			if (e.sample)
+				cost += e.skeleton->NumAnimated() * _cost_per_bone;
+			else if (waited >= interval && ((_frame + h) % interval == 0 || waited >= 2 * interval))	// Due on its staggered frame, or late
+				_due.push_back(std::make_pair((float)waited / interval, h));
+		}
+		if (_layout_changed && _palettes.size() < total)	// Grow the buffers, never shrink them
+		{
+			_sampled.resize(total, glm::mat4(1.0f));
+			_previous.resize(total, glm::mat4(1.0f));
+			_palettes.resize(total, glm::mat4(1.0f));
+			_packed.resize((size_t)total * BONE_PALETTE_FLOATS, 0.0f);
+		}
+		_layout_changed = false;
+
+		std::sort(_shared.begin(), _shared.end());	// Group the sharing characters by pose
+		for (size_t i = 0, j; i < _shared.size(); i = j)	// For each pose...
+		{
+			Entry &leader = _entries[_shared[i].handle];	// The first one samples it at the step's start
+			leader.sample = true;
+			leader.pose_time = _shared[i].step * _shared[i].quantum;
+			for (j = i + 1; j < _shared.size() && _shared[j].SamePose(_shared[i]); j++)	// The rest show its palette
+			{
+				_entries[_shared[j].handle].source = _shared[i].handle;
+				leader.lod = std::min(leader.lod, _entries[_shared[j].handle].lod);		// At the detail of the nearest
+			}
+			cost += leader.skeleton->NumAnimated() * _cost_per_bone;
+		}
+
+		std::sort(_due.begin(), _due.end(), [](const std::pair<float, uint32_t> &a, const std::pair<float, uint32_t> &b) { return a.first > b.first; });	// Most overdue first
+		for (size_t i = 0; i < _due.size(); i++)	// Spend the budget...
+		{
+			Entry &e = _entries[_due[i].second];
+			double c = e.skeleton->NumAnimated() * _cost_per_bone;	// Its estimated cost
+			bool starving = i == 0 || _due[i].first >= ANIM_MAX_MISSED;		// The most overdue, and any that waited too long, always run
+			if (!starving && cost + c > _budget)	// If it doesn't fit, it waits
+				continue;
+			e.sample = true;
+			cost += c;
+		}
+
+		Entry* entries = _entries.data();	// Hoist the arrays for the jobs
+		const uint32_t* active = _active.data();
+		glm::mat4* sampled = _sampled.data();
+		glm::mat4* previous = _previous.data();
+		glm::mat4* palettes = _palettes.data();
+		float* packed = _packed.data();
+		uint64_t frame = _frame;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();		// Time the batch
+		Parallel::Jobs().For(0, _active.size(), ANIM_BATCH_GRAIN, [=](size_t from, size_t to)
+		{
+			for (size_t i = from; i < to; i++)	// For each character in the batch...
+			{
+				Entry &e = entries[active[i]];
+				if (e.source != active[i])	// If it shows another's pose...
+					continue;
+				uint32_t n = e.skeleton->NumPaletteSlots();		// Its bone count
+				if (e.sample)	// If it's sampled, keep the last sample for extrapolation
+				{
+					std::memcpy(previous + e.offset, sampled + e.offset, n * sizeof(glm::mat4));
+					e.skeleton->Evaluate(e.pose_time, e.instance, sampled + e.offset, e.lod);
+					std::memcpy(palettes + e.offset, sampled + e.offset, n * sizeof(glm::mat4));
+					e.previous_time = e.sample_time;
+					e.sample_time = e.time;
+					e.last_frame = frame;
+					e.samples++;
+				}
+				else	// Otherwise carry on from its last two samples (up to ANIM_MAX_MISSED intervals, when it's sampled regardless)
+				{
+					float span = e.sample_time - e.previous_time;	// Time between the samples
+					float last = e.skeleton->ClipTime(e.sample_time);	// Where the last sample fell in the clip
+					bool looped = e.skeleton->ClipTime(e.previous_time) > last || e.skeleton->ClipTime(e.time) < last;	// Across the loop the motion jumps, hold instead
+					float t = span > 0.0f && !looped ? std::min((e.time - e.sample_time) / span, ANIM_MAX_MISSED) : 0.0f;
+					Extrapolate(sampled + e.offset, previous + e.offset, n, t, palettes + e.offset);
+				}
+				BonePalette::Pack(palettes + e.offset, n, packed + (size_t)e.offset * BONE_PALETTE_FLOATS);
+			}
+		});
+		double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();	// Wall time
+
+		uint32_t bones = 0;		// Bones sampled
+		_num_sampled = _num_extrapolated = _num_shared = 0;
+		for (uint32_t h : _active)	// Count what ran
+		{
+			if (_entries[h].source != h)
+				_num_shared++;
+			else if (_entries[h].sample)
+			{
+				bones += _entries[h].skeleton->NumAnimated();
+				_num_sampled++;
+			}
+			else
+				_num_extrapolated++;
+		}
+		if (bones)	// Follow the measured cost so the budget tracks the machine and the core count
+			_cost_per_bone += (elapsed / bones - _cost_per_bone) * ANIM_COST_SMOOTHING;
+	}
+
+	// Releases everything
+	static inline void Destroy()
+	{
+		_entries.clear();
+		_free.clear();
+		_active.clear();
+		_due.clear();
+		_shared.clear();
+		_sampled.clear();
+		_previous.clear();
+		_palettes.clear();
+		_packed.clear();
+	}
+};
+
+// Static definitions
+std::vector<AnimSystem::Entry>	AnimSystem::_entries;
+std::vector<uint32_t>			AnimSystem::_free;
+std::vector<uint32_t>			AnimSystem::_active;
+std::vector<std::pair<float, uint32_t>>	AnimSystem::_due;
+std::vector<AnimSystem::SharedKey>	AnimSystem::_shared;
+std::vector<glm::mat4>			AnimSystem::_sampled;
+std::vector<glm::mat4>			AnimSystem::_previous;
+std::vector<glm::mat4>			AnimSystem::_palettes;
+std::vector<float>				AnimSystem::_packed;
+glm::vec3						AnimSystem::_viewer = glm::vec3(0.0f);
+double							AnimSystem::_budget = ANIM_FRAME_BUDGET;
+double							AnimSystem::_cost_per_bone = 0.0001;
+uint64_t						AnimSystem::_frame = 0;
+bool							AnimSystem::_layout_changed = false;
+uint32_t						AnimSystem::_num_sampled = 0;
+uint32_t						AnimSystem::_num_extrapolated = 0;
+uint32_t						AnimSystem::_num_shared = 0;
+
+#endif
@@ -5,10 +5,14 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include "Spline.h"
 #include "Object.h"
 #include "Actor.h"
 #include "Camera.h"
 
+#define BEZIER_DEFAULT_DURATION 5.0f // seconds a path takes when no speed is given
+#define BEZIER_ROTATION_KEYS 32 // orientation keys sampled from the rotational cubic
+
 namespace Animator
 {
 	// linear interpolation between two points
@@ -35,92 +39,77 @@ namespace Animator
 		inline float GetZ() { return _pos.z; }
 	};
 
-	// evaluate a point on a bezier curve. t goes from 0 - 1.0 (normalised)
-	inline void evaluate_bezier(glm::vec3& dest, std::vector<ControlPoint*> _control_points, const float t)
-	{
-		glm::vec3 ab;
-		glm::vec3 bc;
-		glm::vec3 cd;
-		glm::vec3 abbc;
-		glm::vec3 bccd;
-		glm::vec3 euler;
-
-		int test = _control_points.size();
-
-		// 4 Control Points
-		lerp(ab, _control_points[0]->GetPosition(), _control_points[1]->GetPosition(), t);
-		lerp(bc, _control_points[1]->GetPosition(), _control_points[2]->GetPosition(), t);
-		lerp(cd, _control_points[2]->GetPosition(), _control_points[3]->GetPosition(), t);
-
-		lerp(abbc, ab, bc, t);
-		lerp(bccd, bc, cd, t);
-
-		lerp(dest, abbc, bccd, t);
-	}
-
-	// evaluate a point on a bezier curve. t goes from 0 - 1.0 (normalised)
-	inline void evaluate_bezier_rot(glm::vec3& dest, std::vector<glm::vec3> _rot_points, const float t)
-	{
-		glm::vec3 ab;
-		glm::vec3 bc;
-		glm::vec3 cd;
-		glm::vec3 abbc;
-		glm::vec3 bccd;
-
-		lerp(ab, _rot_points[0], _rot_points[1], t);
-		lerp(bc, _rot_points[1], _rot_points[2], t);
-		lerp(cd, _rot_points[2], _rot_points[3], t);
-
-		lerp(abbc, ab, bc, t);
-		lerp(bccd, bc, cd, t);
-
-		lerp(dest, abbc, bccd, t);
-	}
-
+	// A cubic path walked at constant speed. The control points make one Bézier segment of a Spline::Path. The four
+	// rotational frames are still the control values of a cubic over the x / y euler angles, evaluated at the same
+	// parameter as the position: it's sampled into orientation keys, each placed at the arc length of its parameter,
+	// so playing only advances a distance instead of stepping through precomputed samples
 	class Bezier : public Object
 	{
 	private:
 		bool _isPlaying;
+		float _distance;
+		float _speed;
 
-		glm::vec3 _point_on_bezier;
-		glm::vec3 _rotation_on_bezier;
-
-		std::vector<glm::vec3> _pos_steps;
-		std::vector<glm::vec3> _rot_steps;
-
-		unsigned int _current_pos_step;
-		unsigned int _current_rot_step_x;
-		unsigned int _current_rot_step_y;
+		Spline::Path _path;
 
 		std::vector<glm::vec3> _rotational_points;
 		std::vector<ControlPoint*> _control_points;
 	public:
-		inline Bezier(std::string name)
+		inline Bezier(std::string name, float speed = 0.0f)
 		{
 			SetName(name);	
 			_isPlaying = true;
+			_distance = 0.0f;
+			_speed = speed;
 		}
 		inline ~Bezier()
 		{
 			_control_points.clear();
 		}
 
+		// Builds the path from the four control points and rotational frames added so far. The path keeps its own
+		// copy, so the control points are released afterwards
 		inline void CreatePath()
 		{
-			for (unsigned int i = 0; i < 1000; i++)
+			_path.Clear();
+			Spline::Segment segment = Spline::Segment();
+			if (_control_points.size() >= 4)
 			{
-				float t = static_cast<float>(i) / 999.0f;
-
-				evaluate_bezier(_point_on_bezier, _control_points, t);
-				evaluate_bezier_rot(_rotation_on_bezier, _rotational_points, t);
+				segment = Spline::Segment::Bezier(_control_points[0]->GetPosition(), _control_points[1]->GetPosition(), _control_points[2]->GetPosition(), _control_points[3]->GetPosition());
+				_path.AddSegment(segment);
+			}
+			_path.Build();
+			_control_points.clear();
 
-				_pos_steps.push_back(_point_on_bezier);
-				_rot_steps.push_back(_rotation_on_bezier);
+			if (_rotational_points.size() >= 4 && _path.NumSegments() > 0)
+			{
+				for (unsigned int i = 0; i < BEZIER_ROTATION_KEYS; i++)
+				{
+					float t = (float)i / (BEZIER_ROTATION_KEYS - 1);
+					glm::vec3 rot = evaluate_rotation(t);
+					_path.AddOrientation(segment.Length(0.0f, t), glm::angleAxis(rot.x, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(rot.y, glm::vec3(0.0f, 1.0f, 0.0f)));
+				}
 			}
+			else if (!_rotational_points.empty())	// Too few frames for the cubic, hold the first
+				_path.AddOrientation(0.0f, glm::angleAxis(_rotational_points[0].x, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::angleAxis(_rotational_points[0].y, glm::vec3(0.0f, 1.0f, 0.0f)));
 
-			_current_pos_step = 0;
-			_current_rot_step_x = 0;
-			_current_rot_step_y = 0;
+			if (_speed <= 0.0f)
+				_speed = _path.Length() / BEZIER_DEFAULT_DURATION;
+			_distance = 0.0f;
+			_isPlaying = _path.NumSegments() > 0;
+		}
+
+		// Evaluates the cubic through the first four rotational frames at 't' (de Casteljau, as the old samples were)
+		inline glm::vec3 evaluate_rotation(const float t)
+		{
+			glm::vec3 ab, bc, cd, abbc, bccd, dest;
+			lerp(ab, _rotational_points[0], _rotational_points[1], t);
+			lerp(bc, _rotational_points[1], _rotational_points[2], t);
+			lerp(cd, _rotational_points[2], _rotational_points[3], t);
+			lerp(abbc, ab, bc, t);
+			lerp(bccd, bc, cd, t);
+			lerp(dest, abbc, bccd, t);
+			return dest;
 		}
 
 		inline void AddControlPoint(ControlPoint* _controlPoint)
@@ -136,51 +125,25 @@ namespace Animator
 		inline uint16_t GetCurrentFrame() { return(0); }
 
 		inline bool IsPlaying() { return _isPlaying; }
+		inline float GetDistance() { return _distance; }
+		inline const Spline::Path& GetPath() { return _path; }
+		inline void SetSpeed(float speed) { _speed = speed; }
 
 		inline void Play(double& delta, Actor* attachment)
 		{
-			// Check if the mover animation is currently playing and has not reached the final keyframe
-			if (_current_pos_step != _pos_steps.size() - 1)
+			// Check if the mover animation is currently playing and has not reached the end of the path
+			if (_isPlaying && _distance < _path.Length())
 			{
-				_isPlaying = true;
-
-				// ROTATION ------------------------------------------------------------------------------------------
-				glm::vec3 Rot(attachment->_trans._rot.x, attachment->_trans._rot.y, 0.0f);
-
-				float rot_step_len_x = glm::length(_rot_steps[_current_rot_step_x + 1].x - _rot_steps[_current_rot_step_x].x);
-				float rot_step_len_y = glm::length(_rot_steps[_current_rot_step_y + 1].y - _rot_steps[_current_rot_step_y].y);
+				_distance = std::min(_distance + _speed * (float)delta, _path.Length());
 
-				Rot.x = _rot_steps[_current_rot_step_x].x;
-				Rot.y = _rot_steps[_current_rot_step_y].y;
+				glm::vec3 Pos = _path.PositionAt(_distance);
+				glm::quat Rot = _path.OrientationAt(_distance);
 
-				float time_x = glm::length((Rot.x - _rot_steps[_current_rot_step_x + 1].x) / rot_step_len_x);
-				float time_y = glm::length((Rot.y - _rot_steps[_current_rot_step_y + 1].y) / rot_step_len_y);
-
-				if (time_x >= 1.0f)
-					_current_rot_step_x++;
-				if (time_y >= 1.0f)
-					_current_rot_step_y++;
-				// -------------------------------------------------------------------------------------------------------
-
-				// TRANSLATION ------------------------------------------------------------------------------------------
-				glm::vec3 step_dir = glm::normalize(_pos_steps[_current_pos_step + 1] - _pos_steps[_current_pos_step]);
-				float step_len = glm::length(_pos_steps[_current_pos_step + 1] - _pos_steps[_current_pos_step]);
-
-				attachment->_trans._pos += step_len * step_dir * ((float)delta * 200.0f);
-
-				if (attachment->GetObjectType() == MESH)
-					attachment->UpdateModel();
-
-				float t = glm::length((attachment->_trans._pos - _pos_steps[_current_pos_step + 1]) / step_len);
-
-				if (t >= 1.0f)
-					_current_pos_step++;
-				// -------------------------------------------------------------------------------------------------------
+				attachment->_trans._pos = Pos;
 
 				if (attachment->GetObjectType() == MESH)
 				{
-					attachment->SetModel(glm::rotate(Rot.x, glm::vec3(1.0f, 0.0f, 0.0f)) * glm::rotate(Rot.y, glm::vec3(0.0f, 1.0f, 0.0f))
-						* glm::translate(-_pos_steps[_current_pos_step]) * glm::scale(attachment->_trans._sca));
+					attachment->SetModel(glm::mat4_cast(Rot) * glm::translate(-Pos) * glm::scale(attachment->_trans._sca));
 				}
 			}
 			else
@@ -188,9 +151,9 @@ namespace Animator
 				_isPlaying = false;
 			}
 		}
-		inline void Pause() {}
-		inline void Rewind() {} //std::reverse();
-		inline void Stop() {}
+		inline void Pause() { _isPlaying = false; }
+		inline void Rewind() { _distance = 0.0f; _isPlaying = true; }
+		inline void Stop() { _distance = _path.Length(); _isPlaying = false; }
 	};
 
 	class Mover
@@ -209,6 +172,8 @@ namespace Animator
 
 		inline ~Mover()
 		{
+			for (unsigned int i = 0; i < _bezier_chain.size(); i++)
+				delete _bezier_chain[i];
 			_bezier_chain.clear();
 		}
 
@@ -216,23 +181,24 @@ namespace Animator
 		{
 			_bezier_index = _bezier_index + 1;
 
-			_bezier_chain.push_back(new Bezier("bezier_" + _bezier_index));
+			Bezier* bezier = new Bezier("bezier_" + std::to_string(_bezier_index));
 
-			_bezier_chain[_bezier_chain.size() - 1]->AddControlPoint(new ControlPoint(glm::vec3(positions[0].x, positions[0].y, positions[0].z)));
-			_bezier_chain[_bezier_chain.size() - 1]->AddControlPoint(new ControlPoint(glm::vec3(positions[1].x, positions[1].y, positions[1].z)));
-			_bezier_chain[_bezier_chain.size() - 1]->AddControlPoint(new ControlPoint(glm::vec3(positions[2].x, positions[2].y, positions[2].z)));
-			_bezier_chain[_bezier_chain.size() - 1]->AddControlPoint(new ControlPoint(glm::vec3(positions[3].x, positions[3].y, positions[3].z)));
+			// The control points only live until the path is built
+			ControlPoint points[4] = { positions[0], positions[1], positions[2], positions[3] };
+			for (unsigned int i = 0; i < 4; i++)
+				bezier->AddControlPoint(&points[i]);
+			for (unsigned int i = 0; i < 4; i++)
+				bezier->AddRotationalFrame(rotations[i]);
 
-			_bezier_chain[_bezier_chain.size() - 1]->AddRotationalFrame(glm::vec3(rotations[0].x, rotations[0].y, rotations[0].z));
-			_bezier_chain[_bezier_chain.size() - 1]->AddRotationalFrame(glm::vec3(rotations[1].x, rotations[1].y, rotations[1].z));
-			_bezier_chain[_bezier_chain.size() - 1]->AddRotationalFrame(glm::vec3(rotations[2].x, rotations[2].y, rotations[2].z));
-			_bezier_chain[_bezier_chain.size() - 1]->AddRotationalFrame(glm::vec3(rotations[3].x, rotations[3].y, rotations[3].z));
-
-			_bezier_chain[_bezier_chain.size() - 1]->CreatePath();
+			bezier->CreatePath();
+			_bezier_chain.push_back(bezier);
 		}
 
 		inline void Play(double& delta, Actor* attachment)
 		{
+			if (_current_bezier >= _bezier_chain.size())
+				return;
+
 			if (_bezier_chain[_current_bezier]->IsPlaying() == false)
 			{
 				_current_bezier = _current_bezier + 1;
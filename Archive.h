@@ -0,0 +1,335 @@
+#ifndef __ARCHIVE_H__
+#define __ARCHIVE_H__
+
+#include <iostream>		// Get error output
+#include <fstream>	// Get file streams for the writer
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get sort / lower_bound
+#include <cstdint>	// Get fixed size integers
+#include "MappedFile.h"		// Map the archive
+#include "Parallel.h"	// Decompress blocks in parallel
+#include "Lz.h"		// Get the block codec
+
+#define ARCHIVE_MAGIC			0x314B4150	// "PAK1"
+#define ARCHIVE_VERSION			1	// Bump whenever the layout below changes
+#define ARCHIVE_ALIGNMENT		4096	// Entries start on page boundaries so uncompressed data can be used in place
+#define ARCHIVE_BLOCK_SIZE		(64 * 1024)		// Uncompressed size of a compression block
+#define ARCHIVE_RAW_BLOCK		0x80000000	// Set in a block's stored size when compression didn't help
+#define ARCHIVE_COMPRESSED		0x1		// Entry flag: the entry is stored as compressed blocks
+
+// A packed content archive (.pak): a header, the entry data, then a table of contents sorted by path hash,
+// a block size table for compressed entries and a table of entry paths. Paths are normalised before hashing
+// ("Res\\Models\\a.obj" and "./Res/Models/a.obj" are the same entry)
+namespace Archive
+{
+	// The file header
+	struct Header
+	{
+		uint32_t	magic;	// ARCHIVE_MAGIC
+		uint32_t	version;	// ARCHIVE_VERSION
+		uint32_t	num_entries;	// Number of entries
+		uint32_t	num_blocks;		// Number of compression blocks
+		uint64_t	toc_offset;		// Offset of the Entry table
+		uint64_t	blocks_offset;	// Offset of the block size table
+		uint64_t	names_offset;	// Offset of the path table
+		uint64_t	file_size;	// Total size, used to detect truncated archives
+	};
+
+	// A table of contents entry
+	struct Entry
+	{
+		uint64_t	hash;	// Hash of the normalised path
+		uint64_t	offset;		// Offset of the stored data
+		uint64_t	size;	// Uncompressed size
+		uint64_t	stored_size;	// Size in the archive
+		uint32_t	first_block;	// First entry in the block table (compressed entries)
+		uint32_t	num_blocks;		// Number of blocks (compressed entries)
+		uint32_t	name;	// Offset of the path in the path table
+		uint32_t	flags;	// ARCHIVE_ flags
+	};
+
+	// Normalises a path for hashing
+	inline std::string Normalise(std::string path)
+	{
+		for (char &c : path)	// For each character...
+			if (c == '\\')	// If it's a windows separator...
+				c = '/';	// Use forward slashes
+		while (path.compare(0, 2, "./") == 0)	// While there's a redundant prefix...
+			path.erase(0, 2);	// Strip it
+		return path;	// Return the result
+	}
+
+	// 64 bit FNV-1a hash of a normalised path
+	inline uint64_t Hash(const std::string &normalised)
+	{
+		uint64_t h = 14695981039346656037ull;	// Offset basis
+		for (unsigned char c : normalised)	// For each byte...
+			h = (h ^ c) * 1099511628211ull;		// Mix it in
+		return h;	// Return the hash
+	}
+
+	// A mounted archive
+	class Reader
+	{
+	private:
+		MappedFile			_file;	// The mapped archive
+		const Header*		_header;	// The header
+		const Entry*		_entries;	// The table of contents
+		const uint32_t*		_blocks;	// The block size table
+		const char*			_names;		// The path table
+		std::vector<uint64_t>	_block_offsets;		// Offset of every block, built once on open
+
+	public:
+		inline Reader() : _header(NULL), _entries(NULL), _blocks(NULL), _names(NULL) {}
+
+		// Maps and validates an archive
+		inline bool Open(const char* uri)
+		{
+			if (!_file.Open(uri))	// If it doesn't exist...
+				return false;	// Return false as failed
+
+			const Header* h = (const Header*)_file.Data();	// The header
+			uint64_t size = _file.Size();	// The archive size
+			if (size < sizeof(Header) || h->magic != ARCHIVE_MAGIC || h->version != ARCHIVE_VERSION || h->file_size != size ||
+				h->toc_offset + (uint64_t)h->num_entries * sizeof(Entry) > size || h->blocks_offset + (uint64_t)h->num_blocks * 4 > size ||
+				h->names_offset > size || h->toc_offset % 8 || h->blocks_offset % 4 ||
+				(h->num_entries && (h->names_offset == size || _file.Data()[size - 1] != '\0')))	// If the layout is broken (or the last path runs off the end)...
+			{
+				std::cout << "Archive Error: '" << uri << "' is not a version " << ARCHIVE_VERSION << " archive!\n";	// Print out error message
+				_file.Close();	// Release it
+				return false;	// Return false as failed
+			}
+
+			_header = h;	// Accept the header
+			_entries = (const Entry*)(_file.Data() + h->toc_offset);	// Locate the contents
+			_blocks = (const uint32_t*)(_file.Data() + h->blocks_offset);	// Locate the block sizes
+			_names = (const char*)(_file.Data() + h->names_offset);		// Locate the paths
+
+			_block_offsets.resize(h->num_blocks);	// One offset per block
+			for (uint32_t e = 0; e < h->num_entries; e++)	// For each entry...
+			{
+				const Entry &entry = _entries[e];	// The entry
+				bool valid = entry.offset + entry.stored_size <= size && entry.name < size - h->names_offset &&
+					(!(entry.flags & ARCHIVE_COMPRESSED) || (uint64_t)entry.first_block + entry.num_blocks <= h->num_blocks);
+				if (!(entry.flags & ARCHIVE_COMPRESSED))	// If it's stored as is...
+					valid = valid && entry.stored_size == entry.size;	// It must be complete
+				else	// Read writes block b at b * ARCHIVE_BLOCK_SIZE, so the blocks must cover the size exactly
+					valid = valid && entry.num_blocks == (entry.size + ARCHIVE_BLOCK_SIZE - 1) / ARCHIVE_BLOCK_SIZE;
+
+				uint64_t at = entry.offset;		// The running block offset
+				for (uint32_t b = 0; valid && (entry.flags & ARCHIVE_COMPRESSED) && b < entry.num_blocks; b++)	// For each block...
+				{
+					_block_offsets[entry.first_block + b] = at;		// Record where it starts
+					at += _blocks[entry.first_block + b] & ~ARCHIVE_RAW_BLOCK;	// Skip it
+				}
+				if ((entry.flags & ARCHIVE_COMPRESSED) && at != entry.offset + entry.stored_size)	// If the blocks don't add up...
+					valid = false;	// The table is broken
+				if (!valid)		// If the entry is broken...
+				{
+					std::cout << "Archive Error: '" << uri << "' has a corrupt entry!\n";	// Print out error message
+					Close();	// Release it
+					return false;	// Return false as failed
+				}
+			}
+
+			return true;	// Return success
+		}
+
+		// Unmaps the archive
+		inline void Close()
+		{
+			_file.Close();	// Unmap it
+			_header = NULL;		// Reset the header
+			_entries = NULL;	// Reset the contents
+			_blocks = NULL;		// Reset the block sizes
+			_names = NULL;	// Reset the paths
+			_block_offsets.clear();		// Reset the offsets
+		}
+
+		inline bool IsOpen() const { return _header != NULL; }		// Return whether an archive is mounted
+		inline uint32_t NumEntries() const { return _header ? _header->num_entries : 0; }	// Return the entry count
+		inline const Entry& GetEntry(uint32_t i) const { return _entries[i]; }	// Return an entry
+		inline const char* GetName(const Entry &e) const { return _names + e.name; }	// Return an entry's path
+
+		// Finds an entry by path (binary search on the hash, then a path compare to rule out collisions)
+		inline const Entry* Find(const std::string &path) const
+		{
+			if (!_header)	// If nothing is mounted...
+				return NULL;	// Return null
+
+			std::string normalised = Normalise(path);	// The lookup key
+			uint64_t hash = Hash(normalised);	// Its hash
+
+			const Entry* end = _entries + _header->num_entries;		// The end of the table
+			const Entry* e = std::lower_bound(_entries, end, hash, [](const Entry &a, uint64_t h) { return a.hash < h; });	// The first candidate
+			for (; e != end && e->hash == hash; e++)	// For each entry with this hash...
+				if (normalised == GetName(*e))	// If the path matches...
+					return e;	// Return it
+
+			return NULL;	// Return null by default
+		}
+
+		// Returns a pointer to the entry's bytes when it's stored uncompressed (valid while mounted), otherwise null
+		inline const unsigned char* View(const Entry &e) const
+		{
+			return (e.flags & ARCHIVE_COMPRESSED) ? NULL : _file.Data() + e.offset;		// Return the data in place
+		}
+
+		// Copies / decompresses an entry into 'out'. Blocks are independent so they are decoded in parallel
+		inline bool Read(const Entry &e, std::vector<unsigned char> &out) const
+		{
+			out.resize((size_t)e.size);		// Make room
+
+			if (!(e.flags & ARCHIVE_COMPRESSED))	// If it's stored as is...
+			{
+				if (e.size) std::memcpy(&out[0], _file.Data() + e.offset, (size_t)e.size);		// Copy it
+				return true;	// Return success
+			}
+
+			bool ok = true;		// Whether every block decoded (only ever cleared)
+			Parallel::For(0, e.num_blocks, 4, [&](size_t from, size_t to)
+			{
+				for (size_t b = from; b < to; b++)	// For each block in range...
+				{
+					uint32_t stored = _blocks[e.first_block + b];	// Its stored size
+					uint32_t length = stored & ~ARCHIVE_RAW_BLOCK;	// Its size in the archive
+					const unsigned char* src = _file.Data() + _block_offsets[e.first_block + b];	// Its data
+					size_t begin = b * (size_t)ARCHIVE_BLOCK_SIZE;	// Its output offset
+					size_t size = (size_t)std::min<uint64_t>(ARCHIVE_BLOCK_SIZE, e.size - begin);	// Its output size
+
+					bool block_ok = (stored & ARCHIVE_RAW_BLOCK) ? length == size : Lz::Decompress(src, length, &out[begin], size);	// Decode it
+					if (block_ok && (stored & ARCHIVE_RAW_BLOCK))	// If it was stored raw...
+						std::memcpy(&out[begin], src, size);	// Copy it
+					if (!block_ok)	// If it's corrupt...
+						ok = false;		// Remember
+				}
+			});
+
+			if (!ok)	// If any block failed...
+				std::cout << "Archive Error: Corrupt block in '" << GetName(e) << "'!\n";	// Print out error message
+			return ok;	// Return the result
+		}
+	};
+
+	// Packs files into an archive. 'files' pairs the path loaders ask for with the file on disk.
+	// Entries that don't shrink by at least an eighth are stored uncompressed so they can be used in place
+	inline bool Write(const std::vector<std::pair<std::string, std::string>> &files, const char* uri, bool compress)
+	{
+		struct Packed
+		{
+			std::string					name;	// Normalised path
+			std::vector<unsigned char>	data;	// Stored bytes
+			std::vector<uint32_t>		blocks;		// Stored block sizes
+			uint64_t					size;	// Uncompressed size
+		};
+
+		std::vector<Packed> packed(files.size());	// One per file
+
+		for (size_t f = 0; f < files.size(); f++)	// For each file...
+		{
+			std::ifstream in(files[f].second, std::ios::binary);	// Open it
+			if (!in)	// If it failed...
+			{
+				std::cout << "Archive Error: Failed to read '" << files[f].second << "'!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+
+			std::vector<unsigned char> raw((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());		// Read it
+			packed[f].name = Normalise(files[f].first);		// Assign path
+			packed[f].size = raw.size();	// Assign size
+
+			size_t num_blocks = (raw.size() + ARCHIVE_BLOCK_SIZE - 1) / ARCHIVE_BLOCK_SIZE;		// Its block count
+			std::vector<std::vector<uint8_t>> blocks(compress ? num_blocks : 0);	// Compressed blocks
+			Parallel::For(0, blocks.size(), 1, [&](size_t from, size_t to)
+			{
+				for (size_t b = from; b < to; b++)	// For each block in range...
+				{
+					size_t begin = b * ARCHIVE_BLOCK_SIZE;	// Its start
+					Lz::Compress(&raw[begin], std::min<size_t>(ARCHIVE_BLOCK_SIZE, raw.size() - begin), blocks[b]);		// Compress it
+				}
+			});
+
+			size_t total = 0;	// The compressed size
+			for (size_t b = 0; b < blocks.size(); b++)	// For each block...
+				total += std::min<size_t>(blocks[b].size(), std::min<size_t>(ARCHIVE_BLOCK_SIZE, raw.size() - b * ARCHIVE_BLOCK_SIZE));
+
+			if (!compress || raw.empty() || total > raw.size() - raw.size() / 8)	// If compression isn't worth it...
+			{
+				packed[f].data.swap(raw);	// Store it as is
+				continue;
+			}
+
+			for (size_t b = 0; b < blocks.size(); b++)	// For each block...
+			{
+				size_t begin = b * ARCHIVE_BLOCK_SIZE;	// Its start
+				size_t size = std::min<size_t>(ARCHIVE_BLOCK_SIZE, raw.size() - begin);		// Its size
+				if (blocks[b].size() >= size)	// If this block didn't shrink...
+				{
+					packed[f].blocks.push_back((uint32_t)size | ARCHIVE_RAW_BLOCK);		// Store it raw
+					packed[f].data.insert(packed[f].data.end(), raw.begin() + begin, raw.begin() + begin + size);
+				}
+				else
+				{
+					packed[f].blocks.push_back((uint32_t)blocks[b].size());		// Store it compressed
+					packed[f].data.insert(packed[f].data.end(), blocks[b].begin(), blocks[b].end());
+				}
+			}
+		}
+
+		std::vector<unsigned char> out(sizeof(Header), 0);	// The archive bytes
+		std::vector<Entry> toc;		// The table of contents
+		std::vector<uint32_t> block_table;	// The block sizes
+		std::string names;	// The path table
+
+		for (Packed &p : packed)	// For each file...
+		{
+			out.resize((out.size() + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT, 0);	// Align it
+
+			Entry e;	// Its entry
+			e.hash = Hash(p.name);	// Assign hash
+			e.offset = out.size();	// Assign offset
+			e.size = p.size;	// Assign size
+			e.stored_size = p.data.size();	// Assign stored size
+			e.first_block = (uint32_t)block_table.size();	// Assign first block
+			e.num_blocks = (uint32_t)p.blocks.size();	// Assign block count
+			e.name = (uint32_t)names.size();	// Assign path
+			e.flags = p.blocks.empty() ? 0 : ARCHIVE_COMPRESSED;	// Assign flags
+			toc.push_back(e);	// Store it
+
+			names += p.name;	// Store the path
+			names += '\0';	// Terminate it
+			block_table.insert(block_table.end(), p.blocks.begin(), p.blocks.end());	// Store the block sizes
+			out.insert(out.end(), p.data.begin(), p.data.end());	// Store the data
+		}
+
+		std::sort(toc.begin(), toc.end(), [](const Entry &a, const Entry &b) { return a.hash < b.hash; });	// Sort for binary search
+
+		Header header;	// The header
+		header.magic = ARCHIVE_MAGIC;	// Stamp the file
+		header.version = ARCHIVE_VERSION;	// Stamp the version
+		header.num_entries = (uint32_t)toc.size();	// Assign entry count
+		header.num_blocks = (uint32_t)block_table.size();	// Assign block count
+
+		out.resize((out.size() + 7) / 8 * 8, 0);	// Align the tables
+		header.toc_offset = out.size();		// Assign contents offset
+		out.insert(out.end(), (const unsigned char*)toc.data(), (const unsigned char*)(toc.data() + toc.size()));
+		header.blocks_offset = out.size();	// Assign block table offset
+		out.insert(out.end(), (const unsigned char*)block_table.data(), (const unsigned char*)(block_table.data() + block_table.size()));
+		header.names_offset = out.size();	// Assign path table offset
+		out.insert(out.end(), names.begin(), names.end());
+		header.file_size = out.size();	// Assign size
+		std::memcpy(&out[0], &header, sizeof(header));	// Write the header
+
+		std::ofstream file(uri, std::ios::binary | std::ios::trunc);	// Create the archive
+		if (!file.write((const char*)&out[0], out.size()))	// Write it in one go
+		{
+			std::cout << "Archive Error: Failed to write '" << uri << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		return true;	// Return success
+	}
+}
+
+#endif
@@ -4,7 +4,7 @@
 #define BITMAP_X_COUNT	16	// The default number of chars on each row
 #define ASCII_OFFSET	32	// The subtracting offset from ascii values
 
-#include "DdsLoader.h"	// For loading in dds files
+#include "SpriteAtlas.h"	// The bitmaps share the font atlas
 #include "Uniform.h"	// For our atlas texture maps
 
 // This will contain bitmap data
@@ -14,8 +14,10 @@ struct BitmapAtlas
 	double			_height;	// Height of bitmap
 	double			_element_size;	// The size of each atlas element
 	unsigned int	_type;	// Font type
-	GLuint			_texture_id;	// The texture ID
+	unsigned int	_region;	// The bitmap's region in the font atlas
 	uniform			_u_texture;		// The uniform location variable
+	uniform			_u_rect;	// The region uv rect uniform
+	uniform			_u_layer;	// The region layer uniform
 	std::string		_name;	// The name of the bitmap
 
 							// Default constructor
@@ -33,11 +35,8 @@ struct BitmapAtlas
 		_element_size = (unsigned int)_width / BITMAP_X_COUNT;	// Calculate the element size in pixels
 	}
 
-	// Deconstructor
-	inline ~BitmapAtlas()
-	{
-		glDeleteTextures(1, &_texture_id);	// Delete the bitmap texture
-	}
+	// Deconstructor (the font atlas owns the pixels)
+	inline ~BitmapAtlas() {}
 
 	// This function will load a bitmap font file
 	inline void LoadFile(std::string bitmap)
@@ -47,8 +46,7 @@ struct BitmapAtlas
 		for (unsigned int i = 0; i < 4; i++)	// Iterate four times...
 			_name.pop_back();	// Remove file extension from name
 
-		size_t w, h, m;		// Temp input variables
-		_texture_id = LoadDds({ bitmap }, w, h, m, 0, GL_REPEAT, GL_REPEAT, GL_LINEAR, GL_LINEAR, GL_TEXTURE_2D, false);	// Load bitmap as dds format
+		_region = SpriteAtlas::Get(SPRITE_ATLAS_FONTS)->Add(bitmap);	// Add the bitmap to the font atlas
 	}
 };
 
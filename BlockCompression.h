@@ -0,0 +1,484 @@
+#ifndef __BLOCK_COMPRESSION_H__
+#define __BLOCK_COMPRESSION_H__
+
+#include <vector>	// Get dynamic array
+#include <cstring>	// Get memcpy
+#include <cstdint>	// Get fixed size integers
+#include <cmath>	// Get sqrt / log10
+#include <algorithm>	// Get min / max
+#include "Parallel.h"	// Compress block rows in parallel
+#include "TextureContainer.h"	// Get the format enum
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>	// Get SSE2
+#define BC_SIMD 1	// Pick bc1 indices four pixels at a time
+#endif
+
+// CPU encoders and decoders for BC1 (opaque colour), BC3 (colour + alpha) and BC5 (two channel normal maps).
+// Colour endpoints come from the principal axis of the block, are inset, then refined once with a least squares
+// fit over the chosen indices. Alpha / red-green channels use the BC4 scheme, trying both palette modes.
+// The decoders follow the D3D reference rounding so PSNR matches what the GPU samples
+namespace BlockCompression
+{
+	// Packs an 8 bit colour to 565
+	inline uint16_t To565(float r, float g, float b)
+	{
+		int ri = std::min(31, std::max(0, (int)(r * 31.0f / 255.0f + 0.5f)));	// Quantise red
+		int gi = std::min(63, std::max(0, (int)(g * 63.0f / 255.0f + 0.5f)));	// Quantise green
+		int bi = std::min(31, std::max(0, (int)(b * 31.0f / 255.0f + 0.5f)));	// Quantise blue
+		return (uint16_t)((ri << 11) | (gi << 5) | bi);		// Pack them
+	}
+
+	// Expands 565 to 8 bits per channel (bit replication, like the hardware)
+	inline void From565(uint16_t c, int rgb[3])
+	{
+		int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;	// Unpack
+		rgb[0] = (r << 3) | (r >> 2);	// Expand red
+		rgb[1] = (g << 2) | (g >> 4);	// Expand green
+		rgb[2] = (b << 3) | (b >> 2);	// Expand blue
+	}
+
+	// Builds the 4 colour palette of a bc1 block (c0 > c1 mode)
+	inline void Palette4(uint16_t c0, uint16_t c1, int palette[4][3])
+	{
+		From565(c0, palette[0]);	// First endpoint
+		From565(c1, palette[1]);	// Second endpoint
+		for (int k = 0; k < 3; k++)		// For each channel...
+		{
+			palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;	// Two thirds / one third
+			palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;	// One third / two thirds
+		}
+	}
+
+	// Picks the nearest palette entry for each pixel, returns the packed indices and the total squared error
+	inline uint32_t PickIndices(const float px[3][16], const int palette[4][3], float &error)
+	{
+		uint32_t indices = 0;	// The packed indices
+		error = 0.0f;	// The running error
+
+#ifdef BC_SIMD
+		for (int i = 0; i < 16; i += 4)		// Four pixels at a time...
+		{
+			__m128 r = _mm_loadu_ps(&px[0][i]), g = _mm_loadu_ps(&px[1][i]), b = _mm_loadu_ps(&px[2][i]);	// The pixels
+			__m128 best = _mm_set1_ps(1e30f);	// Best distance per pixel
+			__m128i best_index = _mm_setzero_si128();	// Best index per pixel
+			for (int p = 0; p < 4; p++)		// For each palette entry...
+			{
+				__m128 dr = _mm_sub_ps(r, _mm_set1_ps((float)palette[p][0]));
+				__m128 dg = _mm_sub_ps(g, _mm_set1_ps((float)palette[p][1]));
+				__m128 db = _mm_sub_ps(b, _mm_set1_ps((float)palette[p][2]));
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));	// Squared distance
+				__m128 closer = _mm_cmplt_ps(d, best);	// Which pixels it beats
+				best = _mm_min_ps(d, best);		// Keep the closest
+				best_index = _mm_or_si128(_mm_andnot_si128(_mm_castps_si128(closer), best_index), _mm_and_si128(_mm_castps_si128(closer), _mm_set1_epi32(p)));
+			}
+
+			float d[4];		// Distances out
+			int32_t idx[4];		// Indices out
+			_mm_storeu_ps(d, best);
+			_mm_storeu_si128((__m128i*)idx, best_index);
+			for (int k = 0; k < 4; k++)		// Pack them
+			{
+				indices |= (uint32_t)idx[k] << (2 * (i + k));
+				error += d[k];
+			}
+		}
+#else
+		for (int i = 0; i < 16; i++)	// For each pixel...
+		{
+			float best = 1e30f;		// Best distance
+			int best_index = 0;		// Best index
+			for (int p = 0; p < 4; p++)		// For each palette entry...
+			{
+				float dr = px[0][i] - palette[p][0], dg = px[1][i] - palette[p][1], db = px[2][i] - palette[p][2];
+				float d = dr * dr + dg * dg + db * db;	// Squared distance
+				if (d < best) { best = d; best_index = p; }		// Keep the closest
+			}
+			indices |= (uint32_t)best_index << (2 * i);		// Pack it
+			error += best;	// Accumulate
+		}
+#endif
+		return indices;		// Return the indices
+	}
+
+	// Orders the endpoints for 4 colour mode, fixing up the indices if they were swapped
+	inline void WriteBC1(uint16_t c0, uint16_t c1, uint32_t indices, uint8_t out[8])
+	{
+		if (c0 < c1)	// If the order would select 3 colour mode...
+		{
+			std::swap(c0, c1);	// Swap the endpoints
+			indices ^= 0x55555555;	// 0<->1 and 2<->3
+		}
+		else if (c0 == c1)	// If the block is flat...
+			indices = 0;	// Every pixel is the endpoint
+
+		out[0] = (uint8_t)c0; out[1] = (uint8_t)(c0 >> 8);	// First endpoint
+		out[2] = (uint8_t)c1; out[3] = (uint8_t)(c1 >> 8);	// Second endpoint
+		std::memcpy(out + 4, &indices, 4);	// Indices (little endian)
+	}
+
+	// Best endpoint pair per 8 bit value so that index 2 (2/3 c0 + 1/3 c1) reproduces it, for 5 and 6 bit channels
+	inline const uint8_t (*SingleColourTable(int bits))[2]
+	{
+		struct Tables { uint8_t t5[256][2]; uint8_t t6[256][2]; };	// One table per channel width
+		static const Tables tables = []()	// Built once, thread safe
+		{
+			Tables t;
+			for (int b = 5; b <= 6; b++)	// For each channel width...
+			{
+				int top = (1 << b) - 1;		// The largest quantised value
+				uint8_t (*table)[2] = b == 5 ? t.t5 : t.t6;		// The table to fill
+				for (int v = 0; v < 256; v++)	// For each value...
+				{
+					int best = 1 << 30;		// The best error so far
+					for (int e0 = 0; e0 <= top; e0++)	// For each endpoint pair...
+						for (int e1 = 0; e1 <= top; e1++)
+						{
+							int x0 = b == 5 ? (e0 << 3) | (e0 >> 2) : (e0 << 2) | (e0 >> 4);	// Expanded endpoints
+							int x1 = b == 5 ? (e1 << 3) | (e1 >> 2) : (e1 << 2) | (e1 >> 4);
+							int error = std::abs((2 * x0 + x1) / 3 - v);	// What index 2 decodes to
+							if (error < best) { best = error; table[v][0] = (uint8_t)e0; table[v][1] = (uint8_t)e1; }
+						}
+				}
+			}
+			return t;
+		}();
+		return bits == 5 ? tables.t5 : tables.t6;	// Return the table
+	}
+
+	// Encodes 16 rgba pixels (row major) as a bc1 colour block, alpha is ignored
+	inline void EncodeBC1(const uint8_t rgba[64], uint8_t out[8])
+	{
+		bool flat = true;	// Whether every pixel has the same colour
+		for (int i = 1; i < 16 && flat; i++)
+			flat = rgba[i * 4] == rgba[0] && rgba[i * 4 + 1] == rgba[1] && rgba[i * 4 + 2] == rgba[2];
+		if (flat)	// If it does, 565 endpoints alone would lose precision...
+		{
+			const uint8_t (*t5)[2] = SingleColourTable(5), (*t6)[2] = SingleColourTable(6);	// Exact matches through index 2
+			uint16_t c0 = (uint16_t)((t5[rgba[0]][0] << 11) | (t6[rgba[1]][0] << 5) | t5[rgba[2]][0]);
+			uint16_t c1 = (uint16_t)((t5[rgba[0]][1] << 11) | (t6[rgba[1]][1] << 5) | t5[rgba[2]][1]);
+			uint32_t indices = 0xAAAAAAAA;	// Every pixel uses index 2
+			if (c0 < c1)	// Index 2 must stay 2/3 c0 after ordering, so use index 3 with swapped endpoints
+			{
+				std::swap(c0, c1);
+				indices = 0xFFFFFFFF;
+			}
+			if (c0 == c1)	// If the endpoints are equal the block is exact anyway
+				indices = 0;
+			out[0] = (uint8_t)c0; out[1] = (uint8_t)(c0 >> 8);	// First endpoint
+			out[2] = (uint8_t)c1; out[3] = (uint8_t)(c1 >> 8);	// Second endpoint
+			std::memcpy(out + 4, &indices, 4);	// Indices
+			return;		// Done
+		}
+
+		float px[3][16];	// Pixels as channel planes
+		float mean[3] = { 0.0f, 0.0f, 0.0f };	// The block mean
+		for (int i = 0; i < 16; i++)	// For each pixel...
+			for (int k = 0; k < 3; k++)		// For each channel...
+			{
+				px[k][i] = rgba[i * 4 + k];		// Store it
+				mean[k] += px[k][i] / 16.0f;	// Accumulate the mean
+			}
+
+		float cov[6] = { 0.0f };	// Covariance (rr, rg, rb, gg, gb, bb)
+		for (int i = 0; i < 16; i++)	// For each pixel...
+		{
+			float r = px[0][i] - mean[0], g = px[1][i] - mean[1], b = px[2][i] - mean[2];
+			cov[0] += r * r; cov[1] += r * g; cov[2] += r * b; cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+		}
+
+		float axis[3] = { 0.577f, 0.577f, 0.577f };	// Start from the grey axis
+		for (int it = 0; it < 8; it++)	// Power iteration for the principal axis
+		{
+			float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			float length = std::sqrt(x * x + y * y + z * z);	// Its length
+			if (length < 1e-6f)		// If the block is flat...
+				break;	// Any axis will do
+			axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;	// Normalise
+		}
+
+		float lo = 1e30f, hi = -1e30f;	// Extent along the axis
+		for (int i = 0; i < 16; i++)	// For each pixel...
+		{
+			float t = (px[0][i] - mean[0]) * axis[0] + (px[1][i] - mean[1]) * axis[1] + (px[2][i] - mean[2]) * axis[2];
+			lo = std::min(lo, t);
+			hi = std::max(hi, t);
+		}
+		float inset = (hi - lo) / 16.0f;	// Pull the endpoints in, the extremes are usually outliers
+		lo += inset;
+		hi -= inset;
+
+		uint16_t c0 = To565(mean[0] + axis[0] * hi, mean[1] + axis[1] * hi, mean[2] + axis[2] * hi);	// First endpoint
+		uint16_t c1 = To565(mean[0] + axis[0] * lo, mean[1] + axis[1] * lo, mean[2] + axis[2] * lo);	// Second endpoint
+
+		int palette[4][3];	// The decoded palette
+		float error;	// The block error
+		Palette4(c0, c1, palette);
+		uint32_t indices = PickIndices(px, palette, error);		// Pick indices
+
+		// Refine: least squares endpoints for the chosen indices
+		static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };	// Weight of c0 per index
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f, ax[3] = { 0.0f }, bx[3] = { 0.0f };
+		for (int i = 0; i < 16; i++)	// For each pixel...
+		{
+			float a = weights[(indices >> (2 * i)) & 3], b = 1.0f - a;	// Its endpoint weights
+			aa += a * a; bb += b * b; ab += a * b;
+			for (int k = 0; k < 3; k++) { ax[k] += a * px[k][i]; bx[k] += b * px[k][i]; }
+		}
+		float det = aa * bb - ab * ab;	// The system determinant
+		if (std::fabs(det) > 1e-6f)		// If it's solvable...
+		{
+			float e0[3], e1[3];		// The refined endpoints
+			for (int k = 0; k < 3; k++)
+			{
+				e0[k] = (ax[k] * bb - bx[k] * ab) / det;
+				e1[k] = (bx[k] * aa - ax[k] * ab) / det;
+			}
+			uint16_t r0 = To565(e0[0], e0[1], e0[2]), r1 = To565(e1[0], e1[1], e1[2]);	// Quantise them
+			int refined_palette[4][3];	// Their palette
+			float refined_error;	// Their error
+			Palette4(r0, r1, refined_palette);
+			uint32_t refined = PickIndices(px, refined_palette, refined_error);		// Re-pick indices
+			if (refined_error < error)	// If it's better...
+			{
+				c0 = r0; c1 = r1; indices = refined;	// Keep it
+			}
+		}
+
+		WriteBC1(c0, c1, indices, out);		// Write the block
+	}
+
+	// Builds the 8 entry palette of a bc4 block
+	inline void PaletteBC4(int a0, int a1, int palette[8])
+	{
+		palette[0] = a0;	// First endpoint
+		palette[1] = a1;	// Second endpoint
+		if (a0 > a1)	// 8 value mode
+			for (int i = 1; i < 7; i++)
+				palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		else	// 6 value mode plus 0 and 255
+		{
+			for (int i = 1; i < 5; i++)
+				palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	// Encodes one 8 bit channel of 16 pixels as a bc4 block ('stride' bytes between pixels)
+	inline void EncodeBC4(const uint8_t* values, int stride, uint8_t out[8])
+	{
+		int lo = 255, hi = 0, lo_inner = 255, hi_inner = 0;		// Extents, and extents ignoring 0 / 255
+		for (int i = 0; i < 16; i++)	// For each pixel...
+		{
+			int v = values[i * stride];		// Its value
+			lo = std::min(lo, v);
+			hi = std::max(hi, v);
+			if (v > 0) lo_inner = std::min(lo_inner, v);
+			if (v < 255) hi_inner = std::max(hi_inner, v);
+		}
+
+		uint64_t best_bits = 0;		// The best block
+		int best_error = 0x7FFFFFFF;	// Its error
+		for (int mode = 0; mode < 2; mode++)	// Try both palette modes
+		{
+			int a0 = mode == 0 ? hi : std::min(lo_inner, hi_inner);	// 8 value mode needs a0 > a1
+			int a1 = mode == 0 ? lo : std::max(lo_inner, hi_inner);		// 6 value mode needs a0 <= a1
+			if (mode == 0 && a0 == a1)	// A flat block still needs a0 > a1 for 8 value mode
+			{
+				if (a1 > 0) a1--;	// Step the second endpoint down
+				else a0++;	// Or the first one up
+			}
+			if (mode == 1 && lo_inner > hi_inner)	// If every pixel is 0 or 255...
+				a0 = a1 = 0;
+
+			int palette[8];		// The decoded palette
+			PaletteBC4(a0, a1, palette);
+
+			uint64_t bits = (uint64_t)a0 | ((uint64_t)a1 << 8);		// The block
+			int error = 0;	// Its error
+			for (int i = 0; i < 16; i++)	// For each pixel...
+			{
+				int v = values[i * stride];		// Its value
+				int best = 0, best_d = 0x7FFFFFFF;	// The nearest entry
+				for (int p = 0; p < 8; p++)
+				{
+					int d = (v - palette[p]) * (v - palette[p]);
+					if (d < best_d) { best_d = d; best = p; }
+				}
+				bits |= (uint64_t)best << (16 + 3 * i);		// Store the index
+				error += best_d;	// Accumulate
+			}
+
+			if (error < best_error)		// If it's the best so far...
+			{
+				best_error = error;
+				best_bits = bits;
+			}
+		}
+
+		for (int i = 0; i < 8; i++)		// Write little endian
+			out[i] = (uint8_t)(best_bits >> (8 * i));
+	}
+
+	// Decodes a bc1 block to 16 rgba pixels
+	inline void DecodeBC1(const uint8_t in[8], uint8_t rgba[64])
+	{
+		uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8)), c1 = (uint16_t)(in[2] | (in[3] << 8));	// The endpoints
+		uint32_t indices;	// The indices
+		std::memcpy(&indices, in + 4, 4);
+
+		int palette[4][3];	// The palette
+		int alpha[4] = { 255, 255, 255, 255 };	// Its alpha
+		if (c0 > c1)	// 4 colour mode
+			Palette4(c0, c1, palette);
+		else	// 3 colour mode + transparent black
+		{
+			From565(c0, palette[0]);
+			From565(c1, palette[1]);
+			for (int k = 0; k < 3; k++) { palette[2][k] = (palette[0][k] + palette[1][k]) / 2; palette[3][k] = 0; }
+			alpha[3] = 0;
+		}
+
+		for (int i = 0; i < 16; i++)	// For each pixel...
+		{
+			int p = (indices >> (2 * i)) & 3;	// Its index
+			rgba[i * 4 + 0] = (uint8_t)palette[p][0];
+			rgba[i * 4 + 1] = (uint8_t)palette[p][1];
+			rgba[i * 4 + 2] = (uint8_t)palette[p][2];
+			rgba[i * 4 + 3] = (uint8_t)alpha[p];
+		}
+	}
+
+	// Decodes a bc4 block into one channel ('stride' bytes between pixels)
+	inline void DecodeBC4(const uint8_t in[8], uint8_t* values, int stride)
+	{
+		uint64_t bits = 0;	// The block
+		for (int i = 0; i < 8; i++)
+			bits |= (uint64_t)in[i] << (8 * i);
+
+		int palette[8];		// The palette
+		PaletteBC4(in[0], in[1], palette);
+		for (int i = 0; i < 16; i++)	// For each pixel...
+			values[i * stride] = (uint8_t)palette[(bits >> (16 + 3 * i)) & 7];
+	}
+
+	// Returns whether we can encode a format
+	inline bool CanEncode(TextureContainer::Format f)
+	{
+		return f == TextureContainer::FORMAT_BC1 || f == TextureContainer::FORMAT_BC1_SRGB || f == TextureContainer::FORMAT_BC3 ||
+			f == TextureContainer::FORMAT_BC3_SRGB || f == TextureContainer::FORMAT_BC5;
+	}
+
+	// Gathers a 4x4 block of rgba pixels, clamping at the edges of images that aren't a multiple of 4
+	inline void FetchBlock(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, uint8_t block[64])
+	{
+		for (uint32_t y = 0; y < 4; y++)
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t sx = std::min(bx * 4 + x, width - 1), sy = std::min(by * 4 + y, height - 1);	// The source pixel
+				std::memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+			}
+	}
+
+	// Compresses an rgba8 image (block rows in parallel), 'out' receives TextureContainer::ImageSize bytes
+	inline bool Compress(const uint8_t* rgba, uint32_t width, uint32_t height, TextureContainer::Format format, std::vector<uint8_t> &out)
+	{
+		if (!CanEncode(format))		// If we don't have an encoder...
+			return false;	// Return false as failed
+
+		uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;	// The block grid
+		size_t block_bytes = TextureContainer::GetFormatInfo(format).block_bytes;	// Bytes per block
+		out.resize(blocks_x * blocks_y * block_bytes);	// Make room
+
+		Parallel::For(0, blocks_y, 4, [&](size_t from, size_t to)
+		{
+			uint8_t block[64];	// One block of pixels
+			for (size_t by = from; by < to; by++)	// For each block row in range...
+				for (uint32_t bx = 0; bx < blocks_x; bx++)	// For each block...
+				{
+					FetchBlock(rgba, width, height, bx, (uint32_t)by, block);	// Gather it
+					uint8_t* dst = &out[(by * blocks_x + bx) * block_bytes];	// Where it goes
+
+					switch (format)
+					{
+					case TextureContainer::FORMAT_BC1: case TextureContainer::FORMAT_BC1_SRGB:
+						EncodeBC1(block, dst);	// Colour
+						break;
+					case TextureContainer::FORMAT_BC3: case TextureContainer::FORMAT_BC3_SRGB:
+						EncodeBC4(block + 3, 4, dst);	// Alpha
+						EncodeBC1(block, dst + 8);	// Colour
+						break;
+					default:
+						EncodeBC4(block + 0, 4, dst);	// Red
+						EncodeBC4(block + 1, 4, dst + 8);	// Green
+						break;
+					}
+				}
+		});
+
+		return true;	// Return success
+	}
+
+	// Decodes a compressed image back to rgba8 (BC5 decodes to red / green with blue 0 and alpha 255)
+	inline bool Decompress(const uint8_t* data, uint32_t width, uint32_t height, TextureContainer::Format format, std::vector<uint8_t> &rgba)
+	{
+		if (!CanEncode(format))		// If we don't have a decoder...
+			return false;	// Return false as failed
+
+		uint32_t blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;	// The block grid
+		size_t block_bytes = TextureContainer::GetFormatInfo(format).block_bytes;	// Bytes per block
+		rgba.assign((size_t)width * height * 4, 0);		// Make room
+
+		for (uint32_t by = 0; by < blocks_y; by++)	// For each block row...
+			for (uint32_t bx = 0; bx < blocks_x; bx++)	// For each block...
+			{
+				const uint8_t* src = data + (by * blocks_x + bx) * block_bytes;		// The block
+				uint8_t block[64];	// The decoded pixels
+				switch (format)
+				{
+				case TextureContainer::FORMAT_BC1: case TextureContainer::FORMAT_BC1_SRGB:
+					DecodeBC1(src, block);
+					break;
+				case TextureContainer::FORMAT_BC3: case TextureContainer::FORMAT_BC3_SRGB:
+					DecodeBC1(src + 8, block);
+					DecodeBC4(src, block + 3, 4);
+					break;
+				default:
+					DecodeBC4(src, block + 0, 4);
+					DecodeBC4(src + 8, block + 1, 4);
+					for (int i = 0; i < 16; i++) { block[i * 4 + 2] = 0; block[i * 4 + 3] = 255; }
+					break;
+				}
+
+				for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)		// Scatter the pixels inside the image
+					for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+						std::memcpy(&rgba[(((size_t)by * 4 + y) * width + bx * 4 + x) * 4], block + (y * 4 + x) * 4, 4);
+			}
+
+		return true;	// Return success
+	}
+
+	// Peak signal to noise ratio in dB over the channels a format stores (rgb for BC1, rgba for BC3, rg for BC5)
+	inline double Psnr(const uint8_t* a, const uint8_t* b, size_t num_pixels, TextureContainer::Format format)
+	{
+		bool bc5 = format == TextureContainer::FORMAT_BC5;	// Only red / green matter
+		bool alpha = format == TextureContainer::FORMAT_BC3 || format == TextureContainer::FORMAT_BC3_SRGB;		// Whether alpha matters
+		int channels = bc5 ? 2 : (alpha ? 4 : 3);	// Channels compared
+
+		double sum = 0.0;	// Sum of squared errors
+		for (size_t i = 0; i < num_pixels; i++)		// For each pixel...
+			for (int k = 0; k < channels; k++)	// For each compared channel...
+			{
+				double d = (double)a[i * 4 + k] - (double)b[i * 4 + k];
+				sum += d * d;
+			}
+
+		double mse = sum / (double)(num_pixels * channels);		// Mean squared error
+		return mse <= 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);	// Return dB (capped for identical images)
+	}
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef __BONE_PALETTE_H__
+#define __BONE_PALETTE_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <glew.h>	// Get the uniform functions
+#include <glm/glm.hpp>	// Get glm variables
+#include <cstring>	// Get strcmp
+#include <string>	// Get string
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>	// Get SSE2
+#define BONE_PALETTE_SIMD 1		// Transpose with SSE
+#endif
+
+#define BONE_PALETTE_MAX	100		// Size of the gBones array in the skinning shader
+#define BONE_PALETTE_FLOATS	12	// Floats per packed bone
+
+// Skinning matrices are affine, so only their top three rows are sent: 48 bytes a bone instead of 64. The packed
+// rows upload as the shader's 'uniform mat3x4 gBones[BONE_PALETTE_MAX]' (column i holding row i), which skins with
+// 'vec4(p, 1.0) * gBones[id]'. Shaders that still declare 'uniform mat4 gBones[]' are detected when resolving and
+// get the palette expanded back to full matrices. Packing is plain CPU work, so it can be checked without a GL context
+namespace BonePalette
+{
+	// Packs 'count' matrices into 'out' (BONE_PALETTE_FLOATS each, row-major)
+	inline void Pack(const glm::mat4* in, uint32_t count, float* out)
+	{
+		for (uint32_t i = 0; i < count; i++, out += BONE_PALETTE_FLOATS)	// For each bone...
+		{
+			const float* m = &in[i][0][0];	// Column-major source
+#ifdef BONE_PALETTE_SIMD
+			__m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);	// Columns to rows
+			_mm_storeu_ps(out, c0);
+			_mm_storeu_ps(out + 4, c1);
+			_mm_storeu_ps(out + 8, c2);
+#else
+			for (int r = 0; r < 3; r++)		// For each of the top rows...
+				for (int c = 0; c < 4; c++)
+					out[r * 4 + c] = m[c * 4 + r];
+#endif
+		}
+	}
+
+	// Rebuilds a full matrix from a packed bone
+	inline glm::mat4 Unpack(const float* in)
+	{
+		glm::mat4 m(1.0f);	// The bottom row stays 0, 0, 0, 1
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 4; c++)
+				m[c][r] = in[r * 4 + c];
+		return m;	// Return it
+	}
+
+	// The palette uniform of one shader program, looked up once
+	class Uniform
+	{
+	private:
+		GLint	_location;	// Location of gBones[0] (the array's elements follow it)
+		bool	_full;		// Whether the shader declares the array as mat4
+		mutable glm::mat4 _expanded[BONE_PALETTE_MAX];	// Scratch for shaders that take full matrices
+
+	public:
+		inline Uniform() : _location(-1), _full(false) {}
+
+		// Finds the array in 'program', returns false if the shader doesn't skin
+		inline bool Resolve(GLuint program, const char* name = "gBones")
+		{
+			_location = glGetUniformLocation(program, name);	// Arrays resolve to their first element
+			_full = false;
+			if (_location == -1)	// If the shader doesn't skin...
+				return false;	// Return failure
+
+			std::string element = std::string(name) + "[0]";	// Arrays are reported as their first element
+			GLint count = 0;	// Active uniforms
+			glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+			for (GLint u = 0; u < count; u++)	// For each uniform...
+			{
+				GLchar active[256];		// Its name
+				GLsizei length = 0;
+				GLint size = 0;
+				GLenum type = 0;
+				glGetActiveUniform(program, (GLuint)u, sizeof(active), &length, &size, &type, active);
+				if (strcmp(active, name) == 0 || element == active)		// If it's the palette...
+				{
+					_full = type == GL_FLOAT_MAT4;	// Older shaders take the whole matrix
+					break;
+				}
+			}
+			return true;
+		}
+
+		// Uploads a packed palette with one call (the program must be bound)
+		inline void Upload(const float* packed, uint32_t count) const
+		{
+			if (_location == -1 || !packed || !count)	// If there's nowhere to send it...
+				return;		// Return as normal
+			count = count < BONE_PALETTE_MAX ? count : BONE_PALETTE_MAX;
+			if (!_full)		// If the shader takes the packed rows...
+			{
+				glUniformMatrix3x4fv(_location, count, GL_FALSE, packed);
+				return;
+			}
+			for (uint32_t i = 0; i < count; i++)	// Otherwise, for each bone...
+				_expanded[i] = Unpack(packed + i * BONE_PALETTE_FLOATS);	// Restore the bottom row
+			glUniformMatrix4fv(_location, count, GL_FALSE, &_expanded[0][0][0]);
+		}
+	};
+}
+
+#endif
@@ -69,8 +69,7 @@ public:
 	{
 		_t = CAMERA;	// Set actor type
 
-		_u_view = glGetUniformLocation(shader_program, "view");		// Locate our view uniform
-		_u_proj = glGetUniformLocation(shader_program, "proj");		// Locate our proj uniform
+		GetUniforms(shader_program);	// Locate our matrix uniforms
 
 		_front = glm::vec3(0.0f, 0.0f, 1.0f);	// Initialise the front vector
 		_up = glm::vec3(0.0f, 1.0f, 0.0f);	// Initialise the up vector
@@ -97,8 +96,7 @@ public:
 	{
 		_t = CAMERA;	// Set actor type
 
-		_u_view = glGetUniformLocation(shader_program, "view");		// Locate our view uniform
-		_u_proj = glGetUniformLocation(shader_program, "proj");		// Locate our proj uniform
+		GetUniforms(shader_program);	// Locate our matrix uniforms
 
 		_front = glm::vec3(0.0f, 0.0f, -1.0f);	// Initialise the front vector
 		_up = glm::vec3(0.0f, 1.0f, 0.0f);	// Initialise the up vector
@@ -118,6 +116,13 @@ public:
 		UpdateLookVectors();	// Update the current look vectors
 	}
 
+	// Locates the view and projection uniforms (again after the shader is relinked)
+	inline virtual void GetUniforms(unsigned int shader_program)
+	{
+		_u_view = glGetUniformLocation(shader_program, "view");		// Locate our view uniform
+		_u_proj = glGetUniformLocation(shader_program, "proj");		// Locate our proj uniform
+	}
+
 	inline int GetProjectionType() { return _proj_type; }	// Return the projection matrix type
 
 	inline glm::mat4 GetViewMatrix() { return glm::lookAt(_trans._pos, _trans._pos + _front, _up); }	// Function for getting LookAt matrix
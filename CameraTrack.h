@@ -0,0 +1,155 @@
+#ifndef __CAMERA_TRACK_H__
+#define __CAMERA_TRACK_H__
+
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get upper_bound
+#include <cmath>	// Get atan2 / asin
+#include <glm/glm.hpp>	// Get glm variables
+#include <glm/gtx/quaternion.hpp>	// Get slerp / squad
+#include "Spline.h"		// Get Hermite segments
+#include "Camera.h"		// Drive the player camera
+
+// How a track blends between its keyframes
+enum CameraTrackType
+{
+	TRACK_LINEAR,	// Lerp positions, slerp rotations
+	TRACK_SMOOTH	// Catmull-Rom positions, squad rotations
+};
+
+// A cinematic camera path stored as keyframes (a time, position, rotation and field of view: 36 bytes each) and
+// sampled analytically at any time. The rotation maps the camera's axes to the world: +z is its front, +y its up.
+// Building a track touches no GL state; Apply() writes a sample into an existing camera, so a cinematic drives the
+// player camera rather than swapping camera objects
+class CameraTrack
+{
+public:
+	// A pose the camera passes through
+	struct Keyframe
+	{
+		float		time;	// Seconds from the start of the track
+		glm::vec3	position;	// Where the camera is
+		glm::quat	rotation;	// Which way it faces
+		float		fov;	// Its field of view
+	};
+
+private:
+	std::vector<Keyframe>	_keys;	// Sorted by time
+	unsigned int			_type;	// How keys are blended
+
+	// Returns the segment a time falls in and the fraction through it (clamped to the track)
+	inline size_t Locate(float time, float &u) const
+	{
+		Keyframe key;
+		key.time = time;
+		size_t i = std::upper_bound(_keys.begin(), _keys.end(), key, [](const Keyframe &a, const Keyframe &b) { return a.time < b.time; }) - _keys.begin();
+		if (i == 0)		// Before the first key
+		{
+			u = 0.0f;
+			return 0;
+		}
+		if (i >= _keys.size())	// After the last
+		{
+			u = 1.0f;
+			return _keys.size() - 2;
+		}
+		float span = _keys[i].time - _keys[i - 1].time;
+		u = span > 0.0f ? (time - _keys[i - 1].time) / span : 1.0f;
+		return i - 1;	// Return the segment
+	}
+
+	// Returns a position's tangent at key i scaled to segment [from, from + 1] (Catmull-Rom on uneven times)
+	inline glm::vec3 Tangent(size_t i, size_t from) const
+	{
+		size_t a = i ? i - 1 : i, b = i + 1 < _keys.size() ? i + 1 : i;	// The neighbours (the ends reuse themselves)
+		float span = _keys[b].time - _keys[a].time;
+		return span > 0.0f ? (_keys[b].position - _keys[a].position) * ((_keys[from + 1].time - _keys[from].time) / span) : glm::vec3(0.0f);
+	}
+
+public:
+	inline CameraTrack(unsigned int type = TRACK_SMOOTH) : _type(type) {}
+
+	inline void SetType(unsigned int type) { _type = type; }	// Assign how keys are blended
+	inline void Clear() { _keys.clear(); }	// Remove every keyframe
+	inline size_t NumKeyframes() const { return _keys.size(); }		// Return the keyframe count
+	inline float GetDuration() const { return _keys.empty() ? 0.0f : _keys.back().time; }	// Return the time of the last keyframe
+
+	// Adds a keyframe, keeping the rotations on one hemisphere so blends take the short way round
+	inline void AddKeyframe(float time, const glm::vec3 &position, const glm::quat &rotation, float fov)
+	{
+		Keyframe key = { time, position, glm::normalize(rotation), fov };
+		std::vector<Keyframe>::iterator at = std::upper_bound(_keys.begin(), _keys.end(), key, [](const Keyframe &a, const Keyframe &b) { return a.time < b.time; });
+		at = _keys.insert(at, key);
+		for (std::vector<Keyframe>::iterator k = (at == _keys.begin() ? at + 1 : at); k != _keys.end(); ++k)	// Re-align from the new key on
+			if (glm::dot((k - 1)->rotation, k->rotation) < 0.0f)
+				k->rotation = -k->rotation;
+	}
+
+	// Adds a keyframe from a camera's current pose
+	inline void AddKeyframe(float time, Camera &camera)
+	{
+		AddKeyframe(time, camera.GetPosition(), Rotation(camera.GetFront(), camera.GetUp()), camera.GetFov());
+	}
+
+	// Returns the rotation whose +z is 'front' and +y is as close to 'up' as possible
+	static inline glm::quat Rotation(const glm::vec3 &front, const glm::vec3 &up)
+	{
+		glm::vec3 z = glm::normalize(front);
+		glm::vec3 x = glm::normalize(glm::cross(up, z));
+		return glm::quat_cast(glm::mat3(x, glm::cross(z, x), z));
+	}
+
+	// Samples the track at a time (clamped to its keys), returns false if it has none
+	inline bool Sample(float time, glm::vec3 &position, glm::quat &rotation, float &fov) const
+	{
+		if (_keys.empty())	// If there's nothing to sample...
+			return false;	// Return false as failed
+		if (_keys.size() == 1)	// A single key holds
+		{
+			position = _keys[0].position;
+			rotation = _keys[0].rotation;
+			fov = _keys[0].fov;
+			return true;
+		}
+
+		float u;	// Fraction through the segment
+		size_t i = Locate(time, u);
+		const Keyframe &a = _keys[i], &b = _keys[i + 1];	// Its keys
+		fov = a.fov + (b.fov - a.fov) * u;
+		if (_type == TRACK_SMOOTH)
+		{
+			position = Spline::Segment::Hermite(a.position, Tangent(i, i), b.position, Tangent(i + 1, i)).Position(u);
+			const glm::quat &before = _keys[i ? i - 1 : i].rotation, &after = _keys[i + 2 < _keys.size() ? i + 2 : i + 1].rotation;
+			rotation = glm::normalize(glm::squad(a.rotation, b.rotation, glm::intermediate(before, a.rotation, b.rotation), glm::intermediate(a.rotation, b.rotation, after), u));
+		}
+		else
+		{
+			position = a.position + (b.position - a.position) * u;
+			rotation = glm::slerp(a.rotation, b.rotation, u);
+		}
+		return true;	// Return success
+	}
+
+	// Moves a camera to the track's pose at a time (its matrices follow on its next Update)
+	inline bool Apply(float time, Camera &camera) const
+	{
+		glm::vec3 position;
+		glm::quat rotation;
+		float fov;
+		if (!Sample(time, position, rotation, fov))		// If there's no pose...
+			return false;	// Return false as failed
+
+		glm::vec3 front = rotation * glm::vec3(0.0f, 0.0f, 1.0f), up = rotation * glm::vec3(0.0f, 1.0f, 0.0f);
+		camera.SetPosition(position);
+		camera.SetFront(front);
+		camera.SetUp(up);
+		camera.SetRight(glm::normalize(glm::cross(front, up)));
+		float yaw = glm::degrees(std::atan2(front.z, front.x));		// Keep the mouse angles in step, or the next move snaps back
+		camera.SetYaw(yaw < 0.0f ? yaw + 360.0f : yaw);
+		camera.SetPitch(glm::degrees(std::asin(glm::clamp(front.y, -1.0f, 1.0f))));
+		camera.SetFov(fov);
+		camera.UpdateProjectionMatrix();
+		return true;	// Return success
+	}
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "Timer.h"
 #include "Texture.h"
+#include "SpriteAtlas.h"
 #include "SoundCue.h"
 #include "SoundMaster.h"
 
@@ -49,25 +50,7 @@ public:
 	
 	unsigned int addFrame(const char * file)
 	{
-		unsigned int id;
-
-		int width;
-		int height;
-		int nr_comp;
-
-		unsigned char* data = stbi_load(file, &width, &height, &nr_comp, 0);
-
-		glGenTextures(1, &id);
-		glBindTexture(GL_TEXTURE_2D, id);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-		return id;
+		return SpriteAtlas::Get(SPRITE_ATLAS_EFFECTS)->Add(file);	// The frame's region in the effects atlas
 	}
 
 	inline virtual void Update(double delta) = 0;
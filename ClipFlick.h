@@ -14,6 +14,8 @@ private:
 
 	uniform _u_texture;
 	uniform _u_model;
+	uniform _u_frame_rect;
+	uniform _u_frame_layer;
 
 	std::vector<unsigned int> _frames;
 public:
@@ -38,6 +40,8 @@ public:
 
 		_u_model = glGetUniformLocation(shader_program, "model");
 		_u_texture = glGetUniformLocation(shader_program, "screenTexture");
+		_u_frame_rect = glGetUniformLocation(shader_program, "frame_rect");
+		_u_frame_layer = glGetUniformLocation(shader_program, "frame_layer");
 
 		_pos = glm::vec3(0.0f, 0.0f, 0.0f);
 		_sca = glm::vec3(1.0f, 1.0f, 1.0f);
@@ -70,10 +74,10 @@ public:
 		glUniformMatrix4fv(_u_model, 1, GL_FALSE, glm::value_ptr(mod));
 		glUniform1i(_u_texture, 0);
 
-		glActiveTexture(GL_TEXTURE0);
+		SpriteAtlas* atlas = SpriteAtlas::Get(SPRITE_ATLAS_EFFECTS);	// Every frame lives in the effects atlas
 
-		_isLooping == true ? glBindTexture(GL_TEXTURE_2D, _frames[(int)_timer->seconds() % _nr_frames]) 
-			: glBindTexture(GL_TEXTURE_2D, _frames[(int)_timer->seconds()]);
+		_isLooping == true ? atlas->Use(_frames[(int)_timer->seconds() % _nr_frames], 0, _u_frame_rect, _u_frame_layer)
+			: atlas->Use(_frames[(int)_timer->seconds()], 0, _u_frame_rect, _u_frame_layer);
 
 		_screen_rect->Render(1);
 	}
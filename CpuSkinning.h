@@ -0,0 +1,226 @@
+#ifndef __CPU_SKINNING_H__
+#define __CPU_SKINNING_H__
+
+#include <vector>	// Get dynamic array
+#include <cmath>	// Get sqrt
+#include <algorithm>	// Get max
+#include <cstdint>	// Get fixed size integers
+#include <glm/glm.hpp>	// Get glm variables
+#include "VertexBoneData.h"		// Get the packed weights
+#include "Parallel.h"	// Get the job pool
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>	// Get SSE2
+#define CPU_SKINNING_SIMD 1		// Blend whole matrix columns at a time
+#endif
+
+#define CPU_SKINNING_GRAIN	1024	// Vertices per job
+
+// Skinning on the CPU, for what can't read back the skinning shader: hit tests against animated characters and
+// servers without a GPU. The kernels read the cooked PackedBoneData and a palette as AnimSystem / AnimRuntime
+// produce it, and write deformed positions and normals into caller buffers in parallel.
+// LINEAR matches the shader (the weighted sum of the bone matrices); DUAL_QUATERNION blends rigid transforms instead,
+// which keeps volume at twisting joints but ignores any scale in the palette
+namespace CpuSkinning
+{
+	// How bone transforms are blended
+	enum Method
+	{
+		LINEAR,
+		DUAL_QUATERNION
+	};
+
+	// A rigid transform as a unit dual quaternion, both parts stored x, y, z, w
+	struct DualQuat
+	{
+		glm::vec4	real;	// The rotation
+		glm::vec4	dual;	// Half the translation times the rotation
+	};
+
+	// Converts an affine matrix to a dual quaternion (the columns are normalised, so scale is dropped)
+	inline DualQuat ToDualQuat(const glm::mat4 &m)
+	{
+		glm::vec3 x = glm::normalize(glm::vec3(m[0])), y = glm::normalize(glm::vec3(m[1])), z = glm::normalize(glm::vec3(m[2]));	// The rotation
+		glm::vec4 q;	// The rotation quaternion
+		float trace = x.x + y.y + z.z;	// Pick the largest component to divide by
+		if (trace > 0.0f)
+		{
+			float s = std::sqrt(trace + 1.0f) * 2.0f;
+			q = glm::vec4((y.z - z.y) / s, (z.x - x.z) / s, (x.y - y.x) / s, 0.25f * s);
+		}
+		else if (x.x > y.y && x.x > z.z)
+		{
+			float s = std::sqrt(1.0f + x.x - y.y - z.z) * 2.0f;
+			q = glm::vec4(0.25f * s, (y.x + x.y) / s, (z.x + x.z) / s, (y.z - z.y) / s);
+		}
+		else if (y.y > z.z)
+		{
+			float s = std::sqrt(1.0f + y.y - x.x - z.z) * 2.0f;
+			q = glm::vec4((y.x + x.y) / s, 0.25f * s, (z.y + y.z) / s, (z.x - x.z) / s);
+		}
+		else
+		{
+			float s = std::sqrt(1.0f + z.z - x.x - y.y) * 2.0f;
+			q = glm::vec4((z.x + x.z) / s, (z.y + y.z) / s, 0.25f * s, (x.y - y.x) / s);
+		}
+		q /= glm::length(q);
+
+		glm::vec3 t(m[3]), v(q);	// The translation and the rotation's axis part
+		DualQuat out;	// The result
+		out.real = q;
+		out.dual = 0.5f * glm::vec4(q.w * t + glm::cross(t, v), -glm::dot(t, v));
+		return out;		// Return it
+	}
+
+	// Applies a (normalised) dual quaternion to a point / direction
+	inline glm::vec3 TransformPoint(const DualQuat &d, const glm::vec3 &p)
+	{
+		glm::vec3 r(d.real), e(d.dual);		// The vector parts
+		glm::vec3 rotated = p + 2.0f * glm::cross(r, glm::cross(r, p) + d.real.w * p);
+		return rotated + 2.0f * (d.real.w * e - d.dual.w * r + glm::cross(r, e));
+	}
+	inline glm::vec3 TransformVector(const DualQuat &d, const glm::vec3 &n)
+	{
+		glm::vec3 r(d.real);	// The vector part
+		return n + 2.0f * glm::cross(r, glm::cross(r, n) + d.real.w * n);
+	}
+
+	// Linear blend skins 'count' vertices starting at 'first'. 'normals' / 'out_normals' may be NULL
+	inline void SkinLinear(const glm::mat4* palette, uint32_t num_bones, const glm::vec3* positions, const glm::vec3* normals,
+		const PackedBoneData* bones, size_t first, size_t count, glm::vec3* out_positions, glm::vec3* out_normals)
+	{
+		for (size_t v = first; v < first + count; v++)	// For each vertex...
+		{
+			const PackedBoneData &b = bones[v];		// Its influences
+#ifdef CPU_SKINNING_SIMD
+			__m128 c0 = _mm_setzero_ps(), c1 = _mm_setzero_ps(), c2 = _mm_setzero_ps(), c3 = _mm_setzero_ps();	// The blended columns
+			for (int i = 0; i < NUM_BONES_PER_VERTEX; i++)
+			{
+				const float* m = &palette[b.IDs[i] < num_bones ? b.IDs[i] : 0][0][0];	// The bone's matrix
+				__m128 w = _mm_set1_ps(b.Weights[i] * (1.0f / 255.0f));
+				c0 = _mm_add_ps(c0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+				c1 = _mm_add_ps(c1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+				c2 = _mm_add_ps(c2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+				c3 = _mm_add_ps(c3, _mm_mul_ps(w, _mm_loadu_ps(m + 12)));
+			}
+
+			float r[4];		// A lane for the store
+			const glm::vec3 &p = positions[v];
+			_mm_storeu_ps(r, _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(p.x)), _mm_mul_ps(c1, _mm_set1_ps(p.y))),
+				_mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(p.z)), c3)));
+			out_positions[v] = glm::vec3(r[0], r[1], r[2]);
+			if (normals && out_normals)
+			{
+				const glm::vec3 &n = normals[v];
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(n.x)), _mm_mul_ps(c1, _mm_set1_ps(n.y))), _mm_mul_ps(c2, _mm_set1_ps(n.z)));
+				__m128 sq = _mm_mul_ps(d, d);	// Normalise it in the register
+				__m128 len = _mm_add_ss(_mm_add_ss(sq, _mm_shuffle_ps(sq, sq, 1)), _mm_shuffle_ps(sq, sq, 2));
+				len = _mm_sqrt_ss(_mm_max_ss(len, _mm_set_ss(1e-20f)));
+				_mm_storeu_ps(r, _mm_div_ps(d, _mm_shuffle_ps(len, len, 0)));
+				out_normals[v] = glm::vec3(r[0], r[1], r[2]);
+			}
+#else
+			glm::mat4 m(0.0f);	// The blended matrix
+			for (int i = 0; i < NUM_BONES_PER_VERTEX; i++)
+				m += palette[b.IDs[i] < num_bones ? b.IDs[i] : 0] * (b.Weights[i] * (1.0f / 255.0f));
+			out_positions[v] = glm::vec3(m * glm::vec4(positions[v], 1.0f));
+			if (normals && out_normals)
+				out_normals[v] = glm::normalize(glm::vec3(m * glm::vec4(normals[v], 0.0f)));
+#endif
+		}
+	}
+
+	// Dual quaternion skins 'count' vertices starting at 'first'. 'normals' / 'out_normals' may be NULL
+	inline void SkinDualQuat(const DualQuat* palette, uint32_t num_bones, const glm::vec3* positions, const glm::vec3* normals,
+		const PackedBoneData* bones, size_t first, size_t count, glm::vec3* out_positions, glm::vec3* out_normals)
+	{
+		for (size_t v = first; v < first + count; v++)	// For each vertex...
+		{
+			const PackedBoneData &b = bones[v];		// Its influences
+			const DualQuat &pivot = palette[b.IDs[0] < num_bones ? b.IDs[0] : 0];	// Blend on the first bone's hemisphere
+			DualQuat d;		// The blend
+#ifdef CPU_SKINNING_SIMD
+			__m128 real = _mm_setzero_ps(), dual = _mm_setzero_ps();
+			for (int i = 0; i < NUM_BONES_PER_VERTEX; i++)
+			{
+				const DualQuat &q = palette[b.IDs[i] < num_bones ? b.IDs[i] : 0];
+				float w = b.Weights[i] * (1.0f / 255.0f);
+				w = glm::dot(q.real, pivot.real) < 0.0f ? -w : w;	// Take the short way round
+				__m128 vw = _mm_set1_ps(w);
+				real = _mm_add_ps(real, _mm_mul_ps(vw, _mm_loadu_ps(&q.real.x)));
+				dual = _mm_add_ps(dual, _mm_mul_ps(vw, _mm_loadu_ps(&q.dual.x)));
+			}
+			__m128 sq = _mm_mul_ps(real, real);		// Normalise both parts by the real one's length
+			sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+			sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+			__m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(sq, _mm_set1_ps(1e-20f))));
+			_mm_storeu_ps(&d.real.x, _mm_mul_ps(real, inv));
+			_mm_storeu_ps(&d.dual.x, _mm_mul_ps(dual, inv));
+#else
+			d.real = d.dual = glm::vec4(0.0f);
+			for (int i = 0; i < NUM_BONES_PER_VERTEX; i++)
+			{
+				const DualQuat &q = palette[b.IDs[i] < num_bones ? b.IDs[i] : 0];
+				float w = b.Weights[i] * (1.0f / 255.0f);
+				w = glm::dot(q.real, pivot.real) < 0.0f ? -w : w;	// Take the short way round
+				d.real += q.real * w;
+				d.dual += q.dual * w;
+			}
+			float inv = 1.0f / std::sqrt(std::max(glm::dot(d.real, d.real), 1e-20f));
+			d.real *= inv;
+			d.dual *= inv;
+#endif
+			out_positions[v] = TransformPoint(d, positions[v]);
+			if (normals && out_normals)
+				out_normals[v] = glm::normalize(TransformVector(d, normals[v]));
+		}
+	}
+
+	// Skins 'count' vertices into the output buffers across the job pool. 'palette' holds 'num_bones' skinning
+	// matrices; 'normals' / 'out_normals' may be NULL when only positions are wanted
+	inline void Skin(Method method, const glm::mat4* palette, uint32_t num_bones, const glm::vec3* positions, const glm::vec3* normals,
+		const PackedBoneData* bones, size_t count, glm::vec3* out_positions, glm::vec3* out_normals)
+	{
+		if (!count || !num_bones)	// If there's nothing to skin...
+			return;		// Return as normal
+
+		if (method == DUAL_QUATERNION)
+		{
+			std::vector<DualQuat> quats(num_bones);		// Convert the palette once
+			for (uint32_t i = 0; i < num_bones; i++)
+				quats[i] = ToDualQuat(palette[i]);
+			const DualQuat* q = quats.data();
+			Parallel::Jobs().For(0, count, CPU_SKINNING_GRAIN, [=](size_t from, size_t to)
+			{
+				SkinDualQuat(q, num_bones, positions, normals, bones, from, to - from, out_positions, out_normals);
+			});
+		}
+		else
+			Parallel::Jobs().For(0, count, CPU_SKINNING_GRAIN, [=](size_t from, size_t to)
+			{
+				SkinLinear(palette, num_bones, positions, normals, bones, from, to - from, out_positions, out_normals);
+			});
+	}
+
+	// Returns the distance along a ray to a triangle, or a negative value if it misses
+	inline float IntersectRayTriangle(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+	{
+		glm::vec3 e1 = b - a, e2 = c - a;	// The edges
+		glm::vec3 p = glm::cross(direction, e2);
+		float det = glm::dot(e1, p);
+		if (std::fabs(det) < 1e-12f)	// If the ray runs along the triangle...
+			return -1.0f;
+		float inv = 1.0f / det;
+		glm::vec3 s = origin - a;
+		float u = glm::dot(s, p) * inv;
+		if (u < 0.0f || u > 1.0f)
+			return -1.0f;
+		glm::vec3 q = glm::cross(s, e1);
+		float v = glm::dot(direction, q) * inv;
+		if (v < 0.0f || u + v > 1.0f)
+			return -1.0f;
+		return glm::dot(e2, q) * inv;	// Return the distance
+	}
+}
+
+#endif
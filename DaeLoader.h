@@ -1,447 +1,725 @@
 #ifndef __DAE_LOADER_H__
 #define __DAE_LOADER_H__
 
+#include <iostream>		// Get error output
 #include <fstream>	// Include file stream functionality
 #include <string>	// Include string for char manipulation
-#include <iterator>		// Get iterator functions
-#include <sstream>	// Include sstream for string manipulation
+#include <string_view>	// Include string views for zero-copy tokens
+#include <charconv>		// Include from_chars for fast number parsing
+#include <unordered_map>	// Include hash maps for id lookups
+#include <algorithm>	// Get sort / min
+#include <glm/gtc/matrix_transform.hpp>		// Get translate / rotate / scale
 #include "VertexData.h"		// Get access to the vertex data struct
 #include "AnimData.h"	// Include anim data structs
-
-#define GEOMETRY_VERTEX			0	// Geometry vertex positions, normals and texcoords
-#define GEOMETRY_INDEX			1	// Geometry index data for each vertex
-#define JOINT_NAME				2	// Joint names (used for specifying ids)
-#define INVERSE_BIND_MATRIX		3	// Joint inverse bind matrices (used to calculate in local coords)
-#define WEIGHT_VALUE			4	// Weight values (used to determin the intensity of the skinning information)
-#define VERTEX_WEIGHT			5	// Vertex weight data (used to point out the amount of weights / joints affecting each vertex)
-#define ANIMATION				6	// Animation data (used to determin each matrix position at a given time frame for each joint)
-#define HIERARCHY				7	// Hierarchy data (used to determin the joint structure between children and parent information)
+#include "Parallel.h"	// Get parallel loops for large arrays
+#include "Vfs.h"	// Read through the content archive
 
 #define MAX_WEIGHTS				3	// Each vertex can only be affected by a maximum of up to three weights
-#define MAX_JOINTS				32	// Each vao can hold a maximum of up to 32 joints
+
+#define DAE_PARALLEL_ARRAY_BYTES	(256 * 1024)	// Number arrays with more text than this are parsed across all cores
 
 
 // This namespace will store all the functions needed to load the key data from a .dae file
 namespace DaeLoader
 {
-	// A struct for containing the weight vertex data
-	struct WeightVertexList
-	{
-		std::vector<glm::ivec3> _joint_indices;	// A list of joint indices
-		std::vector<glm::ivec3> _weight_indices;	// A list of weight indices
+	// Returns true for xml whitespace
+	inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
 
-		// Default constructor
-		inline WeightVertexList() {}
+	// The events produced by the xml reader
+	enum XmlToken
+	{
+		XML_EOF,	// End of the document
+		XML_START,	// A start tag (self closing tags are followed by a matching XML_END)
+		XML_END,	// An end tag
+		XML_TEXT	// A run of character data that isn't only whitespace
 	};
 
-
-	// This will load all of the vertex data for the geometry
-	static inline void Import(const char* uri, VertexData& out_vertex_data, AnimData& out_anim_data)
+	// A pull (SAX style) xml tokenizer over a document in memory. Names, attributes and text are returned
+	// as views into the document so nothing is copied, and it doesn't care how the file is laid out across lines
+	class XmlReader
 	{
-		FILE*			file;	// The file object
-		std::string		line;	// String for current line
+	private:
+		const char*			_cur;	// The read position
+		const char*			_end;	// The end of the document
+		std::string_view	_name;	// The current element name
+		std::string_view	_attribs;	// The raw attribute text of the current start tag
+		std::string_view	_text;	// The current text run
+		bool				_self_closing;	// Whether the current start tag closes itself
+
+		inline bool StartsWith(const char* s) const
+		{
+			const char* p = _cur;	// Compare from the read position
+			for (; *s; s++, p++)	// For each character...
+				if (p >= _end || *p != *s)	// If it doesn't match...
+					return false;	// Return false
+			return true;	// Return true
+		}
 
-		if (fopen_s(&file, uri, "r") != 0)		// If file failed to open...
+		inline void SkipPast(const char* s)
 		{
-			std::cout << "Error: Failed to open file!\n";	// Print out error message
-			return;		// Return as normal
+			std::string_view rest(_cur, _end - _cur);	// The unread document
+			size_t at = rest.find(s);	// Find the terminator
+			_cur = at == std::string_view::npos ? _end : _cur + at + std::char_traits<char>::length(s);	// Move past it
 		}
 
-		bool						begin_scan = false;	// A bool for checking when to start extracting data
-		int							current_scan = -1;		// A count for each line extraction
-		int							current_anim = -1;	// Current joint anim
-		unsigned int				state = 0;	// A state system for checking key data
-		unsigned int				count = 0;		// Num variables
-		unsigned int				stride = 0;		// Stride for each attribute
-		unsigned int				count_div_stride = 0;	// The total lines for extraction
-		unsigned int				vertex_state = 0;	// State of vertex extraction
-		unsigned int				i_0 = 0;	// Start point before buffer
-		unsigned int				i_1 = 0; 	// End point before buffer
-		unsigned int				len = 0;	// Length of buffer
-		VertexData					vd = VertexData();		// A temp variable for our vertex data
-		AnimData					ad = AnimData();		// A temp variable for our anim data
-		std::ifstream				file_stream(uri);	// Create an ifstream for reading file
-
-		std::vector<std::string>	temp_values;	// For conversion purposes
-
-		std::vector<glm::mat4x4>	inverse_bind_matrices;		// The joint inverse bind matrices in order
-		std::vector<glm::mat4x4>	joint_matrices;		// The joint inverse bind matrices in order
-		std::vector<std::string>	joint_names;	// Temp container to get each joint name
-		std::vector<float>			weights;	// The weight values
-		std::vector<unsigned int>	vcount;	// The weight index data for each vertex
-		
-		Joint						root_joint;		// The joint data for skeletal heirarchy
-		WeightVertexList			weight_vertices;	// The weight vertex list data for each position
-		std::vector<JointAnim>		joint_anims;	// The animation data for each joint
-
-		while (std::getline(file_stream, line))		// Iterate through each line
+	public:
+		// Initial constructor
+		inline XmlReader(const char* data, size_t size) : _cur(data), _end(data + size), _self_closing(false) {}
+
+		inline std::string_view Name() const { return _name; }	// Return the current element name
+		inline std::string_view Text() const { return _text; }	// Return the current text run
+
+		// Returns the value of an attribute on the current start tag (empty if it's missing)
+		inline std::string_view Attribute(std::string_view key) const
 		{
-			if (begin_scan)	// If this line is ready for extraction...
+			const char* p = _attribs.data();	// Attribute read position
+			const char* e = p + _attribs.size();	// Attribute end
+
+			while (p < e)	// While there are attributes left...
 			{
-				current_scan++;	// Increment the current line index
+				while (p < e && IsSpace(*p)) p++;	// Skip whitespace
+				const char* n = p;	// Name start
+				while (p < e && *p != '=' && !IsSpace(*p)) p++;		// Find the name end
+				std::string_view name(n, p - n);	// The attribute name
+				while (p < e && (IsSpace(*p) || *p == '=')) p++;	// Skip to the value
+				if (p >= e || (*p != '"' && *p != '\''))	// If the value isn't quoted...
+					break;	// The tag is malformed
+				char quote = *p++;	// Remember the quote type
+				const char* v = p;	// Value start
+				while (p < e && *p != quote) p++;	// Find the closing quote
+				if (name == key)	// If this is the attribute we want...
+					return std::string_view(v, p - v);	// Return its value
+				if (p < e) p++;		// Skip the closing quote
+			}
 
-				if (state == GEOMETRY_VERTEX)	// If we're in the state of extracting vertex data...
-				{
-					glm::vec3 v = glm::vec3(0.0f);	// Temp vertex container
+			return std::string_view();	// Return nothing by default
+		}
 
-					if (static_cast<unsigned int>(current_scan) < (count / stride))	// If the current scan index is less than the N of vertices divided by stride...
-					{
-						if (vertex_state == 0)	// If vertex type POSITIONS
-						{
-							sscanf_s(line.c_str(), "%f %f %f", &v.x, &v.y, &v.z);	// Get line buffer and store data to temp variables
-							vd.positions.push_back(glm::vec3(v.x, v.y, v.z));	// Add a position vertex using temp variable values
-						}
-						else if (vertex_state == 1)	// If vertex type NORMALS
-						{
-							sscanf_s(line.c_str(), "%f %f %f", &v.x, &v.y, &v.z);	// Get line buffer and store data to temp variables
-							vd.normals.push_back(glm::vec3(v.x, v.y, v.z));	// Add a position vertex using temp variable values
-						}
-						else if (vertex_state == 2)	// If vertex type TEXCOORDS
+		// Advances to the next start tag, end tag or text run
+		inline XmlToken Next()
+		{
+			if (_self_closing)	// If the last tag closed itself...
+			{
+				_self_closing = false;	// Consume it
+				_attribs = std::string_view();	// Attributes belong to start tags only
+				return XML_END;		// Report the matching end tag
+			}
+
+			while (_cur < _end)		// While there is document left...
+			{
+				if (*_cur != '<')	// If this is character data...
+				{
+					const char* t = _cur;	// Text start
+					while (_cur < _end && *_cur != '<') _cur++;		// Find the next tag
+					for (const char* c = t; c < _cur; c++)	// Check the text...
+						if (!IsSpace(*c))	// If any of it isn't whitespace...
 						{
-							sscanf_s(line.c_str(), "%f %f", &v.x, &v.y);	// Get line buffer and store data to temp variables
-							vd.texcoords.push_back(glm::vec3(v.x, v.y, 0.0f));	// Add a position vertex using temp variable values
+							_text = std::string_view(t, _cur - t);	// Record it
+							return XML_TEXT;	// Return the text
 						}
-					}
-					else	// If the current scan exceeds the N of vertics...
-					{
-						current_scan = -1;	// Reset the current scan count
-						begin_scan = false;	// Stop extraction
-
-						if (vertex_state >= 2)	// If the vertex state has finished...
-							state++;	// Go to next state
-						else	// If vertex state has NOT finished...
-							vertex_state++;		// Skip to next vertex state
-					}
+					continue;	// Otherwise ignore the whitespace
 				}
-				else if (state == JOINT_NAME)	// Extract joint name data
+
+				if (StartsWith("<!--")) { SkipPast("-->"); continue; }	// Skip comments
+				if (StartsWith("<![CDATA["))	// If this is raw character data...
 				{
-					std::stringstream ss(line);	// Create string stream for maniplulation
-					std::copy(std::istream_iterator<std::string>(ss), std::istream_iterator<std::string>(), std::back_inserter(joint_names));	// Iterate through each string usign stream and store in vector list
+					const char* t = _cur + 9;	// Text start
+					SkipPast("]]>");	// Move past it
+					_text = std::string_view(t, std::max<ptrdiff_t>(0, (_cur - 3) - t));	// Record it
+					return XML_TEXT;	// Return the text
+				}
+				if (StartsWith("<?") || StartsWith("<!")) { SkipPast(">"); continue; }	// Skip declarations
 
-					unsigned int i;
-					for (i = 0; i < 13; i++)	// Get the last 13 characters we don't need
-						joint_names[joint_names.size() - 1].pop_back();		// Delete the unwanted chars
+				bool closing = StartsWith("</");	// Is this an end tag?
+				_cur += closing ? 2 : 1;	// Move past the bracket
+				const char* n = _cur;	// Name start
+				while (_cur < _end && !IsSpace(*_cur) && *_cur != '>' && *_cur != '/') _cur++;	// Find the name end
+				_name = std::string_view(n, _cur - n);	// Record the name
 
-					current_scan = -1;	// Reset the current scan count
-					begin_scan = false;	// Start extraction
-					state++;	// Go to next state
-				}
-				else if (state == INVERSE_BIND_MATRIX)	// Extract joint inverse bind matrix data
+				const char* a = _cur;	// Attribute start
+				char quote = 0;		// The open quote, if any
+				while (_cur < _end && (quote || *_cur != '>'))	// Find the end of the tag (ignoring '>' inside values)
 				{
-					if (static_cast<unsigned int>(current_scan) < (count / stride) + 1)	// If the current scan index is less than the N of vertices divided by stride...
-					{
-						if (current_scan > 0)	// Skip the empty line before scanning
-						{
-							glm::mat4x4	m = glm::mat4x4(0.0f);		// A temp inverse matrix
-							sscanf_s(line.c_str(), "%f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f",	&m[0][0], &m[1][0], &m[2][0], &m[3][0],
-																										&m[0][1], &m[1][1], &m[2][1], &m[3][1],
-																										&m[0][2], &m[1][2], &m[2][2], &m[3][2],
-																										&m[0][3], &m[1][3], &m[2][3], &m[3][3]);	// Get line buffer and store data to temp variables
-
-							inverse_bind_matrices.push_back(m);	// Add an inverse bind matrix using temp variable values
-						}
-					}
-					else
-					{
-						current_scan = -1;	// Reset the current scan count
-						begin_scan = false;	// Start extraction
-						state++;	// Go to next state
-					}
+					if (quote) { if (*_cur == quote) quote = 0; }	// Close the value
+					else if (*_cur == '"' || *_cur == '\'') quote = *_cur;	// Open a value
+					_cur++;		// Next character
 				}
-				else if (state == WEIGHT_VALUE)	// Extract weight data
-				{
-					if (current_scan > 0)	// Skip the empty line
-					{
-						if (static_cast<unsigned int>(current_scan) < count + 1)	// If the current scan is greater than count plus 1 offset...
-						{
-							std::stringstream ss(line);	// Create string stream for maniplulation
-
-							for (unsigned int i = 0; i < stride; i++)	// Iterate through 16 times for each line
-							{
-								float temp_value = 0.0f;	// Create a temp weight var
-								ss >> temp_value;	// Get next index in stream
-								weights.push_back(temp_value);	// Add a weight to the weight container
-							}
-						}
-						else
-						{
-							unsigned int num_chars = 15;	// The amount of unwanted chars
-							for (unsigned int i = 0; i < num_chars; i++)	// Iterate 15 times
-								weights.pop_back();		// Remove unwanted "</float_array>" 
+				const char* ae = _cur;	// Attribute end
+				if (_cur < _end) _cur++;	// Move past the bracket
 
-							current_scan = -1;	// Reset the current scan count
-							begin_scan = false;	// Start extraction
-							state++;	// Go to next state
-						}
-					}
-				}
-				else if (state == ANIMATION)	// Extract weight data
+				if (closing)	// If this is an end tag...
 				{
-					if (current_scan > 0)	// Skip the empty line
-					{
-						if (joint_anims[current_anim]._time_stamps.size() != count)		// IF we haven't finished getting input array...
-						{
-							if (static_cast<unsigned int>(current_scan) < count_div_stride + 1)	// If the current scan is greater than count plus 1 offset...
-							{
-								std::stringstream ss(line);	// Create string stream for maniplulation
-
-								for (unsigned int i = 0; i < stride; i++)	// Iterate through 16 times for each line
-								{
-									float temp_value = 0.0f;	// Create a temp weight var
-									ss >> temp_value;	// Get next index in stream
-									joint_anims[current_anim]._time_stamps.push_back(temp_value);	// Add a weight to the weight container
-								}
-							}
-							else
-							{
-								unsigned int i = 0;		// A temp iterator index
-								unsigned int zeros = 0;		// A temp variable for checking the amount of zeros
-								for (i = 0; i < joint_anims[current_anim]._time_stamps.size(); i++)	// Iterate 15 times
-								{
-									if (joint_anims[current_anim]._time_stamps[i] == 0.0f)	// If we found an unwanted zero value...
-										zeros++;	// Count it
-								}
-
-								for (i = 0; i < zeros; i++)		// For the amount of zeros found...
-									joint_anims[current_anim]._time_stamps.pop_back();	// Remove them
-
-								current_scan = 0;	// Reset the current scan count
-							}
-						}
-						else	// Otherwise get the output array
-						{
-							
-							if (static_cast<unsigned int>(current_scan) < count + 1)	// If the current scan is greater than count plus 1 offset...
-							{
-								std::string temp_float;		// Create temp float value
-								std::stringstream ss(line);	// Create string stream for maniplulation		
-								for (unsigned int i = 0; i < stride; i++)	// Iterate through each stride
-								{
-									ss >> temp_float;	// Get current float to temp value
-									temp_values.push_back(temp_float);	// Store value to temp_values container
-								}									
-							}
-							else	// When finished scanning...
-							{
-								unsigned int i;		// Index iterator
-								unsigned int num_chars = 41;	// The amount of unwanted chars
-								for (i = 0; i < num_chars; i++)	// Iterate through the number of unwanted chars
-									temp_values[temp_values.size() - 1].pop_back();		// Remove the unwanted chars in last temp_value
-
-								for (i = 0; i != temp_values.size(); i += stride)	// Iterate through each stride of temp float values
-								{
-									// Convert the temp values and store the matrix data for the current join anim
-									joint_anims[current_anim]._matrices.push_back(glm::mat4x4(	std::stof(temp_values[i]), std::stof(temp_values[i+1]), std::stof(temp_values[i+2]), std::stof(temp_values[i+3]), 
-																								std::stof(temp_values[i+4]), std::stof(temp_values[i+5]), std::stof(temp_values[i+6]), std::stof(temp_values[i+7]),
-																								std::stof(temp_values[i+8]), std::stof(temp_values[i+9]), std::stof(temp_values[i+10]), std::stof(temp_values[i+11]),
-																								std::stof(temp_values[i+12]), std::stof(temp_values[+13]), std::stof(temp_values[i+14]), std::stof(temp_values[i+15])));
-								}
-								
-								temp_values.resize(0);	// Reset the temp char container
-								current_scan = -1;	// Reset the current scan count
-								begin_scan = false;	// Start extraction
-							}
-						}
-					}
+					_attribs = std::string_view();	// End tags have no attributes
+					return XML_END;		// Return it
 				}
+
+				_self_closing = ae > a && ae[-1] == '/';	// Check for <tag/>
+				_attribs = std::string_view(a, (ae - a) - (_self_closing ? 1 : 0));	// Record the attributes
+				return XML_START;	// Return it
 			}
 
+			return XML_EOF;		// Return end of document
+		}
+	};
+
+	// Parses whitespace separated numbers between p and e and appends them to out
+	template <typename T>
+	inline void ParseNumbers(const char* p, const char* e, std::vector<T> &out)
+	{
+		while (true)
+		{
+			while (p < e && IsSpace(*p)) p++;	// Skip whitespace
+			if (p >= e)		// If we've run out of text...
+				break;	// Stop
 
-			switch (state)	// Check for each search state
+			if (*p == '+') p++;		// from_chars doesn't accept a leading plus
+
+			T value = T();	// The parsed value
+			std::from_chars_result r = std::from_chars(p, e, value);	// Parse the number
+			if (r.ec != std::errc())	// If it isn't a number...
 			{
-			case GEOMETRY_VERTEX:	// Get VERTEX data
-				if ((vertex_state == 0) && (std::string::npos != line.find("-POSITION-array")))	// Find the start of POSITIONS
-				{
-					stride = 3;		// Set stride for POSITION attribute
-					len = line.find(">") - line.find("t=") - 4;	// Calculate the buffer size of count value
-					count = std::stoi(line.substr(line.find("t=") + 3, len));	// Convert count to int
+				while (p < e && !IsSpace(*p)) p++;	// Skip the token
+				value = T();	// Keep the array aligned with a zero
+			}
+			else
+				p = r.ptr;	// Continue after the number
+
+			out.push_back(value);	// Record the value
+		}
+	}
+
+	// Parses a run of a number array onto the end of 'out' (an array split by a comment or CDATA arrives in several
+	// runs). Large runs are cut at whitespace and the pieces parsed in parallel
+	template <typename T>
+	inline void ParseArray(std::string_view text, std::vector<T> &out, size_t count_hint = 0)
+	{
+		out.reserve(count_hint);	// Reserve the declared count
+
+		const char* begin = text.data();	// Text start
+		const char* end = begin + text.size();		// Text end
+
+		if (text.size() < DAE_PARALLEL_ARRAY_BYTES)		// If the array is small...
+		{
+			ParseNumbers(begin, end, out);	// Parse it here
+			return;		// Return as normal
+		}
+
+		size_t num_pieces = Parallel::NumWorkers();		// One piece per worker
+		std::vector<const char*> cuts(num_pieces + 1, end);		// The piece boundaries
+		cuts[0] = begin;	// The first piece starts at the beginning
+
+		for (size_t k = 1; k < num_pieces; k++)		// For each inner boundary...
+		{
+			const char* c = std::max(cuts[k - 1], begin + text.size() * k / num_pieces);	// Approximate cut
+			while (c < end && !IsSpace(*c)) c++;	// Never cut a number in half
+			cuts[k] = c;	// Record it
+		}
+
+		std::vector<std::vector<T>> pieces(num_pieces);		// The parsed pieces
+		Parallel::For(0, num_pieces, 1, [&](size_t from, size_t to)
+		{
+			for (size_t k = from; k < to; k++)	// For each piece in range...
+			{
+				pieces[k].reserve((cuts[k + 1] - cuts[k]) / 4);		// Rough guess at the count
+				ParseNumbers(cuts[k], cuts[k + 1], pieces[k]);	// Parse it
+			}
+		});
+
+		for (std::vector<T> &piece : pieces)	// For each piece in order...
+			out.insert(out.end(), piece.begin(), piece.end());	// Append it
+	}
+
+	// Parses a whitespace separated list of names
+	inline void ParseNames(std::string_view text, std::vector<std::string> &out)
+	{
+		size_t i = 0;	// Read position
+		while (i < text.size())		// While there is text left...
+		{
+			while (i < text.size() && IsSpace(text[i])) i++;	// Skip whitespace
+			size_t n = i;	// Name start
+			while (i < text.size() && !IsSpace(text[i])) i++;	// Find the name end
+			if (i > n)	// If we found a name...
+				out.push_back(std::string(text.substr(n, i - n)));	// Record it
+		}
+	}
+
+	// Converts 16 row-major collada floats to a column-major matrix
+	inline glm::mat4x4 ToMatrix(const float* f)
+	{
+		glm::mat4x4 m;	// The result
+		for (unsigned int r = 0; r < 4; r++)	// For each row...
+			for (unsigned int c = 0; c < 4; c++)	// For each column...
+				m[c][r] = f[r * 4 + c];		// Transpose into glm layout
+		return m;	// Return the result
+	}
+
+	// Removes the leading '#' of a url reference
+	inline std::string Url(std::string_view ref)
+	{
+		return std::string(!ref.empty() && ref[0] == '#' ? ref.substr(1) : ref);	// Return the id
+	}
+
+	// Converts an attribute to an unsigned int (0 if missing)
+	inline unsigned int ToUInt(std::string_view s)
+	{
+		unsigned int value = 0;		// The result
+		std::from_chars(s.data(), s.data() + s.size(), value);	// Parse it
+		return value;	// Return the result
+	}
+
+	// A <source> array
+	struct Source
+	{
+		std::vector<float>			_floats;	// Float data
+		std::vector<std::string>	_names;		// Name / idref data
+		unsigned int				_stride;	// Values per element
+
+		inline Source() : _stride(1) {}
+	};
+
+	// An <input> of a primitive, skin or sampler
+	struct Input
+	{
+		std::string		_semantic;	// What the input is
+		std::string		_source;	// The source / vertices id
+		unsigned int	_offset;	// Offset inside each index tuple
+		unsigned int	_set;	// Set number (texcoord channel)
+	};
+
+	// A <node> of the visual scene
+	struct Node
+	{
+		int				_parent;	// Parent node index (-1 for scene roots)
+		bool			_is_joint;	// Whether the node is type="JOINT"
+		std::string		_id;	// Node id
+		std::string		_sid;	// Node sid
+		std::string		_name;	// Node name
+		glm::mat4x4		_matrix;	// Local transform
+	};
+
+	// The state gathered while walking the document
+	struct Document
+	{
+		std::unordered_map<std::string, Source>				_sources;	// All sources by id
+		std::unordered_map<std::string, std::vector<Input>>	_vertices;	// <vertices> inputs by id
+		std::unordered_map<std::string, std::vector<Input>>	_samplers;	// <sampler> inputs by id
+		std::vector<std::pair<std::string, std::string>>	_channels;	// (sampler id, target) pairs
+		std::vector<Node>									_nodes;		// Scene nodes in document order
+
+		std::string					_skin_geometry;		// The geometry the skin applies to
+		std::vector<Input>			_skin_joints;	// <joints> inputs
+		std::vector<Input>			_skin_weights;	// <vertex_weights> inputs
+		std::vector<unsigned int>	_skin_vcount;	// Influences per position
+		std::vector<int>			_skin_v;	// Influence index tuples
+		glm::mat4x4					_bind_shape;	// The skin's bind shape matrix
+
+		std::vector<unsigned int>	_out_positions;		// The position index behind each output vertex
+		std::vector<std::string>	_out_geometries;	// The geometry behind each output vertex
+
+		inline Document() : _bind_shape(1.0f) {}
+	};
+
+	// Hashes an index tuple of an output vertex
+	struct CornerKey
+	{
+		unsigned int	_p, _n, _t, _g;		// Position, normal, texcoord and primitive-group indices
+		inline bool operator==(const CornerKey &o) const { return _p == o._p && _n == o._n && _t == o._t && _g == o._g; }
+	};
+	struct CornerHash
+	{
+		inline size_t operator()(const CornerKey &k) const
+		{
+			size_t h = k._p;	// Start from the position index
+			h = h * 0x9E3779B1u ^ k._n;		// Mix in the normal
+			h = h * 0x9E3779B1u ^ k._t;		// Mix in the texcoord
+			return h * 0x9E3779B1u ^ k._g;	// Mix in the group
+		}
+	};
+
+	// Builds output vertices for a <triangles> / <polylist> / <polygons> block
+	inline void BuildPrimitive(Document &doc, const std::string &geometry, unsigned int group, const std::vector<Input> &inputs,
+		const std::vector<unsigned int> &vcount, const std::vector<unsigned int> &p, VertexData &out,
+		std::unordered_map<CornerKey, unsigned int, CornerHash> &corner_map)
+	{
+		const Source* positions = NULL;		// Position source
+		const Source* normals = NULL;	// Normal source
+		const Source* texcoords = NULL;		// Texcoord source
+		unsigned int p_off = 0, n_off = 0, t_off = 0, stride = 0;	// Offsets inside each index tuple
+
+		auto find = [&](const std::string &id) -> const Source*	// Source lookup
+		{
+			auto it = doc._sources.find(id);	// Find the id
+			return it == doc._sources.end() ? NULL : &it->second;	// Return it or null
+		};
 
-					if (std::string::npos != line.find(">"))	// Find the end of the line
-						begin_scan = true;	// Get ready to extract the next line of data
+		for (const Input &in : inputs)	// For each input...
+		{
+			stride = std::max(stride, in._offset + 1);	// Grow the tuple size
+			if (in._semantic == "VERTEX")	// If this references <vertices>...
+			{
+				for (const Input &v : doc._vertices[in._source])	// For each input of the vertices element...
+				{
+					if (v._semantic == "POSITION") { positions = find(v._source); p_off = in._offset; }
+					else if (v._semantic == "NORMAL") { normals = find(v._source); n_off = in._offset; }
+					else if (v._semantic == "TEXCOORD" && !texcoords) { texcoords = find(v._source); t_off = in._offset; }
 				}
+			}
+			else if (in._semantic == "NORMAL") { normals = find(in._source); n_off = in._offset; }
+			else if (in._semantic == "TEXCOORD" && (!texcoords || in._set == 0)) { texcoords = find(in._source); t_off = in._offset; }
+		}
+
+		if (!positions || !stride)	// If there's nothing to build...
+			return;		// Return as normal
+
+		size_t num_corners = p.size() / stride;		// The number of index tuples
+		std::vector<unsigned int> polygon_corners;	// Output vertex of each corner of the current polygon
+
+		auto emit = [&](size_t corner) -> unsigned int		// Creates (or reuses) the output vertex for a corner
+		{
+			const unsigned int* tuple = &p[corner * stride];	// The index tuple
+			CornerKey key = { tuple[p_off], normals ? tuple[n_off] : 0, texcoords ? tuple[t_off] : 0, group };	// Its key
+
+			auto it = corner_map.find(key);		// Check for a duplicate
+			if (it != corner_map.end())		// If we've already built it...
+				return it->second;	// Reuse it
+
+			glm::vec3 pos(0.0f), nrm(0.0f, 1.0f, 0.0f), uv(0.0f);	// The vertex attributes
+			size_t ps = positions->_stride;		// Position stride
+			if ((key._p + 1) * ps <= positions->_floats.size() && ps >= 3)
+				pos = glm::vec3(positions->_floats[key._p * ps], positions->_floats[key._p * ps + 1], positions->_floats[key._p * ps + 2]);
+			if (normals && normals->_stride >= 3 && (key._n + 1) * normals->_stride <= normals->_floats.size())
+			{
+				size_t ns = normals->_stride;	// Normal stride
+				nrm = glm::vec3(normals->_floats[key._n * ns], normals->_floats[key._n * ns + 1], normals->_floats[key._n * ns + 2]);
+			}
+			if (texcoords && texcoords->_stride >= 2 && (key._t + 1) * texcoords->_stride <= texcoords->_floats.size())
+			{
+				size_t ts = texcoords->_stride;		// Texcoord stride
+				uv = glm::vec3(texcoords->_floats[key._t * ts], texcoords->_floats[key._t * ts + 1], 0.0f);
+			}
+
+			unsigned int index = (unsigned int)out.positions.size();	// The new vertex index
+			out.positions.push_back(pos);	// Assign position data
+			out.normals.push_back(nrm);		// Assign normal data
+			out.texcoords.push_back(uv);	// Assign texcoord data
+			doc._out_positions.push_back(key._p);	// Remember the position for skinning
+			doc._out_geometries.push_back(geometry);	// Remember the geometry for skinning
+			corner_map.insert(std::make_pair(key, index));		// Record it
+			return index;	// Return it
+		};
+
+		size_t corner = 0;	// The next corner
+		size_t num_polygons = vcount.empty() ? num_corners / 3 : vcount.size();	// Triangles have an implicit vcount of 3
+		for (size_t poly = 0; poly < num_polygons; poly++)	// For each polygon...
+		{
+			size_t n = vcount.empty() ? 3 : vcount[poly];	// Its corner count
+			if (corner + n > num_corners)	// If the index data is truncated...
+				break;	// Stop
+
+			polygon_corners.clear();	// Start a new polygon
+			for (size_t k = 0; k < n; k++)	// For each of its corners...
+				polygon_corners.push_back(emit(corner + k));	// Build the output vertex
+
+			for (size_t k = 1; k + 1 < n; k++)	// Fan triangulate
+			{
+				out.indices.push_back(polygon_corners[0]);
+				out.indices.push_back(polygon_corners[k]);
+				out.indices.push_back(polygon_corners[k + 1]);
+			}
+
+			corner += n;	// Next polygon
+		}
+	}
 
-				if ((vertex_state == 1) && (std::string::npos != line.find("-Normal0-array")))	// Find the start of NORMALS
+	// Builds the joint tree below a scene node
+	inline Joint BuildJoint(const Document &doc, int node, const std::unordered_map<std::string, unsigned int> &joint_ids)
+	{
+		const Node &n = doc._nodes[node];	// The scene node
+		unsigned int id = JOINT_NONE;	// Its joint id
+		for (const std::string* key : { &n._sid, &n._name, &n._id })	// Try each way the skin may reference it...
+		{
+			auto it = joint_ids.find(*key);		// Look it up
+			if (!key->empty() && it != joint_ids.end()) { id = it->second; break; }	// Found it
+		}
+
+		Joint joint(id, n._sid.empty() ? n._name : n._sid, n._matrix);	// Create the joint
+		for (size_t c = node + 1; c < doc._nodes.size(); c++)	// Children always come after their parent...
+			if (doc._nodes[c]._parent == node && doc._nodes[c]._is_joint)	// If this is a child joint...
+				joint._children.push_back(BuildJoint(doc, (int)c, joint_ids));	// Build it
+		return joint;	// Return the joint
+	}
+
+	// This will load the geometry, skin, skeleton and animation data from a collada document in memory
+	inline bool ImportFromMemory(const char* data, size_t size, VertexData& out_vertex_data, AnimData& out_anim_data)
+	{
+		Document doc;	// The gathered state
+		XmlReader xml(data, size);	// The tokenizer
+
+		std::vector<std::string_view>	stack;	// Open elements
+		std::vector<int>				node_stack;		// Open scene nodes
+		std::string						source_id;	// The open <source>
+		std::string						vertices_id;	// The open <vertices>
+		std::string						sampler_id;		// The open <sampler>
+		std::string						geometry_id;	// The open <geometry>
+		std::vector<Input>				prim_inputs;	// Inputs of the open primitive
+		std::vector<unsigned int>		prim_vcount;	// vcount of the open primitive
+		std::vector<unsigned int>		prim_p;		// Indices of the open primitive
+		std::vector<unsigned int>		prim_scratch;	// Scratch for <polygons> blocks
+		std::vector<float>				values;		// The numbers of the open matrix / transform element
+		unsigned int					group = 0;	// Primitive group counter
+		size_t							array_count = 0;	// The declared count of the open array
+		bool							in_skin = false;	// Whether we're inside a <skin>
+		bool							in_scene = false;	// Whether we're inside a <visual_scene>
+		std::unordered_map<CornerKey, unsigned int, CornerHash> corner_map;	// Output vertex dedupe
+
+		out_vertex_data = VertexData();		// Reset the output
+		out_anim_data = AnimData();		// Reset the output
+
+		for (XmlToken tok = xml.Next(); tok != XML_EOF; tok = xml.Next())	// For each token...
+		{
+			if (tok == XML_START)	// If an element opened...
+			{
+				std::string_view name = xml.Name();		// Its name
+				std::string_view parent = stack.empty() ? std::string_view() : stack.back();	// Its parent
+				stack.push_back(name);	// Open it
+				values.clear();		// Text runs append, so start every element empty
+
+				if (name == "source") { source_id = std::string(xml.Attribute("id")); doc._sources[source_id]; }
+				else if (name == "float_array" || name == "Name_array" || name == "IDREF_array" || name == "int_array")
+				{
+					array_count = ToUInt(xml.Attribute("count"));
+					if (!source_id.empty()) { doc._sources[source_id]._floats.clear(); doc._sources[source_id]._names.clear(); }
+				}
+				else if (name == "p") prim_scratch.clear();
+				else if (name == "accessor" && !source_id.empty())
+					doc._sources[source_id]._stride = std::max(1u, ToUInt(xml.Attribute("stride")));
+				else if (name == "geometry") { geometry_id = std::string(xml.Attribute("id")); }
+				else if (name == "vertices") { vertices_id = std::string(xml.Attribute("id")); doc._vertices[vertices_id].clear(); }
+				else if (name == "triangles" || name == "polylist" || name == "polygons")
+				{
+					prim_inputs.clear();	// Fresh inputs
+					prim_vcount.clear();	// Fresh vcount
+					prim_p.clear();		// Fresh indices
+				}
+				else if (name == "skin") { in_skin = true; doc._skin_geometry = Url(xml.Attribute("source")); }
+				else if (name == "sampler") { sampler_id = std::string(xml.Attribute("id")); doc._samplers[sampler_id].clear(); }
+				else if (name == "channel") doc._channels.push_back(std::make_pair(Url(xml.Attribute("source")), std::string(xml.Attribute("target"))));
+				else if (name == "visual_scene") in_scene = true;
+				else if (name == "node" && in_scene)
+				{
+					Node node;	// The new node
+					node._parent = node_stack.empty() ? -1 : node_stack.back();		// Its parent
+					node._is_joint = xml.Attribute("type") == "JOINT";	// Its type
+					node._id = std::string(xml.Attribute("id"));	// Its id
+					node._sid = std::string(xml.Attribute("sid"));	// Its sid
+					node._name = std::string(xml.Attribute("name"));	// Its name
+					node._matrix = glm::mat4x4(1.0f);	// Identity until a transform is read
+					node_stack.push_back((int)doc._nodes.size());	// Open it
+					doc._nodes.push_back(node);		// Record it
+				}
+				else if (name == "input")
 				{
-					stride = 3;		// Set stride for NORMAL attribute
-					len = line.find(">") - line.find("t=") - 4;	// Calculate the buffer size of count value
-					count = std::stoi(line.substr(line.find("t=") + 3, len));	// Convert count to int
+					Input in;	// The new input
+					in._semantic = std::string(xml.Attribute("semantic"));	// Its semantic
+					in._source = Url(xml.Attribute("source"));	// Its source
+					in._offset = ToUInt(xml.Attribute("offset"));	// Its tuple offset
+					in._set = ToUInt(xml.Attribute("set"));		// Its set
+
+					if (parent == "vertices") doc._vertices[vertices_id].push_back(in);
+					else if (parent == "triangles" || parent == "polylist" || parent == "polygons") prim_inputs.push_back(in);
+					else if (parent == "joints" && in_skin) doc._skin_joints.push_back(in);
+					else if (parent == "vertex_weights" && in_skin) doc._skin_weights.push_back(in);
+					else if (parent == "sampler") doc._samplers[sampler_id].push_back(in);
+				}
+			}
+			else if (tok == XML_TEXT && !stack.empty())	// If we have character data...
+			{
+				std::string_view name = stack.back();	// The element it belongs to
+				std::string_view text = xml.Text();		// The text
+
+				if (name == "float_array" && !source_id.empty()) ParseArray(text, doc._sources[source_id]._floats, array_count);	// Arrays outside a <source> aren't referenced
+				else if ((name == "Name_array" || name == "IDREF_array") && !source_id.empty()) ParseNames(text, doc._sources[source_id]._names);
+				else if (name == "p" && stack.size() > 1 && stack[stack.size() - 2] == "polygons") ParseArray(text, prim_scratch);	// Each <p> is one polygon
+				else if (name == "p") ParseArray(text, prim_p);
+				else if (name == "vcount" && in_skin) ParseArray(text, doc._skin_vcount);
+				else if (name == "vcount") ParseArray(text, prim_vcount);
+				else if (name == "v" && in_skin) ParseArray(text, doc._skin_v);
+				else if (name == "bind_shape_matrix" || name == "matrix" || name == "translate" || name == "rotate" || name == "scale")
+					ParseArray(text, values);	// Applied once the element closes
+			}
+			else if (tok == XML_END && !stack.empty())	// If an element closed...
+			{
+				std::string_view name = stack.back();	// Its name
+				const std::vector<float> &f = values;	// The numbers it held
 
-					if (std::string::npos != line.find(">"))	// Find the end of the line
-						begin_scan = true;	// Get ready to extract the next line of data
+				if (name == "p" && stack.size() > 1 && stack[stack.size() - 2] == "polygons")	// A whole polygon has been read
+				{
+					prim_vcount.push_back((unsigned int)prim_scratch.size());	// Record its size in tuples (fixed up at the end)
+					prim_p.insert(prim_p.end(), prim_scratch.begin(), prim_scratch.end());	// Append it
+				}
+				else if (name == "bind_shape_matrix")
+				{
+					if (f.size() >= 16) doc._bind_shape = ToMatrix(&f[0]);	// Convert the values
 				}
+				else if (!node_stack.empty() && (name == "matrix" || name == "translate" || name == "rotate" || name == "scale"))
+				{
+					glm::mat4x4 &m = doc._nodes[node_stack.back()]._matrix;		// The node's transform
 
-				if ((vertex_state == 2) && (std::string::npos != line.find("-UV0-array")))	// Find the start of TEXCOORDS
+					if (name == "matrix" && f.size() >= 16) m = m * ToMatrix(&f[0]);
+					else if (name == "translate" && f.size() >= 3) m = glm::translate(m, glm::vec3(f[0], f[1], f[2]));
+					else if (name == "rotate" && f.size() >= 4) m = glm::rotate(m, glm::radians(f[3]), glm::vec3(f[0], f[1], f[2]));
+					else if (name == "scale" && f.size() >= 3) m = glm::scale(m, glm::vec3(f[0], f[1], f[2]));
+				}
+				else if (name == "triangles" || name == "polylist" || name == "polygons")
 				{
-					stride = 2;		// Set stride for TEXCOORD attribute
-					len = line.find(">") - line.find("t=") - 4;	// Calculate the buffer size of count value
-					count = std::stoi(line.substr(line.find("t=") + 3, len));	// Convert count to int
+					if (name == "polygons")		// If the polygon sizes were recorded in values...
+					{
+						unsigned int stride = 0;	// The tuple size
+						for (const Input &in : prim_inputs) stride = std::max(stride, in._offset + 1);
+						for (unsigned int &n : prim_vcount) n = stride ? n / stride : 0;	// Convert to corner counts
+					}
 
-					if (std::string::npos != line.find(">"))	// Find the end of the line
-						begin_scan = true;	// Get ready to extract the next line of data
+					BuildPrimitive(doc, geometry_id, group++, prim_inputs, prim_vcount, prim_p, out_vertex_data, corner_map);	// Build it
 				}
+				else if (name == "source") source_id.clear();
+				else if (name == "skin") in_skin = false;
+				else if (name == "visual_scene") in_scene = false;
+				else if (name == "node" && in_scene && !node_stack.empty()) node_stack.pop_back();
 
-				break;
-			case GEOMETRY_INDEX:	// Get INDEX data
-				if (std::string::npos != line.find("<triangles"))
-				{
-					i_0 = line.find("t=") + 3;	// Get the first index offset for count
-					i_1 = line.find("m") - 2;	// Get the last index offset for count
-					len = i_1 - i_0;	// Calculate the buffer size
+				stack.pop_back();	// Close it
+			}
+		}
 
-					count = std::stoi(line.substr(i_0, len)) * 9;		// Convert the count value to int
+		if (out_vertex_data.positions.empty())	// If we didn't find any geometry...
+		{
+			std::cout << "Dae Import Error: The file contains no triangle data!\n";		// Print out error message
+			return false;	// Return false as failed
+		}
 
-					i_0 = line.find("<p>") + 4;		// Get the first index offset for count
-					i_1 = line.find("</p>");	// Get the last index offset for count
-					len = i_1 - i_0;	// Calculate the buffer size
+		CalculateTangents(out_vertex_data);		// Calculate a tangent for each vertex
 
-					std::string indices_str = line.substr(i_0, len);	// Get index data to string
-					std::stringstream indices_strs(indices_str);	// Create string stream for maniplulation
+		// Skin: joint names, inverse bind matrices and the strongest weights of each vertex
+		std::unordered_map<std::string, unsigned int> joint_ids;	// Joint name -> id
+		out_anim_data._bind_shape_matrix = doc._bind_shape;		// Assign the bind shape
 
-					unsigned int i;		// A temp index variable
-					for (i = 0; i < count; i++)	// Iterate through each index
-					{
-						unsigned int index = 0;		// Create a temp value
-						indices_strs >> index;	// Get next index in stream
-						vd.indices.push_back(index);	// Add a new index
-					}
+		for (const Input &in : doc._skin_joints)	// For each <joints> input...
+		{
+			const Source &src = doc._sources[in._source];	// Its source
+			if (in._semantic == "JOINT")
+				out_anim_data._joint_names = src._names;	// Record the joint order
+			else if (in._semantic == "INV_BIND_MATRIX")
+				for (size_t i = 0; i + 16 <= src._floats.size(); i += 16)	// For each matrix...
+					out_anim_data._inverse_bind_matrices.push_back(ToMatrix(&src._floats[i]));	// Record it
+		}
+
+		for (unsigned int i = 0; i < out_anim_data._joint_names.size(); i++)	// For each joint...
+			joint_ids[out_anim_data._joint_names[i]] = i;	// Map its name to its id
+
+		if (!doc._skin_weights.empty())		// If the mesh is skinned...
+		{
+			unsigned int stride = 0, j_off = 0, w_off = 0;	// Tuple layout
+			const Source* weights = NULL;	// The weight source
+			for (const Input &in : doc._skin_weights)	// For each input...
+			{
+				stride = std::max(stride, in._offset + 1);	// Grow the tuple size
+				if (in._semantic == "JOINT") j_off = in._offset;
+				else if (in._semantic == "WEIGHT") { w_off = in._offset; weights = &doc._sources[in._source]; }
+			}
+
+			std::vector<size_t> first(doc._skin_vcount.size() + 1, 0);		// Tuple offset of each position's influences
+			for (size_t i = 0; i < doc._skin_vcount.size(); i++)
+				first[i + 1] = first[i] + doc._skin_vcount[i];
 
-					for (i = 0; i != vd.indices.size(); i += 3)		// Iterate through each index with an offset of three
+			out_anim_data._joint_ids.assign(out_vertex_data.positions.size(), glm::ivec3(0));	// One joint set per vertex
+			out_anim_data._weights.assign(out_vertex_data.positions.size(), glm::vec3(0.0f));	// One weight set per vertex
+
+			Parallel::For(0, out_vertex_data.positions.size(), 4096, [&](size_t from, size_t to)
+			{
+				std::vector<std::pair<float, int>> influences;	// (weight, joint) pairs of a vertex
+				for (size_t v = from; v < to; v++)	// For each output vertex...
+				{
+					unsigned int pos = doc._out_positions[v];	// Its position index
+					if (!weights || stride == 0 || doc._out_geometries[v] != doc._skin_geometry || pos >= doc._skin_vcount.size())
+						continue;	// Not skinned
+
+					influences.clear();		// Gather its influences
+					for (size_t k = first[pos]; k < first[pos + 1] && (k + 1) * stride <= doc._skin_v.size(); k++)
 					{
-						unsigned int p_i = vd.indices[i];		// Position index
-						unsigned int n_i = vd.indices[i + 1];	// Normal index
-						unsigned int t_i = vd.indices[i + 2];	// Texcoord index
+						int joint = doc._skin_v[k * stride + j_off];	// The joint (-1 is the bind shape)
+						int w = doc._skin_v[k * stride + w_off];	// The weight index
+						float weight = w >= 0 && (size_t)w < weights->_floats.size() ? weights->_floats[w] : 0.0f;	// The weight
+						if (joint >= 0)		// If it's a real joint...
+							influences.push_back(std::make_pair(weight, joint));	// Record it
+					}
 
-						glm::vec3 position = vd.positions[p_i];		// Get the index of position
-						glm::vec3 normal = vd.normals[n_i];		// Get the index of normal
-						glm::vec3 texcoord = vd.texcoords[t_i];		// Get the index of texcoord
+					std::sort(influences.begin(), influences.end(), [](const std::pair<float, int> &a, const std::pair<float, int> &b)
+						{ return a.first > b.first || (a.first == b.first && a.second < b.second); });		// Strongest first
 
-						out_vertex_data.positions.push_back(position);	// Assign position data
-						out_vertex_data.normals.push_back(normal);	// Assign normal data
-						out_vertex_data.texcoords.push_back(texcoord);	// Assign texcoord data
+					float total = 0.0f;		// Sum of the kept weights
+					for (size_t k = 0; k < influences.size() && k < MAX_WEIGHTS; k++)
+					{
+						out_anim_data._joint_ids[v][(int)k] = influences[k].second;		// Keep the joint
+						out_anim_data._weights[v][(int)k] = influences[k].first;	// Keep the weight
+						total += influences[k].first;	// Sum it
 					}
+					if (total > 0.0f)	// If there are weights...
+						out_anim_data._weights[v] /= total;		// Renormalise them
+				}
+			});
+		}
 
-					out_vertex_data.indices = vd.indices;	// Assign indices
+		// Skeleton: the first joint node whose parent isn't a joint
+		for (size_t n = 0; n < doc._nodes.size(); n++)
+		{
+			const Node &node = doc._nodes[n];	// The node
+			if (node._is_joint && (node._parent < 0 || !doc._nodes[node._parent]._is_joint))	// If this is a skeleton root...
+			{
+				out_anim_data._root_joint = BuildJoint(doc, (int)n, joint_ids);		// Build the tree
+				break;	// Only one skeleton is supported
+			}
+		}
 
+		// Animation: one joint anim per matrix channel
+		for (const std::pair<std::string, std::string> &channel : doc._channels)
+		{
+			std::string node_id = channel.second.substr(0, channel.second.find('/'));	// The targeted node
+			std::string joint_name = node_id;	// The name the skeleton uses for it
+			for (const Node &node : doc._nodes)		// Find the node...
+				if (node._id == node_id) { joint_name = node._sid.empty() ? node._name : node._sid; break; }
+
+			const Source* input = NULL;		// Key times
+			const Source* output = NULL;	// Key values
+			for (const Input &in : doc._samplers[channel.first])	// For each sampler input...
+			{
+				if (in._semantic == "INPUT") input = &doc._sources[in._source];
+				else if (in._semantic == "OUTPUT") output = &doc._sources[in._source];
+			}
 
-					// NEEDS FIXING!!! // ------------------------------
-					std::cout << "Vertex indices: " << vd.indices.size() << "\n";
-					std::cout << "Vertex positions: " << vd.positions.size() << "\n";
-					std::cout << "Vertex normals: " << vd.normals.size() << "\n";
-					std::cout << "Vertex texcoords: " << vd.texcoords.size() << "\n";
-					// NEEDS FIXING!!! // ------------------------------
+			if (!input || !output || output->_stride != 16)		// Only baked matrix channels are supported
+				continue;	// Skip it
 
+			JointAnim anim(joint_name);		// The new joint anim
+			anim._time_stamps = input->_floats;		// Assign key times
+			for (size_t i = 0; i + 16 <= output->_floats.size() && anim._matrices.size() < anim._time_stamps.size(); i += 16)
+				anim._matrices.push_back(ToMatrix(&output->_floats[i]));	// Assign key poses
+			out_anim_data._joint_anims.push_back(anim);		// Record it
+		}
 
+		return true;	// Return success
+	}
 
-					state++;	// Go to next state!
-				}
-				break;
-			//case JOINT_NAME:	// Get JOINT NAME data
-			//	if (std::string::npos != line.find("<Name_array"))	// If joint_id names have been discovered...
-			//		begin_scan = true;	// Start extraction
-			//	break;
-			//case INVERSE_BIND_MATRIX:	// Get JOINT INVERSE BIND MATRIX data
-			//	if (std::string::npos != line.find("<float_array"))	// If joint_inverse_bind matrices have been discovered...
-			//	{
-			//		i_0 = line.find("t=") + 3;	// Get the first index offset for count
-			//		i_1 = line.find(">") - 1;	// Get the last index offset for count
-			//		len = i_1 - i_0;	// Calculate the buffer size
-
-			//		count = std::stoi(line.substr(i_0, len));		// Convert the count value to int
-			//		stride = 16;	// Set stride to 4x4 matrix
-
-			//		begin_scan = true;	// Start extraction
-			//	}
-			//	break;
-			//case WEIGHT_VALUE:	// Get the WEIGHT data
-			//	if (std::string::npos != line.find("<float_array"))	// If weight data have been discovered...
-			//	{
-			//		i_0 = line.find("t=") + 3;	// Get the first index offset for count
-			//		i_1 = line.find(">") - 1;	// Get the last index offset for count
-			//		len = i_1 - i_0;	// Calculate the buffer size
-
-			//		stride = 16;	// Set stride to 4x4 matrix
-			//		count = (std::stoi(line.substr(i_0, len)) + stride - 1) / stride;		// Convert the count value to int
-			//		
-			//		begin_scan = true;	// Start extraction
-			//	}
-			//	break;
-			//case VERTEX_WEIGHT:		// Get the VERTEX WEIGHT data
-			//	if (std::string::npos != line.find("<vcount"))	// If weight vertices have been discovered...
-			//	{
-			//		std::string l = line.substr(line.find(">") + 1, line.length());		// Get the start of array
-			//		std::stringstream ss(l);	// Create string stream for maniplulation
-			//		std::copy(std::istream_iterator<unsigned int>(ss), std::istream_iterator<unsigned int>(), std::back_inserter(vcount));	// Iterate through each string usign stream and store in vector list
-			//		
-			//		current_scan = -1;	// Reset the current scan count
-			//	}
-			//	else if (std::string::npos != line.find("<v>"))	// If weight vertices have been discovered...
-			//	{
-			//		std::string l = line.substr(line.find(">") + 1, line.length());		// Get the start of array
-			//		std::stringstream ss(l);	// Create string stream for maniplulation
-			//		std::vector<unsigned int> wj_indices;	// Create a temp container for the weight and joint index data
-			//		std::copy(std::istream_iterator<unsigned int>(ss), std::istream_iterator<unsigned int>(), std::back_inserter(wj_indices));	// Iterate through each string usign stream and store in vector list
-
-			//		unsigned int i, j;		// Iterator index
-			//		std::vector<glm::ivec2> pairs;	// Temp pair container
-
-			//		for (i = 0; i != wj_indices.size(); i += 2)		// Iterate through each weight vertex
-			//			pairs.push_back(glm::ivec2(wj_indices[i], wj_indices[i + 1]));	// Add a pair for every two offsets
-			//		
-			//		unsigned int offset_count = 0;	// Create a temp offset counter for each vertex size
-			//		for (i = 0; i < vcount.size(); i++)		// Iterate through each index
-			//		{
-			//			glm::ivec3 joint_indices;	// Create a temp joint index container
-			//			glm::ivec3 weight_indices;	// Create a temp weight index container
-
-			//			for (j = 0; j != vcount[i]; j++)	// Iterate through each local offset
-			//			{
-			//				joint_indices[j] = pairs[offset_count + j].x;	// Assign temp joint index variables
-			//				weight_indices[j] = pairs[offset_count + j].y;	// Assign temp weight index variables
-			//			}
-			//			
-			//			weight_vertices._joint_indices.push_back(joint_indices);	// Add new joint index array
-			//			weight_vertices._weight_indices.push_back(weight_indices);	// Add new weight index array
-
-			//			offset_count += vcount[i];	// Increment to next vertex offset
-			//		}
-
-			//		current_scan = -1;	// Reset the current scan count
-			//		state++;	// Go to next state!
-			//	}
-			//	break;
-			//case ANIMATION:		// Get the ANIMATION data
-			//	if (std::string::npos != line.find("<animation id"))	// If we've come across an animation...
-			//	{
-			//		current_anim++;		// Incremenet the curent_anim ready to store new joint anim data
-
-			//		i_0 = line.find("e=") + 3;	// Get the first index offset for count
-			//		i_1 = line.find("><") - 1;		// Get the last index offset for count
-			//		len = i_1 - i_0;	// Calculate the buffer size
-
-			//		joint_anims.push_back(line.substr(i_0, len));	// Add a new joint animation
-
-			//		i_0 = line.find("t=") + 3;	// Get the first index offset for count
-			//		i_1 = line.find(">") - 1;	// Get the last index offset for count
-			//		len = i_1 - i_0;	// Calculate the buffer size
-
-			//		stride = 16;	// Set stride to 4x4 matrix
-			//		count = std::stoi(line.substr(i_0, len));		// Convert the count value to int
-			//		count_div_stride = (count + stride - 1) / stride;	// Calculate the number of total lines to count
-
-			//		current_scan = -1;	// Reset the current scan count
-			//		begin_scan = true;	// Start extracting data
-			//	}
-			//	else if (std::string::npos != line.find("</library_animations>"))	// If we've finished reading the anim library...
-			//		state++;	// Go to next state!
-			//	break;
-			//case HIERARCHY:
-			//	state++;
-			//	break;
-			default:
-				break;
-			}
+	// This will load all of the key data from a collada file
+	inline bool Import(const char* uri, VertexData& out_vertex_data, AnimData& out_anim_data)
+	{
+		VfsFile file;	// The document, parsed in place
+		if (!Vfs::Open(uri, file))	// If the file failed to open...
+		{
+			std::cout << "Dae Import Error: Failed to open file!\n";	// Print out error message
+			return false;	// Return false as failed
 		}
+
+		return ImportFromMemory((const char*)file.Data(), file.Size(), out_vertex_data, out_anim_data);	// Parse it
 	}
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,8 @@
 #include "ObjLoader.h"	// Get access to our obj wavefront loader functions
 #include "DaeLoader.h"	// Get access to our dao loader functions
 #include "Asset.h"
+#include "HotReload.h"	// Re-import meshes when their files change
+#include "Vfs.h"	// Read through the content archive
 
 // This namespace will manage data and information via input / output
 namespace DataIO
@@ -16,44 +18,80 @@ namespace DataIO
 	{
 	public:
 
-		// This function will attempt to import a wavefront: obj file
-		static inline Mesh* WavefrontObjI(uniform shader_program, const char* file)
+		// This function reads a wavefront: obj file into optimised vertex data and chunks (no GL calls, safe on any thread)
+		static inline bool ReadWavefrontObj(const std::string &uri, VertexData &vd_opt, std::vector<Chunk> &chunks_opt, std::string &name)
 		{
-			VertexData vd_opt;	// This will contain our optimised vertex data
 			Wavefront::ObjData obj;		// This will contain our native obj data from file
-			std::vector<Chunk> chunks_opt;	// This will contain our optimised chunks (in order)
-			std::vector<Material*> mats_opt;	// This will contain our temp material data
 
-			std::string s_file = file;	// Convert file name to string for conversion
-
-			if (!Wavefront::Import((static_cast<std::string>(__OBJ_EXTENSION__) + s_file).c_str(), obj))	// Attempt to import our obj file...
+			if (!Wavefront::Import(uri.c_str(), obj) || obj.g.empty())	// Attempt to import our obj file...
 			{
 				std::cout << "Wavefront Import Error: The obj file failed to import!\n";	// Print error code
+				return false;	// Return false as failed
 			}
 
 			IndexVertexData(obj.v, obj.vt, obj.vn, vd_opt.indices, vd_opt.positions, vd_opt.texcoords, vd_opt.normals, vd_opt.tangents);	// Index our obj data for ebo optimisation
 			CalculateTangents(vd_opt);	// Calculate tangents for each triangle
 
-			Vao* vao_opt = Wavefront::CreateVao(vd_opt.positions, vd_opt.texcoords, vd_opt.normals, vd_opt.tangents, vd_opt.indices);	// Initialise a new ebo using our optimised vertex data
-			
 			chunks_opt.push_back(Chunk(obj.g[0].from, obj.g[0].to, 0));		// Add a chunk for our first main element
-			mats_opt.push_back(Content::_materials[0]);		// Assign the default material for our first main element
 
 			if (obj.g.size() > 1)	// If multiple groups were detected...
 			{
 				for (unsigned int i = obj.g.size() - 1; i != 0; i--)	// Iterate through the rest of the groups backwards
-				{
 					chunks_opt.push_back(Chunk(sizeof(GLuint) * obj.g[i].from, obj.g[i].to, i));		// Add another chunk for each group detected
-					mats_opt.push_back(Content::_materials[0]);		// Add another default material to this chunk
-				}
 			}
 
-			Mesh* mesh = new StaticMesh(shader_program, obj.o, mats_opt, Content::_cubemaps[0]);
+			name = obj.o;	// Assign the object name
+			return true;	// Return true as success
+		}
+
+		// This function swaps freshly read geometry into an existing mesh (main thread)
+		static inline void ApplyGeometry(Mesh* mesh, VertexData &vd, std::vector<Chunk> &chunks)
+		{
+			Vao* vao = Wavefront::CreateVao(vd.positions, vd.texcoords, vd.normals, vd.tangents, vd.indices);	// Initialise a new ebo using the vertex data
+
+			if (mesh->GetVao())		// If the mesh already has geometry...
+				delete mesh->GetVao();	// Delete it
 
-			mesh->SetVao(vao_opt);	// Assign the optimised ebo to our mesh ebo
-			mesh->SetVertexData(vd_opt);	// Assign the optimised vertex data
-			mesh->SetChunks(chunks_opt);	// Assign the optimised chunk list to our mesh chunk list
-			mesh->SetNumIndices(vd_opt.indices.size());	// Assign the number of indices to our mesh
+			while (mesh->GetMaterials().size() < chunks.size())		// If the file gained chunks...
+				mesh->GetMaterials().push_back(Content::_materials[0]);		// Give them the default material
+
+			mesh->SetVao(vao);	// Assign the optimised ebo to our mesh ebo
+			mesh->SetVertexData(vd);	// Assign the optimised vertex data
+			mesh->SetChunks(chunks);	// Assign the optimised chunk list to our mesh chunk list
+			mesh->SetNumIndices(vd.indices.size());	// Assign the number of indices to our mesh
+		}
+
+		// This function will attempt to import a wavefront: obj file
+		static inline Mesh* WavefrontObjI(uniform shader_program, const char* file)
+		{
+			VertexData vd_opt;	// This will contain our optimised vertex data
+			std::vector<Chunk> chunks_opt;	// This will contain our optimised chunks (in order)
+			std::vector<Material*> mats_opt;	// This will contain our temp material data
+			std::string name;	// The object name
+
+			std::string uri = static_cast<std::string>(__OBJ_EXTENSION__) + file;	// The full path
+
+			if (!ReadWavefrontObj(uri, vd_opt, chunks_opt, name))	// Read and optimise the file
+				return NULL;	// Return null as failed
+
+			for (unsigned int i = 0; i < chunks_opt.size(); i++)	// For each chunk...
+				mats_opt.push_back(Content::_materials[0]);		// Assign the default material
+
+			Mesh* mesh = new StaticMesh(shader_program, name, mats_opt, Content::_cubemaps[0]);
+
+			mesh->SetVao(NULL);		// No geometry yet
+			ApplyGeometry(mesh, vd_opt, chunks_opt);	// Upload the geometry
+
+			HotReload::Watch(uri, mesh, [mesh, uri]() -> HotReload::Apply	// Re-import the obj when it changes
+			{
+				VertexData vd;	// The new vertex data
+				std::vector<Chunk> chunks;	// The new chunks
+				std::string name;	// The object name
+				if (!ReadWavefrontObj(uri, vd, chunks, name))	// If the file is broken...
+					return HotReload::Apply();	// Keep the current geometry
+
+				return [mesh, vd, chunks]() mutable { ApplyGeometry(mesh, vd, chunks); };	// Swap it in
+			});
 
 			Content::_meshes.push_back(mesh);
 
@@ -149,11 +187,11 @@ namespace DataIO
 	{
 	public:
 
-		// Open a mesh file
-		static inline bool MeshI(unsigned int shader_program, const char* file)
+		// Read a mesh file into vertex data, chunks and material names (no GL calls, safe on any thread)
+		static inline bool ReadMesh(const std::string &uri, VertexData &vd, std::vector<Chunk> &c, std::vector<std::string> &m, std::string &n)
 		{
-			std::ifstream _in(static_cast<std::string>(__STATIC_MESH_URI__) + file);	// Check if the file is valid
-			if (!_in)	// If the file is invalid...
+			std::istringstream _in;	// The file contents
+			if (!Vfs::OpenText(uri, _in))	// If the file is invalid...
 			{
 				std::cout << "Mesh Error: The file is invalid! Check that the file exists.\n";	// Print out error message
 				return false;	// Return false as failed
@@ -168,11 +206,6 @@ namespace DataIO
 			int cd[3];	// Store chunk data
 			float x, y, z;	// Create temp variables for vertex data
 			char chars[128];	// Create temp variable for character data
-			std::string n;	// This will store the meshes name
-			Vao* vao;	// Our vertex buffer object for storing vertex arrays
-			VertexData vd;	// Our vertex data for parsing to our ebo
-			std::vector<Chunk> c;	// Our chunk data for assigning to our mesh
-			std::vector<Material*> m;	// Our material data for assigning to our mesh chunks
 
 			for (unsigned int i = 0; i < line.size(); i++)	// Iterate through each line...
 			{
@@ -187,7 +220,7 @@ namespace DataIO
 					sscanf_s((&line[i])[0].c_str(), "c %d %d %d %s", &cd[0], &cd[1], &cd[2], &chars, 128);		// Scan this line
 
 					c.push_back(Chunk(cd[1], cd[2], cd[0]));	// Record chunk data
-					m.push_back(Content::GetMaterial(chars));	// Record material data
+					m.push_back(chars);		// Record material name
 					break;
 
 				case 'p':	// If the character is a 'p'...
@@ -212,14 +245,31 @@ namespace DataIO
 				}
 			}
 
-			vao = Wavefront::CreateVao(vd.positions, vd.texcoords, vd.normals, vd.tangents, vd.indices);		// Create our vao
-			
+			CalculateTangents(vd);	// Tangents aren't stored in the mesh file, so rebuild them per vertex
+
+			return true;	// Return true as success
+		}
+
+		// Open a mesh file
+		static inline bool MeshI(unsigned int shader_program, const char* file)
+		{
+			std::string uri = static_cast<std::string>(__STATIC_MESH_URI__) + file;		// The full path
+			VertexData vd;	// Our vertex data for parsing to our ebo
+			std::vector<Chunk> c;	// Our chunk data for assigning to our mesh
+			std::vector<std::string> names;		// Our material names for each chunk
+			std::vector<Material*> m;	// Our material data for assigning to our mesh chunks
+			std::string n;	// This will store the meshes name
+
+			if (!ReadMesh(uri, vd, c, names, n))	// If the file can't be read...
+				return false;	// Return false as failed
+
+			for (unsigned int i = 0; i < names.size(); i++)		// For each chunk...
+				m.push_back(Content::GetMaterial(names[i]));	// Record material data
+
 			Mesh* mesh = new StaticMesh(shader_program, n, m, Content::_cubemaps[0]);		// Create our temp variable for allocating a mesh
-			
-			mesh->SetVao(vao);	// Assign the optimised ebo to our mesh ebo
-			mesh->SetVertexData(vd);	// Assign the optimised vertex data
-			mesh->SetChunks(c);	// Assign the optimised chunk list to our mesh chunk list
-			mesh->SetNumIndices(vd.indices.size());	// Assign the number of indices to our mesh
+
+			mesh->SetVao(NULL);		// No geometry yet
+			Import::ApplyGeometry(mesh, vd, c);		// Upload the geometry
 
 
 
@@ -227,6 +277,30 @@ namespace DataIO
 			mesh->SetCollisionType(COLLISION_TYPE_PER_VERTEX);
 			// TEMP !!! --------------------------------------------------------------
 
+			HotReload::Watch(uri, mesh, [mesh, uri]() -> HotReload::Apply	// Re-import the mesh when it changes
+			{
+				VertexData vd;	// The new vertex data
+				std::vector<Chunk> c;	// The new chunks
+				std::vector<std::string> names;		// The new material names
+				std::string n;	// The mesh name
+				if (!ReadMesh(uri, vd, c, names, n))	// If the file is broken...
+					return HotReload::Apply();	// Keep the current geometry
+
+				return [mesh, vd, c, names]() mutable	// Swap it in
+				{
+					for (unsigned int i = 0; i < names.size(); i++)		// For each chunk...
+					{
+						if (i < mesh->GetMaterials().size())	// If the chunk already exists...
+							mesh->GetMaterials()[i] = Content::GetMaterial(names[i]);	// Update its material
+						else
+							mesh->GetMaterials().push_back(Content::GetMaterial(names[i]));		// Add its material
+					}
+
+					Import::ApplyGeometry(mesh, vd, c);		// Swap the geometry
+					mesh->SetCollisionType(COLLISION_TYPE_PER_VERTEX);	// Rebuild the collision data
+				};
+			});
+
 			Content::_meshes.push_back(mesh);	// Add the mesh to our content
 			
 			return true;	// Return true as success
@@ -2,138 +2,160 @@
 #define __DDS_LOADER_H__
 
 #include <glew.h>
+#include "TextureContainer.h"	// Parse dds / ktx2 files without GL
 
-#define FOURCC_DXT1 0x31545844
-#define FOURCC_DXT3 0x33545844
-#define FOURCC_DXT5 0x35545844
-
-
-
-// This function imports a dds file and returns the dds data as a struct
-inline GLuint LoadDds(std::vector<std::string> file, size_t &img_width, size_t &img_height, size_t &num_mips, GLvoid* data, GLint wrap_s, GLint wrap_t, GLint min_filter, GLint mag_filter, size_t texture_type, bool anistropic_filtering)
+// Maps a container format to its GL formats, returns false if GL can't take it
+inline bool GetGlFormat(TextureContainer::Format f, GLenum &internal_format, GLenum &format, GLenum &type)
 {
+	format = GL_RGBA;	// Most formats are rgba
+	type = GL_UNSIGNED_BYTE;	// Most formats are bytes
 
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
-
-	// "Bind" the newly created texture : all future texture functions will modify this texture
-	glBindTexture(texture_type, textureID);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-	for (unsigned int i = 0; i < file.size(); i++)	// For each image...
+	switch (f)
 	{
-		FILE *fp;
-
-		unsigned char header[124];
-		unsigned int height;
-		unsigned int width;
-		unsigned int linearSize;
-		unsigned int mipMapCount;
-		unsigned int fourCC;
-		unsigned int components;
-		unsigned int format;
-		unsigned int bufsize;
-		unsigned char* buffer;
-
-
-		/* try to open the file */
-		errno_t err;
-		err = fopen_s(&fp, file[i].c_str(), "rb");
-		if (fp == NULL)
-			return 0;
-
-		/* verify the type of file */
-		char filecode[4];
-		fread(filecode, 1, 4, fp);
-		if (strncmp(filecode, "DDS ", 4) != 0)
-		{
-			fclose(fp);
-			return 0;
-		}
-
-		/* get the surface desc */
-		fread(&header, 124, 1, fp);
-
-		height = *(unsigned int*)&(header[8]);
-		width = *(unsigned int*)&(header[12]);
-		linearSize = *(unsigned int*)&(header[16]);
-		mipMapCount = *(unsigned int*)&(header[24]);
-		fourCC = *(unsigned int*)&(header[80]);
-		bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize;
-		buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char));
-
-		fread(buffer, 1, bufsize, fp);
+	case TextureContainer::FORMAT_BC1: internal_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; break;
+	case TextureContainer::FORMAT_BC1_SRGB: internal_format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT; break;
+	case TextureContainer::FORMAT_BC2: internal_format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; break;
+	case TextureContainer::FORMAT_BC2_SRGB: internal_format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT; break;
+	case TextureContainer::FORMAT_BC3: internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; break;
+	case TextureContainer::FORMAT_BC3_SRGB: internal_format = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT; break;
+	case TextureContainer::FORMAT_BC4: internal_format = GL_COMPRESSED_RED_RGTC1; break;
+	case TextureContainer::FORMAT_BC4_SNORM: internal_format = GL_COMPRESSED_SIGNED_RED_RGTC1; break;
+	case TextureContainer::FORMAT_BC5: internal_format = GL_COMPRESSED_RG_RGTC2; break;
+	case TextureContainer::FORMAT_BC5_SNORM: internal_format = GL_COMPRESSED_SIGNED_RG_RGTC2; break;
+	case TextureContainer::FORMAT_BC6H_UF16: internal_format = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT; break;
+	case TextureContainer::FORMAT_BC6H_SF16: internal_format = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT; break;
+	case TextureContainer::FORMAT_BC7: internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM; break;
+	case TextureContainer::FORMAT_BC7_SRGB: internal_format = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM; break;
+	case TextureContainer::FORMAT_RGBA8: internal_format = GL_RGBA8; break;
+	case TextureContainer::FORMAT_RGBA8_SRGB: internal_format = GL_SRGB8_ALPHA8; break;
+	case TextureContainer::FORMAT_BGRA8: internal_format = GL_RGBA8; format = GL_BGRA; break;
+	case TextureContainer::FORMAT_BGRA8_SRGB: internal_format = GL_SRGB8_ALPHA8; format = GL_BGRA; break;
+	case TextureContainer::FORMAT_RGBX8: internal_format = GL_RGB8; break;	// RGB storage drops the unused byte, so alpha samples as 1
+	case TextureContainer::FORMAT_BGRX8: internal_format = GL_RGB8; format = GL_BGRA; break;
+	case TextureContainer::FORMAT_BGRX8_SRGB: internal_format = GL_SRGB8; format = GL_BGRA; break;
+	case TextureContainer::FORMAT_RGBA16F: internal_format = GL_RGBA16F; type = GL_HALF_FLOAT; break;
+	case TextureContainer::FORMAT_RGBA32F: internal_format = GL_RGBA32F; type = GL_FLOAT; break;
+	default: return false;
+	}
 
-		/* close the file pointer */
-		fclose(fp);
+	return true;	// Return success
+}
 
-		components = (fourCC == FOURCC_DXT1) ? 3 : 4;
-		switch (fourCC)
-		{
-		case FOURCC_DXT1:
-			format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
-			break;
-		case FOURCC_DXT3:
-			format = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
-			break;
-		case FOURCC_DXT5:
-			format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
-			break;
-		default:
-			free(buffer);
-			return 0;
-		}
+// Uploads every subresource of a parsed image into the bound texture. 'target' is GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP
+// or GL_TEXTURE_2D_ARRAY; 'face' places a single 2d image on one face of a cubemap built from separate files
+inline bool UploadImage(const TextureContainer::Image &image, GLenum target, unsigned int face)
+{
+	GLenum internal_format, format, type;	// The GL formats
+	if (!GetGlFormat(image.format, internal_format, format, type))	// If GL can't take it...
+	{
+		std::cout << "Texture Error: " << TextureContainer::GetFormatInfo(image.format).name << " can't be uploaded!\n";	// Print out error message
+		return false;	// Return false as failed
+	}
 
-		unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+	bool compressed = TextureContainer::IsCompressed(image.format);		// Whether to use the compressed entry points
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);	// Rows are tightly packed
 
-		unsigned int offset = 0;
-		for (unsigned int level = 0; level < mipMapCount && (width || height); ++level)
+	if (target == GL_TEXTURE_2D_ARRAY)	// If it's an array...
+	{
+		for (unsigned int m = 0; m < image.mips; m++)	// For each mip...
 		{
-			unsigned int size = ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
-			glCompressedTexImage2D(texture_type != GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_2D : GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, format, width, height,
-				0, size, buffer + offset);
+			const TextureContainer::Subresource &top = image.Get(m);	// The size of this level
+			if (compressed)		// Allocate the level for every layer
+				glCompressedTexImage3D(target, m, internal_format, top.width, top.height, image.layers, 0, (GLsizei)(top.size * image.layers), NULL);
+			else
+				glTexImage3D(target, m, internal_format, top.width, top.height, image.layers, 0, format, type, NULL);
 
-			if ((level < 1) && (i < 1))		// Only assign input variable values from first image
+			for (unsigned int l = 0; l < image.layers; l++)		// For each layer...
 			{
-				img_width = width;	// Assign texture width
-				img_height = height;	// Assign texture height
-				data = buffer;	// Assign buffer data
-				num_mips = mipMapCount;		// Assign number of mips
+				const TextureContainer::Subresource &s = image.Get(m, l);	// The subresource
+				if (compressed)		// Upload it in place
+					glCompressedTexSubImage3D(target, m, 0, 0, l, s.width, s.height, 1, internal_format, (GLsizei)s.size, s.data);
+				else
+					glTexSubImage3D(target, m, 0, 0, l, s.width, s.height, 1, format, type, s.data);
 			}
-
-			offset += size;
-			width /= 2;
-			height /= 2;
 		}
+		return true;	// Return success
+	}
 
-		if (anistropic_filtering)	// If anistropic_filtering is true...
+	for (unsigned int f = 0; f < image.faces; f++)	// For each face in the file...
+		for (unsigned int m = 0; m < image.mips; m++)	// For each mip...
 		{
-			GLfloat f_largest;	// A contianer for storing the amount of texels in view for anistropic filtering
-			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &f_largest);		// Query the amount of texels for calculation
-			glTexParameterf(texture_type, GL_TEXTURE_MAX_ANISOTROPY_EXT, f_largest);	// Apply filter to texture
+			const TextureContainer::Subresource &s = image.Get(m, 0, f);	// The subresource
+			GLenum face_target = target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face + f : GL_TEXTURE_2D;	// Where it goes
+			if (compressed)		// Upload it in place
+				glCompressedTexImage2D(face_target, m, internal_format, s.width, s.height, 0, (GLsizei)s.size, s.data);
+			else
+				glTexImage2D(face_target, m, internal_format, s.width, s.height, 0, format, type, s.data);
 		}
 
-		if (mipMapCount <= 0)
-			glGenerateMipmap(texture_type);	// Generate mipmap
-
-		free(buffer);	// Free buffers from memory
-	}
+	return true;	// Return success
+}
 
-	// Parameters
-	glTexParameteri(texture_type, GL_GENERATE_MIPMAP, GL_TRUE);
-	glTexParameteri(texture_type, GL_TEXTURE_MAX_LEVEL, 9);
+// Applies sampler state to the bound texture. A single level uncompressed image gets a generated chain; GL can't
+// generate mips for block compressed formats, so those stop at the levels they have
+inline void SetTextureParameters(GLenum texture_type, size_t num_mips, bool compressed, GLint wrap_s, GLint wrap_t, GLint min_filter, GLint mag_filter, bool anistropic_filtering)
+{
+	bool generate = num_mips <= 1 && !compressed;	// Whether GL builds the chain
+	if (generate)	// If the file had no chain...
+		glGenerateMipmap(texture_type);		// Generate mipmap
 	glTexParameteri(texture_type, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(texture_type, GL_TEXTURE_MAX_LEVEL, generate ? 9 : (GLint)num_mips - 1);	// Stop at the last stored level
 	glTexParameteri(texture_type, GL_TEXTURE_MIN_FILTER, min_filter);
 	glTexParameteri(texture_type, GL_TEXTURE_MAG_FILTER, mag_filter);
 	glTexParameteri(texture_type, GL_TEXTURE_WRAP_S, wrap_s);
 	glTexParameteri(texture_type, GL_TEXTURE_WRAP_T, wrap_t);
 
-	// Set additional cubemap parameters
-	if (texture_type == GL_TEXTURE_CUBE_MAP)
+	if (texture_type == GL_TEXTURE_CUBE_MAP)	// Set additional cubemap parameters
 		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, wrap_s);
 
+	if (anistropic_filtering)	// If anistropic_filtering is true...
+	{
+		GLfloat f_largest;	// A contianer for storing the amount of texels in view for anistropic filtering
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &f_largest);		// Query the amount of texels for calculation
+		glTexParameterf(texture_type, GL_TEXTURE_MAX_ANISOTROPY_EXT, f_largest);	// Apply filter to texture
+	}
+}
+
+// Creates a texture from files that were already parsed (the GL half of loading, main thread only). A single file
+// may hold a whole cubemap or array, otherwise each file is one face of a cubemap
+inline GLuint UploadTexture(const std::vector<const TextureContainer::Image*> &images, size_t &img_width, size_t &img_height, size_t &num_mips, GLint wrap_s, GLint wrap_t, GLint min_filter, GLint mag_filter, size_t texture_type, bool anistropic_filtering)
+{
+	if (images.empty())		// If there's nothing to upload...
+		return 0;	// Return null
+
+	GLuint textureID;	// Create one OpenGL texture
+	glGenTextures(1, &textureID);
+	glBindTexture(texture_type, textureID);		// All future texture functions will modify this texture
+
+	for (unsigned int i = 0; i < images.size(); i++)	// For each image...
+		if (!UploadImage(*images[i], texture_type, i))	// If it can't be uploaded...
+		{
+			glDeleteTextures(1, &textureID);	// Don't leak the texture
+			return 0;	// Return null
+		}
+
+	img_width = images[0]->width;	// Assign texture width
+	img_height = images[0]->height;		// Assign texture height
+	num_mips = images[0]->mips;		// Assign number of mips
+
+	SetTextureParameters(texture_type, num_mips, TextureContainer::IsCompressed(images[0]->format), wrap_s, wrap_t, min_filter, mag_filter, anistropic_filtering);	// Apply sampler state
 	return textureID;	// Return texture id
 }
 
-#endif
\ No newline at end of file
+// This function imports dds / ktx2 files and returns the texture object (0 on failure)
+inline GLuint LoadDds(std::vector<std::string> file, size_t &img_width, size_t &img_height, size_t &num_mips, GLint wrap_s, GLint wrap_t, GLint min_filter, GLint mag_filter, size_t texture_type, bool anistropic_filtering)
+{
+	std::vector<TextureContainer::File> files(file.size());	// The mapped files
+	std::vector<const TextureContainer::Image*> images;		// Their layouts
+
+	for (unsigned int i = 0; i < file.size(); i++)	// For each image...
+	{
+		if (!files[i].Open(file[i]))	// If it can't be parsed...
+			return 0;	// Return null
+		images.push_back(&files[i].GetImage());		// Collect it
+	}
+
+	return UploadTexture(images, img_width, img_height, num_mips, wrap_s, wrap_t, min_filter, mag_filter, texture_type, anistropic_filtering);	// Upload them
+}
+
+#endif
@@ -14,6 +14,7 @@
 #include "Engine/PBR.h"
 #include "Engine/ParticleSystem.h"
 #include "Engine/Inventory.h"
+#include "Engine/AnimSystem.h"	// Get the batched animation update
 #include "Manipulators.h"
 
 // the different render views
@@ -67,6 +68,8 @@ public:
 		glDepthFunc(GL_LEQUAL);
 		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
+		TextureStreamer::Initialise();	// Start streaming texture mips
+
 		// Initialise screen rectangles
 		_screen_rect = new Rect((double)width, (double)height, 1.0f, true);
 
@@ -81,17 +84,25 @@ public:
 		shaders[1]->AddShaderAttachment("skinning.f", GL_FRAGMENT_SHADER);	// final gather fragment
 		shaders[1]->LinkProgram();		// link both shader attachments
 
-		passes.push_back(new GeometryPass({ shaders[0]->GetProgram(), shaders[1]->GetProgram() }));		// Initialise the geometry pass
+		GeometryPass* geometry_pass = new GeometryPass({ shaders[0]->GetProgram(), shaders[1]->GetProgram() });	// Initialise the geometry pass
+		passes.push_back(geometry_pass);
+		shaders[0]->OnRelink([geometry_pass]() { geometry_pass->GetUniforms(); });	// Everything drawn with it caches locations
 
 		// Initialise light pass shader
 		shaders.push_back(new ShaderProgram);
 		shaders[2]->AddShaderAttachment("Rect.v", GL_VERTEX_SHADER);	// Screen rect shader
 		shaders[2]->AddShaderAttachment("Light.f", GL_FRAGMENT_SHADER);	// Light fragment
 		shaders[2]->LinkProgram();		// Link both shader attachments
-		passes.push_back(new LightPass(shaders[2]->GetProgram()));	// Initialise the light pass
+		LightPass* light_pass = new LightPass(shaders[2]->GetProgram());	// Initialise the light pass
+		passes.push_back(light_pass);
 
 		// Get global uniforms from light shader
 		_u_view_type = glGetUniformLocation(shaders[2]->GetProgram(), "view_type");		// Buffer view type
+		shaders[2]->OnRelink([light_pass]()		// Locations may move when a reload relinks it
+		{
+			light_pass->GetUniforms();
+			_u_view_type = glGetUniformLocation(shaders[2]->GetProgram(), "view_type");
+		});
 
 		// Initialise GBuffer pass
 		passes.push_back(new GBufferPass(shaders[2]->GetProgram(), width, height));		// Initialise the gbuffer
@@ -196,12 +207,23 @@ public:
 
 		_ibl = new PBR::IBL("Res/Content/HDRI/Etnies_Park_Center_Env.hdr", { shaders[14]->GetProgram(), shaders[15]->GetProgram(), shaders[16]->GetProgram(), shaders[17]->GetProgram() });
 
+#ifndef ENGINE_SHIPPING
+		for (size_t i = 0; i < shaders.size(); i++)		// For each shader program...
+			shaders[i]->WatchFiles();	// Recompile it when its files change
+		Vfs::PreferLooseFiles(true);	// Edited files on disk override the archive, so reloads don't re-read the packed copy
+		HotReload::Start();		// Start watching asset files (shipping builds don't run the watcher)
+#endif
+
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);	// Clear background colour
 	}
 
 	// Destroy all allocated memory
 	inline static void Destroy()
 	{
+		HotReload::Stop();	// Stop watching asset files
+		TextureStreamer::Destroy();		// Stop streaming texture mips
+		AnimSystem::Destroy();	// Release the animation instances
+
 		passes.clear();		// Destroy gbuffer data
 		shaders.clear();	// Delete all shader programs
 		post_effects.clear();
@@ -217,7 +239,12 @@ public:
 	{
 		deltaTime = (float)delta;
 
+		HotReload::Update();	// Swap in any assets that changed on disk
+		TextureStreamer::Update();	// Upload / evict texture mips
+
 		passes[GEOMETRY_PASS]->Update(delta);		// Update the geometry pass
+		AnimSystem::SetViewer(Content::_map->GetCamera()->GetPosition());	// Animation detail is measured from the camera
+		AnimSystem::Update(delta);	// Pose every animated character for this frame
 		//_inv->Update(delta);
 	}
 
@@ -283,6 +310,13 @@ public:
 			glBindTexture(GL_TEXTURE_2D, ((SsaoPass*)passes[SSAO_PASS])->GetFbos()[1]->GetAttachments()[0]->_texture);
 
 			_ibl->Render();
+			if ((GLint)((LightPass*)passes[LIGHT_PASS])->_u_irradiance_sh != -1)	// If the shader evaluates the coefficients...
+				glUniform3fv(((LightPass*)passes[LIGHT_PASS])->_u_irradiance_sh, SH_COEFFICIENTS, _ibl->GetIrradianceSH().Data());
+			else	// Otherwise it still samples the irradiance cubemap
+			{
+				glActiveTexture(GL_TEXTURE10);
+				glBindTexture(GL_TEXTURE_CUBE_MAP, _ibl->GetIrradianceMap());
+			}
 
 			_screen_rect->Render(1); // Render to screen rectangle
 
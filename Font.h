@@ -51,6 +51,8 @@ struct Font : public Object
 
 				std::string index = std::to_string(i);	// Convert i to string
 				_bitmaps[_bitmaps.size() - 1]->_u_texture = glGetUniformLocation(shader_program, ("font[" + index + "]").c_str());	// Get each font texture uniform location
+				_bitmaps[_bitmaps.size() - 1]->_u_rect = glGetUniformLocation(shader_program, ("font_rect[" + index + "]").c_str());		// Get each font region uniform location
+				_bitmaps[_bitmaps.size() - 1]->_u_layer = glGetUniformLocation(shader_program, ("font_layer[" + index + "]").c_str());	// Get each font layer uniform location
 			}
 		}
 		else
@@ -66,9 +68,10 @@ struct Font : public Object
 	// Bind the specific font style atlas
 	inline void Bind(float style)
 	{
-		glUniform1i(_bitmaps[(unsigned int)style]->_u_texture, 0);	// Bind the texture uniform
-		glActiveTexture(GL_TEXTURE0 + (unsigned int)style);	// Assign texture type
-		glBindTexture(GL_TEXTURE_2D, _bitmaps[(unsigned int)style]->_texture_id);		// Bind the texture ID
+		BitmapAtlas* bitmap = _bitmaps[(unsigned int)style];	// The style's bitmap
+		SpriteAtlas* atlas = SpriteAtlas::Get(SPRITE_ATLAS_FONTS);	// Every style lives in the font atlas
+		glUniform1i(bitmap->_u_texture, 0);		// Bind the texture uniform
+		atlas->Use(bitmap->_region, 0, bitmap->_u_rect, bitmap->_u_layer);	// Point the style at its region
 	}
 };
 
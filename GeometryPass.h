@@ -68,7 +68,7 @@ public:
 		Content::_map->AddActor(new Camera(_shader_programs[0], glm::vec3(0.0f, 5.0f, 0.0f),
 			CAMERA_FOV, CAMERA_SPEED, CAMERA_LOOK_SENSITIVITY, CAMERA_NEAR, CAMERA_FAR, GetUpdatedAspectRatio()), CAMERA);
 
-		_anim_mesh = new AnimMesh(_shader_programs[0], "Bob_Idle", "walking");
+		_anim_mesh = new AnimMesh(_shader_programs[0], "Bob_Idle", "walking");
 
 		TextureCache::Initialise();
 
@@ -95,6 +95,21 @@ public:
 		//_mover->addPath(keyframes2, rotations);
 	}
 
+	// Locates the geometry uniforms again after a reload relinks the program: ours, then those cached by
+	// everything drawn with it (the map's actors, the animated mesh and the materials)
+	inline void GetUniforms()
+	{
+		_u_camera_pos = glGetUniformLocation(_shader_programs[0], "camera_pos");
+		_u_selection_colour = glGetUniformLocation(_shader_programs[0], "selection_colour");
+		_u_wire_mode = glGetUniformLocation(_shader_programs[0], "wire_mode");
+
+		for (Actor* a : Content::_map->GetActors())		// For each actor in the map (the camera included)...
+			a->GetUniforms(_shader_programs[0]);	// Refresh its locations
+		_anim_mesh->GetUniforms(_shader_programs[0]);	// And the animated mesh
+		for (Material* m : Content::_materials)		// For each material...
+			m->GetUniforms(_shader_programs[0]);	// Refresh its map locations
+	}
+
 	inline bool &IsWireMode() { return _wire_mode; }	// Return the current polygon mode
 	inline void SetWireMode(bool value) { _wire_mode = value; }		// Set the current polygon mode
 
@@ -147,7 +162,11 @@ public:
 
 				
 				glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);	// Assign current polygon mode
+				TextureStreamer::SetDrawSize(TextureStreamer::ProjectedSize(Content::_map->GetCamera()->GetProjectionMatrix(),
+					Content::_map->GetCamera()->GetViewMatrix(), a->GetPosition(),
+					std::max(glm::length(a->GetRadius() * a->GetScale()), 1.0f), (float)_vp_height));	// Stream textures for its size on screen
 				/*if (obj_visible)*/ a->Render();
+				TextureStreamer::SetDrawSize(TEXTURE_STREAM_FULL_SIZE);		// Other draws get full detail
 
 				glEnable(GL_CULL_FACE);
 				glEnable(GL_DEPTH_TEST);	// Enable depth tests
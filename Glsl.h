@@ -8,6 +8,9 @@
 #include <vector>	// Vector for dynamic arays
 #include <fstream>	// FStream for opening shader files
 #include <sstream>	// SStream for converting file contents to a string
+#include <functional>	// Callbacks run after a reload relinks
+#include "HotReload.h"	// Recompile programs when their files change
+#include "Vfs.h"	// Read shaders through the content archive
 
 
 // This class will contain the key data for creating a shader attachment
@@ -18,6 +21,7 @@ protected:
 	GLuint				_shader;	// This is the shader identifier
 	GLint				_result;	// Our result for compiling
 	std::string			_glsl_code;	// Our glsl context from file
+	std::string			_file;	// The file the source came from
 
 public:
 	// Default constructor
@@ -32,34 +36,37 @@ public:
 
 	inline unsigned int GetType() { return _type; }		// Return the shader type
 	inline GLuint GetShader() { return _shader; }	// Return the shader handle
+	inline const std::string &GetFile() { return _file; }	// Return the source file
+
+	// Reads a glsl file into 'out_code', returns false if it can't be read
+	static inline bool ReadSource(const GLchar* file, std::string &out_code)
+	{
+		return Vfs::ReadText(file, out_code);	// Read the whole file through the content archive
+	}
 
 	// A create function to form a shader
 	inline void Create(GLuint &program, const GLchar* file, GLuint type)
 	{
 		_type = type;	// Assign the shader type
+		_file = file;	// Remember the file for reloading
 
-		std::ifstream		_file;		// Our glsl file
-		std::stringstream	_stream;	// For assigning our file contents
-
-		_file.exceptions(std::ifstream::badbit);	// If the file successfully opened...
-		try		// Attempt...
-		{
-			_file.open(file);	// Open the shader file
-			_stream << _file.rdbuf();	// Read the file's buffer contents into a stream
-			_file.close();	// Close the file now that we've consumed the data
-			_glsl_code = _stream.str();		// Convert the stream into a string
-		}
-		catch (std::ifstream::failure e)	// Otherwise...
+		if (!ReadSource(file, _glsl_code))	// If the file can't be read...
 		{
 			std::cout << "Shader Error: File was unsuccessfully read!\n"; // Call an error message
 			return;		// Return out of this function
 		}
 
-		const GLchar* final_glsl_code = _glsl_code.c_str();	// Convert string into OpenGL const char format
+		Compile(_glsl_code);	// Compile the source
+	}
+
+	// Compiles glsl source into a new shader object, returns false on compile errors
+	inline bool Compile(const std::string &glsl_code)
+	{
+		const GLchar* final_glsl_code = glsl_code.c_str();	// Convert string into OpenGL const char format
 
 		GLchar log[512];	// Create a buffer for debugging glsl error information
 
-		_shader = glCreateShader(type);		// Create our OpenGL shader as VERTEX
+		_shader = glCreateShader(_type);	// Create our OpenGL shader as VERTEX
 		glShaderSource(_shader, 1, &final_glsl_code, NULL);		// Feed OpenGL our glsl source code
 		glCompileShader(_shader);	// Compile our shader
 
@@ -67,9 +74,12 @@ public:
 		if (!_result)	// If it failed to compile...
 		{
 			glGetShaderInfoLog(_shader, 512, NULL, log);	// Get the error information from OpenGL end
-			std::cout << "Shader Error: Shader attachment failed to compile!\n" << log << std::endl;	// Print our the error information
-			return;		// Return out of this function
+			std::cout << "Shader Error: Shader attachment failed to compile!\n" << _file << "\n" << log << std::endl;	// Print our the error information
+			return false;	// Return out of this function
 		}
+
+		_glsl_code = glsl_code;		// Keep the source that compiled
+		return true;	// Return success
 	}
 };
 
@@ -81,6 +91,115 @@ private:
 	GLint							_result;	// Our result for linking
 	GLuint							_program;	// Our shader program handler
 	std::vector<ShaderAttachment>	_attachments;	// This list will contain our shader attachments
+	std::vector<std::function<void()>>	_on_relink;		// Run after a reload relinks
+
+	// A uniform's value read back from the program, so a relink can restore it
+	struct UniformValue
+	{
+		std::string				name;	// Looked up again after the relink
+		GLenum					type;	// The GLSL type
+		std::vector<GLint>		ints;	// Integer, boolean and sampler components
+		std::vector<GLfloat>	floats;		// Float components
+	};
+
+	// Returns how many components a uniform type has and whether they're integers (0 for types that aren't restored)
+	static inline int Components(GLenum type, bool &integer)
+	{
+		integer = false;
+		switch (type)
+		{
+		case GL_FLOAT: return 1;
+		case GL_FLOAT_VEC2: return 2;
+		case GL_FLOAT_VEC3: return 3;
+		case GL_FLOAT_VEC4: return 4;
+		case GL_FLOAT_MAT3: return 9;
+		case GL_FLOAT_MAT4: return 16;
+		default: break;
+		}
+		integer = true;
+		switch (type)
+		{
+		case GL_INT: case GL_BOOL: return 1;
+		case GL_INT_VEC2: case GL_BOOL_VEC2: return 2;
+		case GL_INT_VEC3: case GL_BOOL_VEC3: return 3;
+		case GL_INT_VEC4: case GL_BOOL_VEC4: return 4;
+		case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE: case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW: case GL_SAMPLER_BUFFER:
+		case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_RECT: return 1;	// Samplers hold their texture unit
+		default: return 0;
+		}
+	}
+
+	// Reads back every plain uniform of the program (uniform block members live in buffers and aren't touched)
+	inline std::vector<UniformValue> SaveUniforms()
+	{
+		std::vector<UniformValue> values;	// What was set
+		GLint count = 0;	// Active uniforms
+		glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &count);
+		for (GLint u = 0; u < count; u++)	// For each uniform...
+		{
+			GLchar name[256];	// Its name
+			GLsizei length = 0;
+			GLint size = 0;		// Array length
+			GLenum type = 0;
+			glGetActiveUniform(_program, (GLuint)u, sizeof(name), &length, &size, &type, name);
+			bool integer;
+			int components = Components(type, integer);
+			if (!components)	// If it's a type we don't restore...
+				continue;
+
+			std::string base(name, length);		// Arrays are reported as their first element
+			if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+				base.resize(base.size() - 3);
+			for (GLint e = 0; e < size; e++)	// For each element...
+			{
+				UniformValue value;
+				value.name = size > 1 ? base + "[" + std::to_string(e) + "]" : base;
+				value.type = type;
+				GLint location = glGetUniformLocation(_program, value.name.c_str());
+				if (location < 0)	// Block members have no location
+					break;
+				if (integer)
+				{
+					value.ints.resize(components);
+					glGetUniformiv(_program, location, value.ints.data());
+				}
+				else
+				{
+					value.floats.resize(components);
+					glGetUniformfv(_program, location, value.floats.data());
+				}
+				values.push_back(value);
+			}
+		}
+		return values;	// Return them
+	}
+
+	// Sets saved uniforms again by name on the bound program (ones the edit removed are skipped)
+	inline void RestoreUniforms(const std::vector<UniformValue> &values)
+	{
+		for (size_t i = 0; i < values.size(); i++)	// For each saved uniform...
+		{
+			const UniformValue &v = values[i];
+			GLint location = glGetUniformLocation(_program, v.name.c_str());	// It may have moved
+			if (location < 0)	// If the edit removed it...
+				continue;
+			switch (v.ints.empty() ? (int)v.floats.size() : -(int)v.ints.size())
+			{
+			case 1: glUniform1fv(location, 1, v.floats.data()); break;
+			case 2: glUniform2fv(location, 1, v.floats.data()); break;
+			case 3: glUniform3fv(location, 1, v.floats.data()); break;
+			case 4: glUniform4fv(location, 1, v.floats.data()); break;
+			case 9: glUniformMatrix3fv(location, 1, GL_FALSE, v.floats.data()); break;
+			case 16: glUniformMatrix4fv(location, 1, GL_FALSE, v.floats.data()); break;
+			case -1: glUniform1iv(location, 1, v.ints.data()); break;
+			case -2: glUniform2iv(location, 1, v.ints.data()); break;
+			case -3: glUniform3iv(location, 1, v.ints.data()); break;
+			case -4: glUniform4iv(location, 1, v.ints.data()); break;
+			default: break;
+			}
+		}
+	}
 
 public:
 	// Our default constructor
@@ -98,6 +217,7 @@ public:
 	// The deconstructor will delete our shader program
 	inline ~ShaderProgram()
 	{
+		HotReload::Unwatch(this);	// Stop watching our files
 		glDeleteProgram(_program);	// Delete our shader program to save memory leakage
 	}
 
@@ -144,6 +264,100 @@ public:
 		return true;
 	}
 
+	// Registers a function to run after Reload relinks, with the program bound. Linking may move uniform locations,
+	// so owners that cached locations re-query them here
+	inline void OnRelink(std::function<void()> callback) { _on_relink.push_back(callback); }
+
+	// Replaces the attachments' source and relinks. Everything is compiled and test linked first, so a broken edit
+	// keeps the current program running. The program id is kept, but linking resets every uniform to zero (sampler
+	// units included) and GL doesn't promise the locations survive: the values set by the owners are read back by
+	// name before the relink and set again after it, and the OnRelink callbacks then refresh any cached locations
+	inline bool Reload(const std::vector<std::string> &sources)
+	{
+		if (sources.size() != _attachments.size())		// If the sources don't match our attachments...
+			return false;	// Return false as failed
+
+		std::vector<ShaderAttachment> attachments = _attachments;	// The new attachments
+		bool compiled = true;	// Whether everything compiled
+		for (size_t i = 0; i < attachments.size(); i++)		// For each attachment...
+			compiled = attachments[i].Compile(sources[i]) && compiled;	// Compile the new source
+
+		GLuint test = glCreateProgram();	// A scratch program to validate the link
+		for (size_t i = 0; compiled && i < attachments.size(); i++)		// For each new shader...
+			glAttachShader(test, attachments[i].GetShader());	// Attach it
+		if (compiled)	// If everything compiled...
+		{
+			glLinkProgram(test);	// Link it
+			glGetProgramiv(test, GL_LINK_STATUS, &_result);		// Check the result
+		}
+		for (size_t i = 0; compiled && i < attachments.size(); i++)		// For each new shader...
+			glDetachShader(test, attachments[i].GetShader());	// Detach it again
+		glDeleteProgram(test);	// Delete the scratch program
+
+		if (!compiled || !_result)	// If the edit is broken...
+		{
+			for (size_t i = 0; i < attachments.size(); i++)		// For each new shader...
+				glDeleteShader(attachments[i].GetShader());		// Delete it
+			std::cout << "Shader Program Error: Reload failed, keeping the previous program!\n";		// Print error message
+			return false;	// Return false as failed
+		}
+
+		std::vector<UniformValue> values = SaveUniforms();	// Read back what the owners set
+
+		GLuint old_shaders[MAX_SHADER_ATTACHMENTS + 1];		// The currently attached shaders
+		GLsizei num_old = 0;	// Their count
+		glGetAttachedShaders(_program, MAX_SHADER_ATTACHMENTS + 1, &num_old, old_shaders);	// Find them
+		for (GLsizei i = 0; i < num_old; i++)	// For each old shader...
+			glDetachShader(_program, old_shaders[i]);	// Detach it (they were already flagged for deletion)
+
+		_attachments = attachments;		// Swap the attachments in
+		for (size_t i = 0; i < _attachments.size(); i++)	// For each new shader...
+			glAttachShader(_program, _attachments[i].GetShader());	// Attach it to the live program
+		glLinkProgram(_program);	// Relink in place
+		glGetProgramiv(_program, GL_LINK_STATUS, &_result);		// Check the result
+
+		for (size_t i = 0; i < _attachments.size(); i++)	// For each new shader...
+			glDeleteShader(_attachments[i].GetShader());	// Flag it for deletion with the program
+		if (!_result)	// If the relink failed after all...
+		{
+			std::cout << "Shader Program Error: Failed to relink program!\n";	// Print error message
+			return false;	// Return false as failed
+		}
+
+		GLint previous = 0;		// The program bound by the caller
+		glGetIntegerv(GL_CURRENT_PROGRAM, &previous);
+		glUseProgram(_program);		// Uniforms are set on the bound program
+		RestoreUniforms(values);	// Put the owners' values back
+		for (size_t i = 0; i < _on_relink.size(); i++)	// For each owner...
+			_on_relink[i]();	// Let it refresh its locations
+		glUseProgram((GLuint)previous);		// Rebind the caller's program
+
+		return true;	// Return success
+	}
+
+	// Recompiles this program whenever one of its files changes
+	inline void WatchFiles()
+	{
+		std::vector<std::string> files;		// The source files in attachment order
+		for (size_t i = 0; i < _attachments.size(); i++)	// For each attachment...
+			files.push_back(_attachments[i].GetFile());		// Record its file
+
+		HotReload::Unwatch(this);	// Replace any previous registration
+		for (size_t i = 0; i < files.size(); i++)	// For each file...
+		{
+			ShaderProgram* program = this;	// The program to reload
+			HotReload::Watch(files[i], this, [program, files]() -> HotReload::Apply
+			{
+				std::vector<std::string> sources(files.size());		// All sources, since the program is relinked as a whole
+				for (size_t f = 0; f < files.size(); f++)	// For each file...
+					if (!ShaderAttachment::ReadSource(files[f].c_str(), sources[f]))	// If it can't be read...
+						return HotReload::Apply();	// Skip this change
+
+				return [program, sources]() { program->Reload(sources); };	// Compile and link on the main thread
+			});
+		}
+	}
+
 	inline void UseProgram() { glUseProgram(_program); }	// Bind our program (ATTACHMENTS MUST BE LINKED!)
 	inline void DetachProgram() { glUseProgram(0); }	// Unbind our program
 };
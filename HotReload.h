@@ -0,0 +1,313 @@
+#ifndef __HOT_RELOAD_H__
+#define __HOT_RELOAD_H__
+
+#include <iostream>		// Get error output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <map>	// Get path lookups
+#include <functional>	// Get std::function
+#include <thread>	// Get the worker thread
+#include <mutex>	// Get mutex
+#include <condition_variable>	// Wait for a running loader in Unwatch
+#include <atomic>	// Get atomic flags
+#include <chrono>	// Get clocks
+#include "Archive.h"	// Normalise paths the way the archives do
+
+#ifdef __linux__
+#include <sys/inotify.h>	// Get inotify
+#include <poll.h>	// Get poll
+#include <unistd.h>		// Get read / close
+#else
+#include <filesystem>	// Get last_write_time for the polling fallback
+#endif
+
+#define HOT_RELOAD_POLL_MS		50	// How long the worker waits for file events before checking for settled changes
+#define HOT_RELOAD_SETTLE_MS	150	// A file must be quiet this long before it is re-imported (editors save in several writes)
+
+// Reports files that changed on disk. Linux uses inotify on the directory of every watched file,
+// other platforms fall back to polling the modification time of the watched files themselves
+class FileWatcher
+{
+private:
+	std::mutex								_mutex;		// Guards the tables below (files are added from the main thread)
+#ifdef __linux__
+	int										_fd;	// The inotify instance
+	std::map<int, std::string>				_dirs;	// Watch descriptor -> directory
+	std::map<std::string, int>				_dir_wds;	// Directory -> watch descriptor
+#else
+	std::map<std::string, std::filesystem::file_time_type>	_times;		// File -> last seen modification time
+#endif
+
+public:
+#ifdef __linux__
+	inline FileWatcher() { _fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC); }	// Create the inotify instance
+	inline ~FileWatcher() { if (_fd >= 0) close(_fd); }		// Release it
+#else
+	inline FileWatcher() {}
+	inline ~FileWatcher() {}
+#endif
+
+	// Starts reporting changes to 'path'
+	inline void AddFile(const std::string &path)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);	// Lock the tables
+#ifdef __linux__
+		size_t slash = path.find_last_of('/');	// Split off the directory
+		std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);		// The directory
+		if (_fd < 0 || _dir_wds.count(dir))		// If we can't watch or already watch it...
+			return;		// Return as normal
+
+		int wd = inotify_add_watch(_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);	// Whole writes and atomic renames
+		if (wd < 0)		// If the watch failed...
+		{
+			std::cout << "Hot Reload Error: Failed to watch '" << dir << "'!\n";	// Print out error message
+			return;		// Return
+		}
+		_dirs[wd] = dir;	// Map the descriptor
+		_dir_wds[dir] = wd;		// Map the directory
+#else
+		std::error_code ec;		// Missing files are simply reported when they appear
+		_times[path] = std::filesystem::last_write_time(path, ec);	// Record the current time
+#endif
+	}
+
+	// Waits up to 'timeout_ms' and appends the paths that changed to 'out'
+	inline void Poll(int timeout_ms, std::vector<std::string> &out)
+	{
+#ifdef __linux__
+		if (_fd < 0)	// If inotify isn't available...
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));		// Just wait
+			return;		// Return as normal
+		}
+
+		pollfd pfd = { _fd, POLLIN, 0 };	// Wait for events
+		if (poll(&pfd, 1, timeout_ms) <= 0)		// If nothing happened...
+			return;		// Return as normal
+
+		alignas(inotify_event) char buffer[16384];	// Event buffer
+		ssize_t length;		// Bytes read
+		while ((length = read(_fd, buffer, sizeof(buffer))) > 0)	// While there are events...
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the tables
+			for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+			{
+				const inotify_event* e = (const inotify_event*)p;	// The event
+				std::map<int, std::string>::iterator dir = _dirs.find(e->wd);	// Its directory
+				if (e->len && dir != _dirs.end())	// If it names a file in a watched directory...
+					out.push_back(dir->second + "/" + e->name);		// Report it
+			}
+		}
+#else
+		std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));		// Wait between scans
+		std::lock_guard<std::mutex> lock(_mutex);	// Lock the tables
+		for (auto &file : _times)	// For each watched file...
+		{
+			std::error_code ec;		// Ignore missing files
+			std::filesystem::file_time_type t = std::filesystem::last_write_time(file.first, ec);	// Its current time
+			if (!ec && t != file.second)	// If it changed...
+			{
+				file.second = t;	// Remember it
+				out.push_back(file.first);	// Report it
+			}
+		}
+#endif
+	}
+};
+
+// This class re-imports assets when their files change. Objects register a 'prepare' function per file: it runs on
+// the worker thread (file IO, parsing, indexing) and returns an 'apply' function that the main thread runs from Update()
+// to swap the result into the existing object, so everything holding a pointer to it picks up the change.
+// Registrations are owned by an object and must be removed with Unwatch() before it is deleted. Paths are compared
+// after Archive::Normalise, so "Res\\a.obj" and "./Res/a.obj" are the same file
+class HotReload
+{
+public:
+	typedef std::function<void()>	Apply;		// Swaps a prepared result in (main thread, may use GL)
+	typedef std::function<Apply()>	Prepare;	// Loads a changed file (worker thread, must not use GL)
+
+private:
+	// A file registration
+	struct Entry
+	{
+		unsigned int	id;		// Unique registration id
+		const void*		owner;	// The object the registration belongs to
+		std::string		path;	// The normalised file path
+		Prepare			prepare;	// The loader
+	};
+
+	typedef std::chrono::steady_clock Clock;	// The debounce clock
+
+	static std::mutex								_mutex;		// Guards everything below
+	static std::vector<Entry>						_entries;	// All registrations
+	static std::condition_variable					_idle;		// Signalled when a loader finishes
+	static const void*								_busy;		// The owner whose loader is running, if any
+	static std::vector<std::pair<unsigned int, Apply>>	_ready;		// Prepared results waiting for the main thread
+	static std::map<std::string, Clock::time_point>	_pending;	// Changed files waiting to settle
+	static unsigned int								_next_id;	// The next registration id
+	static FileWatcher*								_watcher;	// The file watcher
+	static std::thread								_worker;	// The worker thread
+	static std::atomic<bool>						_running;	// Whether the worker should keep going
+
+	// The worker loop: collect events, wait for files to settle, then run their loaders
+	static inline void Run()
+	{
+		std::vector<std::string> changed;	// Paths reported this poll
+		std::vector<Entry> jobs;	// Loaders to run this poll
+
+		while (_running)	// While the service is running...
+		{
+			changed.clear();	// Fresh batch
+			_watcher->Poll(HOT_RELOAD_POLL_MS, changed);	// Wait for events
+
+			Clock::time_point now = Clock::now();	// The current time
+			jobs.clear();	// Fresh jobs
+			{
+				std::lock_guard<std::mutex> lock(_mutex);	// Lock the registry
+				for (const std::string &path : changed)		// For each event...
+					_pending[Archive::Normalise(path)] = now;	// (Re)start its settle timer
+
+				for (std::map<std::string, Clock::time_point>::iterator it = _pending.begin(); it != _pending.end();)
+				{
+					if (now - it->second < std::chrono::milliseconds(HOT_RELOAD_SETTLE_MS))		// If it's still being written...
+					{
+						++it;	// Check it next time
+						continue;
+					}
+
+					for (const Entry &e : _entries)		// For each registration...
+						if (e.path == it->first)	// If it's for this file...
+							jobs.push_back(e);	// Queue its loader
+					it = _pending.erase(it);	// The file is handled
+				}
+			}
+
+			for (Entry &job : jobs)		// For each loader (run outside the lock)...
+			{
+				{
+					std::lock_guard<std::mutex> lock(_mutex);	// Lock the registry
+					bool alive = false;		// Whether it's still registered
+					for (const Entry &e : _entries)		// Check the registry...
+						if (e.id == job.id) { alive = true; break; }
+					if (!alive)		// If its owner was unwatched since the poll...
+						continue;	// The loader may point at a deleted object
+					_busy = job.owner;	// Unwatch waits for us while we use it
+				}
+
+				Apply apply = job.prepare();	// Load the file
+
+				std::lock_guard<std::mutex> lock(_mutex);	// Lock the queue
+				_busy = NULL;	// The owner is no longer used
+				if (apply)	// If loading succeeded (otherwise keep the current asset)...
+					_ready.push_back(std::make_pair(job.id, apply));	// Hand it to the main thread
+				_idle.notify_all();		// Wake a waiting Unwatch
+			}
+		}
+	}
+
+public:
+	// Starts the watcher thread
+	static inline void Start()
+	{
+		if (_running)	// If it's already running...
+			return;		// Return as normal
+
+		if (!_watcher)	// If there's no watcher yet...
+			_watcher = new FileWatcher();	// Create it
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the registry
+			for (const Entry &e : _entries)		// For each file registered before starting...
+				_watcher->AddFile(e.path);	// Watch it
+		}
+
+		_running = true;	// Let the worker run
+		_worker = std::thread(Run);		// Start it
+	}
+
+	// Stops the watcher thread and drops any results that weren't applied
+	static inline void Stop()
+	{
+		if (!_running)	// If it isn't running...
+			return;		// Return as normal
+
+		_running = false;	// Ask the worker to finish
+		_worker.join();		// Wait for it
+
+		std::lock_guard<std::mutex> lock(_mutex);	// Lock the queue
+		_ready.clear();		// Drop pending results
+		_pending.clear();	// Drop pending files
+	}
+
+	// Registers a loader for 'path' owned by 'owner'
+	static inline void Watch(const std::string &path, const void* owner, Prepare prepare)
+	{
+		Entry e;	// The registration
+		e.owner = owner;	// Assign owner
+		e.path = Archive::Normalise(path);	// Assign path
+		e.prepare = prepare;	// Assign loader
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the registry
+			e.id = _next_id++;	// Assign id
+			_entries.push_back(e);	// Store it
+		}
+
+		if (_watcher)	// If the service has started...
+			_watcher->AddFile(e.path);	// Watch the file now
+	}
+
+	// Removes every registration of 'owner' (call before deleting it). If one of its loaders is running on the
+	// worker this waits for it to finish, so nothing touches the owner once it returns (the result is dropped)
+	static inline void Unwatch(const void* owner)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);	// Lock the registry
+		for (size_t i = 0; i < _entries.size();)	// For each registration...
+		{
+			if (_entries[i].owner == owner)		// If it belongs to the owner...
+				_entries.erase(_entries.begin() + i);	// Remove it
+			else
+				i++;	// Next
+		}
+		_idle.wait(lock, [owner]() { return _busy != owner; });		// Wait out a running loader
+	}
+
+	// Applies every prepared result, call once per frame from the thread that owns the GL context
+	static inline void Update()
+	{
+		std::vector<std::pair<unsigned int, Apply>> ready;	// The results to apply
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the queue
+			if (_ready.empty())		// If nothing changed...
+				return;		// Return as normal
+			ready.swap(_ready);		// Take the results
+
+			for (size_t r = 0; r < ready.size(); r++)	// For each result...
+			{
+				bool alive = false;		// Whether its owner still exists
+				for (const Entry &e : _entries)		// Check the registry...
+					if (e.id == ready[r].first) { alive = true; break; }
+				if (!alive)		// If it was unwatched in the meantime...
+					ready[r].second = Apply();	// Drop it
+			}
+		}
+
+		for (std::pair<unsigned int, Apply> &r : ready)		// For each live result...
+			if (r.second)
+				r.second();		// Swap it in
+	}
+};
+
+// Static definitions
+std::mutex										HotReload::_mutex;
+std::vector<HotReload::Entry>					HotReload::_entries;
+std::condition_variable							HotReload::_idle;
+const void*										HotReload::_busy = NULL;
+std::vector<std::pair<unsigned int, HotReload::Apply>>	HotReload::_ready;
+std::map<std::string, HotReload::Clock::time_point>	HotReload::_pending;
+unsigned int									HotReload::_next_id = 1;
+FileWatcher*									HotReload::_watcher = NULL;
+std::thread										HotReload::_worker;
+std::atomic<bool>								HotReload::_running(false);
+
+#endif
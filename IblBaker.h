@@ -0,0 +1,411 @@
+#ifndef __IBL_BAKER_H__
+#define __IBL_BAKER_H__
+
+#include <iostream>		// Get error / report output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <cmath>	// Get trig / log2
+#include <chrono>	// Time the bake
+#include <filesystem>	// Create the cache directory
+#include <glm/glm.hpp>	// Get vectors
+#include <stb_image.h>	// Decode the hdr
+#include "Vfs.h"	// Read the hdr
+#include "Parallel.h"	// Bake faces in parallel
+#include "TextureCooker.h"	// Write dds files
+#include "SphericalHarmonics.h"	// Project diffuse irradiance
+
+#define IBL_CACHE_URI			"Res/Cache/Ibl/"	// Where baked products live
+#define IBL_VERSION				2	// Bump when the baker changes so old caches are ignored
+#define IBL_ENV_SIZE			512		// Environment cubemap face size
+#define IBL_PREFILTER_SIZE		128		// Prefiltered cubemap face size
+#define IBL_PREFILTER_MIPS		5	// Prefiltered levels (roughness 0 to 1)
+#define IBL_PREFILTER_SAMPLES	1024	// GGX samples per prefiltered texel
+#define IBL_BRDF_SIZE			512		// BRDF LUT width / height
+#define IBL_BRDF_SAMPLES		1024	// Samples per LUT texel
+#define IBL_IRRADIANCE_SIZE		32	// Face size of the irradiance cubemap older lighting shaders sample
+
+// The CPU half of image based lighting. Converts an equirectangular hdr to a cubemap, projects the diffuse
+// irradiance to spherical harmonics, prefilters the specular mips with GGX importance sampling and integrates the
+// split sum BRDF LUT, the same maths the capture shaders run but without a GPU. The products are written next to
+// each other, named after a hash of the hdr's bytes, so an unchanged environment is baked once and loaded from then on
+namespace IblBaker
+{
+	// A float rgb cubemap, 'levels' holds every mip of face 0, then every mip of face 1 and so on (the dds order)
+	struct Cube
+	{
+		uint32_t							size;	// Top level face size
+		uint32_t							mips;	// Levels per face
+		std::vector<std::vector<glm::vec3>>	levels;		// Texels, row major
+
+		inline std::vector<glm::vec3>& Level(uint32_t face, uint32_t mip) { return levels[face * mips + mip]; }
+		inline const std::vector<glm::vec3>& Level(uint32_t face, uint32_t mip) const { return levels[face * mips + mip]; }
+	};
+
+	// The products for one environment
+	struct Products
+	{
+		std::string		environment;	// Environment cubemap dds
+		std::string		irradiance;		// Irradiance SH9 coefficients
+		std::string		prefilter;	// Prefiltered cubemap dds
+		std::string		brdf;	// BRDF LUT dds (independent of the environment)
+	};
+
+	// 64 bit FNV-1a hash of some bytes
+	inline uint64_t Hash(const unsigned char* data, size_t size)
+	{
+		uint64_t h = 14695981039346656037ull ^ IBL_VERSION;	// Offset basis, salted with the version
+		for (size_t i = 0; i < size; i++)	// For each byte...
+			h = (h ^ data[i]) * 1099511628211ull;	// Mix it in
+		return h;	// Return the hash
+	}
+
+	// Names the cached products of an hdr file
+	inline Products GetProducts(uint64_t hash)
+	{
+		char hex[17];	// The hash as text
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+		std::string base = std::string(IBL_CACHE_URI) + hex;	// The common prefix
+		return Products{ base + "_env.dds", base + "_sh9.txt", base + "_prefilter.dds", std::string(IBL_CACHE_URI) + "brdf_v" + std::to_string(IBL_VERSION) + ".dds" };
+	}
+
+	// Converts a float to a half (round to nearest, overflow to infinity)
+	inline uint16_t ToHalf(float f)
+	{
+		uint32_t x;		// The bits
+		std::memcpy(&x, &f, 4);
+		uint32_t sign = (x >> 16) & 0x8000;		// The sign
+		int exponent = (int)((x >> 23) & 0xFF) - 127 + 15;	// The rebiased exponent
+		uint32_t mantissa = x & 0x7FFFFF;	// The mantissa
+
+		if (((x >> 23) & 0xFF) == 0xFF)		// If it's inf / nan...
+			return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+		if (exponent >= 31)		// If it's too big...
+			return (uint16_t)(sign | 0x7C00);	// Infinity
+		if (exponent <= 0)	// If it's denormal...
+		{
+			if (exponent < -10)		// If it's too small...
+				return (uint16_t)sign;	// Zero
+			mantissa |= 0x800000;	// Make the implicit bit explicit
+			uint32_t shift = (uint32_t)(14 - exponent);		// How far to shift it down
+			uint32_t half = (mantissa >> shift) + ((mantissa >> (shift - 1)) & 1);	// Rounded
+			return (uint16_t)(sign | half);
+		}
+		uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);	// Truncated
+		return (uint16_t)(half + ((mantissa >> 12) & 1));	// Rounded (a carry into the exponent is still correct)
+	}
+
+	// The direction through the centre of texel (x, y) of a face, in the GL cubemap convention
+	inline glm::vec3 FaceDirection(uint32_t face, float x, float y, uint32_t size)
+	{
+		float s = 2.0f * (x + 0.5f) / size - 1.0f;	// Face coords in [-1, 1]
+		float t = 2.0f * (y + 0.5f) / size - 1.0f;
+		switch (face)
+		{
+		case 0: return glm::normalize(glm::vec3(1.0f, -t, -s));		// +X
+		case 1: return glm::normalize(glm::vec3(-1.0f, -t, s));		// -X
+		case 2: return glm::normalize(glm::vec3(s, 1.0f, t));	// +Y
+		case 3: return glm::normalize(glm::vec3(s, -1.0f, -t));		// -Y
+		case 4: return glm::normalize(glm::vec3(s, -t, 1.0f));	// +Z
+		default: return glm::normalize(glm::vec3(-s, -t, -1.0f));	// -Z
+		}
+	}
+
+	// The face and face coords ([0, 1]) a direction lands on
+	inline uint32_t DirectionToFace(const glm::vec3 &d, float &u, float &v)
+	{
+		glm::vec3 a = glm::abs(d);	// Absolute components
+		uint32_t face;	// The major axis
+		float s, t, m;	// Face coords / the major component
+		if (a.x >= a.y && a.x >= a.z) { m = a.x; face = d.x > 0.0f ? 0 : 1; s = d.x > 0.0f ? -d.z : d.z; t = -d.y; }
+		else if (a.y >= a.z) { m = a.y; face = d.y > 0.0f ? 2 : 3; s = d.x; t = d.y > 0.0f ? d.z : -d.z; }
+		else { m = a.z; face = d.z > 0.0f ? 4 : 5; s = d.z > 0.0f ? d.x : -d.x; t = -d.y; }
+		u = 0.5f * (s / m + 1.0f);	// To [0, 1]
+		v = 0.5f * (t / m + 1.0f);
+		return face;	// Return the face
+	}
+
+	// Bilinear sample of an rgb image with clamped edges, (u, v) in [0, 1]
+	inline glm::vec3 Bilinear(const glm::vec3* texels, uint32_t width, uint32_t height, float u, float v, bool wrap_u)
+	{
+		float x = u * width - 0.5f, y = v * height - 0.5f;	// Texel space
+		int x0 = (int)std::floor(x), y0 = (int)std::floor(y);	// The top left texel
+		float fx = x - x0, fy = y - y0;		// Weights
+		int x1 = x0 + 1, y1 = std::min(y0 + 1, (int)height - 1);	// The bottom right texel
+		y0 = std::max(y0, 0);
+		if (wrap_u) { x0 = (x0 + (int)width) % (int)width; x1 = x1 % (int)width; }	// Wrap around the seam
+		else { x0 = std::max(x0, 0); x1 = std::min(x1, (int)width - 1); }	// Clamp to the edge
+
+		glm::vec3 top = glm::mix(texels[(size_t)y0 * width + x0], texels[(size_t)y0 * width + x1], fx);
+		glm::vec3 bottom = glm::mix(texels[(size_t)y1 * width + x0], texels[(size_t)y1 * width + x1], fx);
+		return glm::mix(top, bottom, fy);	// Return the blend
+	}
+
+	// Trilinear sample of a cube at a fractional mip
+	inline glm::vec3 SampleCube(const Cube &cube, const glm::vec3 &dir, float mip)
+	{
+		mip = std::min(std::max(mip, 0.0f), (float)(cube.mips - 1));	// Clamp to the chain
+		uint32_t m0 = (uint32_t)mip, m1 = std::min(m0 + 1, cube.mips - 1);	// The levels either side
+		float u, v;		// Face coords
+		uint32_t face = DirectionToFace(dir, u, v);		// The face
+		uint32_t s0 = std::max(cube.size >> m0, 1u), s1 = std::max(cube.size >> m1, 1u);	// Their sizes
+		glm::vec3 a = Bilinear(cube.Level(face, m0).data(), s0, s0, u, v, false);
+		if (m0 == m1) return a;
+		return glm::mix(a, Bilinear(cube.Level(face, m1).data(), s1, s1, u, v, false), mip - m0);	// Return the blend
+	}
+
+	// Box filters the chain below level 0 (what glGenerateMipmap does)
+	inline void BuildMips(Cube &cube)
+	{
+		for (uint32_t f = 0; f < 6; f++)	// For each face...
+			for (uint32_t m = 1; m < cube.mips; m++)	// For each level...
+			{
+				uint32_t src = std::max(cube.size >> (m - 1), 1u), dst = std::max(cube.size >> m, 1u);	// Sizes
+				const std::vector<glm::vec3> &a = cube.Level(f, m - 1);		// The level above
+				std::vector<glm::vec3> &b = cube.Level(f, m);	// This level
+				b.assign((size_t)dst * dst, glm::vec3(0.0f));
+				for (uint32_t y = 0; y < dst; y++)
+					for (uint32_t x = 0; x < dst; x++)
+					{
+						uint32_t x0 = std::min(x * 2, src - 1), x1 = std::min(x * 2 + 1, src - 1);	// The 2x2 footprint
+						uint32_t y0 = std::min(y * 2, src - 1), y1 = std::min(y * 2 + 1, src - 1);
+						b[(size_t)y * dst + x] = 0.25f * (a[(size_t)y0 * src + x0] + a[(size_t)y0 * src + x1] + a[(size_t)y1 * src + x0] + a[(size_t)y1 * src + x1]);
+					}
+			}
+	}
+
+	// Allocates an empty cube
+	inline Cube MakeCube(uint32_t size, uint32_t mips)
+	{
+		Cube cube;	// The result
+		cube.size = size;	// Assign size
+		cube.mips = mips;	// Assign levels
+		cube.levels.resize((size_t)6 * mips);	// One level per face per mip
+		for (uint32_t f = 0; f < 6; f++)
+			for (uint32_t m = 0; m < mips; m++)
+				cube.Level(f, m).resize((size_t)std::max(size >> m, 1u) * std::max(size >> m, 1u));
+		return cube;	// Return it
+	}
+
+	// Projects an equirectangular image onto a cube (the equirectangular capture shader)
+	inline Cube Equirectangular(const float* rgb, uint32_t width, uint32_t height)
+	{
+		std::vector<glm::vec3> texels((size_t)width * height);	// Repack as vec3
+		std::memcpy(texels.data(), rgb, texels.size() * sizeof(glm::vec3));
+
+		Cube cube = MakeCube(IBL_ENV_SIZE, TextureContainer::MaxMips(IBL_ENV_SIZE, IBL_ENV_SIZE));	// The environment
+		Parallel::For(0, 6 * IBL_ENV_SIZE, 16, [&](size_t from, size_t to)	// For each row of each face...
+		{
+			for (size_t r = from; r < to; r++)
+			{
+				uint32_t face = (uint32_t)(r / IBL_ENV_SIZE), y = (uint32_t)(r % IBL_ENV_SIZE);		// The face / row
+				for (uint32_t x = 0; x < IBL_ENV_SIZE; x++)		// For each texel...
+				{
+					glm::vec3 d = FaceDirection(face, (float)x, (float)y, IBL_ENV_SIZE);	// Its direction
+					float u = std::atan2(d.z, d.x) * 0.1591f + 0.5f;	// Spherical coords
+					float v = std::asin(std::min(std::max(d.y, -1.0f), 1.0f)) * 0.3183f + 0.5f;
+					cube.Level(face, 0)[(size_t)y * IBL_ENV_SIZE + x] = Bilinear(texels.data(), width, height, u, v, true);
+				}
+			}
+		});
+		BuildMips(cube);	// Generate the chain
+		return cube;	// Return it
+	}
+
+	// The i'th of n points of the Hammersley set
+	inline glm::vec2 Hammersley(uint32_t i, uint32_t n)
+	{
+		uint32_t bits = i;	// Van der Corput radical inverse
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return glm::vec2((float)i / (float)n, bits * 2.3283064365386963e-10f);	// Return the point
+	}
+
+	// A GGX distributed half vector around +Z
+	inline glm::vec3 ImportanceSampleGGX(const glm::vec2 &xi, float roughness)
+	{
+		float a = roughness * roughness;	// Alpha
+		float phi = 6.28318531f * xi.x;		// Azimuth
+		float cos_theta = std::sqrt((1.0f - xi.y) / (1.0f + (a * a - 1.0f) * xi.y));	// Elevation
+		float sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+		return glm::vec3(std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, cos_theta);	// Return it
+	}
+
+	// GGX prefiltering of the environment (the prefilter shader). Per level the sample set is built once in tangent
+	// space with its weight and source mip, then rotated onto every texel's normal
+	inline Cube Prefilter(const Cube &env)
+	{
+		Cube cube = MakeCube(IBL_PREFILTER_SIZE, IBL_PREFILTER_MIPS);	// The result
+		float texel_angle = 4.0f * 3.14159265f / (6.0f * env.size * env.size);	// Solid angle of an environment texel
+
+		for (uint32_t m = 0; m < IBL_PREFILTER_MIPS; m++)	// For each level...
+		{
+			uint32_t size = std::max((uint32_t)IBL_PREFILTER_SIZE >> m, 1u);	// Its size
+			float roughness = (float)m / (float)(IBL_PREFILTER_MIPS - 1);	// Its roughness
+
+			struct Sample { glm::vec3 l; float weight, mip; };	// A light direction in tangent space
+			std::vector<Sample> samples;	// The set
+			if (m == 0)		// A mirror only sees the environment at its own resolution
+				samples.push_back(Sample{ glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, std::log2((float)env.size / size) });
+			else
+				for (uint32_t i = 0; i < IBL_PREFILTER_SAMPLES; i++)	// For each sample...
+				{
+					glm::vec3 h = ImportanceSampleGGX(Hammersley(i, IBL_PREFILTER_SAMPLES), roughness);		// The half vector (N = V = +Z)
+					glm::vec3 l = 2.0f * h.z * h - glm::vec3(0.0f, 0.0f, 1.0f);		// Reflect V about it
+					if (l.z <= 0.0f) continue;	// Below the horizon
+
+					float a2 = roughness * roughness * roughness * roughness;	// Alpha squared
+					float denom = h.z * h.z * (a2 - 1.0f) + 1.0f;
+					float d = a2 / (3.14159265f * denom * denom);	// GGX D
+					float pdf = d * h.z / (4.0f * h.z) + 0.0001f;	// N = V so NdotH == HdotV
+					float sample_angle = 1.0f / (IBL_PREFILTER_SAMPLES * pdf + 0.0001f);	// Solid angle of this sample
+					samples.push_back(Sample{ l, l.z, std::max(0.5f * std::log2(sample_angle / texel_angle), 0.0f) });		// Fetch from the matching mip
+				}
+
+			float total = 0.0f;		// Sum of the weights
+			for (const Sample &s : samples) total += s.weight;
+
+			Parallel::For(0, 6 * size, 1, [&](size_t from, size_t to)	// For each row of each face...
+			{
+				for (size_t r = from; r < to; r++)
+				{
+					uint32_t face = (uint32_t)(r / size), y = (uint32_t)(r % size);		// The face / row
+					for (uint32_t x = 0; x < size; x++)		// For each texel...
+					{
+						glm::vec3 n = FaceDirection(face, (float)x, (float)y, size);	// The normal
+						glm::vec3 up = std::abs(n.z) < 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);		// Tangent frame
+						glm::vec3 tx = glm::normalize(glm::cross(up, n)), ty = glm::cross(n, tx);
+
+						glm::vec3 sum(0.0f);	// The filtered radiance
+						for (const Sample &s : samples)		// For each sample...
+							sum += SampleCube(env, tx * s.l.x + ty * s.l.y + n * s.l.z, s.mip) * s.weight;
+						cube.Level(face, m)[(size_t)y * size + x] = sum / total;
+					}
+				}
+			});
+		}
+		return cube;	// Return it
+	}
+
+	// The GGX half vectors for one roughness, shared by every view angle of a LUT row
+	inline std::vector<glm::vec3> HalfVectors(float roughness, uint32_t count)
+	{
+		std::vector<glm::vec3> halves(count);	// The set
+		for (uint32_t i = 0; i < count; i++)
+			halves[i] = ImportanceSampleGGX(Hammersley(i, count), roughness);
+		return halves;	// Return it
+	}
+
+	// The split sum BRDF scale / bias for a view angle and roughness (the brdf shader)
+	inline glm::vec2 IntegrateBRDF(float n_dot_v, float roughness, const std::vector<glm::vec3> &halves)
+	{
+		glm::vec3 v(std::sqrt(1.0f - n_dot_v * n_dot_v), 0.0f, n_dot_v);	// The view vector (N = +Z)
+		float k = roughness * roughness / 2.0f;		// Schlick-GGX k for IBL
+		float a = 0.0f, b = 0.0f;	// Scale / bias
+
+		for (const glm::vec3 &h : halves)	// For each half vector...
+		{
+			glm::vec3 l = 2.0f * glm::dot(v, h) * h - v;	// The light vector
+			float n_dot_l = std::max(l.z, 0.0f), n_dot_h = std::max(h.z, 0.0f), v_dot_h = std::max(glm::dot(v, h), 0.0f);
+			if (n_dot_l <= 0.0f) continue;	// Below the horizon
+
+			float g = (n_dot_v / (n_dot_v * (1.0f - k) + k)) * (n_dot_l / (n_dot_l * (1.0f - k) + k));	// Smith G
+			float g_vis = g * v_dot_h / (n_dot_h * n_dot_v);
+			float f1 = 1.0f - v_dot_h, f2 = f1 * f1, fc = f2 * f2 * f1;		// Fresnel term
+			a += (1.0f - fc) * g_vis;
+			b += fc * g_vis;
+		}
+		return glm::vec2(a, b) / (float)halves.size();	// Return the average
+	}
+
+	// Half float rgba of a cube's levels, in dds order
+	inline std::vector<std::vector<uint8_t>> ToHalfLevels(const Cube &cube)
+	{
+		std::vector<std::vector<uint8_t>> out(cube.levels.size());	// The result
+		for (size_t i = 0; i < cube.levels.size(); i++)		// For each level...
+		{
+			out[i].resize(cube.levels[i].size() * 8);	// Four halves per texel
+			uint16_t* dst = (uint16_t*)out[i].data();
+			for (size_t t = 0; t < cube.levels[i].size(); t++)
+			{
+				dst[t * 4 + 0] = ToHalf(cube.levels[i][t].x);
+				dst[t * 4 + 1] = ToHalf(cube.levels[i][t].y);
+				dst[t * 4 + 2] = ToHalf(cube.levels[i][t].z);
+				dst[t * 4 + 3] = 0x3C00;	// Alpha 1
+			}
+		}
+		return out;		// Return it
+	}
+
+	// Bakes the BRDF LUT to 'uri' (rg in a half float rgba texture, roughness increases with the row)
+	inline bool BakeBRDF(const std::string &uri)
+	{
+		std::vector<std::vector<uint8_t>> level(1, std::vector<uint8_t>((size_t)IBL_BRDF_SIZE * IBL_BRDF_SIZE * 8));	// The LUT
+		uint16_t* dst = (uint16_t*)level[0].data();
+		Parallel::For(0, IBL_BRDF_SIZE, 4, [&](size_t from, size_t to)	// For each row...
+		{
+			for (size_t y = from; y < to; y++)
+			{
+				float roughness = (y + 0.5f) / IBL_BRDF_SIZE;	// The row's roughness
+				std::vector<glm::vec3> halves = HalfVectors(roughness, IBL_BRDF_SAMPLES);	// Its samples
+				for (uint32_t x = 0; x < IBL_BRDF_SIZE; x++)	// For each texel...
+				{
+					glm::vec2 ab = IntegrateBRDF((x + 0.5f) / IBL_BRDF_SIZE, roughness, halves);	// Integrate it
+					uint16_t* t = dst + (y * IBL_BRDF_SIZE + x) * 4;
+					t[0] = ToHalf(ab.x); t[1] = ToHalf(ab.y); t[2] = 0; t[3] = 0x3C00;
+				}
+			}
+		});
+		return TextureCooker::WriteDds(uri, TextureContainer::FORMAT_RGBA16F, IBL_BRDF_SIZE, IBL_BRDF_SIZE, level);	// Write it
+	}
+
+	// Bakes every product of 'hdr' that isn't cached yet, returns their files (empty names on failure)
+	inline Products Bake(const std::string &hdr)
+	{
+		VfsFile file;	// The hdr
+		if (!Vfs::Open(hdr, file))	// If it can't be read...
+		{
+			std::cout << "IBL Error: Failed to open '" << hdr << "'!\n";	// Print out error message
+			return Products();	// Return nothing
+		}
+
+		Products products = GetProducts(Hash(file.Data(), file.Size()));	// Where they go
+		std::error_code ec;		// Ignore 'already exists'
+		std::filesystem::create_directories(IBL_CACHE_URI, ec);		// Make sure the cache exists
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();		// Time the bake
+		bool ok = true, baked = false;	// Whether everything was written / anything was missing
+		if (!Vfs::Exists(products.brdf))	// If the LUT hasn't been baked...
+		{
+			ok &= BakeBRDF(products.brdf);	// Bake it
+			baked = true;
+		}
+
+		if (!Vfs::Exists(products.environment) || !Vfs::Exists(products.irradiance) || !Vfs::Exists(products.prefilter))	// If the environment hasn't been baked...
+		{
+			int w, h, c;	// The hdr size
+			float* rgb = stbi_loadf_from_memory(file.Data(), (int)file.Size(), &w, &h, &c, 3);		// Decode it as rgb
+			if (!rgb)	// If it failed...
+			{
+				std::cout << "IBL Error: Failed to decode '" << hdr << "'!\n";	// Print out error message
+				return Products();	// Return nothing
+			}
+			Cube env = Equirectangular(rgb, (uint32_t)w, (uint32_t)h);		// Project it
+			SphericalHarmonics::SH9 sh = SphericalHarmonics::ToIrradiance(SphericalHarmonics::ProjectEquirectangular(rgb, (uint32_t)w, (uint32_t)h));	// And its diffuse light
+			stbi_image_free(rgb);	// Free the pixels
+
+			ok &= TextureCooker::WriteDds(products.environment, TextureContainer::FORMAT_RGBA16F, env.size, env.size, ToHalfLevels(env), 1, true);
+			ok &= SphericalHarmonics::Save(products.irradiance, sh);
+			ok &= TextureCooker::WriteDds(products.prefilter, TextureContainer::FORMAT_RGBA16F, IBL_PREFILTER_SIZE, IBL_PREFILTER_SIZE, ToHalfLevels(Prefilter(env)), 1, true);
+			baked = true;
+		}
+
+		if (baked)	// If anything was baked...
+			std::cout << "IBL: Baked '" << hdr << "' in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s\n";	// Report it
+		return ok ? products : Products();	// Return the files
+	}
+}
+
+#endif
@@ -7,44 +7,26 @@
 #include <glew.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/glm.hpp>
+#include "StreamBuffer.h"	// Get the per frame instance store
 
-// Dynamic - parsed to uniform data
+#define INSTANCE_DATA_LOCATION	2	// vec4 per instance (xyz position, w alpha)
+
+// Dynamic - streamed to vertex attribute data every frame. The quad (positions at location 0, texcoords at 1) is
+// built once; each frame's instances are written straight into a triple-buffered StreamBuffer and drawn with one
+// instanced call, so the count is bound only by the buffer, not by the uniform limits
 class Instance
 {
 private:
 	unsigned int				_num_instances;
-	unsigned int				_geometry_vao;
-	unsigned int				_geometry_vbo;
+	unsigned int				_quad_vao;
+	unsigned int				_quad_vbo;
+	StreamBuffer				_stream;
 
-	unsigned int quadVAO;
-	unsigned int quadVBO;
 public:
 	inline Instance(unsigned int num_instances)
 	{
 		_num_instances = num_instances;
 
-		GLfloat vertex_positions[] = { -0.01f,  0.015f, 0.0f,
-										0.01f, -0.015f, 0.0f,
-									   -0.01f, -0.015f, 0.0f,
-
-									   -0.01f,  0.015f, 0.0f,
-										0.01f, -0.015f, 0.0f,
-										0.01f,  0.015f, 0.0f };
-
-		// Generate geometry vao
-		glGenVertexArrays(1, &_geometry_vao);
-		glBindVertexArray(_geometry_vao);
-
-		// Store vbo data to an array buffer
-		glGenBuffers(1, &_geometry_vbo);
-		glBindBuffer(GL_ARRAY_BUFFER, _geometry_vbo);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_positions), &vertex_positions, GL_STATIC_DRAW);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-	}
-
-	void renderQuad()
-	{
 		float quadVertices[] = {
 			// positions        // texture Coords
 			-1.0f,  1.0f, 0.0f, 0.0f, 1.0f,
@@ -52,34 +34,56 @@ public:
 			 1.0f,  1.0f, 0.0f, 1.0f, 1.0f,
 			 1.0f, -1.0f, 0.0f, 1.0f, 0.0f,
 		};
-		// setup plane VAO
-		glGenVertexArrays(1, &quadVAO);
-		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
-		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+
+		// Setup plane vao
+		glGenVertexArrays(1, &_quad_vao);
+		glGenBuffers(1, &_quad_vbo);
+		glBindVertexArray(_quad_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, _quad_vbo);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 		glEnableVertexAttribArray(0);
 		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-
-		glBindVertexArray(quadVAO);
-		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, _num_instances);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+		// Set instance data (each frame picks its region with the base instance)
+		_stream.Create(sizeof(glm::vec4) * (num_instances ? num_instances : 1));
+		glBindBuffer(GL_ARRAY_BUFFER, _stream.GetBuffer());
+		glEnableVertexAttribArray(INSTANCE_DATA_LOCATION);
+		glVertexAttribPointer(INSTANCE_DATA_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+		glVertexAttribDivisor(INSTANCE_DATA_LOCATION, 1);
 		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
 	inline ~Instance()
 	{
-		glDeleteBuffers(1, &_geometry_vbo);
-		glDeleteVertexArrays(1, &_geometry_vao);
+		_stream.Destroy();
+		glDeleteBuffers(1, &_quad_vbo);
+		glDeleteVertexArrays(1, &_quad_vao);
 	}
 
-	inline void render()
+	// Returns where to write this frame's instances (room for getCapacity(), NULL if the buffer is unusable)
+	inline glm::vec4* map()
 	{
-		//glBindVertexArray(_geometry_vao);
-		//glDrawArraysInstanced(GL_TRIANGLES, 0, 6, _num_instances);
-		//glBindVertexArray(0);
+		return (glm::vec4*)_stream.Begin();
+	}
 
-		renderQuad();
+	// Draws the first 'count' instances written since map() with one call
+	inline void render(unsigned int count)
+	{
+		_stream.End();
+		if (!count)
+			return;
+
+		glBindVertexArray(_quad_vao);
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, count < _num_instances ? count : _num_instances,
+			(GLuint)(_stream.GetOffset() / sizeof(glm::vec4)));
+		glBindVertexArray(0);
+		_stream.Fence();
 	}
+
+	inline unsigned int getCapacity() const { return _num_instances; }
 };
 
 
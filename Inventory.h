@@ -140,6 +140,8 @@ public:
 		glUniform1i(_loc_instanced, false);
 		glUniform3f(_loc_colour, 1.0f, 1.0f, 1.0f);
 
+		SpriteAtlas::Get(SPRITE_ATLAS_HUD)->Bind(0);
+
 		for (unsigned int i = 0; i < _items.size(); i++)
 			_items[i]->Render();
 	}
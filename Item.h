@@ -5,12 +5,19 @@
 // Internal Classes
 #include "Actor.h"
 #include "Rect.h"
+#include "SpriteAtlas.h"
+
+#define ITEM_ICON_URI "Res/Icons/"
 
 // the Item class handles a single item within the inventory
 class Item : public Actor
 {
 private:
 	unsigned int _loc_pos;
+	unsigned int _loc_icon_rect;
+	unsigned int _loc_icon_layer;
+
+	int			 _icon;
 
 	glm::vec2	 _dims;
 	Rect*		 _rect;
@@ -33,6 +40,12 @@ public:
 	{
 		// load in the uniforms
 		_loc_pos = glGetUniformLocation(shader_program, "item_pos");
+		_loc_icon_rect = glGetUniformLocation(shader_program, "icon_rect");
+		_loc_icon_layer = glGetUniformLocation(shader_program, "icon_layer");
+
+		// add the icon to the hud atlas if the item has one
+		std::string icon = ITEM_ICON_URI + item + ".png";
+		_icon = Vfs::Exists(icon) ? (int)SpriteAtlas::Get(SPRITE_ATLAS_HUD)->Add(icon) : -1;
 
 		// set the name of the item
 		SetName(item);
@@ -61,6 +74,10 @@ public:
 	{
 		glUniform2f(_loc_pos, _trans._pos.x, _trans._pos.y);
 
+		// point the quad at its icon, the inventory binds the atlas once for every item
+		if (_icon >= 0) SpriteAtlas::Get(SPRITE_ATLAS_HUD)->SetRegion(_icon, _loc_icon_rect, _loc_icon_layer);
+		else glUniform1f(_loc_icon_layer, -1.0f);
+
 		_rect->Render(1);
 	}
 };
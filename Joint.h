@@ -2,21 +2,27 @@
 #define __JOINT_H__
 
 #include <vector>	// Get dynamic array
+#include <string>	// Get string variable
 #include <glm\glm.hpp>	// Get glm variables
 
+// A single joint in the skeletal hierarchy
 struct Joint
 {
+	unsigned int		_id;	// Index into the skin's joint list (JOINT_NONE if the node isn't skinned)
+	std::string			_name;	// The joint name / sid
+	glm::mat4x4			_matrix;	// Local bind transform relative to the parent
 
-	unsigned int		_id;
-	std::string			_name;
-	glm::mat4x4			_matrix;
+	std::vector<Joint>	_children;	// Child joints
 
-	std::vector<Joint>	_children;
+	// Default constructor
+	inline Joint() : _id(0), _name(""), _matrix(1.0f) {}
 
-	inline Joint() {}
+	// Initial constructor
 	inline Joint(unsigned int id, std::string name, glm::mat4x4 matrix)
 	{
-
+		_id = id;	// Assign id
+		_name = name;	// Assign name
+		_matrix = matrix;	// Assign local transform
 	}
 };
 
@@ -5,93 +5,67 @@
 #include <vector>
 #include "Content.h"
 #include <glm/glm.hpp>
-#include <glm/gtx/compatibility.hpp>
 #include <glew.h>
-#include "Camera.h"
+#include "CameraTrack.h"
 
 typedef unsigned int uint;
 
+#define KINEMATIC_KEY_SPACING 1.65f	// seconds between keyframes added without a time (the old 100 path steps at 60 fps)
+
 enum InterpolationType
 {
-	LINEAR
+	LINEAR = TRACK_LINEAR,
+	SMOOTH = TRACK_SMOOTH
 };
 
+// Plays a cinematic on the player camera. The keyframes live in a CameraTrack, so nothing is allocated per step
+// and the camera is sampled at the playback time every frame
 class Kinematic
 {
 private:
 
 	Camera *m_playerCamera;
 
-	uint m_interpolationType;
-	uint m_pathSteps;
-	uint m_pathIndex;
+	CameraTrack m_track;
+	double m_time;
 public:
-	std::vector<Camera*> m_KeyFrames;
-	std::vector<Camera*> m_cameraPath;
-
 	bool m_play;
 
 	inline Kinematic(Camera *_camera)
 	{
 		m_playerCamera = _camera;
 		m_play = true;
-		m_interpolationType = LINEAR;
-		m_pathSteps = 100;
-		m_pathIndex = 0;
-	}
-	inline ~Kinematic()
-	{
-		m_KeyFrames.clear();
-		m_cameraPath.clear();
+		m_time = 0.0;
 	}
 
+	// Adds the pose of 'camera' as the next keyframe (the camera itself isn't kept)
 	inline void AddKeyFrame(Camera* camera)
 	{
-		m_KeyFrames.push_back(camera);
+		m_track.AddKeyframe(m_track.NumKeyframes() ? m_track.GetDuration() + KINEMATIC_KEY_SPACING : 0.0f, *camera);
 	}
 
-	inline void BuildPath(uint m_program, uint m_type, double &deltaTime)
+	// Adds a keyframe at a time
+	inline void AddKeyFrame(float time, glm::vec3 position, glm::quat rotation, float fov)
 	{
-		m_interpolationType = m_type;
-
-		if (m_type == LINEAR)
-		{
-			for (uint i = 0; i < m_KeyFrames.size() - 1; i++)
-			{
-				for (uint j = 0; j < m_pathSteps; j++)
-				{
-					glm::vec3 difference = glm::lerp(m_KeyFrames[i]->_trans._pos, m_KeyFrames[i + 1]->_trans._pos, (float)j / (float)(m_pathSteps - 1));
-					glm::vec3 center = m_KeyFrames[i]->_trans._pos + difference;
-
-					difference = glm::lerp(m_KeyFrames[i]->GetFront(), m_KeyFrames[i + 1]->GetFront(), (float)j / (float)(m_pathSteps - 1));
-					glm::vec3 look = m_KeyFrames[i]->GetFront() + difference;
-
-					difference = glm::lerp(m_KeyFrames[i]->GetUp(), m_KeyFrames[i + 1]->GetUp(), (float)j / (float)(m_pathSteps - 1));
-					glm::vec3 up = m_KeyFrames[i]->GetUp() + difference;
-
-					glm::vec3 r = glm::cross(up, look);
-					glm::vec3 u = glm::cross(look, r * -1.f);
-
-					Camera *m_camera = new Camera(m_program, center, 75.0f, 0.1f, 0.0f, 0.1f, 100.0f, (float)1920 / (float)1080);
-					m_camera->Update(deltaTime);
+		m_track.AddKeyframe(time, position, rotation, fov);
+	}
 
-					m_cameraPath.push_back(m_camera);
-				}
-			}
-		}
+	// Chooses how the keyframes are blended
+	inline void BuildPath(uint m_type)
+	{
+		m_track.SetType(m_type);
 	}
 
+	inline void Rewind() { m_time = 0.0; }
+	inline bool IsFinished() { return m_time >= m_track.GetDuration(); }
+	inline CameraTrack& GetTrack() { return m_track; }
+
 	inline void Update(double &deltaTime)
 	{
-		if (!m_cameraPath.empty())
+		if (m_play && m_track.NumKeyframes())
 		{
-			if (m_play)
-			{
-				m_playerCamera = m_cameraPath[m_pathIndex];
-
-				if (m_pathIndex < m_cameraPath.size() - 1)
-					m_pathIndex++;
-			}
+			m_time = std::min(m_time + deltaTime, (double)m_track.GetDuration());
+			m_track.Apply((float)m_time, *m_playerCamera);
 		}
 
 		m_playerCamera->UpdateProjectionMatrix();
@@ -100,11 +74,8 @@ public:
 
 	inline void Render()
 	{
-		for (unsigned int i = 0; i < m_KeyFrames.size() - 1; i++)
-			m_KeyFrames[i]->Render();
-		for (unsigned int j = 0; j < m_pathSteps; j++)
-			m_cameraPath[j]->Render();
+		m_playerCamera->Render();
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -15,6 +15,7 @@ public:
 	GLuint  _u_mod;
 	GLuint  _u_shadow_matrix;
 	GLuint  _u_lsm; // light space matrix for rendering the shadows in viewspace
+	GLuint  _u_irradiance_sh; // diffuse ambient light as 9 spherical harmonic coefficients
 
 	// Constructor
 	inline LightPass(GLuint shader_program)
@@ -41,7 +42,7 @@ public:
 		glUniform1i(glGetUniformLocation(shader_program, "gNormalSS"), 7);
 		glUniform1i(glGetUniformLocation(shader_program, "gShadowmap"), 8);
 		glUniform1i(glGetUniformLocation(shader_program, "gSsao"), 9);
-		glUniform1i(glGetUniformLocation(shader_program, "irradianceMap"), 10);
+		glUniform1i(glGetUniformLocation(shader_program, "irradianceMap"), 10);	// Only in shaders without irradianceSH
 		glUniform1i(glGetUniformLocation(shader_program, "prefilterMap"), 11);
 		glUniform1i(glGetUniformLocation(shader_program, "brdfLUT"), 12);
 
@@ -49,12 +50,20 @@ public:
 	    //Content::_map->AddActor(new PointLight(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)), LIGHT);
 	    //Content::_map->AddActor(new SpotLight(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f)), LIGHT);
 
+		GetUniforms();	// Find the per frame uniforms
+	}
+
+	// Looks up the uniform locations (again after the program is relinked by a reload)
+	inline void GetUniforms()
+	{
+		GLuint shader_program = _shader_programs[0];	// The light shader
 		LightMaster::getUniforms(shader_program, Content::_map->GetActors());
 
 		_u_camera_pos = glGetUniformLocation(shader_program, "camera_pos");		// Initialise camera uniform location
 		_u_lsm = glGetUniformLocation(shader_program, "lightSpaceMatrix"); // load in the light space matrix for the shadow mapping
 		_u_shadow_matrix = glGetUniformLocation(shader_program, "shadowMatrix");
 		_u_mod = glGetUniformLocation(shader_program, "mod");
+		_u_irradiance_sh = glGetUniformLocation(shader_program, "irradianceSH");
 	}
 
 	// Virtual voids
@@ -0,0 +1,132 @@
+#ifndef __LZ_H__
+#define __LZ_H__
+
+#include <vector>	// Get dynamic array
+#include <cstring>	// Get memcpy
+#include <cstdint>	// Get fixed size integers
+
+#define LZ_MIN_MATCH		4	// The shortest match worth encoding
+#define LZ_MAX_OFFSET		65535	// Matches are addressed with 16 bits
+#define LZ_HASH_BITS		14	// Size of the match finder table
+
+// A small byte-oriented LZ77 block codec (LZ4 style sequences) used for archive blocks. Each sequence is a token
+// (4 bits literal count, 4 bits match length - 4), extra length bytes, the literals, then a 16 bit match offset.
+// The last sequence of a block only has literals. Decompression is a tight copy loop with full bounds checks
+namespace Lz
+{
+	// Writes an extended length (values of 15 and above continue in 255 steps)
+	inline void WriteLength(std::vector<uint8_t> &out, size_t length)
+	{
+		while (length >= 255)	// While there's more than a byte left...
+		{
+			out.push_back(255);		// Write a full byte
+			length -= 255;	// Consume it
+		}
+		out.push_back((uint8_t)length);		// Write the remainder
+	}
+
+	// Compresses 'size' bytes and appends the block to 'out'
+	inline void Compress(const uint8_t* src, size_t size, std::vector<uint8_t> &out)
+	{
+		std::vector<uint32_t> table(1 << LZ_HASH_BITS, 0xFFFFFFFF);		// Last position of each 4 byte hash
+		size_t anchor = 0;	// Start of the pending literals
+		size_t ip = 0;	// Read position
+
+		while (ip + LZ_MIN_MATCH <= size)	// While a match could still fit...
+		{
+			uint32_t sequence;	// The next four bytes
+			std::memcpy(&sequence, src + ip, 4);	// Read them
+			uint32_t h = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);	// Hash them
+			uint32_t candidate = table[h];	// The last place we saw them
+			table[h] = (uint32_t)ip;	// Remember this place
+
+			uint32_t found;		// The candidate's four bytes
+			if (candidate == 0xFFFFFFFF || ip - candidate > LZ_MAX_OFFSET ||
+				(std::memcpy(&found, src + candidate, 4), found != sequence))	// If there's no usable match...
+			{
+				ip++;	// Try the next byte
+				continue;
+			}
+
+			size_t length = LZ_MIN_MATCH;	// The match length
+			while (ip + length < size && src[candidate + length] == src[ip + length])	// Extend it
+				length++;
+
+			size_t literals = ip - anchor;	// Literals before the match
+			size_t extra = length - LZ_MIN_MATCH;	// Match length beyond the minimum
+			out.push_back((uint8_t)(((literals < 15 ? literals : 15) << 4) | (extra < 15 ? extra : 15)));	// Write the token
+			if (literals >= 15) WriteLength(out, literals - 15);	// Write the long literal count
+			out.insert(out.end(), src + anchor, src + ip);	// Write the literals
+			size_t offset = ip - candidate;		// The match distance
+			out.push_back((uint8_t)(offset & 0xFF));	// Write the offset (little endian)
+			out.push_back((uint8_t)(offset >> 8));
+			if (extra >= 15) WriteLength(out, extra - 15);	// Write the long match length
+
+			ip += length;	// Skip the match
+			anchor = ip;	// Literals restart here
+		}
+
+		size_t literals = size - anchor;	// The trailing literals
+		out.push_back((uint8_t)((literals < 15 ? literals : 15) << 4));		// Write the final token
+		if (literals >= 15) WriteLength(out, literals - 15);	// Write the long literal count
+		out.insert(out.end(), src + anchor, src + size);	// Write the literals
+	}
+
+	// Decompresses a block into exactly 'dst_size' bytes, returns false if the block is corrupt
+	inline bool Decompress(const uint8_t* src, size_t src_size, uint8_t* dst, size_t dst_size)
+	{
+		const uint8_t* ip = src;	// Read position
+		const uint8_t* iend = src + src_size;	// Read end
+		uint8_t* op = dst;	// Write position
+		uint8_t* oend = dst + dst_size;		// Write end
+
+		while (ip < iend)	// While there are sequences...
+		{
+			uint8_t token = *ip++;	// Read the token
+
+			size_t literals = token >> 4;	// The literal count
+			if (literals == 15)		// If it continues...
+			{
+				uint8_t b;	// The next length byte
+				do { if (ip >= iend) return false; b = *ip++; literals += b; } while (b == 255);
+			}
+			if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals)	// If the literals overrun...
+				return false;	// The block is corrupt
+			std::memcpy(op, ip, literals);	// Copy the literals
+			ip += literals;		// Advance input
+			op += literals;		// Advance output
+
+			if (ip == iend)		// If that was the last sequence...
+				break;	// Done
+
+			if (iend - ip < 2)	// If the offset is missing...
+				return false;	// The block is corrupt
+			size_t offset = ip[0] | ((size_t)ip[1] << 8);	// Read the offset
+			ip += 2;	// Advance input
+			if (offset == 0 || offset > (size_t)(op - dst))		// If it points before the block...
+				return false;	// The block is corrupt
+
+			size_t length = (token & 15);	// The match length
+			if (length == 15)	// If it continues...
+			{
+				uint8_t b;	// The next length byte
+				do { if (ip >= iend) return false; b = *ip++; length += b; } while (b == 255);
+			}
+			length += LZ_MIN_MATCH;		// Add the implied minimum
+			if ((size_t)(oend - op) < length)	// If the match overruns...
+				return false;	// The block is corrupt
+
+			const uint8_t* match = op - offset;		// The match source
+			if (offset >= length)	// If the ranges don't overlap...
+				std::memcpy(op, match, length);		// Copy in one go
+			else
+				for (size_t i = 0; i < length; i++)		// Overlapping matches repeat a pattern
+					op[i] = match[i];	// Copy byte by byte
+			op += length;	// Advance output
+		}
+
+		return op == oend;	// The block must fill the output exactly
+	}
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <iostream>		// Get error output
+#include <cstddef>	// Get size_t
+
+#ifdef _WIN32
+#include <windows.h>	// Get CreateFileMapping / MapViewOfFile
+#else
+#include <sys/mman.h>	// Get mmap / munmap
+#include <sys/stat.h>	// Get fstat
+#include <fcntl.h>	// Get open
+#include <unistd.h>		// Get close
+#endif
+
+// A read-only view of a whole file mapped into memory. The os pages the data in on demand,
+// so opening a file costs almost nothing and the contents can be used in place without copying
+class MappedFile
+{
+private:
+	const unsigned char*	_data;	// The first byte of the view
+	size_t					_size;	// The size of the view in bytes
+
+#ifdef _WIN32
+	HANDLE					_file;	// The file handle
+	HANDLE					_mapping;	// The mapping handle
+#else
+	int						_fd;	// The file descriptor
+#endif
+
+	MappedFile(const MappedFile&);	// Views can't be copied
+	MappedFile& operator=(const MappedFile&);	// Views can't be copied
+
+public:
+	// Default constructor
+#ifdef _WIN32
+	inline MappedFile() : _data(NULL), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(NULL) {}
+#else
+	inline MappedFile() : _data(NULL), _size(0), _fd(-1) {}
+#endif
+
+	// Destructor
+	inline ~MappedFile()
+	{
+		Close();	// Release the view
+	}
+
+	// Maps the file at 'uri', returns false if it doesn't exist or can't be mapped
+	inline bool Open(const char* uri)
+	{
+		Close();	// Release any previous view
+
+#ifdef _WIN32
+		_file = CreateFileA(uri, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);	// Open the file
+		if (_file == INVALID_HANDLE_VALUE)	// If the file failed to open...
+			return false;	// Return false as failed
+
+		LARGE_INTEGER size;		// The file size
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)		// Empty files can't be mapped
+		{
+			Close();	// Release the handle
+			return false;	// Return false as failed
+		}
+
+		_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);	// Create the mapping
+		if (_mapping)	// If the mapping was created...
+			_data = (const unsigned char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);	// Map the whole file
+		_size = (size_t)size.QuadPart;	// Record the size
+#else
+		_fd = open(uri, O_RDONLY);	// Open the file
+		if (_fd < 0)	// If the file failed to open...
+			return false;	// Return false as failed
+
+		struct stat st;		// The file info
+		if (fstat(_fd, &st) != 0 || st.st_size == 0)	// Empty files can't be mapped
+		{
+			Close();	// Release the descriptor
+			return false;	// Return false as failed
+		}
+
+		void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, _fd, 0);	// Map the whole file
+		_data = view == MAP_FAILED ? NULL : (const unsigned char*)view;		// Record the view
+		_size = (size_t)st.st_size;		// Record the size
+#endif
+
+		if (!_data)		// If the mapping failed...
+		{
+			std::cout << "Mapped File Error: Failed to map '" << uri << "'!\n";	// Print out error message
+			Close();	// Release the handles
+			return false;	// Return false as failed
+		}
+
+		return true;	// Return success
+	}
+
+	// Releases the view (pointers into it become invalid)
+	inline void Close()
+	{
+#ifdef _WIN32
+		if (_data) UnmapViewOfFile(_data);	// Unmap the view
+		if (_mapping) CloseHandle(_mapping);	// Close the mapping
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);	// Close the file
+		_mapping = NULL;	// Reset the mapping
+		_file = INVALID_HANDLE_VALUE;	// Reset the file
+#else
+		if (_data) munmap((void*)_data, _size);		// Unmap the view
+		if (_fd >= 0) close(_fd);	// Close the file
+		_fd = -1;	// Reset the descriptor
+#endif
+		_data = NULL;	// Reset the view
+		_size = 0;	// Reset the size
+	}
+
+	inline bool IsOpen() const { return _data != NULL; }	// Return whether a file is mapped
+	inline const unsigned char* Data() const { return _data; }	// Return the first byte
+	inline size_t Size() const { return _size; }	// Return the size in bytes
+};
+
+#endif
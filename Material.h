@@ -42,9 +42,29 @@ public:
 				std::cout << "Error: Failed to initialise material - texture index " << i << " is type cube!\n";
 				return;
 			}
-			else	// Otherwise, choose texture type as 2d
+		}
+		
+		size_t empty_slots = MAX_TEXTURES - textures.size();	// Calculate empty slots if any
+		
+		for (size_t i = 0; i < empty_slots; i++)	// For each empty slot...
+		{
+			size_t map_type_index = _textures.size() + i;	// Get the index offset
+			GLubyte data_a[] = { 255, 255, 255 };	// Set a default colour of white for most empty map
+
+			_textures.push_back(new Texture::Texture2d((uint8_t)map_type_index, 1, 1, { (GLubyte**)data_a } ));		// Implement the extra slots
+		}
+
+		GetUniforms(shader_program);	// Locate the map uniforms
+	}
+
+	// Locates the uniform of each texture map (again after the shader is relinked)
+	inline void GetUniforms(GLuint shader_program)
+	{
+		for (size_t i = 0; i < _textures.size() && i < MAX_TEXTURES; i++)	// Iterate through each texture
+		{
+			if (_textures[i]->type_2d)	// If it's a 2d map...
 			{
-				Texture::Texture2d* t = ((Texture::Texture2d*)textures[i]);		// Create temp reference var
+				Texture::Texture2d* t = ((Texture::Texture2d*)_textures[i]);		// Create temp reference var
 				switch (t->unit)	// Iterate through each map type
 				{
 				case NORMAL:
@@ -65,16 +85,6 @@ public:
 				}
 			}
 		}
-		
-		size_t empty_slots = MAX_TEXTURES - textures.size();	// Calculate empty slots if any
-		
-		for (size_t i = 0; i < empty_slots; i++)	// For each empty slot...
-		{
-			size_t map_type_index = _textures.size() + i;	// Get the index offset
-			GLubyte data_a[] = { 255, 255, 255 };	// Set a default colour of white for most empty map
-
-			_textures.push_back(new Texture::Texture2d((uint8_t)map_type_index, 1, 1, { (GLubyte**)data_a } ));		// Implement the extra slots
-		}
 	}
 
 	// Deconstructor
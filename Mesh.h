@@ -11,6 +11,7 @@
 #include "Vao.h"	// Get access to the ebo class
 #include "Cubemap.h"	// Get access to cubemap data
 #include "Query.h"
+#include "HotReload.h"	// Get asset reloading
 
 // A list of mesh types
 enum MeshTypes
@@ -43,7 +44,7 @@ public:
 	inline Mesh() { _t = MESH; }
 
 	// Deconstructor
-	inline ~Mesh() { if (_vao) delete _vao; }
+	inline ~Mesh() { HotReload::Unwatch(this); if (_vao) delete _vao; }	// Stop reloading and delete our geometry
 
 	inline Query *GetQuery() { return _query; }
 	inline unsigned int &GetLODGroup() { return _lodgroup; }
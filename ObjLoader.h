@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <fstream>
+#include "Vfs.h"	// Read through the content archive
 #include <glm\glm.hpp>
 #include "Vao.h"
 
@@ -44,8 +45,8 @@ namespace Wavefront
 	{
 		ObjData obj;	// To store our in / out data
 
-		std::ifstream _in(file);	// Check if the file is valid
-		if (!_in)	// If the file is invalid...
+		std::istringstream _in;	// The file contents
+		if (!Vfs::OpenText(file, _in))	// If the file is invalid...
 		{
 			std::cout << "Wavefront Import Error: The file is invalid! Check that the file exists.\n";	// Print out error message
 			return false;	// Return false as failed
@@ -14,6 +14,7 @@
 #include "Rbo.h"
 #include "Content.h"
 #include "GBufferData.h"
+#include "IblBaker.h"
 
 // namespace which stores all the classes and data for calculating PBR
 namespace PBR
@@ -85,8 +86,8 @@ namespace PBR
 			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 		}
 
-		// generate the capture fbo and rbo
-		inline void CreateCaptureFBO()
+		// generate the capture fbo and rbo (shared by every capture, so no map object is needed)
+		static inline void CreateCaptureFBO()
 		{
 			glGenFramebuffers(1, &capture_fbo);
 			glGenRenderbuffers(1, &capture_rbo);
@@ -98,75 +99,12 @@ namespace PBR
 		}
 	};
 	
-	// Solve diffuse integral by convolution to create an irradiance (cube)map.
-	struct IrradianceMap
-	{
-		// the irradianceMap texture ID
-		unsigned int irradianceMap;
-
-		// texture cubemap class in order to generate a empty cubemap
-		Texture::TextureCubemap* _env_map_hdr;
-
-		// Default constructer
-		inline IrradianceMap() = default;
-
-		// Constructer : within this constructer we generate a empty cubemap,  
-		inline IrradianceMap(GLuint shader_program, unsigned int env_map)
-		{
-			// Generate an empty cubemap
-			irradianceMap = _env_map_hdr->GenerateEmptyCubemap(32, 32);
-
-			// bind the capture fbo and the rbo
-			glBindFramebuffer(GL_FRAMEBUFFER, PBR::capture_fbo);
-			glBindRenderbuffer(GL_RENDERBUFFER, PBR::capture_rbo);
-			glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-
-			// start the irradiance shader
-			glUseProgram(shader_program);
-
-			// uniforms
-			glUniform1i(glGetUniformLocation(shader_program, "environmentMap"), 0);
-			glUniformMatrix4fv(glGetUniformLocation(shader_program, "proj"), 1, GL_FALSE, glm::value_ptr(_capture_projection));
-			
-			// bind the environment map
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, env_map);
-
-			// downsample the resolution to 32x32
-			glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
-
-			// Bind the capture fbo
-			glBindFramebuffer(GL_FRAMEBUFFER, capture_fbo);
-			for (unsigned int i = 0; i < 6; ++i)
-			{
-				// set the view matrices
-				glUniformMatrix4fv(glGetUniformLocation(shader_program, "view"), 1, GL_FALSE, glm::value_ptr(_capture_views[i]));
-				// send the irradiance map to the fbo
-				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, irradianceMap, 0);
-				// clear the screen
-				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-				// render cube
-				Primitives::cube();
-			}
-
-			// unbind the capture fbo
-			glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		}
-
-		// Get the irradiance texture
-		unsigned int GetIrradianceMap() { return irradianceMap; }
-	};
-	
 	// Prefilter the environment map using mip mapping
 	struct PrefilterMap
 	{
 		// prefilter map texture ID
 		unsigned int prefilterMap;
 
-		// texture cubemap class in order to generate a empty cubemap
-		Texture::TextureCubemap* _env_map_hdr;
-
 		// default Constructer
 		inline PrefilterMap() = default;
 
@@ -174,7 +112,7 @@ namespace PBR
 		inline PrefilterMap(GLuint shader_program, unsigned int env_map)
 		{
 			// generate an empty cubemap
-			prefilterMap = _env_map_hdr->GenerateEmptyCubemap(128, 128, true);
+			prefilterMap = Texture::TextureCubemap::GenerateEmptyCubemap(128, 128, true);
 
 			// use the prefilter shader
 			glUseProgram(shader_program);
@@ -287,15 +225,36 @@ namespace PBR
 
 		// hdr image file 
 		Texture::TextureHDR*		_texture_hdr;
-
-		// environment cubemap
-		Texture::TextureCubemap* _env_map_hdr;
 		
-		// the nessasary PBR maps 
+		// the nessasary PBR maps (only used when the baked maps can't be loaded)
 		PBR::EquirectangularMap* _equi_map;
-		PBR::IrradianceMap* _irr_map;
 		PBR::PrefilterMap* _prefilter_map;
 		PBR::BRDF* _brdf;
+
+		// diffuse irradiance as spherical harmonics (27 floats instead of a cubemap)
+		SphericalHarmonics::SH9 _irradiance_sh;
+
+		// the texture IDs bound when rendering
+		unsigned int _prefilter_id;
+		unsigned int _brdf_id;
+
+		// the coefficients as a small cubemap, only made for lighting shaders that still sample irradianceMap
+		unsigned int _irradiance_map;
+
+		// load the baked maps from the cache, baking any that are missing first
+		inline bool LoadBaked(const char* hdr_file)
+		{
+			IblBaker::Products products = IblBaker::Bake(hdr_file);
+			if (products.brdf.empty())
+				return false;
+
+			size_t w, h, m;
+			_env_map       = LoadDds({ products.environment }, w, h, m, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_TEXTURE_CUBE_MAP, false);
+			_prefilter_id  = LoadDds({ products.prefilter }, w, h, m, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_TEXTURE_CUBE_MAP, false);
+			_brdf_id       = LoadDds({ products.brdf }, w, h, m, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR, GL_LINEAR, GL_TEXTURE_2D, false);
+
+			return SphericalHarmonics::Load(products.irradiance, _irradiance_sh) && _env_map && _prefilter_id && _brdf_id;
+		}
 	public:
 		// Default constructer
 		inline IBL() = default;
@@ -309,14 +268,17 @@ namespace PBR
 			// delete environment map
 			glDeleteTextures(1, &_env_map);
 
+			// delete the baked maps (the captured ones are owned by their structs)
+			if (!_prefilter_map) glDeleteTextures(1, &_prefilter_id);
+			if (!_brdf) glDeleteTextures(1, &_brdf_id);
+			glDeleteTextures(1, &_irradiance_map);
+
 			// clear shader vector list
 			_shader_programs.clear();
 
 			// delete pointers
 			delete _texture_hdr;
-			delete _env_map_hdr;
 			delete _equi_map;
-			delete _irr_map;
 			delete _prefilter_map;
 			delete _brdf;
 		}
@@ -324,42 +286,79 @@ namespace PBR
 		// get the environment map
 		inline unsigned int GetEnvironmentMap() { return _env_map; }
 
+		// get the diffuse irradiance coefficients for the lighting shader
+		inline const SphericalHarmonics::SH9& GetIrradianceSH() { return _irradiance_sh; }
+
+		// get the diffuse irradiance as a cubemap, evaluated from the coefficients the first time it's asked for
+		inline unsigned int GetIrradianceMap()
+		{
+			if (_irradiance_map)
+				return _irradiance_map;
+
+			std::vector<float> faces = SphericalHarmonics::ToCubemap(_irradiance_sh, IBL_IRRADIANCE_SIZE);
+			glGenTextures(1, &_irradiance_map);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, _irradiance_map);
+			for (unsigned int i = 0; i < 6; i++)
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, IBL_IRRADIANCE_SIZE, IBL_IRRADIANCE_SIZE, 0, GL_RGB, GL_FLOAT,
+					&faces[(size_t)i * IBL_IRRADIANCE_SIZE * IBL_IRRADIANCE_SIZE * 3]);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			return _irradiance_map;
+		}
+
 		// initialise all the nessasary PBR maps 
 		inline void Create(const char* hdr_file, std::vector<GLuint> shader_programs)
 		{
 			// initialise the shader programs
-			shader_programs = _shader_programs;
+			_shader_programs = shader_programs;
+
+			_texture_hdr = NULL;
+			_equi_map = NULL;
+			_prefilter_map = NULL;
+			_brdf = NULL;
+			_env_map = _prefilter_id = _brdf_id = _irradiance_map = 0;
+
+			// use the maps baked on the CPU for this hdr, they're only baked the first time it's seen
+			if (LoadBaked(hdr_file))
+				return;
+
+			// otherwise capture them on the GPU (the irradiance is projected on the CPU either way, shader 1 is unused)
+			SphericalHarmonics::Project(hdr_file, _irradiance_sh);
+			glDeleteTextures(1, &_env_map);
+			glDeleteTextures(1, &_prefilter_id);
+			glDeleteTextures(1, &_brdf_id);
 
 			// create the capturing fbo
-			_equi_map->CreateCaptureFBO();
+			PBR::EquirectangularMap::CreateCaptureFBO();
 
 			// load in the hdr image
 			_texture_hdr   = new Texture::TextureHDR(hdr_file);
 
 			// generate the environment map
-			_env_map       = _env_map_hdr->GenerateEmptyCubemap(512, 512);
+			_env_map       = Texture::TextureCubemap::GenerateEmptyCubemap(512, 512);
 			
 			// initialise the maps
 			_equi_map      = new PBR::EquirectangularMap(shader_programs[0], _env_map, PBR::capture_fbo, PBR::capture_rbo, _texture_hdr);
-			_irr_map       = new PBR::IrradianceMap(shader_programs[1], _env_map);
 			_prefilter_map = new PBR::PrefilterMap(shader_programs[2], _env_map);
 			_brdf		   = new PBR::BRDF(shader_programs[3]);
+
+			_prefilter_id  = _prefilter_map->GetPrefilterMap();
+			_brdf_id       = _brdf->GetBRDFTexture();
 		}
 
 		// bind the pbr maps to the screen
 		inline void Render()
 		{
-			// irradiance map
-			glActiveTexture(GL_TEXTURE10);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, _irr_map->GetIrradianceMap());
-
 			// prefilter map
 			glActiveTexture(GL_TEXTURE11);
-			glBindTexture(GL_TEXTURE_CUBE_MAP, _prefilter_map->GetPrefilterMap());
+			glBindTexture(GL_TEXTURE_CUBE_MAP, _prefilter_id);
 
 			// brdf texture 
 			glActiveTexture(GL_TEXTURE12);
-			glBindTexture(GL_TEXTURE_2D, _brdf->GetBRDFTexture());
+			glBindTexture(GL_TEXTURE_2D, _brdf_id);
 		}
 	};
 };
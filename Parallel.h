@@ -0,0 +1,171 @@
+#ifndef __PARALLEL_H__
+#define __PARALLEL_H__
+
+#include <thread>	// Get worker threads
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get min / max
+#include <atomic>	// Get the shared chunk counter
+#include <mutex>	// Get locks
+#include <condition_variable>	// Wake / wait for the pool
+
+// This namespace contains simple data-parallel helpers for splitting loops across the available cores
+namespace Parallel
+{
+	// Returns the number of hardware threads we are allowed to use
+	inline unsigned int NumWorkers()
+	{
+		unsigned int n = std::thread::hardware_concurrency();	// Ask the os for the core count
+		return n ? n : 1;	// Some platforms report zero, so fall back to a single worker
+	}
+
+	// Splits [begin, end) into contiguous ranges of at least 'grain' items and calls fn(from, to) for each range in parallel.
+	// The calling thread processes the first range itself, so small loops never pay for a thread
+	template <typename F>
+	inline void For(size_t begin, size_t end, size_t grain, F fn)
+	{
+		if (end <= begin)	// If there is nothing to do...
+			return;		// Return as normal
+
+		size_t count = end - begin;		// The number of items to process
+		size_t max_jobs = (count + std::max<size_t>(grain, 1) - 1) / std::max<size_t>(grain, 1);	// The number of ranges the grain size allows
+		size_t num_jobs = std::min<size_t>(NumWorkers(), max_jobs);	// Never use more ranges than workers
+
+		if (num_jobs <= 1)	// If the loop is too small to split...
+		{
+			fn(begin, end);		// Run it on this thread
+			return;		// Return as normal
+		}
+
+		size_t step = (count + num_jobs - 1) / num_jobs;	// The size of each range
+		std::vector<std::thread> workers;	// The helper threads
+		workers.reserve(num_jobs - 1);	// Reserve the helpers
+
+		for (size_t j = 1; j < num_jobs; j++)	// For each range after the first...
+		{
+			size_t from = begin + j * step;		// Range start
+			size_t to = std::min(end, from + step);		// Range end
+			if (from < to)	// If the range is not empty...
+				workers.push_back(std::thread([&fn, from, to]() { fn(from, to); }));	// Hand it to a helper thread
+		}
+
+		fn(begin, std::min(end, begin + step));		// Process the first range on this thread
+
+		for (std::thread &w : workers)	// For each helper...
+			w.join();	// Wait for it to finish
+	}
+
+	// A pool of persistent workers for loops that run every frame, where starting threads each time would cost more
+	// than the work. The range is cut into grain sized chunks that the workers and the caller take in turn, so
+	// uneven chunks balance themselves. One loop runs at a time; a For called from inside a job runs serially
+	class JobPool
+	{
+	private:
+		std::vector<std::thread>	_workers;	// The helper threads
+		std::mutex					_mutex;		// Guards the batch state
+		std::condition_variable		_wake;	// Signals a new batch
+		std::condition_variable		_done;	// Signals the last helper finished
+		std::mutex					_batch;		// Serialises callers
+		void						(*_call)(void*, size_t, size_t);	// Runs one chunk of the current loop
+		void*						_context;	// The current loop's function
+		size_t						_begin, _end, _grain;	// The current range
+		std::atomic<size_t>			_next;	// The next chunk to hand out
+		uint64_t					_generation;	// Bumped for every batch
+		size_t						_busy;	// Helpers still working on the batch
+		bool						_running;	// Whether the helpers should keep going
+
+		static inline bool &InJob() { static thread_local bool in_job = false; return in_job; }	// Whether this thread is running a chunk
+
+		// Takes chunks until the range is used up
+		inline void Drain()
+		{
+			for (size_t chunk = _next++; _begin + chunk * _grain < _end; chunk = _next++)
+			{
+				size_t from = _begin + chunk * _grain;	// Chunk start
+				_call(_context, from, std::min(_end, from + _grain));
+			}
+		}
+
+		// The helper loop: sleep until there's a batch, help drain it, report back
+		inline void Run()
+		{
+			InJob() = true;		// Nested loops run inline on helpers
+			uint64_t seen = 0;	// The last batch this helper worked on
+			std::unique_lock<std::mutex> lock(_mutex);
+			for (;;)
+			{
+				_wake.wait(lock, [&]() { return !_running || _generation != seen; });	// Wait for work
+				if (!_running)	// If the pool is shutting down...
+					return;
+				seen = _generation;
+				lock.unlock();
+				Drain();	// Help
+				lock.lock();
+				if (--_busy == 0)	// If this was the last helper...
+					_done.notify_one();
+			}
+		}
+
+	public:
+		inline JobPool(unsigned int num_workers = Parallel::NumWorkers()) : _call(NULL), _context(NULL), _begin(0), _end(0), _grain(1), _next(0), _generation(0), _busy(0), _running(true)
+		{
+			for (unsigned int i = 1; i < num_workers; i++)	// The caller is the first worker
+				_workers.push_back(std::thread([this]() { Run(); }));
+		}
+
+		inline ~JobPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_running = false;	// Stop the helpers
+			}
+			_wake.notify_all();
+			for (std::thread &w : _workers)		// For each helper...
+				w.join();	// Wait for it to finish
+		}
+
+		inline unsigned int NumWorkers() const { return (unsigned int)_workers.size() + 1; }	// Return the helpers and the caller
+
+		// Calls fn(from, to) for grain sized chunks of [begin, end) across the pool and returns when all are done
+		template <typename F>
+		inline void For(size_t begin, size_t end, size_t grain, F fn)
+		{
+			if (end <= begin)	// If there is nothing to do...
+				return;		// Return as normal
+
+			grain = std::max<size_t>(grain, 1);
+			if (_workers.empty() || end - begin <= grain || InJob())	// If it can't or needn't be split...
+			{
+				fn(begin, end);		// Run it on this thread
+				return;		// Return as normal
+			}
+
+			std::lock_guard<std::mutex> batch(_batch);	// One loop at a time
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_call = [](void* context, size_t from, size_t to) { (*(F*)context)(from, to); };	// Type erase without allocating
+				_context = &fn;
+				_begin = begin; _end = end; _grain = grain;
+				_next = 0;
+				_busy = _workers.size();
+				_generation++;	// Publish the batch
+			}
+			_wake.notify_all();
+
+			InJob() = true;		// Nested loops in the caller's chunks run inline too
+			Drain();	// Help
+			InJob() = false;
+
+			std::unique_lock<std::mutex> lock(_mutex);
+			_done.wait(lock, [&]() { return _busy == 0; });		// Wait for the helpers to finish their chunks
+		}
+	};
+
+	// The shared pool, started on first use
+	inline JobPool &Jobs()
+	{
+		static JobPool pool;	// The pool
+		return pool;	// Return it
+	}
+}
+
+#endif
@@ -0,0 +1,199 @@
+#ifndef __PARTICLE_MANAGER_H__
+#define __PARTICLE_MANAGER_H__
+
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get sort / min
+#include <cstdint>	// Get fixed size integers
+#include <glm/glm.hpp>	// Get glm variables
+#include "ParticleSystem.h"		// Get the emitters
+#include "Parallel.h"	// Get the job pool
+
+#define PARTICLE_BATCH_GRAIN		1		// Emitters per job (each is a whole kernel pass)
+#define PARTICLE_CULL_DISTANCE		150.0f	// Emitters further than this aren't updated or drawn
+#define PARTICLE_BUDGET				200000	// Live particles allowed across every emitter
+
+// The particle update phase. Emitters register here with a priority and Update() runs them all as jobs: each one
+// owns its pool and its generator, so they need no locks and a seeded emitter plays back the same on any thread.
+// Before that, emitters outside the view frustum or beyond the cull distance are skipped (frozen until they come
+// back), and the global budget is dealt out to the rest by priority over distance: the most important get their
+// full capacity and the remainder are throttled to what's left, so the particle count (and the frame's cost) is
+// bounded however many effects are on screen. Blended emitters are depth sorted in the same jobs, along the view
+// given to SetView. Render() draws the visible emitters on the calling (GL) thread
+class ParticleManager
+{
+private:
+	// A registered emitter
+	struct Entry
+	{
+		ParticleSystem*		system;		// What it updates (NULL if the slot is free, not owned)
+		float				priority;	// How much it matters (higher is kept first)
+		float				radius;		// Bounding sphere around the emitter's position (0 asks the emitter every frame)
+		float				score;	// Priority over distance this frame
+		bool				visible;	// Whether it passed culling this frame
+	};
+
+	static std::vector<Entry>		_entries;	// All emitters, indexed by handle
+	static std::vector<uint32_t>	_free;	// Released handles
+	static std::vector<uint32_t>	_visible;	// Handles updated this frame, most important first
+	static glm::vec4				_planes[6];		// The view frustum (normals point inwards)
+	static glm::vec3				_viewer;	// Where distances are measured from
+	static glm::vec3				_forward;	// Which way the view looks (blended emitters sort along it)
+	static float					_cull_distance;		// Beyond this emitters are skipped
+	static uint32_t					_budget;	// Live particles allowed
+	static uint32_t					_num_culled;	// Emitters skipped last frame
+	static uint32_t					_num_throttled;		// Emitters given less than their capacity last frame
+	static uint32_t					_num_particles;		// Live particles after last frame
+
+	// Returns whether a sphere touches the frustum
+	static inline bool InFrustum(const glm::vec3 &centre, float radius)
+	{
+		for (int p = 0; p < 6; p++)		// For each plane...
+			if (glm::dot(glm::vec3(_planes[p]), centre) + _planes[p].w <= -radius)	// Completely outside it
+				return false;
+		return true;
+	}
+
+public:
+	// Registers an emitter, returns its handle (radius 0 follows the emitter's own bounds as its particles move)
+	static inline uint32_t Add(ParticleSystem* system, float priority = 1.0f, float radius = 0.0f)
+	{
+		uint32_t handle;	// The slot
+		if (!_free.empty())		// If a slot was released...
+		{
+			handle = _free.back();	// Reuse it
+			_free.pop_back();
+		}
+		else
+		{
+			handle = (uint32_t)_entries.size();		// Otherwise add one
+			_entries.push_back(Entry());
+		}
+
+		Entry &e = _entries[handle];	// The entry
+		e.system = system;
+		e.priority = priority;
+		e.radius = radius;
+		e.score = 0.0f;
+		e.visible = false;
+		return handle;	// Return the handle
+	}
+
+	// Releases an emitter (it keeps its particles and its last limit)
+	static inline void Remove(uint32_t handle)
+	{
+		if (handle >= _entries.size() || !_entries[handle].system)	// If it isn't registered...
+			return;		// Return as normal
+		_entries[handle].system = NULL;		// Free the slot
+		_free.push_back(handle);
+	}
+
+	// Assigns the view the emitters are culled against
+	static inline void SetView(const glm::mat4 &view_projection, const glm::vec3 &viewer)
+	{
+		for (int i = 0; i < 3; i++)		// Left / right, bottom / top, near / far from the rows of the matrix
+		{
+			glm::vec4 w(view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3]);
+			glm::vec4 r(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+			_planes[i * 2] = w + r;
+			_planes[i * 2 + 1] = w - r;
+		}
+		for (int p = 0; p < 6; p++)		// Normalise so the distances are in world units
+			_planes[p] /= glm::length(glm::vec3(_planes[p]));
+		_viewer = viewer;
+		_forward = glm::vec3(_planes[4]);	// The near plane faces along the view
+	}
+
+	inline static void SetPriority(uint32_t handle, float priority) { _entries[handle].priority = priority; }	// Assign how much an emitter matters
+	inline static void SetRadius(uint32_t handle, float radius) { _entries[handle].radius = radius; }	// Assign an emitter's bounds (0 follows its particles)
+	inline static void SetCullDistance(float distance) { _cull_distance = distance; }	// Assign how far emitters are updated
+	inline static void SetBudget(uint32_t particles) { _budget = particles; }	// Assign the live particles allowed
+	inline static bool IsVisible(uint32_t handle) { return _entries[handle].visible; }	// Return whether an emitter ran last frame
+	inline static uint32_t GetNumVisible() { return (uint32_t)_visible.size(); }	// Return the emitters updated last frame
+	inline static uint32_t GetNumCulled() { return _num_culled; }	// Return the emitters skipped last frame
+	inline static uint32_t GetNumThrottled() { return _num_throttled; }		// Return the emitters held below capacity last frame
+	inline static uint32_t GetNumParticles() { return _num_particles; }		// Return the live particles after last frame
+
+	// Culls the emitters, deals out the budget and updates the visible ones in parallel
+	static inline void Update(double delta)
+	{
+		_visible.clear();	// Gather this frame's emitters
+		_num_culled = 0;
+		for (uint32_t h = 0; h < _entries.size(); h++)	// For each slot...
+		{
+			Entry &e = _entries[h];		// The entry
+			if (!e.system)	// If it's free...
+				continue;
+			float distance = glm::length(e.system->_position - _viewer);
+			float radius = e.radius > 0.0f ? e.radius : e.system->getRadius();	// Culled emitters are frozen, so their box still holds
+			e.visible = distance - radius < _cull_distance && InFrustum(e.system->_position, radius);
+			if (!e.visible)		// If it can't be seen, it waits
+			{
+				_num_culled++;
+				continue;
+			}
+			e.score = e.priority / (1.0f + distance);	// Near and important first
+			_visible.push_back(h);
+		}
+
+		std::sort(_visible.begin(), _visible.end(), [](uint32_t a, uint32_t b) { return _entries[a].score != _entries[b].score ? _entries[a].score > _entries[b].score : a < b; });
+		uint32_t remaining = _budget;	// Deal out the budget
+		_num_throttled = 0;
+		for (uint32_t h : _visible)
+		{
+			ParticleSystem* system = _entries[h].system;
+			uint32_t limit = std::min(system->getCapacity(), remaining);
+			if (limit < system->getCapacity())
+				_num_throttled++;
+			system->setLimit(limit);
+			remaining -= limit;
+		}
+
+		Entry* entries = _entries.data();	// Hoist the arrays for the jobs
+		const uint32_t* visible = _visible.data();
+		glm::vec3 viewer = _viewer, forward = _forward;
+		Parallel::Jobs().For(0, _visible.size(), PARTICLE_BATCH_GRAIN, [=](size_t from, size_t to)
+		{
+			for (size_t i = from; i < to; i++)	// For each emitter in the batch...
+			{
+				ParticleSystem* system = entries[visible[i]].system;
+				system->update(delta);
+				if (system->isDepthSorted())	// Blended ones are sorted here too, off the render thread
+					system->sortParticles(viewer, forward);
+			}
+		});
+
+		_num_particles = 0;		// Count what's alive
+		for (uint32_t h : _visible)
+			_num_particles += _entries[h].system->numAlive();
+	}
+
+	// Draws the emitters that ran this frame (the particle shader must be bound)
+	static inline void Render()
+	{
+		for (uint32_t h : _visible)
+			_entries[h].system->render();
+	}
+
+	// Releases everything (the emitters belong to their owners)
+	static inline void Destroy()
+	{
+		_entries.clear();
+		_free.clear();
+		_visible.clear();
+	}
+};
+
+// Static definitions
+std::vector<ParticleManager::Entry>	ParticleManager::_entries;
+std::vector<uint32_t>			ParticleManager::_free;
+std::vector<uint32_t>			ParticleManager::_visible;
+glm::vec4						ParticleManager::_planes[6] = { glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f) };
+glm::vec3						ParticleManager::_viewer = glm::vec3(0.0f);
+glm::vec3						ParticleManager::_forward = glm::vec3(0.0f, 0.0f, -1.0f);
+float							ParticleManager::_cull_distance = PARTICLE_CULL_DISTANCE;
+uint32_t						ParticleManager::_budget = PARTICLE_BUDGET;
+uint32_t						ParticleManager::_num_culled = 0;
+uint32_t						ParticleManager::_num_throttled = 0;
+uint32_t						ParticleManager::_num_particles = 0;
+
+#endif
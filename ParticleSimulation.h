@@ -0,0 +1,479 @@
+#ifndef __PARTICLE_SIMULATION_H__
+#define __PARTICLE_SIMULATION_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <cmath>	// Get nearbyint / fabs
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get min / max
+#include <cstring>	// Get memcpy
+#include <cfloat>	// Get FLT_MAX
+#include <glm/glm.hpp>	// Get glm variables
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>	// Get SSE2
+#define PARTICLE_SIMD 1		// Update four particles at a time
+#endif
+
+#define PARTICLE_PI			3.14159265f
+#define PARTICLE_TWO_PI		6.28318531f
+#define PARTICLE_SORT_MOVES		4		// Insertion moves per particle before a depth sort starts over
+#define PARTICLE_SORT_DESCENTS	64		// ... or one neighbour in this many out of order
+#define PARTICLE_SORT_DEPTH		16		// Most bits a quantised depth gets (fewer once the slot needs more than 16)
+#define PARTICLE_SORT_DIGIT		8		// Bits per radix pass (two cover the depth)
+#define PARTICLE_SORT_BUCKETS	(1u << PARTICLE_SORT_DIGIT)
+
+// The particle simulation core: an emitter's particles live in parallel arrays (one per attribute) and are advanced
+// by kernels that run four at a time with SSE2, so an update streams through memory with no pointers or virtual
+// calls. Dead particles are swap-removed, so the live ones always fill [0, count). Every emitter has its own
+// xoshiro128+ generator, so a seeded emitter replays exactly. Sines come from one polynomial used by both the SIMD
+// lanes and the scalar tail, so where a particle lands in the arrays doesn't change its result
+namespace ParticleSimulation
+{
+	// xoshiro128+ (Blackman / Vigna), seeded through splitmix64
+	struct Random
+	{
+		uint32_t	s[4];	// The state
+
+		inline Random(uint64_t seed = 1) { Seed(seed); }
+
+		// Restarts the sequence from a seed
+		inline void Seed(uint64_t seed)
+		{
+			for (int i = 0; i < 4; i += 2)	// Two 64 bit splitmix outputs fill the state
+			{
+				uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				z ^= z >> 31;
+				s[i] = (uint32_t)z;
+				s[i + 1] = (uint32_t)(z >> 32);
+			}
+		}
+
+		// Returns the next 32 random bits
+		inline uint32_t Next()
+		{
+			uint32_t result = s[0] + s[3], t = s[1] << 9;
+			s[2] ^= s[0];
+			s[3] ^= s[1];
+			s[1] ^= s[2];
+			s[0] ^= s[3];
+			s[2] ^= t;
+			s[3] = (s[3] << 11) | (s[3] >> 21);
+			return result;	// Return it
+		}
+
+		inline float Float() { return (Next() >> 8) * (1.0f / 16777216.0f); }	// Return a float in [0, 1)
+		inline float Range(float min, float max) { return min + (max - min) * Float(); }	// Return a float in [min, max)
+		inline float Range(const glm::vec2 &range) { return Range(range.x, range.y); }	// Return a float in [range.x, range.y)
+	};
+
+	// The sine both paths use: reduced to [-pi, pi], folded to [-pi / 2, pi / 2], then an odd degree 11 polynomial
+	inline float Sin(float x)
+	{
+		x -= std::nearbyint(x * (1.0f / PARTICLE_TWO_PI)) * PARTICLE_TWO_PI;	// Into [-pi, pi]
+		x = x > PARTICLE_PI * 0.5f ? PARTICLE_PI - x : (x < -PARTICLE_PI * 0.5f ? -PARTICLE_PI - x : x);	// Into [-pi / 2, pi / 2]
+		float x2 = x * x;
+		return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f + x2 * (2.7557319e-6f + x2 * -2.5052108e-8f)))));
+	}
+	inline float Cos(float x) { return Sin(x + PARTICLE_PI * 0.5f); }
+
+#ifdef PARTICLE_SIMD
+	// Four lanes of Sin with the same operations
+	inline __m128 Sin4(__m128 x)
+	{
+		__m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.0f / PARTICLE_TWO_PI))));	// Round to nearest, like nearbyint
+		x = _mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(PARTICLE_TWO_PI)));
+		__m128 hi = _mm_cmpgt_ps(x, _mm_set1_ps(PARTICLE_PI * 0.5f)), lo = _mm_cmplt_ps(x, _mm_set1_ps(-PARTICLE_PI * 0.5f));
+		__m128 folded_hi = _mm_sub_ps(_mm_set1_ps(PARTICLE_PI), x), folded_lo = _mm_sub_ps(_mm_set1_ps(-PARTICLE_PI), x);
+		x = _mm_or_ps(_mm_and_ps(hi, folded_hi), _mm_andnot_ps(hi, _mm_or_ps(_mm_and_ps(lo, folded_lo), _mm_andnot_ps(lo, x))));
+		__m128 x2 = _mm_mul_ps(x, x);
+		__m128 p = _mm_add_ps(_mm_set1_ps(2.7557319e-6f), _mm_mul_ps(x2, _mm_set1_ps(-2.5052108e-8f)));
+		p = _mm_add_ps(_mm_set1_ps(-1.9841270e-4f), _mm_mul_ps(x2, p));
+		p = _mm_add_ps(_mm_set1_ps(8.3333333e-3f), _mm_mul_ps(x2, p));
+		p = _mm_add_ps(_mm_set1_ps(-1.6666667e-1f), _mm_mul_ps(x2, p));
+		p = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, p));
+		return _mm_mul_ps(x, p);
+	}
+	inline __m128 Cos4(__m128 x) { return Sin4(_mm_add_ps(x, _mm_set1_ps(PARTICLE_PI * 0.5f))); }
+	inline __m128 Abs4(__m128 x) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), x); }
+
+	// Running bounds of positions, four lanes wide
+	struct Bounds4
+	{
+		__m128	lower[3], upper[3];		// Per lane minimum / maximum of x, y, z
+
+		inline Bounds4()
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				lower[a] = _mm_set1_ps(FLT_MAX);
+				upper[a] = _mm_set1_ps(-FLT_MAX);
+			}
+		}
+
+		// Takes in four positions
+		inline void Add(__m128 x, __m128 y, __m128 z)
+		{
+			lower[0] = _mm_min_ps(lower[0], x); upper[0] = _mm_max_ps(upper[0], x);
+			lower[1] = _mm_min_ps(lower[1], y); upper[1] = _mm_max_ps(upper[1], y);
+			lower[2] = _mm_min_ps(lower[2], z); upper[2] = _mm_max_ps(upper[2], z);
+		}
+
+		// Folds the lanes into a box
+		inline void Reduce(glm::vec3 &lo, glm::vec3 &hi) const
+		{
+			for (int a = 0; a < 3; a++)
+			{
+				__m128 l = _mm_min_ps(lower[a], _mm_shuffle_ps(lower[a], lower[a], _MM_SHUFFLE(1, 0, 3, 2)));
+				__m128 h = _mm_max_ps(upper[a], _mm_shuffle_ps(upper[a], upper[a], _MM_SHUFFLE(1, 0, 3, 2)));
+				lo[a] = _mm_cvtss_f32(_mm_min_ss(l, _mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 3, 0, 1))));
+				hi[a] = _mm_cvtss_f32(_mm_max_ss(h, _mm_shuffle_ps(h, h, _MM_SHUFFLE(2, 3, 0, 1))));
+			}
+		}
+	};
+#endif
+
+	// An emitter's particles as parallel arrays. Only [0, count) are alive. The kernels also record the box the
+	// particles ended up in, and spawning grows it, so it always holds every live particle (removing some leaves it
+	// loose until the next update)
+	struct Pool
+	{
+		uint32_t			count;	// Live particles
+		uint32_t			capacity;	// Room for particles
+		glm::vec3			lower, upper;	// Bounding box of the live particles (empty while there are none)
+		std::vector<float>	x, y, z;	// Positions
+		std::vector<float>	dir_x, dir_y, dir_z;	// Directions of travel (directional emitters)
+		std::vector<float>	radius;		// Orbit radii (point emitters)
+		std::vector<float>	speed;	// Life spent per second
+		std::vector<float>	age, life;	// Life spent and life span
+		std::vector<float>	wave, phase;	// Sway amplitude and its phase
+		std::vector<float>	alpha, fade;	// Opacity and how fast it changes
+
+		inline Pool() : count(0), capacity(0), lower(FLT_MAX), upper(-FLT_MAX) {}
+
+		// Sizes every array for 'n' particles and clears them
+		inline void Reserve(uint32_t n)
+		{
+			capacity = n;
+			count = 0;
+			for (std::vector<float>* a : { &x, &y, &z, &dir_x, &dir_y, &dir_z, &radius, &speed, &age, &life, &wave, &phase, &alpha, &fade })
+				a->assign(n, 0.0f);
+			lower = glm::vec3(FLT_MAX);
+			upper = glm::vec3(-FLT_MAX);
+		}
+
+		// Grows the bounding box over particles [first, last)
+		inline void Bound(uint32_t first, uint32_t last)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				lower = glm::min(lower, glm::vec3(x[i], y[i], z[i]));
+				upper = glm::max(upper, glm::vec3(x[i], y[i], z[i]));
+			}
+		}
+
+		// Removes particle i by moving the last live one into its place (the freed slot is left transparent)
+		inline void Remove(uint32_t i)
+		{
+			uint32_t last = --count;
+			for (std::vector<float>* a : { &x, &y, &z, &dir_x, &dir_y, &dir_z, &radius, &speed, &age, &life, &wave, &phase, &alpha, &fade })
+				(*a)[i] = (*a)[last];
+			alpha[last] = 0.0f;
+		}
+
+		// Drops the particles past the first 'n' (their slots are left transparent)
+		inline void Truncate(uint32_t n)
+		{
+			for (; count > n; count--)
+				alpha[count - 1] = 0.0f;
+		}
+
+		// Removes every particle that has outlived its life span, returns how many
+		inline uint32_t Compact()
+		{
+			uint32_t removed = 0;
+			for (uint32_t i = 0; i < count;)	// The moved-in particle is checked in the same slot
+				if (age[i] >= life[i])
+				{
+					Remove(i);
+					removed++;
+				}
+				else
+					i++;
+			return removed;		// Return the count
+		}
+	};
+
+	// Directional particles rise along their direction and sway sideways
+	inline void UpdateDirectional(Pool &p, float delta)
+	{
+		uint32_t i = 0;
+		p.lower = glm::vec3(FLT_MAX);	// The box is rebuilt from where they end up
+		p.upper = glm::vec3(-FLT_MAX);
+#ifdef PARTICLE_SIMD
+		__m128 d = _mm_set1_ps(delta), k = _mm_set1_ps(1000.0f), c = _mm_set1_ps(0.01f);
+		Bounds4 bounds;
+		for (; i + 4 <= p.count; i += 4)	// Four at a time...
+		{
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(&p.speed[i]), d);	// Life spent this frame
+			__m128 phase = _mm_loadu_ps(&p.phase[i]), age = _mm_loadu_ps(&p.age[i]);
+			__m128 x = _mm_add_ps(_mm_loadu_ps(&p.x[i]), _mm_mul_ps(v, _mm_loadu_ps(&p.dir_x[i])));
+			x = _mm_add_ps(x, _mm_mul_ps(Sin4(phase), _mm_loadu_ps(&p.wave[i])));
+			__m128 y = _mm_add_ps(_mm_loadu_ps(&p.y[i]), _mm_mul_ps(v, _mm_loadu_ps(&p.dir_y[i])));
+			__m128 z = _mm_add_ps(_mm_loadu_ps(&p.z[i]), _mm_mul_ps(v, _mm_loadu_ps(&p.dir_z[i])));
+			_mm_storeu_ps(&p.x[i], x);
+			_mm_storeu_ps(&p.y[i], y);
+			_mm_storeu_ps(&p.z[i], z);
+			bounds.Add(x, y, z);
+			__m128 fade = _mm_mul_ps(_mm_mul_ps(Sin4(Abs4(_mm_sub_ps(age, _mm_loadu_ps(&p.life[i])))), _mm_loadu_ps(&p.fade[i])), d);
+			_mm_storeu_ps(&p.alpha[i], _mm_add_ps(_mm_loadu_ps(&p.alpha[i]), fade));
+			_mm_storeu_ps(&p.age[i], _mm_add_ps(age, v));
+			_mm_storeu_ps(&p.phase[i], _mm_add_ps(phase, _mm_mul_ps(c, _mm_mul_ps(v, k))));
+		}
+		bounds.Reduce(p.lower, p.upper);
+#endif
+		uint32_t tail = i;	// Where the scalar particles start
+		for (; i < p.count; i++)	// The rest one at a time
+		{
+			float v = p.speed[i] * delta;
+			p.x[i] = p.x[i] + v * p.dir_x[i] + Sin(p.phase[i]) * p.wave[i];
+			p.y[i] += v * p.dir_y[i];
+			p.z[i] += v * p.dir_z[i];
+			p.alpha[i] += Sin(std::fabs(p.age[i] - p.life[i])) * p.fade[i] * delta;
+			p.age[i] += v;
+			p.phase[i] += 0.01f * (v * 1000.0f);
+		}
+		p.Bound(tail, p.count);
+	}
+
+	// Point particles orbit their spawn point, wobbling with their phase (the sideways step turns with the phase, so
+	// they wander in x and z)
+	inline void UpdatePoint(Pool &p, float delta)
+	{
+		uint32_t i = 0;
+		p.lower = glm::vec3(FLT_MAX);	// The box is rebuilt from where they end up
+		p.upper = glm::vec3(-FLT_MAX);
+#ifdef PARTICLE_SIMD
+		__m128 d = _mm_set1_ps(delta), k = _mm_set1_ps(1000.0f), c = _mm_set1_ps(0.01f), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		Bounds4 bounds;
+		for (; i + 4 <= p.count; i += 4)	// Four at a time...
+		{
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(&p.speed[i]), d);	// Life spent this frame
+			__m128 phase = _mm_loadu_ps(&p.phase[i]), age = _mm_loadu_ps(&p.age[i]), r = _mm_loadu_ps(&p.radius[i]);
+			__m128 spin = _mm_mul_ps(v, k);
+			__m128 x = _mm_add_ps(_mm_loadu_ps(&p.x[i]), _mm_mul_ps(_mm_mul_ps(Sin4(spin), Sin4(phase)), r));
+			__m128 y = _mm_add_ps(_mm_loadu_ps(&p.y[i]), _mm_mul_ps(_mm_mul_ps(Cos4(spin), Cos4(phase)), r));
+			__m128 z = _mm_add_ps(_mm_loadu_ps(&p.z[i]), _mm_mul_ps(_mm_mul_ps(Sin4(spin), Cos4(phase)), r));
+			_mm_storeu_ps(&p.x[i], x);
+			_mm_storeu_ps(&p.y[i], y);
+			_mm_storeu_ps(&p.z[i], z);
+			bounds.Add(x, y, z);
+			__m128 fade = _mm_mul_ps(_mm_mul_ps(Sin4(Abs4(_mm_sub_ps(age, _mm_loadu_ps(&p.life[i])))), _mm_loadu_ps(&p.fade[i])), d);
+			_mm_storeu_ps(&p.alpha[i], _mm_add_ps(_mm_loadu_ps(&p.alpha[i]), fade));
+			_mm_storeu_ps(&p.age[i], _mm_add_ps(age, v));
+			__m128 waves = _mm_cmpneq_ps(_mm_loadu_ps(&p.wave[i]), zero);	// Swaying particles advance, the rest hold at 1
+			__m128 advanced = _mm_add_ps(phase, _mm_mul_ps(c, spin));
+			_mm_storeu_ps(&p.phase[i], _mm_or_ps(_mm_and_ps(waves, advanced), _mm_andnot_ps(waves, one)));
+		}
+		bounds.Reduce(p.lower, p.upper);
+#endif
+		uint32_t tail = i;	// Where the scalar particles start
+		for (; i < p.count; i++)	// The rest one at a time
+		{
+			float v = p.speed[i] * delta, spin = v * 1000.0f;
+			p.x[i] += Sin(spin) * Sin(p.phase[i]) * p.radius[i];
+			p.y[i] += Cos(spin) * Cos(p.phase[i]) * p.radius[i];
+			p.z[i] += Sin(spin) * Cos(p.phase[i]) * p.radius[i];
+			p.alpha[i] += Sin(std::fabs(p.age[i] - p.life[i])) * p.fade[i] * delta;
+			p.age[i] += v;
+			p.phase[i] = p.wave[i] != 0.0f ? p.phase[i] + 0.01f * spin : 1.0f;
+		}
+		p.Bound(tail, p.count);
+	}
+
+	// Interleaves the live particles into instance data, 4 floats each (x, y, z, alpha), in 'order' if one is given
+	inline void Pack(const Pool &p, const uint32_t* order, float* out)
+	{
+		uint32_t i = 0;
+		if (order)	// Gathered back to front
+		{
+			for (; i < p.count; i++, out += 4)
+			{
+				uint32_t s = order[i];
+				out[0] = p.x[s];
+				out[1] = p.y[s];
+				out[2] = p.z[s];
+				out[3] = p.alpha[s];
+			}
+			return;
+		}
+#ifdef PARTICLE_SIMD
+		for (; i + 4 <= p.count; i += 4, out += 16)		// Four at a time, transposed into rows
+		{
+			__m128 r0 = _mm_loadu_ps(&p.x[i]), r1 = _mm_loadu_ps(&p.y[i]), r2 = _mm_loadu_ps(&p.z[i]), r3 = _mm_loadu_ps(&p.alpha[i]);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(out, r0);
+			_mm_storeu_ps(out + 4, r1);
+			_mm_storeu_ps(out + 8, r2);
+			_mm_storeu_ps(out + 12, r3);
+		}
+#endif
+		for (; i < p.count; i++, out += 4)	// The rest one at a time
+		{
+			out[0] = p.x[i];
+			out[1] = p.y[i];
+			out[2] = p.z[i];
+			out[3] = p.alpha[i];
+		}
+	}
+
+	// Orders an emitter's particles back to front for alpha blending. Keys are view depths quantised over the depth
+	// range of the pool's bounding box, so each fits in the bits a 32 bit word has left after the slot: (depth << slot
+	// bits | slot). An LSD radix sort of two 8 bit digits over just the depth bits then orders the words (the slots
+	// start in order and every pass is stable, so equal depths keep slot order), and the last pass writes the order
+	// directly. While no particle has changed slot since the last sort, that order is repaired with an insertion sort
+	// instead, which costs one pass when the view barely moved; if too many neighbours are out of order, or repairing
+	// takes more than PARTICLE_SORT_MOVES moves per particle, it falls back to the radix sort
+	class DepthSorter
+	{
+	private:
+		std::vector<uint32_t>	_keys;	// Quantised depth per slot (0 is the farthest)
+		std::vector<uint32_t>	_order;		// Slots back to front
+		std::vector<uint32_t>	_words, _scratch;	// Radix buffers (key << slot bits | slot)
+		bool					_valid;		// Whether _order still names the same particles
+		bool					_incremental;	// Whether the last sort only repaired the order
+
+		// Returns the bits a slot below 'n' needs
+		static inline uint32_t SlotBits(uint32_t n)
+		{
+			uint32_t bits = 0;
+			while (bits < 32 && (n - 1) >> bits)
+				bits++;
+			return bits;	// Return the count
+		}
+
+		// Fills the key of every live slot, far to near in 'depth_bits' bits
+		inline void BuildKeys(const Pool &p, const glm::vec3 &eye, const glm::vec3 &front, uint32_t depth_bits)
+		{
+			_keys.resize(p.count);
+			float d = glm::dot(eye, front);
+			glm::vec3 centre = (p.lower + p.upper) * 0.5f, extent = (p.upper - p.lower) * 0.5f;		// The box's depth range
+			float range = 2.0f * glm::dot(extent, glm::abs(front)), top = (float)((1u << depth_bits) - 1);
+			if (!(range > 0.0f))	// If they all sit at one depth (or the box is empty)...
+			{
+				std::fill(_keys.begin(), _keys.end(), 0u);	// Slot order will do
+				return;
+			}
+			float farthest = glm::dot(centre, front) - d + range * 0.5f, scale = top / range;
+			uint32_t i = 0;
+#ifdef PARTICLE_SIMD
+			__m128 fx = _mm_set1_ps(front.x), fy = _mm_set1_ps(front.y), fz = _mm_set1_ps(front.z), dd = _mm_set1_ps(d);
+			__m128 f = _mm_set1_ps(farthest), s = _mm_set1_ps(scale), hi = _mm_set1_ps(top), zero = _mm_setzero_ps();
+			for (; i + 4 <= p.count; i += 4)	// Four at a time...
+			{
+				__m128 depth = _mm_mul_ps(_mm_loadu_ps(&p.x[i]), fx);
+				depth = _mm_add_ps(depth, _mm_mul_ps(_mm_loadu_ps(&p.y[i]), fy));
+				depth = _mm_sub_ps(_mm_add_ps(depth, _mm_mul_ps(_mm_loadu_ps(&p.z[i]), fz)), dd);
+				__m128 q = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(f, depth), s), zero), hi);	// Clamped, in case the box is stale
+				_mm_storeu_si128((__m128i*)&_keys[i], _mm_cvttps_epi32(q));
+			}
+#endif
+			for (; i < p.count; i++)	// The rest one at a time
+			{
+				float q = (farthest - (p.x[i] * front.x + p.y[i] * front.y + p.z[i] * front.z - d)) * scale;
+				_keys[i] = (uint32_t)std::min(std::max(q, 0.0f), top);
+			}
+		}
+
+		// Repairs last frame's order, returns false if it moved too far to be worth it
+		inline bool Repair()
+		{
+			uint32_t n = (uint32_t)_order.size(), budget = n * PARTICLE_SORT_MOVES + 64, moves = 0, descents = 0;
+			for (uint32_t i = 1; i < n; i++)	// A quick look first: a turned view unsorts everything
+				if (_keys[_order[i - 1]] > _keys[_order[i]] && ++descents > n / PARTICLE_SORT_DESCENTS + 16)
+					return false;
+			for (uint32_t i = 1; i < n; i++)	// Insertion sort (stable, linear when nearly sorted)
+			{
+				uint32_t s = _order[i], k = _keys[s], j = i;
+				for (; j > 0 && _keys[_order[j - 1]] > k; j--)
+				{
+					_order[j] = _order[j - 1];
+					if (++moves > budget)	// Still a permutation, the radix sort takes it from here
+					{
+						_order[j - 1] = s;
+						return false;
+					}
+				}
+				_order[j] = s;
+			}
+			return true;	// Return success
+		}
+
+		// Sorts every live slot by key ('slot_bits' hold the slot, the key fits in the rest)
+		inline void Radix(uint32_t n, uint32_t slot_bits)
+		{
+			uint32_t counts[2][PARTICLE_SORT_BUCKETS] = {};		// Both digits' histograms in one pass (on the stack, jobs sort in parallel)
+			_words.resize(n);
+			_scratch.resize(n);
+			_order.resize(n);
+			for (uint32_t i = 0; i < n; i++)
+			{
+				uint32_t k = _keys[i];
+				_words[i] = k << slot_bits | i;
+				counts[0][k & (PARTICLE_SORT_BUCKETS - 1)]++;
+				counts[1][k >> PARTICLE_SORT_DIGIT]++;
+			}
+
+			int passes[2], num_passes = 0;	// The digits that aren't shared by every key
+			for (int d = 0; d < 2; d++)
+				if (counts[d][(_keys[0] >> (d * PARTICLE_SORT_DIGIT)) & (PARTICLE_SORT_BUCKETS - 1)] != n)
+					passes[num_passes++] = d;
+
+			uint32_t* from = _words.data(), *to = _scratch.data(), mask = (1u << slot_bits) - 1;
+			for (int p = 0; p < num_passes; p++)	// For each digit, low first...
+			{
+				uint32_t* count = counts[passes[p]], shift = slot_bits + passes[p] * PARTICLE_SORT_DIGIT;
+				for (uint32_t b = 0, sum = 0; b < PARTICLE_SORT_BUCKETS; b++)	// Bucket starts
+				{
+					uint32_t c = count[b];
+					count[b] = sum;
+					sum += c;
+				}
+				if (p + 1 == num_passes)	// The last scatter only needs the slots
+				{
+					for (uint32_t i = 0; i < n; i++)
+						_order[count[(from[i] >> shift) & (PARTICLE_SORT_BUCKETS - 1)]++] = from[i] & mask;
+					return;
+				}
+				for (uint32_t i = 0; i < n; i++)	// Scatter, keeping equal keys in order
+					to[count[(from[i] >> shift) & (PARTICLE_SORT_BUCKETS - 1)]++] = from[i];
+				std::swap(from, to);
+			}
+			for (uint32_t i = 0; i < n; i++)	// Every key was equal
+				_order[i] = i;
+		}
+
+	public:
+		inline DepthSorter() : _valid(false), _incremental(false) {}
+
+		inline void Invalidate() { _valid = false; }	// Particles changed slots, the next sort starts over
+
+		// Orders the live particles back to front as seen from 'eye' looking along 'front'
+		inline void Sort(const Pool &p, const glm::vec3 &eye, const glm::vec3 &front)
+		{
+			uint32_t slot_bits = SlotBits(p.count), depth_bits = std::min(32u - slot_bits, (uint32_t)PARTICLE_SORT_DEPTH);
+			BuildKeys(p, eye, front, depth_bits);
+			_incremental = _valid && _order.size() == p.count && Repair();
+			if (!_incremental && p.count)
+				Radix(p.count, slot_bits);
+			_order.resize(p.count);
+			_valid = true;
+		}
+
+		inline const uint32_t* GetOrder() const { return _order.data(); }	// Return the slots back to front
+		inline bool WasIncremental() const { return _incremental; }		// Return whether the last sort only repaired the order
+	};
+}
+
+#endif
@@ -2,128 +2,39 @@
 #define PARTICLE_SYSTEM_H
 
 #include <ctime>
-#include <random>
+#include <cmath>
+#include <climits>
+#include <string>
 #include "Instance.h"
+#include "ParticleSimulation.h"	// Get the particle arrays and kernels
+#include "SpriteAtlas.h"	// Get the shared sprite atlas
 
 // Global formulas
-inline float randF(float min, float max) { return ((max - min)*((float)rand() / RAND_MAX)) + min; }
 inline float avrgf(float min, float max) { return (min + max) / 2; }
 inline float avrgv(glm::vec2 range) { return (range.x + range.y) / 2; }
 
 
-// Abstract particle struct
-struct Particle
-{
-	float			_alpha;
-	float			_alpha_lerp;
-	float			_life;
-	float			_life_count;
-	float			_velocity;
-	float			_speed;
-	float			_wave;
-	float			_wave_count;
-
-	glm::vec2		_pos;
-
-	unsigned int	_loc_alpha;
-	unsigned int	_loc_pos;
-
-	inline Particle() :
-		_alpha(0.0f),
-		_life(0.0f),
-		_life_count(0.0f),
-		_wave(0.0f),
-		_wave_count(0.0f),
-		_alpha_lerp(0.0f),
-		_velocity(0.0f),
-		_speed(0.0f),
-		_pos(glm::vec2(0.0f)) {}
-
-	inline virtual void update(double delta) = 0;
-};
-
-// Directional particle struct
-struct DirectionalParticle : public Particle
-{
-	glm::vec2	_dir;
-
-	inline DirectionalParticle(glm::vec2 pos, glm::vec2 dir, float life, float speed, float wave, float alpha_lerp)
-	{
-		_life = life;
-		_wave = wave;
-		_alpha_lerp = alpha_lerp;
-		_speed = speed;
-		_pos = pos;
-		_dir = dir;
-	}
-
-	inline virtual void update(double delta)
-	{
-		// Update position
-		_velocity = _speed * (float)delta;
-		_pos += _velocity * _dir;
-		_pos.x += sin(_wave_count) * _wave;
-
-		// Update alpha lerp
-		_alpha += (sin((glm::distance(_life_count, _life))) * _alpha_lerp) * (float)delta;
-
-		// Update life span
-		_life_count += _velocity;
-
-		// Update wave count
-		_wave_count += 0.01f * (_velocity * 1000.0f);
-	}
-};
-
-// Point particle struct
-struct PointParticle : public Particle
-{
-	float	_radius;
-
-	inline PointParticle(glm::vec2 pos, float radius, float life, float speed, float wave, float alpha_lerp)
-	{
-		_life = life;
-		_wave = wave;
-		_alpha_lerp = alpha_lerp;
-		_speed = speed;
-		_pos = pos;
-		_radius = radius;
-	}
-
-	inline virtual void update(double delta)
-	{
-		// Update position
-		_velocity = _speed * (float)delta;
-		_pos += (glm::vec2(sin(_velocity * 1000.0f), cos(_velocity * 1000.0f)) *
-			glm::vec2(sin(_wave_count), cos(_wave_count))) * _radius;
-
-		// Update alpha lerp
-		_alpha += (sin((glm::distance(_life_count, _life))) * _alpha_lerp) * (float)delta;
-
-		// Update life span
-		_life_count += _velocity;
-
-		// Update wave count
-		_wave != 0.0f ? _wave_count += 0.01f * (_velocity * 1000.0f) : _wave_count = 1.0f;
-	}
-};
-
-
-// Struct redefinitions
-typedef	Particle				_pt_x;
-typedef DirectionalParticle		_pt_dir;
-typedef PointParticle			_pt_point;
-
-
-// Abstract particle system class
+// Abstract particle system class. Particles live in the emitter's ParticleSimulation::Pool and are advanced by
+// one kernel call a frame; dead ones are swap-removed and new ones spawned in a batch from the emitter's own
+// generator, so an emitter given a seed plays back the same every run. Rendering streams the live particles
+// into the emitter's Instance and draws them with one instanced call. Particles move in 3D around _position;
+// blended emitters (the default) are drawn back to front, sorted by the emitter's DepthSorter once a frame.
+// Shaders that still read the particles[] uniforms instead of the instance attribute get those set as well
 class ParticleSystem
 {
 protected:
-	bool					_particles_divised;
-	float					_particle_indices;
-	float					_particle_divisor;
-	std::vector<_pt_x*>		_particles;
-	t_instance*				_instance;
+	bool							_particles_divised;
+	float							_particle_indices;
+	float							_particle_divisor;
+	unsigned int					_particle_limit;
+	bool							_depth_sorted;
+	bool							_sort_current;
+	ParticleSimulation::Pool		_pool;
+	ParticleSimulation::Random		_random;
+	ParticleSimulation::DepthSorter	_sorter;
+	t_instance*						_instance;
+	std::vector<GLint>				_loc_alpha;		// Per slot uniforms, only for shaders without the instance attribute
+	std::vector<GLint>				_loc_pos;
 
 public:
 	unsigned int			_num_particles;
@@ -140,6 +51,11 @@ public:
 		_particles_divised(false),
 		_particle_indices(0),
 		_particle_divisor(0.0f),
+		_particle_limit(UINT_MAX),
+		_depth_sorted(true),
+		_sort_current(false),
+		_instance(NULL),
+		_num_particles(0),
 		_position(glm::vec3(0.0f)),
 		_spread(glm::vec2(0.0f)),
 		_spawn_delay(glm::vec2(0.0f)),
@@ -148,21 +64,94 @@ public:
 		_alpha_lerp(glm::vec2(0.0f)),
 		_wave(glm::vec2(0.0f)) {}
 
+	inline virtual ~ParticleSystem() { delete _instance; }
+
 	inline virtual void update(double delta) = 0;
 	inline virtual void render() = 0;
 
+	// Empties the emitter and restarts its generator (0 seeds from the clock), so the same seed replays exactly
+	inline void seed(uint64_t seed)
+	{
+		_random.Seed(seed ? seed : static_cast<uint64_t>(time(NULL)));
+		_pool.Reserve(_num_particles);
+		_sorter.Invalidate();
+		_sort_current = false;
+		_particle_indices = 0.0f;
+		_particles_divised = false;
+	}
+
+	// Caps the live particles (a manager's share of its budget), the excess is dropped on the next update
+	inline void setLimit(unsigned int limit) { _particle_limit = limit; }
+
+	// Whether the emitter is blended and drawn back to front (additive emitters can skip the sort)
+	inline void setDepthSorted(bool sorted) { _depth_sorted = sorted; }
+
+	// Orders the particles back to front for this frame's view (render does it if no one did since the update)
+	inline void sortParticles(const glm::vec3 &eye, const glm::vec3 &front)
+	{
+		_sorter.Sort(_pool, eye, front);
+		_sort_current = true;
+	}
+
+	inline unsigned int numAlive() const { return _pool.count; }
+	inline unsigned int getCapacity() const { return _num_particles; }
+	inline unsigned int getLimit() const { return _particle_limit; }
+	inline bool isDepthSorted() const { return _depth_sorted; }
+	inline const ParticleSimulation::DepthSorter& getSorter() const { return _sorter; }
+	// Returns how far the particles reach from _position: the box they ended the last update in (the kernels track it,
+	// since sway and orbits add up per frame rather than per second), and at least the region they spawn in
+	inline float getRadius() const
+	{
+		float spawn = glm::length(glm::vec3(_spread.x, _spread.y, _spread.x));
+		if (!_pool.count)	// If nothing is alive yet...
+			return spawn;	// Return the spawn region
+		glm::vec3 reach = glm::max(glm::abs(_pool.lower - _position), glm::abs(_pool.upper - _position));
+		return std::max(spawn, glm::length(reach));
+	}
+	inline const ParticleSimulation::Pool& getPool() const { return _pool; }
+
 protected:
-	inline virtual void respawn(_pt_x *p) = 0;
+	inline virtual void advance(float delta) = 0;	// Runs the emitter's kernel over the live particles
+	inline virtual void spawn(unsigned int first, unsigned int count) = 0;	// Places particles [first, first + count)
+
+	// Sizes the pool, seeds the generator and allocates the instance stream (finding each slot's uniforms as well
+	// if the shader still declares the particles[] array)
+	inline void createParticles(GLuint shader_program, uint64_t seed_value)
+	{
+		_particle_divisor = (avrgv(_life_span) / avrgv(_spawn_delay)) * avrgv(_speed);
+		_num_particles = static_cast<unsigned int>(avrgv(_life_span) / avrgv(_spawn_delay));
+		seed(seed_value);
+
+		_loc_alpha.clear();
+		_loc_pos.clear();
+		if (glGetUniformLocation(shader_program, "particles[0]._pos") != -1)
+		{
+			_loc_alpha.resize(_num_particles);
+			_loc_pos.resize(_num_particles);
+			for (unsigned int i = 0; i < _num_particles; i++)
+			{
+				std::string	index = std::to_string(i);
+				_loc_alpha[i] = glGetUniformLocation(shader_program, ("particles[" + index + "]._alpha").c_str());
+				_loc_pos[i] = glGetUniformLocation(shader_program, ("particles[" + index + "]._pos").c_str());
+			}
+		}
+
+		_instance = new t_instance(_num_particles);
+	}
 
-	inline void restoreDefaults(_pt_x *p)
+	// Rolls the attributes every emitter shares
+	inline void restoreDefaults(unsigned int first, unsigned int count)
 	{
-		p->_life_count = 0.0f;
-		p->_velocity = 0.0f;
-		p->_alpha = 0.0f;
-		p->_life = randF(_life_span.x, _life_span.y);
-		p->_speed = randF(_speed.x, _speed.y);
-		p->_wave = randF(_wave.x, _wave.y);
-		p->_alpha_lerp = randF(_alpha_lerp.x, _alpha_lerp.y);
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			_pool.age[i] = 0.0f;
+			_pool.alpha[i] = 0.0f;
+			_pool.phase[i] = 0.0f;
+			_pool.life[i] = _random.Range(_life_span);
+			_pool.speed[i] = _random.Range(_speed);
+			_pool.wave[i] = _random.Range(_wave);
+			_pool.fade[i] = _random.Range(_alpha_lerp);
+		}
 	}
 
 	inline void updateParticles(double delta)
@@ -171,22 +160,52 @@ protected:
 		if (!_particles_divised)
 		{
 			_particle_indices += _particle_divisor * (float)delta;
-			if (_particle_indices >= _particles.size())
+			if (_particle_indices >= _num_particles)
 			{
-				_particle_indices = (float)_particles.size();
+				_particle_indices = (float)_num_particles;
 				_particles_divised = true;
 			}
 		}
 
-		for (unsigned int i = 0; i < _particle_indices; i++)
+		// Update particles, then replace the ones that outlived their life span (up to the limit)
+		unsigned int alive = _pool.count;
+		advance((float)delta);
+		unsigned int removed = _pool.Compact();
+
+		unsigned int target = std::min(std::min(static_cast<unsigned int>(std::ceil(_particle_indices)), _num_particles), _particle_limit);
+		_pool.Truncate(target);
+		if (_pool.count < target)
 		{
-			// Update particles
-			_particles[i]->update(delta);
+			unsigned int first = _pool.count;
+			_pool.count = target;
+			spawn(first, target - first);
+			_pool.Bound(first, target);		// The box takes in the new particles
+		}
+
+		// Particles that changed slot void last frame's order
+		if (removed || _pool.count != alive)
+			_sorter.Invalidate();
+		_sort_current = false;
+	}
 
-			// Check for particle life span
-			if (_particles[i]->_life_count >= _particles[i]->_life)
-				respawn(_particles[i]);
+	// Writes the live particles into this frame's instance data and draws them with one call
+	inline void drawParticles(const glm::vec3 &eye, const glm::vec3 &front)
+	{
+		if (_depth_sorted && !_sort_current)
+			sortParticles(eye, front);
+
+		const uint32_t* order = _depth_sorted ? _sorter.GetOrder() : NULL;
+		for (unsigned int i = 0; i < _loc_pos.size() && i < _pool.count; i++)	// Older shaders index the uniforms by gl_InstanceID
+		{
+			unsigned int s = order ? order[i] : i;
+			glUniform1f(_loc_alpha[i], _pool.alpha[s]);
+			glUniform2f(_loc_pos[i], _pool.x[s], _pool.y[s]);
 		}
+
+		glm::vec4* out = _instance->map();
+		if (out)
+			ParticleSimulation::Pack(_pool, order, &out->x);
+		_instance->render(out ? _pool.count : 0);
 	}
 };
 
@@ -198,7 +217,10 @@ private:
 	GLuint proj;
 
 	GLuint _sampler;
-	GLuint _samplerID;
+	GLuint _sprite_rect;
+	GLuint _sprite_layer;
+
+	unsigned int _sprite;
 
 	GLuint cam_u;
 	GLuint cam_r;
@@ -210,7 +232,8 @@ public:
 		glm::vec2	life_span,
 		glm::vec2	speed,
 		glm::vec2	wave,
-		glm::vec2	alpha_lerp)
+		glm::vec2	alpha_lerp,
+		uint64_t	seed = 0)
 	{
 		// Assign temp data
 		_position = position;
@@ -221,28 +244,8 @@ public:
 		_wave = wave;
 		_alpha_lerp = alpha_lerp;
 
-		// Calculate particle count;
-		_particle_divisor = (avrgv(life_span) / avrgv(spawn_delay)) * avrgv(speed);
-		_num_particles = static_cast<unsigned int>(avrgv(life_span) / avrgv(spawn_delay));
-
-		// Seed before randomisation
-		srand(static_cast<unsigned int>(time(NULL)));
-
-		// Create particles
-		for (unsigned int i = 0; i < _num_particles; i++)
-		{
-			std::string	index = std::to_string(i);
-			_particles.push_back(new _pt_dir(
-				glm::vec2(randF(position.x - _spread.x, position.x + _spread.x), position.y),
-				glm::vec2(randF(-_spread.y, _spread.y), 1.0f),
-				randF(life_span.x, life_span.y),
-				randF(speed.x, speed.y),
-				randF(wave.x, wave.y),
-				randF(alpha_lerp.x, alpha_lerp.y)));
-
-			_particles[i]->_loc_alpha = glGetUniformLocation(shader_program, ("particles[" + index + "]._alpha").c_str());
-			_particles[i]->_loc_pos = glGetUniformLocation(shader_program, ("particles[" + index + "]._pos").c_str());
-		}
+		// Create particles (0 seeds from the clock)
+		createParticles(shader_program, seed);
 
 		view = glGetUniformLocation(shader_program, "view");
 		proj = glGetUniformLocation(shader_program, "proj");
@@ -251,34 +254,10 @@ public:
 		cam_r = glGetUniformLocation(shader_program, "cam_right");
 
 		_sampler = glGetUniformLocation(shader_program, "sprite");
+		_sprite_rect = glGetUniformLocation(shader_program, "sprite_rect");
+		_sprite_layer = glGetUniformLocation(shader_program, "sprite_layer");
 
-		int width;
-		int height;
-		int nr_components;
-
-		unsigned char* data = stbi_load("test.png", &width, &height, &nr_components, 0);
-
-		glGenTextures(1, &_samplerID);
-		glBindTexture(GL_TEXTURE_2D, _samplerID);
-
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-		stbi_image_free(data);
-
-
-		// Create instance
-		_instance = new t_instance(_num_particles);
-	}
-
-	inline ~DirectionalParticleSystem()
-	{
-		delete _instance;
-		_particles.clear();
+		_sprite = SpriteAtlas::Get(SPRITE_ATLAS_EFFECTS)->Add("test.png");	// The sprite's region in the effects atlas
 	}
 
 	inline virtual void update(double delta)
@@ -288,12 +267,6 @@ public:
 
 	inline virtual void render()
 	{
-		for (unsigned int i = 0; i < _num_particles; i++)
-		{
-			glUniform1f(_particles[i]->_loc_alpha, _particles[i]->_alpha);
-			glUniform2fv(_particles[i]->_loc_pos, 1, glm::value_ptr(_particles[i]->_pos));
-		}
-
 		glUniformMatrix4fv(view, 1, GL_FALSE, glm::value_ptr(Content::_map->GetCamera()->GetViewMatrix()));
 		glUniformMatrix4fv(proj, 1, GL_FALSE, glm::value_ptr(Content::_map->GetCamera()->GetProjectionMatrix()));
 
@@ -302,17 +275,32 @@ public:
 
 		glUniform1i(_sampler, 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, _samplerID);
+		SpriteAtlas* atlas = SpriteAtlas::Get(SPRITE_ATLAS_EFFECTS);
+		atlas->Use(_sprite, 0, _sprite_rect, _sprite_layer);	// Its region, or the sprite alone for older shaders
+
+		drawParticles(Content::_map->GetCamera()->GetPosition(), Content::_map->GetCamera()->GetFront());
+	}
 
-		_instance->render();
+protected:
+	inline virtual void advance(float delta)
+	{
+		ParticleSimulation::UpdateDirectional(_pool, delta);
 	}
 
-	inline virtual void respawn(_pt_x* p)
+	inline virtual void spawn(unsigned int first, unsigned int count)
 	{
-		restoreDefaults(p);
-		p->_pos = glm::vec2(randF(_position.x - _spread.x, _position.x + _spread.x), _position.y);
-		((_pt_dir*)p)->_dir = glm::vec2(randF(-_spread.y, _spread.y), 1.0f);
+		restoreDefaults(first, count);
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			float r = _spread.x * std::sqrt(_random.Float()), a = _random.Range(-PARTICLE_PI, PARTICLE_PI);	// Uniform over a disc of radius spread.x
+			_pool.x[i] = _position.x + r * ParticleSimulation::Cos(a);
+			_pool.y[i] = _position.y;
+			_pool.z[i] = _position.z + r * ParticleSimulation::Sin(a);
+			float lean = _spread.y * std::sqrt(_random.Float()), heading = _random.Range(-PARTICLE_PI, PARTICLE_PI);	// Leaning up to spread.y off vertical
+			_pool.dir_x[i] = lean * ParticleSimulation::Cos(heading);
+			_pool.dir_y[i] = 1.0f;
+			_pool.dir_z[i] = lean * ParticleSimulation::Sin(heading);
+		}
 	}
 };
 
@@ -324,7 +312,10 @@ private:
 	GLuint proj;
 
 	GLuint _sampler;
-	GLuint _samplerID;
+	GLuint _sprite_rect;
+	GLuint _sprite_layer;
+
+	unsigned int _sprite;
 
 	GLuint cam_u;
 	GLuint cam_r;
@@ -336,7 +327,8 @@ public:
 		glm::vec2	life_span,
 		glm::vec2	speed,
 		glm::vec2	wave,
-		glm::vec2	alpha_lerp)
+		glm::vec2	alpha_lerp,
+		uint64_t	seed = 0)
 	{
 		// Assign temp data
 		_position = position;
@@ -347,62 +339,18 @@ public:
 		_wave = wave;
 		_alpha_lerp = alpha_lerp;
 
-		// Calculate particle count;
-		_particle_divisor = (avrgv(life_span) / avrgv(spawn_delay)) * avrgv(speed);
-		_num_particles = static_cast<unsigned int>(avrgv(life_span) / avrgv(spawn_delay));
-
-		// Seed before randomisation
-		srand(static_cast<unsigned int>(time(NULL)));
-
-		// Create particles
-		for (unsigned int i = 0; i < _num_particles; i++)
-		{
-			std::string	index = std::to_string(i);
-			_particles.push_back(new _pt_point(
-				glm::vec2(randF(position.x - _spread.x, position.x + _spread.x),
-					randF(position.y - _spread.y, _spread.y)),
-				randF(spread.x, spread.y),
-				randF(life_span.x, life_span.y),
-				randF(speed.x, speed.y),
-				randF(wave.x, wave.y),
-				randF(alpha_lerp.x, alpha_lerp.y)));
-
-			_particles[i]->_loc_alpha = glGetUniformLocation(shader_program, ("particles[" + index + "]._alpha").c_str());
-			_particles[i]->_loc_pos = glGetUniformLocation(shader_program, ("particles[" + index + "]._pos").c_str());
-		}
+		// Create particles (0 seeds from the clock)
+		createParticles(shader_program, seed);
 
 		view     = glGetUniformLocation(shader_program, "view");
 		proj     = glGetUniformLocation(shader_program, "proj");
 		cam_u    = glGetUniformLocation(shader_program, "cam_up");
 		cam_r    = glGetUniformLocation(shader_program, "cam_right");
 		_sampler = glGetUniformLocation(shader_program, "sprite");
+		_sprite_rect = glGetUniformLocation(shader_program, "sprite_rect");
+		_sprite_layer = glGetUniformLocation(shader_program, "sprite_layer");
 	
-		int width;
-		int height;
-		int nr_components;
-
-		unsigned char* data = stbi_load("thruster.png", &width, &height, &nr_components, 0);
-
-		glGenTextures(1, &_samplerID);
-		glBindTexture(GL_TEXTURE_2D, _samplerID);
-
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-		stbi_image_free(data);
-
-		// Create instance
-		_instance = new t_instance(_num_particles);
-	}
-
-	inline ~PointParticleSystem()
-	{
-		delete _instance;
-		_particles.clear();
+		_sprite = SpriteAtlas::Get(SPRITE_ATLAS_EFFECTS)->Add("thruster.png");	// The sprite's region in the effects atlas
 	}
 
 	inline virtual void update(double delta)
@@ -412,12 +360,6 @@ public:
 
 	inline virtual void render()
 	{
-		for (unsigned int i = 0; i < _num_particles; i++)
-		{
-			glUniform1f(_particles[i]->_loc_alpha, _particles[i]->_alpha);
-			glUniform3fv(_particles[i]->_loc_pos, 1, glm::value_ptr(_particles[i]->_pos));
-		}
-
 		glUniformMatrix4fv(view, 1, GL_FALSE, glm::value_ptr(Content::_map->GetCamera()->GetViewMatrix()));
 		glUniformMatrix4fv(proj, 1, GL_FALSE, glm::value_ptr(Content::_map->GetCamera()->GetProjectionMatrix()));
 
@@ -426,18 +368,28 @@ public:
 
 		glUniform1i(_sampler, 0);
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, _samplerID);
+		SpriteAtlas* atlas = SpriteAtlas::Get(SPRITE_ATLAS_EFFECTS);
+		atlas->Use(_sprite, 0, _sprite_rect, _sprite_layer);	// Its region, or the sprite alone for older shaders
 
-		_instance->render();
+		drawParticles(Content::_map->GetCamera()->GetPosition(), Content::_map->GetCamera()->GetFront());
+	}
 
+protected:
+	inline virtual void advance(float delta)
+	{
+		ParticleSimulation::UpdatePoint(_pool, delta);
 	}
 
-	inline virtual void respawn(_pt_x *p)
+	inline virtual void spawn(unsigned int first, unsigned int count)
 	{
-		restoreDefaults(p);
-		((_pt_point*)p)->_radius = randF(_spread.x, _spread.y);
-		p->_pos = glm::vec2(randF(_position.x - _spread.x, _position.x + _spread.x), randF(_position.y - _spread.y, _position.y + _spread.y));
+		restoreDefaults(first, count);
+		for (unsigned int i = first; i < first + count; i++)
+		{
+			_pool.radius[i] = _random.Range(_spread.x, _spread.y);
+			_pool.x[i] = _random.Range(_position.x - _spread.x, _position.x + _spread.x);
+			_pool.y[i] = _random.Range(_position.y - _spread.y, _position.y + _spread.y);
+			_pool.z[i] = _random.Range(_position.z - _spread.x, _position.z + _spread.x);
+		}
 	}
 };
 
@@ -0,0 +1,157 @@
+#ifndef __RECT_PACKER_H__
+#define __RECT_PACKER_H__
+
+#include <vector>	// Get dynamic array
+#include <cstdint>	// Get fixed width ints
+#include <algorithm>	// Get sort / max
+
+// A skyline bin packer: the free space of a page is kept as the top edge of everything placed so far (a list of
+// horizontal segments), each rectangle goes where its top is lowest, ties broken by the least space wasted
+// underneath it. Placement is O(segments) and the packing is within a few percent of maxrects for sprite sets
+namespace RectPacker
+{
+	// A placed rectangle
+	struct Rect
+	{
+		uint32_t	x;	// Left in pixels
+		uint32_t	y;	// Top in pixels
+		uint32_t	width;	// Width in pixels
+		uint32_t	height;		// Height in pixels
+		uint32_t	page;	// Which page it landed on
+		uint32_t	id;		// The caller's index
+	};
+
+	// One page of skyline
+	class Skyline
+	{
+	private:
+		struct Segment { uint32_t x, y, width; };	// A run of the skyline at height y
+
+		uint32_t				_width;		// Page width
+		uint32_t				_height;	// Page height
+		std::vector<Segment>	_segments;	// The skyline, left to right
+
+		// Finds the height a rectangle would sit at if its left edge was on segment i, returns false if it won't fit
+		inline bool Fit(size_t i, uint32_t width, uint32_t height, uint32_t &y, uint32_t &waste) const
+		{
+			if (_segments[i].x + width > _width)	// If it runs off the right...
+				return false;	// It doesn't fit
+
+			y = 0; waste = 0;	// Resting height / area wasted underneath
+			uint32_t left = width;	// Width still to cover
+			for (size_t j = i; left > 0; j++)	// Walk the segments it spans to find the highest...
+			{
+				y = std::max(y, _segments[j].y);
+				left -= std::min(left, _segments[j].width);
+			}
+			if (y + height > _height)	// If it runs off the bottom...
+				return false;	// It doesn't fit
+
+			left = width;	// Measure the gaps left underneath
+			for (size_t j = i; left > 0; j++)
+			{
+				uint32_t w = std::min(left, _segments[j].width);	// The covered part of this segment
+				waste += (y - _segments[j].y) * w;
+				left -= w;
+			}
+			return true;	// It fits
+		}
+
+	public:
+		inline Skyline() : _width(0), _height(0) {}
+		inline Skyline(uint32_t width, uint32_t height) { Reset(width, height); }
+
+		// Clears the page
+		inline void Reset(uint32_t width, uint32_t height)
+		{
+			_width = width;		// Assign width
+			_height = height;	// Assign height
+			_segments.assign(1, Segment{ 0, 0, width });	// One flat segment
+		}
+
+		// Places a rectangle, returns false if the page is full
+		inline bool Insert(uint32_t width, uint32_t height, uint32_t &x, uint32_t &y)
+		{
+			size_t best = SIZE_MAX;		// The best segment
+			uint32_t best_y = UINT32_MAX, best_waste = UINT32_MAX;	// Its score
+			for (size_t i = 0; i < _segments.size(); i++)	// For each segment...
+			{
+				uint32_t fy, waste;		// Where it would sit
+				if (Fit(i, width, height, fy, waste) && (fy + height < best_y || (fy + height == best_y && waste < best_waste)))	// Lowest top, then least waste
+				{
+					best = i;
+					best_y = fy + height;
+					best_waste = waste;
+				}
+			}
+			if (best == SIZE_MAX)	// If nothing fit...
+				return false;	// Return false as full
+
+			x = _segments[best].x;	// Assign position
+			y = best_y - height;
+
+			Segment placed = { x, best_y, width };	// The new top edge
+			_segments.insert(_segments.begin() + best, placed);		// Put it in
+			for (size_t i = best + 1; i < _segments.size(); i++)	// Trim the segments it now covers...
+			{
+				uint32_t end = placed.x + placed.width;		// Right edge of the new segment
+				if (_segments[i].x >= end)	// If this one is clear...
+					break;	// Done
+				uint32_t cut = end - _segments[i].x;	// How much is covered
+				if (cut >= _segments[i].width)	// If it's covered entirely...
+				{
+					_segments.erase(_segments.begin() + i--);	// Remove it
+					continue;
+				}
+				_segments[i].x += cut;	// Otherwise shorten it
+				_segments[i].width -= cut;
+				break;
+			}
+			for (size_t i = 0; i + 1 < _segments.size(); i++)	// Merge neighbours at the same height
+				if (_segments[i].y == _segments[i + 1].y)
+				{
+					_segments[i].width += _segments[i + 1].width;
+					_segments.erase(_segments.begin() + i + 1);
+					i--;
+				}
+			return true;	// Return success
+		}
+	};
+
+	// Packs sizes (already padded) onto as few width x height pages as needed, tallest first. Returns false if
+	// something is bigger than a page
+	inline bool Pack(const std::vector<std::pair<uint32_t, uint32_t>> &sizes, uint32_t width, uint32_t height, std::vector<Rect> &out, uint32_t &num_pages)
+	{
+		std::vector<uint32_t> order(sizes.size());	// Insertion order
+		for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)	// Tallest, then widest first
+		{
+			return sizes[a].second != sizes[b].second ? sizes[a].second > sizes[b].second : sizes[a].first > sizes[b].first;
+		});
+
+		std::vector<Skyline> pages;		// The open pages
+		out.assign(sizes.size(), Rect());	// One result per size
+		for (uint32_t i : order)	// For each rectangle...
+		{
+			uint32_t w = sizes[i].first, h = sizes[i].second;	// Its size
+			if (w > width || h > height)	// If it can never fit...
+				return false;	// Return false as failed
+
+			Rect &r = out[i];	// Its result
+			r.width = w; r.height = h; r.id = i;
+			r.page = 0;
+			while (r.page < pages.size() && !pages[r.page].Insert(w, h, r.x, r.y))	// First page with room
+				r.page++;
+			if (r.page == pages.size())		// If they're all full...
+			{
+				pages.push_back(Skyline(width, height));	// Open another
+				pages.back().Insert(w, h, r.x, r.y);
+			}
+		}
+
+		num_pages = (uint32_t)pages.size();		// Assign page count
+		return true;	// Return success
+	}
+}
+
+#endif
@@ -4,6 +4,8 @@
 #include "Engine/Context.h"	// Include context for setting up OpenGL
 #include "Engine/Deferred.h"	// Include the deferred passes for rendering in screenspce
 #include "Engine/Editor.h"		// Include the editor compnents
+#include "Engine/Vfs.h"	// Include the virtual file system for the content archive
+#include "Engine/SpriteAtlas.h"	// Include the shared sprite atlases
 
 
 Context	_opengl_context;	// Our OpenGL context class needs to be globally accessed
@@ -23,16 +25,21 @@ public:
 		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);		// Enable seamless cubemap for hardware acceleration
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE);	// Enable alpha blending
 
+		Vfs::Mount(__CONTENT_ARCHIVE__);	// Mount the packed content (loose files are used if there isn't one)
+
 		Editor::Initialise();	// Initialise the editor
 
 		glDisable(GL_BLEND);
 		Deferred::Initialise(_vp_width, _vp_height);	// Initialise the deferred renderer
+		SpriteAtlas::BuildAll();	// Pack the sprites everything above added, rather than in the first frame
 	}
 
 	// Destroy the render data
 	static inline void Destroy()
 	{
 		_opengl_context.Destroy();	// Free our context data
+		SpriteAtlas::Destroy();		// Release the shared atlases
+		Vfs::Unmount();		// Release the content archive
 	}
 
 	// Update our object's logic with delta time
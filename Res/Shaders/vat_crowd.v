@@ -0,0 +1,63 @@
+#version 330 core
+// Crowd vertex shader for VatCrowd: every vertex is read from the vertex animation texture, so the mesh only
+// supplies texcoords. Decodes exactly like Vat::Sample; pair it with the geometry pass fragment shader
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 6) in vec4 aPlacement;	// xyz position, w yaw in radians
+layout (location = 7) in vec2 aClip;	// x clip index, y start time in seconds
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+
+uniform mat4 view;
+uniform mat4 proj;
+
+uniform sampler2D gVat;
+uniform vec3 gVatMin;
+uniform vec3 gVatExtent;
+uniform int gVatWidth;
+uniform int gVatRows;
+uniform int gVatFrames;
+uniform vec4 gVatClips[16];	// first frame, frames, frames per second, unused (VAT_MAX_CLIPS)
+uniform float gTime;
+
+// Fetches vertex v of frame k
+vec4 FetchFrame(int k, int v)
+{
+	ivec2 texel = ivec2((k / gVatFrames) * gVatWidth + v % gVatWidth, (k % gVatFrames) * gVatRows + v / gVatWidth);
+	return texelFetch(gVat, texel, 0);
+}
+
+// Unpacks the 8:8 octahedral normal in a texel's w
+vec3 DecodeNormal(float w)
+{
+	uint bits = uint(w * 65535.0 + 0.5);
+	vec2 e = vec2(float(bits & 0xFFu), float(bits >> 8u)) / 255.0 * 2.0 - 1.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);	// Unfold the lower half
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+void main()
+{
+	vec4 clip = gVatClips[int(aClip.x)];
+	int frames = int(clip.y);
+	float f = mod((gTime - aClip.y) * clip.z, clip.y);	// Frames into the looping clip
+	int a = min(int(f), frames - 1);
+	int b = (a + 1) % frames;
+	float t = f - float(a);
+
+	vec4 ta = FetchFrame(int(clip.x) + a, gl_VertexID);
+	vec4 tb = FetchFrame(int(clip.x) + b, gl_VertexID);
+	vec3 position = gVatMin + mix(ta.xyz, tb.xyz, t) * gVatExtent;
+	vec3 normal = normalize(mix(DecodeNormal(ta.w), DecodeNormal(tb.w), t));
+
+	float c = cos(aPlacement.w), s = sin(aPlacement.w);	// Turn to the instance's yaw
+	mat3 yaw = mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+	FragPos = aPlacement.xyz + yaw * position;
+	Normal = yaw * normal;
+	TexCoords = aTexCoords;
+	gl_Position = proj * view * vec4(FragPos, 1.0);
+}
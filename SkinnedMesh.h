@@ -25,35 +25,20 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtx/transform.hpp>
-
-#include <assimp/Importer.hpp>      // C++ importer interface
-#include <assimp/scene.h>       // Output data structure
-#include <assimp/postprocess.h> // Post processing flags
+#include <glm/gtx/quaternion.hpp>
 
 #include "HelperFunctions.h"
-#include "BoneInfo.h"
 #include "VertexBoneData.h"
-
-glm::mat3 aiMatrix3x3ToGlm(const aiMatrix3x3 &from)
-{
-	glm::mat3 to;
-	//the a,b,c,d in assimp is the row ; the 1,2,3,4 is the column
-	to[0][0] = from.a1; to[1][0] = from.a2; to[2][0] = from.a3;
-	to[0][1] = from.b1; to[1][1] = from.b2; to[2][1] = from.b3;
-	to[0][2] = from.c1; to[1][2] = from.c2; to[2][2] = from.c3;
-	return to;
-}
-
-glm::mat4 aiMatrix4x4ToGlm(const aiMatrix4x4 &from)
-{
-	glm::mat4 to;
-	//the a,b,c,d in assimp is the row ; the 1,2,3,4 is the column
-	to[0][0] = from.a1; to[1][0] = from.a2; to[2][0] = from.a3; to[3][0] = from.a4;
-	to[0][1] = from.b1; to[1][1] = from.b2; to[2][1] = from.b3; to[3][1] = from.b4;
-	to[0][2] = from.c1; to[1][2] = from.c2; to[2][2] = from.c3; to[3][2] = from.c4;
-	to[0][3] = from.d1; to[1][3] = from.d2; to[2][3] = from.d3; to[3][3] = from.d4;
-	return to;
-}
+#include "Vfs.h"
+#include "SkmFormat.h"
+#include "AnimRuntime.h"
+#include "CpuSkinning.h"
+
+// Meshes are cooked offline by Tools/SkmCook.cpp (skm_cook). Builds that link Assimp can also define SKM_COOK_ON_LOAD
+// to cook missing .skm files from the source .dae on first load
+#ifdef SKM_COOK_ON_LOAD
+#include "SkmCooker.h"
+#endif
 
 class SkinnedMesh
 {
@@ -64,7 +49,6 @@ public:
 		m_VAO = 0;
 		ZERO_MEM(m_Buffers);
 		m_NumBones = 0;
-		m_pScene = NULL;
 	}
 
 	~SkinnedMesh()
@@ -72,11 +56,30 @@ public:
 		Clear();
 	}
 
+	// Maps the cooked mesh 'Filename.skm' and uploads it. Nothing is parsed: the vertex arrays are handed to GL
+	// straight from the mapping and the skeleton / keyframes are read in place for the lifetime of the mesh
 	bool LoadAnimatedMesh(const std::string& Filename)
 	{
 		// Release the previously loaded mesh (if it exists)
 		Clear();
 
+		std::string Cooked = __SKINNED_MESH_URI__ + Filename + __COOKED_SKINNED_MESH_EXTENSION__;
+
+		if (!Vfs::Open(Cooked, m_File)) {
+#ifdef SKM_COOK_ON_LOAD
+			if (!SkmCooker::Cook(__SKINNED_MESH_URI__ + Filename + __SKINNED_MESH_EXTENSION__, Cooked) || !Vfs::Open(Cooked, m_File))
+				return false;
+#else
+			printf("Error loading '%s': cooked mesh not found, run skm_cook (Tools/SkmCook.cpp) from the game's root\n", Cooked.c_str());
+			return false;
+#endif
+		}
+
+		if (!m_Skm.Open(m_File.Data(), m_File.Size())) {
+			m_File.Close();
+			return false;
+		}
+
 		// Create the VAO
 		glGenVertexArrays(1, &m_VAO);
 		glBindVertexArray(m_VAO);
@@ -84,24 +87,7 @@ public:
 		// Create the buffers for the vertices attributes
 		glGenBuffers(ARRAY_SIZE_IN_ELEMENTS(m_Buffers), m_Buffers);
 
-		bool Ret = false;
-
-		m_pScene = m_Importer.ReadFile(__SKINNED_MESH_URI__ + Filename + __SKINNED_MESH_EXTENSION__,
-			aiProcess_Triangulate |
-			aiProcess_GenSmoothNormals |
-			aiProcess_FlipUVs |
-			aiProcess_CalcTangentSpace |
-			aiProcess_JoinIdenticalVertices |
-			aiProcess_LimitBoneWeights);
-
-		if (m_pScene) {
-			m_GlobalInverseTransform = aiMatrix4x4ToGlm(m_pScene->mRootNode->mTransformation);
-			glm::inverse(m_GlobalInverseTransform);
-			Ret = InitFromScene(m_pScene, Filename);
-		}
-		else {
-			printf("Error parsing '%s': '%s'\n", Filename.c_str(), m_Importer.GetErrorString());
-		}
+		bool Ret = InitFromCooked();
 
 		// Make sure the VAO is not changed from the outside
 		glBindVertexArray(0);
@@ -136,386 +122,135 @@ public:
 		return m_NumBones;
 	}
 
-	void BoneTransform(float TimeInSeconds, std::vector<glm::mat4>& Transforms)
+	// Evaluates the first animation at 'TimeInSeconds' for a character. The skeleton was compiled at load time
+	// and the instance keeps the keyframe cursors and the palette, so this neither searches nor allocates
+	const std::vector<glm::mat4>& BoneTransform(AnimRuntime::Instance& Instance, float TimeInSeconds) const
 	{
-		glm::mat4 Identity = glm::mat4(1.0f);
-
-		float TicksPerSecond = (float)(m_pScene->mAnimations[0]->mTicksPerSecond != 0 ? m_pScene->mAnimations[0]->mTicksPerSecond : 25.0f);
-		float TimeInTicks = TimeInSeconds * TicksPerSecond;
-		float AnimationTime = fmod(TimeInTicks, (float)m_pScene->mAnimations[0]->mDuration);
-
-		ReadNodeHeirarchy(AnimationTime, m_pScene->mRootNode, Identity);
-
-		Transforms.resize(m_NumBones);
-
-		for (uint i = 0; i < m_NumBones; i++) {
-			Transforms[i] = m_BoneInfo[i].FinalTransformation;
-		}
+		m_Skeleton.Evaluate(TimeInSeconds, Instance);
+		return Instance.GetPalette();
 	}
-public:
-	void CalcInterpolatedScaling(aiVector3D& Out, float AnimationTime, const aiNodeAnim* pNodeAnim)
-	{
-		if (pNodeAnim->mNumScalingKeys == 1) {
-			Out = pNodeAnim->mScalingKeys[0].mValue;
-			return;
-		}
 
-		uint ScalingIndex = FindScaling(AnimationTime, pNodeAnim);
-		uint NextScalingIndex = (ScalingIndex + 1);
-		assert(NextScalingIndex < pNodeAnim->mNumScalingKeys);
-		float DeltaTime = (float)(pNodeAnim->mScalingKeys[NextScalingIndex].mTime - pNodeAnim->mScalingKeys[ScalingIndex].mTime);
-		float Factor = (AnimationTime - (float)pNodeAnim->mScalingKeys[ScalingIndex].mTime) / DeltaTime;
-		assert(Factor >= 0.0f && Factor <= 1.0f);
-		const aiVector3D& Start = pNodeAnim->mScalingKeys[ScalingIndex].mValue;
-		const aiVector3D& End = pNodeAnim->mScalingKeys[NextScalingIndex].mValue;
-		aiVector3D Delta = End - Start;
-		Out = Start + Factor * Delta;
-	}
-	void CalcInterpolatedRotation(aiQuaternion& Out, float AnimationTime, const aiNodeAnim* pNodeAnim)
+	// Evaluates into 'Transforms' through the mesh's own instance (for callers that only animate it once)
+	void BoneTransform(float TimeInSeconds, std::vector<glm::mat4>& Transforms)
 	{
-		// we need at least two values to interpolate...
-		if (pNodeAnim->mNumRotationKeys == 1) {
-			Out = pNodeAnim->mRotationKeys[0].mValue;
-			return;
-		}
-
-		uint RotationIndex = FindRotation(AnimationTime, pNodeAnim);
-		uint NextRotationIndex = (RotationIndex + 1);
-		assert(NextRotationIndex < pNodeAnim->mNumRotationKeys);
-		float DeltaTime = (float)(pNodeAnim->mRotationKeys[NextRotationIndex].mTime - pNodeAnim->mRotationKeys[RotationIndex].mTime);
-		float Factor = (AnimationTime - (float)pNodeAnim->mRotationKeys[RotationIndex].mTime) / DeltaTime;
-		assert(Factor >= 0.0f && Factor <= 1.0f);
-		const aiQuaternion& StartRotationQ = pNodeAnim->mRotationKeys[RotationIndex].mValue;
-		const aiQuaternion& EndRotationQ = pNodeAnim->mRotationKeys[NextRotationIndex].mValue;
-		aiQuaternion::Interpolate(Out, StartRotationQ, EndRotationQ, Factor);
-		Out = Out.Normalize();
+		const std::vector<glm::mat4>& Palette = BoneTransform(m_Instance, TimeInSeconds);
+		Transforms.assign(Palette.begin(), Palette.end());
+		Transforms.resize(m_NumBones, glm::mat4(1.0f));
 	}
-	void CalcInterpolatedPosition(aiVector3D& Out, float AnimationTime, const aiNodeAnim* pNodeAnim)
-	{
-		if (pNodeAnim->mNumPositionKeys == 1) {
-			Out = pNodeAnim->mPositionKeys[0].mValue;
-			return;
-		}
 
-		uint PositionIndex = FindPosition(AnimationTime, pNodeAnim);
-		uint NextPositionIndex = (PositionIndex + 1);
-		assert(NextPositionIndex < pNodeAnim->mNumPositionKeys);
-		float DeltaTime = (float)(pNodeAnim->mPositionKeys[NextPositionIndex].mTime - pNodeAnim->mPositionKeys[PositionIndex].mTime);
-		float Factor = (AnimationTime - (float)pNodeAnim->mPositionKeys[PositionIndex].mTime) / DeltaTime;
-		assert(Factor >= 0.0f && Factor <= 1.0f);
-		const aiVector3D& Start = pNodeAnim->mPositionKeys[PositionIndex].mValue;
-		const aiVector3D& End = pNodeAnim->mPositionKeys[NextPositionIndex].mValue;
-		aiVector3D Delta = End - Start;
-		Out = Start + Factor * Delta;
-	}
-	
-	uint FindScaling(float AnimationTime, const aiNodeAnim* pNodeAnim)
+	const AnimRuntime::Skeleton& GetSkeleton() const
 	{
-		assert(pNodeAnim->mNumScalingKeys > 0);
-
-		for (uint i = 0; i < pNodeAnim->mNumScalingKeys - 1; i++) {
-			if (AnimationTime < (float)pNodeAnim->mScalingKeys[i + 1].mTime) {
-				return i;
-			}
-		}
-
-		assert(0);
-
-		return 0;
+		return m_Skeleton;
 	}
-	uint FindRotation(float AnimationTime, const aiNodeAnim* pNodeAnim)
-	{
-		assert(pNodeAnim->mNumRotationKeys > 0);
-
-		for (uint i = 0; i < pNodeAnim->mNumRotationKeys - 1; i++) {
-			if (AnimationTime < (float)pNodeAnim->mRotationKeys[i + 1].mTime) {
-				return i;
-			}
-		}
 
-		assert(0);
-
-		return 0;
-	}
-	uint FindPosition(float AnimationTime, const aiNodeAnim* pNodeAnim)
+	uint NumVertices() const
 	{
-		for (uint i = 0; i < pNodeAnim->mNumPositionKeys - 1; i++) {
-			if (AnimationTime < (float)pNodeAnim->mPositionKeys[i + 1].mTime) {
-				return i;
-			}
-		}
-
-		assert(0);
-
-		return 0;
+		return m_Skm.IsValid() ? m_Skm.Count(Skm::SECTION_POSITIONS) : 0;
 	}
-	
-	const aiNodeAnim* FindNodeAnim(const aiAnimation* pAnimation, const std::string NodeName)
-	{
-		for (uint i = 0; i < pAnimation->mNumChannels; i++) {
-			const aiNodeAnim* pNodeAnim = pAnimation->mChannels[i];
 
-			if (std::string(pNodeAnim->mNodeName.data) == NodeName) {
-				return pNodeAnim;
-			}
-		}
-
-		return NULL;
-	}
-	void ReadNodeHeirarchy(float AnimationTime, const aiNode* pNode, const glm::mat4& ParentTransform)
+	// Deforms the bind pose by 'Palette' (NumPaletteSlots() matrices, e.g. AnimSystem::GetPalette) on the CPU.
+	// 'Normals' may be NULL; the buffers must hold NumVertices() elements
+	void Skin(const glm::mat4* Palette, glm::vec3* Positions, glm::vec3* Normals, CpuSkinning::Method Method = CpuSkinning::LINEAR) const
 	{
-		std::string NodeName(pNode->mName.data);
-
-		const aiAnimation* pAnimation = m_pScene->mAnimations[0];
-
-		glm::mat4 NodeTransformation(aiMatrix4x4ToGlm(pNode->mTransformation));
-
-		const aiNodeAnim* pNodeAnim = FindNodeAnim(pAnimation, NodeName);
-
-		if (pNodeAnim)
-		{
-			// Interpolate scaling and generate scaling transformation matrix
-			aiVector3D Scaling;
-			CalcInterpolatedScaling(Scaling, AnimationTime, pNodeAnim);
-			glm::mat4 ScalingM;
-			ScalingM = glm::scale(glm::vec3(Scaling.x, Scaling.y, Scaling.z));
-
-			// Interpolate rotation and generate rotation transformation matrix
-			aiQuaternion RotationQ;
-			CalcInterpolatedRotation(RotationQ, AnimationTime, pNodeAnim);
-			glm::mat4 RotationM;
-			RotationM = glm::mat3(aiMatrix3x3ToGlm(RotationQ.GetMatrix()));
-
-			// Interpolate translation and generate translation transformation matrix
-			aiVector3D Translation;
-			CalcInterpolatedPosition(Translation, AnimationTime, pNodeAnim);
-			glm::mat4 TranslationM;
-			TranslationM = glm::translate(glm::vec3(Translation.x, Translation.y, Translation.z));
-
-			// Combine the above transformations
-			NodeTransformation = TranslationM * RotationM * ScalingM;
-		}
-
-		glm::mat4 GlobalTransformation = ParentTransform * NodeTransformation;
-
-		if (m_BoneMapping.find(NodeName) != m_BoneMapping.end()) {
-			uint BoneIndex = m_BoneMapping[NodeName];
-			m_BoneInfo[BoneIndex].FinalTransformation = m_GlobalInverseTransform * GlobalTransformation * m_BoneInfo[BoneIndex].BoneOffset;
-		}
+		if (!m_Skm.IsValid() || !Palette)
+			return;
+		CpuSkinning::Skin(Method, Palette, m_Skeleton.NumPaletteSlots(), m_Skm.Positions(), Normals ? m_Skm.Normals() : NULL,
+			m_Skm.BoneData(), NumVertices(), Positions, Normals);
+	}
 
-		for (uint i = 0; i < pNode->mNumChildren; i++) {
-			ReadNodeHeirarchy(AnimationTime, pNode->mChildren[i], GlobalTransformation);
+	// Casts a ray (in model space) against skinned positions from Skin(), returns whether it hit and the nearest distance
+	bool IntersectRay(const glm::vec3* Positions, const glm::vec3& Origin, const glm::vec3& Direction, float& Distance) const
+	{
+		bool Hit = false;
+		const uint32_t* Indices = m_Skm.IsValid() ? m_Skm.Indices() : NULL;
+		for (uint i = 0; Indices && i < m_Entries.size(); i++) {
+			const uint32_t* Tri = Indices + m_Entries[i].BaseIndex;
+			const glm::vec3* Base = Positions + m_Entries[i].BaseVertex;
+			for (uint t = 0; t + 2 < m_Entries[i].NumIndices; t += 3) {
+				float d = CpuSkinning::IntersectRayTriangle(Origin, Direction, Base[Tri[t]], Base[Tri[t + 1]], Base[Tri[t + 2]]);
+				if (d >= 0.0f && (!Hit || d < Distance)) {
+					Distance = d;
+					Hit = true;
+				}
+			}
 		}
+		return Hit;
 	}
-	
-	bool InitFromScene(const aiScene* pScene, const std::string& Filename)
+public:
+	bool InitFromCooked()
 	{
-		m_Entries.resize(pScene->mNumMeshes);
-		m_materials.resize(pScene->mNumMaterials);
-
-		std::vector<glm::vec3> Positions;
-		std::vector<glm::vec3> Normals;
-		std::vector<glm::vec3> Tangents;
-		std::vector<glm::vec2> TexCoords;
-		std::vector<VertexBoneData> Bones;
-		std::vector<uint> Indices;
-
-		uint NumVertices = 0;
-		uint NumIndices = 0;
-
-		// Count the number of vertices and indices
-		for (uint i = 0; i < m_Entries.size(); i++) {
-			m_Entries[i].MaterialIndex = pScene->mMeshes[i]->mMaterialIndex;
-			m_Entries[i].NumIndices = pScene->mMeshes[i]->mNumFaces * 3;
-			m_Entries[i].BaseVertex = NumVertices;
-			m_Entries[i].BaseIndex = NumIndices;
-
-			NumVertices += pScene->mMeshes[i]->mNumVertices;
-			NumIndices += m_Entries[i].NumIndices;
-		}
-
-		// Reserve space in the vectors for the vertex attributes and indices
-		Positions.reserve(NumVertices);
-		Normals.reserve(NumVertices);
-		Tangents.reserve(NumVertices);
-		TexCoords.reserve(NumVertices);
-		Bones.resize(NumVertices);
-		Indices.reserve(NumIndices);
-
-		// Initialize the meshes in the scene one by one
-		for (uint i = 0; i < m_Entries.size(); i++) {
-			const aiMesh* paiMesh = pScene->mMeshes[i];
-			InitMesh(i, paiMesh, Positions, Normals, TexCoords, Tangents, Bones, Indices);
+		uint NumEntries = m_Skm.Count(Skm::SECTION_ENTRIES);
+		uint NumVertices = m_Skm.Count(Skm::SECTION_POSITIONS);
+		uint NumIndices = m_Skm.Count(Skm::SECTION_INDICES);
+
+		m_Entries.resize(NumEntries);
+		for (uint i = 0; i < NumEntries; i++) {
+			m_Entries[i].NumIndices = m_Skm.Entries()[i].num_indices;
+			m_Entries[i].BaseVertex = m_Skm.Entries()[i].base_vertex;
+			m_Entries[i].BaseIndex = m_Skm.Entries()[i].base_index;
+			m_Entries[i].MaterialIndex = m_Skm.Entries()[i].material_index;
 		}
 
-		if (!InitMaterials(pScene, Filename)) {
+		m_NumBones = m_Skm.GetHeader().num_bones;
+		if (!m_Skeleton.Compile(m_Skm))
 			return false;
-		}
 
-		// Generate and populate the buffers with vertex attributes and the indices
+		// Upload the vertex attributes and the indices straight from the mapping
 		glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[POS_VB]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Positions[0]) * Positions.size(), &Positions[0], GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * NumVertices, m_Skm.Positions(), GL_STATIC_DRAW);
 		glEnableVertexAttribArray(POSITION_LOCATION);
 		glVertexAttribPointer(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[TEXCOORD_VB]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(TexCoords[0]) * TexCoords.size(), &TexCoords[0], GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * NumVertices, m_Skm.TexCoords(), GL_STATIC_DRAW);
 		glEnableVertexAttribArray(TEX_COORD_LOCATION);
 		glVertexAttribPointer(TEX_COORD_LOCATION, 2, GL_FLOAT, GL_FALSE, 0, 0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[NORMAL_VB]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Normals[0]) * Normals.size(), &Normals[0], GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * NumVertices, m_Skm.Normals(), GL_STATIC_DRAW);
 		glEnableVertexAttribArray(NORMAL_LOCATION);
 		glVertexAttribPointer(NORMAL_LOCATION, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
 		glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[TANGENT_VB]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Tangents[0]) * Tangents.size(), &Tangents[0], GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * NumVertices, m_Skm.Tangents(), GL_STATIC_DRAW);
 		glEnableVertexAttribArray(TANGENT_LOCATION);
 		glVertexAttribPointer(TANGENT_LOCATION, 3, GL_FLOAT, GL_FALSE, 0, 0);
 
+		// 8 bytes per vertex: ids stay integers in the shader, weights are normalised back to 0-1
 		glBindBuffer(GL_ARRAY_BUFFER, m_Buffers[BONE_VB]);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Bones[0]) * Bones.size(), &Bones[0], GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(PackedBoneData) * NumVertices, m_Skm.BoneData(), GL_STATIC_DRAW);
 		glEnableVertexAttribArray(BONE_ID_LOCATION);
-		glVertexAttribIPointer(BONE_ID_LOCATION, 4, GL_INT, sizeof(VertexBoneData), (const GLvoid*)0);
+		glVertexAttribIPointer(BONE_ID_LOCATION, 4, GL_UNSIGNED_BYTE, sizeof(PackedBoneData), (const GLvoid*)0);
 		glEnableVertexAttribArray(BONE_WEIGHT_LOCATION);
-		glVertexAttribPointer(BONE_WEIGHT_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(VertexBoneData), (const GLvoid*)16);
+		glVertexAttribPointer(BONE_WEIGHT_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedBoneData), (const GLvoid*)NUM_BONES_PER_VERTEX);
 
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_Buffers[INDEX_BUFFER]);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Indices[0]) * Indices.size(), &Indices[0], GL_STATIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * NumIndices, m_Skm.Indices(), GL_STATIC_DRAW);
 
 		return GLCheckError();
 	}
-	void InitMesh(uint MeshIndex,
-		const aiMesh* paiMesh,
-		std::vector<glm::vec3>& Positions,
-		std::vector<glm::vec3>& Normals,
-		std::vector<glm::vec2>& TexCoords,
-		std::vector<glm::vec3>& Tangents,
-		std::vector<VertexBoneData>& Bones,
-		std::vector<unsigned int>& Indices)
-	{
-		const aiVector3D Zero3D(0.0f, 0.0f, 0.0f);
-
-		// Populate the vertex attribute vectors
-		for (uint i = 0; i < paiMesh->mNumVertices; i++) {
-			const aiVector3D* pPos = &(paiMesh->mVertices[i]);
-			const aiVector3D* pNormal = &(paiMesh->mNormals[i]);
-			const aiVector3D* pTangent = &(paiMesh->mTangents[i]);
-			const aiVector3D* pTexCoord = paiMesh->HasTextureCoords(0) ? &(paiMesh->mTextureCoords[0][i]) : &Zero3D;
-
-			Positions.push_back(glm::vec3(pPos->x, pPos->y, pPos->z));
-			Normals.push_back(glm::vec3(pNormal->x, pNormal->y, pNormal->z));
-			TexCoords.push_back(glm::vec2(pTexCoord->x, pTexCoord->y));
-			Tangents.push_back(glm::vec3(pTangent->x, pTangent->y, pTangent->z));
-		}
-
-		LoadBones(MeshIndex, paiMesh, Bones);
-
-		// Populate the index buffer
-		for (uint i = 0; i < paiMesh->mNumFaces; i++) {
-			const aiFace& Face = paiMesh->mFaces[i];
-			assert(Face.mNumIndices == 3);
-			Indices.push_back(Face.mIndices[0]);
-			Indices.push_back(Face.mIndices[1]);
-			Indices.push_back(Face.mIndices[2]);
-		}
-	}
-
-	bool InitMaterials(const aiScene* pScene, const std::string& Filename)
-	{
-		//m_materials.push_back(Content::_materials[0]);
-
-		// Extract the directory part from the file name
-		std::string::size_type SlashIndex = Filename.find_last_of("/");
-		std::string Dir;
-
-		if (SlashIndex == std::string::npos) {
-			Dir = ".";
-		}
-		else if (SlashIndex == 0) {
-			Dir = "/";
-		}
-		else {
-			Dir = Filename.substr(0, SlashIndex);
-		}
-
-		bool Ret = true;
-
-		// Initialize the materials
-		for (uint i = 0; i < pScene->mNumMaterials; i++) {
-			const aiMaterial* pMaterial = pScene->mMaterials[i];
-
-			//m_materials[i] = NULL;
-
-			if (pMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-				aiString Path;
-
-				if (pMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &Path, NULL, NULL, NULL, NULL, NULL) == AI_SUCCESS) {
-					std::string p(Path.data);
-
-					if (p.substr(0, 2) == ".\\") {
-						p = p.substr(2, p.size() - 2);
-					}
-
-					std::string FullPath = Dir + "/" + p;
-
-					//m_Textures[i] = new Texture(GL_TEXTURE_2D, FullPath.c_str());
-
-					//if (!m_Textures[i]->Load()) 
-					//{
-					//	//printf("Error loading texture '%s'\n", FullPath.c_str());
-					//	//delete m_Textures[i];
-					//	//m_Textures[i] = NULL;
-					//	//Ret = false;
-					//}
-					//else {
-					//	printf("%d - loaded texture '%s'\n", i, FullPath.c_str());
-					//}
-				}
-			}
-		}
-
-		return Ret;
-	}
-	void LoadBones(uint MeshIndex, const aiMesh* pMesh, std::vector<VertexBoneData>& Bones)
-	{
-		for (uint i = 0; i < pMesh->mNumBones; i++) {
-			uint BoneIndex = 0;
-			std::string BoneName(pMesh->mBones[i]->mName.data);
-
-			if (m_BoneMapping.find(BoneName) == m_BoneMapping.end()) {
-				// Allocate an index for a new bone
-				BoneIndex = m_NumBones;
-				m_NumBones++;
-				BoneInfo bi;
-				m_BoneInfo.push_back(bi);
-				m_BoneInfo[BoneIndex].BoneOffset = aiMatrix4x4ToGlm(pMesh->mBones[i]->mOffsetMatrix);
-				m_BoneMapping[BoneName] = BoneIndex;
-			}
-			else {
-				BoneIndex = m_BoneMapping[BoneName];
-			}
-
-			for (uint j = 0; j < pMesh->mBones[i]->mNumWeights; j++) {
-				uint VertexID = m_Entries[MeshIndex].BaseVertex + pMesh->mBones[i]->mWeights[j].mVertexId;
-				float Weight = pMesh->mBones[i]->mWeights[j].mWeight;
-				Bones[VertexID].AddBoneData(BoneIndex, Weight);
-			}
-		}
-	}
 
 	void Clear()
 	{
 		for (uint i = 0; i < m_materials.size(); i++) 
 			SAFE_DELETE(m_materials[i]);
 
-		if (m_Buffers[0] != 0) 
+		if (m_Buffers[0] != 0) {
 			glDeleteBuffers(ARRAY_SIZE_IN_ELEMENTS(m_Buffers), m_Buffers);
+			ZERO_MEM(m_Buffers);
+		}
 
 		if (m_VAO != 0) {
 			glDeleteVertexArrays(1, &m_VAO);
 			m_VAO = 0;
 		}
+
+		m_Skm = Skm::View();
+		m_File.Close();
+		m_Entries.clear();
+		m_Skeleton.Clear();
+		m_Instance = AnimRuntime::Instance();
+		m_NumBones = 0;
 	}
 
 	enum VB_TYPES {
@@ -549,13 +284,12 @@ public:
 	std::vector<MeshEntry> m_Entries;
 	std::vector<Material*> m_materials;
 
-	std::map<std::string, uint> m_BoneMapping; // maps a bone name to its index
 	uint m_NumBones;
-	std::vector<BoneInfo> m_BoneInfo;
-	glm::mat4 m_GlobalInverseTransform;
+	AnimRuntime::Skeleton m_Skeleton; // flat bones with their key ranges, compiled once from m_Skm
+	AnimRuntime::Instance m_Instance; // cursors and palette for the BoneTransform overload without an instance
 
-	const aiScene* m_pScene;
-	Assimp::Importer m_Importer;
+	VfsFile m_File; // the cooked file, kept mapped (or unpacked) for the keyframes
+	Skm::View m_Skm; // typed access to m_File
 };
 
 #endif	
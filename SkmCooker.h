@@ -0,0 +1,203 @@
+#ifndef __SKM_COOKER_H__
+#define __SKM_COOKER_H__
+
+#include <string>	// Get string
+#include <map>	// Get bone name lookup
+#include <algorithm>	// Get sort
+#include <assimp/Importer.hpp>      // C++ importer interface
+#include <assimp/scene.h>       // Output data structure
+#include <assimp/postprocess.h> // Post processing flags
+#include "SkmFormat.h"	// Get the cooked format
+#include "AnimCompression.h"	// Compress the keys
+#include "TangentSpace.h"	// Generate the tangent frames
+
+// The offline half of the skinned mesh pipeline. This is the only place that needs Assimp: it imports a
+// source file once, flattens it into the .skm layout and writes it next to the source. Tools and the editor
+// include this header; the game itself only includes SkmFormat.h through SkinnedMesh.h
+namespace SkmCooker
+{
+	// Converts an assimp matrix (row-major) to glm (column-major)
+	inline glm::mat4 ToGlm(const aiMatrix4x4 &from)
+	{
+		glm::mat4 to;	// The result
+		to[0][0] = from.a1; to[1][0] = from.a2; to[2][0] = from.a3; to[3][0] = from.a4;
+		to[0][1] = from.b1; to[1][1] = from.b2; to[2][1] = from.b3; to[3][1] = from.b4;
+		to[0][2] = from.c1; to[1][2] = from.c2; to[2][2] = from.c3; to[3][2] = from.c4;
+		to[0][3] = from.d1; to[1][3] = from.d2; to[2][3] = from.d3; to[3][3] = from.d4;
+		return to;	// Return the result
+	}
+
+	// Appends a node and all of its children in parent-first order
+	inline void FlattenNode(const aiNode* node, int32_t parent, const aiAnimation* anim, const std::map<std::string, uint32_t> &bones, Skm::Data &out,
+		std::vector<AnimCompression::Track> &tracks)
+	{
+		Skm::Node flat;		// The flattened node
+		flat.parent = parent;	// Assign parent
+		flat.local = Skm::Matrix::FromGlm(ToGlm(node->mTransformation));	// Assign bind pose
+		flat.name = (uint32_t)out.names.size();		// Assign name offset
+		out.names += node->mName.C_Str();	// Store the name
+		out.names += '\0';	// Terminate it
+
+		std::map<std::string, uint32_t>::const_iterator bone = bones.find(node->mName.C_Str());	// Is it skinned?
+		flat.bone = bone == bones.end() ? SKM_NO_BONE : (int32_t)bone->second;	// Assign bone
+
+		flat.channel = SKM_NO_CHANNEL;	// Not animated by default
+		for (unsigned int c = 0; anim && c < anim->mNumChannels; c++)	// For each channel...
+		{
+			const aiNodeAnim* ch = anim->mChannels[c];	// The channel
+			if (std::string(ch->mNodeName.C_Str()) != node->mName.C_Str())		// If it's for a different node...
+				continue;	// Skip it
+
+			AnimCompression::Track track;	// The full precision keys, compressed once the hierarchy is known
+			for (unsigned int k = 0; k < ch->mNumPositionKeys; k++)		// Copy translation keys
+			{
+				const aiVectorKey &key = ch->mPositionKeys[k];
+				Skm::Vec3Key v = { (float)key.mTime, { key.mValue.x, key.mValue.y, key.mValue.z } };
+				track.positions.push_back(v);
+			}
+			for (unsigned int k = 0; k < ch->mNumRotationKeys; k++)		// Copy rotation keys
+			{
+				const aiQuatKey &key = ch->mRotationKeys[k];
+				Skm::QuatKey q = { (float)key.mTime, { key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z } };
+				track.rotations.push_back(q);
+			}
+			for (unsigned int k = 0; k < ch->mNumScalingKeys; k++)	// Copy scale keys
+			{
+				const aiVectorKey &key = ch->mScalingKeys[k];
+				Skm::Vec3Key v = { (float)key.mTime, { key.mValue.x, key.mValue.y, key.mValue.z } };
+				track.scalings.push_back(v);
+			}
+
+			flat.channel = (int32_t)tracks.size();	// Assign channel
+			tracks.push_back(track);	// Store the keys
+			break;	// One channel per node
+		}
+
+		int32_t index = (int32_t)out.nodes.size();	// This node's index
+		out.nodes.push_back(flat);	// Store the node
+
+		for (unsigned int i = 0; i < node->mNumChildren; i++)	// For each child...
+			FlattenNode(node->mChildren[i], index, anim, bones, out, tracks);	// Flatten it after its parent
+	}
+
+	// Imports 'src' with Assimp and writes the cooked mesh to 'dst'
+	inline bool Cook(const std::string &src, const std::string &dst)
+	{
+		Assimp::Importer importer;	// The importer
+		const aiScene* scene = importer.ReadFile(src,
+			aiProcess_Triangulate |
+			aiProcess_GenSmoothNormals |
+			aiProcess_FlipUVs |
+			aiProcess_JoinIdenticalVertices |
+			aiProcess_LimitBoneWeights);	// Import with the runtime's old post processing, except tangents (generated below)
+
+		if (!scene || !scene->mRootNode)	// If the import failed...
+		{
+			std::cout << "Skm Cook Error: Failed to parse '" << src << "': " << importer.GetErrorString() << "\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		Skm::Data out;	// The cooked data
+		out.global_inverse = glm::inverse(ToGlm(scene->mRootNode->mTransformation));	// Inverse of the root transform
+
+		uint32_t num_vertices = 0, num_indices = 0;		// Running totals
+		for (unsigned int m = 0; m < scene->mNumMeshes; m++)	// For each mesh...
+		{
+			Skm::Entry e;	// The draw entry
+			e.material_index = scene->mMeshes[m]->mMaterialIndex;	// Assign material
+			e.num_indices = scene->mMeshes[m]->mNumFaces * 3;	// Assign index count
+			e.base_vertex = num_vertices;	// Assign first vertex
+			e.base_index = num_indices;		// Assign first index
+			num_vertices += scene->mMeshes[m]->mNumVertices;	// Advance vertices
+			num_indices += e.num_indices;	// Advance indices
+			out.entries.push_back(e);	// Store it
+		}
+
+		std::vector<VertexBoneData> bones(num_vertices);	// Unpacked influences
+		std::map<std::string, uint32_t> bone_mapping;	// Bone name -> index
+
+		for (unsigned int m = 0; m < scene->mNumMeshes; m++)	// For each mesh...
+		{
+			const aiMesh* mesh = scene->mMeshes[m];		// The mesh
+			std::vector<glm::vec3> positions, texcoords, normals, tangents;		// This mesh's attributes, for the tangent generator
+			std::vector<unsigned int> indices;	// Its triangles
+			for (unsigned int v = 0; v < mesh->mNumVertices; v++)	// For each vertex...
+			{
+				const aiVector3D &p = mesh->mVertices[v];	// Position
+				const aiVector3D n = mesh->HasNormals() ? mesh->mNormals[v] : aiVector3D(0.0f, 1.0f, 0.0f);		// Normal
+				const aiVector3D uv = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][v] : aiVector3D(0.0f);	// Texcoord
+
+				positions.push_back(glm::vec3(p.x, p.y, p.z));
+				normals.push_back(glm::vec3(n.x, n.y, n.z));
+				texcoords.push_back(glm::vec3(uv.x, uv.y, 0.0f));
+			}
+
+			for (unsigned int f = 0; f < mesh->mNumFaces; f++)	// For each face...
+				for (unsigned int k = 0; k < 3; k++)	// For each corner...
+					indices.push_back(mesh->mFaces[f].mNumIndices == 3 ? mesh->mFaces[f].mIndices[k] : 0);	// Points / lines collapse
+
+			if (!TangentSpace::Generate(positions, texcoords, normals, indices, tangents))	// If the mesh indexes past its vertices...
+			{
+				std::cout << "Skm Cook Error: '" << src << "' has a mesh with invalid indices!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+
+			for (unsigned int v = 0; v < mesh->mNumVertices; v++)	// Store the vertices
+			{
+				out.positions.push_back(positions[v]);
+				out.normals.push_back(normals[v]);
+				out.tangents.push_back(tangents[v]);
+				out.texcoords.push_back(glm::vec2(texcoords[v]));
+			}
+			out.indices.insert(out.indices.end(), indices.begin(), indices.end());
+
+			for (unsigned int b = 0; b < mesh->mNumBones; b++)	// For each bone...
+			{
+				const aiBone* bone = mesh->mBones[b];	// The bone
+				std::string name(bone->mName.C_Str());	// Its name
+
+				if (bone_mapping.find(name) == bone_mapping.end())	// If it's new...
+				{
+					bone_mapping[name] = (uint32_t)out.bone_offsets.size();		// Allocate an index
+					out.bone_offsets.push_back(Skm::Matrix::FromGlm(ToGlm(bone->mOffsetMatrix)));	// Store its offset
+				}
+
+				uint32_t index = bone_mapping[name];	// The bone index
+				for (unsigned int w = 0; w < bone->mNumWeights; w++)	// For each weight...
+				{
+					VertexBoneData &vb = bones[out.entries[m].base_vertex + bone->mWeights[w].mVertexId];	// The vertex
+					for (unsigned int k = 0; k < NUM_BONES_PER_VERTEX; k++)		// Find a free slot
+						if (vb.Weights[k] == 0.0f) { vb.IDs[k] = index; vb.Weights[k] = bone->mWeights[w].mWeight; break; }
+				}
+			}
+		}
+
+		if (out.bone_offsets.size() > 256)	// If the bones don't fit in 8 bits...
+		{
+			std::cout << "Skm Cook Error: '" << src << "' has more than 256 bones!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		out.bone_data.reserve(num_vertices);	// One packed entry per vertex
+		for (const VertexBoneData &vb : bones)	// For each vertex...
+			out.bone_data.push_back(PackedBoneData::Pack(vb));	// Quantise it
+
+		const aiAnimation* anim = scene->mNumAnimations ? scene->mAnimations[0] : NULL;		// Only the first animation is used
+		if (anim)	// If there is one...
+		{
+			out.ticks_per_second = anim->mTicksPerSecond != 0.0 ? (float)anim->mTicksPerSecond : 25.0f;	// Assign clock rate
+			out.duration = (float)anim->mDuration;	// Assign length
+		}
+
+		std::vector<AnimCompression::Track> tracks;		// One per animated node
+		FlattenNode(scene->mRootNode, SKM_NO_PARENT, anim, bone_mapping, out, tracks);	// Flatten the hierarchy
+
+		AnimCompression::Stats stats = AnimCompression::Compress(tracks, out);	// Drop / quantise the keys
+		std::cout << "Skm Cook: '" << src << "' keys " << stats.source_keys << " -> " << stats.packed_keys << ", "
+			<< stats.source_bytes / 1024 << " KB -> " << stats.packed_bytes / 1024 << " KB\n";	// Report the savings
+
+		return Skm::Write(out, dst.c_str());	// Write it
+	}
+}
+
+#endif
@@ -0,0 +1,385 @@
+#ifndef __SKM_FORMAT_H__
+#define __SKM_FORMAT_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <cstring>	// Get memcpy
+#include <cmath>	// Get sqrt
+#include <iostream>		// Get error output
+#include <fstream>	// Get file output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <glm/glm.hpp>	// Get glm variables
+#include "VertexBoneData.h"		// Get packed bone data
+
+#ifndef __COOKED_SKINNED_MESH_EXTENSION__
+#define __COOKED_SKINNED_MESH_EXTENSION__	((char*)".skm")
+#endif
+
+#define SKM_MAGIC			0x314D4B53	// "SKM1"
+#define SKM_VERSION			2	// Bump whenever the layout below changes
+#define SKM_ALIGNMENT		16	// Every section starts on this boundary
+#define SKM_NO_PARENT		-1	// Parent index of the root node
+#define SKM_NO_BONE			-1	// Bone index of nodes that no vertex is skinned to
+#define SKM_NO_CHANNEL		-1	// Channel index of nodes that aren't animated
+#define SKM_KEY_TIME_STEPS	65535.0f	// Key times are stored as fractions of the clip in 16 bits
+
+// The cooked skinned mesh format (.skm). It is written by SkmCooker and mapped straight into memory at
+// runtime: a header with a section table, followed by tightly packed, aligned arrays. The skeleton is
+// flattened so every parent comes before its children and animation can be evaluated in a single loop.
+// Keys are compressed (see AnimCompression.h): redundant keys are removed when cooking and the rest are 8 bytes,
+// a 16 bit time plus three 16 bit values: translations / scales quantised to their channel's range, rotations as
+// the smallest three components of the quaternion
+namespace Skm
+{
+	// The sections of a cooked file
+	enum SectionType
+	{
+		SECTION_ENTRIES,	// Entry[]: one per sub-mesh
+		SECTION_POSITIONS,	// glm::vec3[] per vertex
+		SECTION_NORMALS,	// glm::vec3[] per vertex
+		SECTION_TANGENTS,	// glm::vec3[] per vertex
+		SECTION_TEXCOORDS,	// glm::vec2[] per vertex
+		SECTION_BONE_DATA,	// PackedBoneData[] per vertex
+		SECTION_INDICES,	// uint32_t[] relative to each entry's base vertex
+		SECTION_NODES,	// Node[] in parent-first order
+		SECTION_BONE_OFFSETS,	// Matrix[] bind pose inverse per bone
+		SECTION_CHANNELS,	// Channel[] per animated node
+		SECTION_POSITION_KEYS,	// PackedKey[]
+		SECTION_ROTATION_KEYS,	// PackedKey[]
+		SECTION_SCALING_KEYS,	// PackedKey[]
+		SECTION_NAMES,	// char[] of null terminated node names
+		NUM_SECTIONS
+	};
+
+	// A byte range inside the file
+	struct Section
+	{
+		uint32_t	offset;		// Byte offset from the start of the file
+		uint32_t	count;	// Number of elements
+	};
+
+	// A column-major 4x4 matrix
+	struct Matrix
+	{
+		float		m[16];	// The values
+
+		inline glm::mat4 ToGlm() const { glm::mat4 r; std::memcpy(&r[0][0], m, sizeof(m)); return r; }	// Convert to glm
+		static inline Matrix FromGlm(const glm::mat4 &g) { Matrix r; std::memcpy(r.m, &g[0][0], sizeof(r.m)); return r; }	// Convert from glm
+	};
+
+	// The file header
+	struct Header
+	{
+		uint32_t	magic;	// SKM_MAGIC
+		uint32_t	version;	// SKM_VERSION
+		uint32_t	file_size;	// Total size in bytes, used to detect truncated files
+		uint32_t	num_bones;	// Number of skinned bones
+		float		ticks_per_second;	// Animation clock rate
+		float		duration;	// Animation length in ticks
+		uint32_t	reserved[2];	// Keeps the sections aligned
+		Matrix		global_inverse;		// Inverse of the scene root transform
+		Section		sections[NUM_SECTIONS];		// Where every array lives
+	};
+
+	// A sub-mesh drawn with one call
+	struct Entry
+	{
+		uint32_t	num_indices;	// Index count
+		uint32_t	base_vertex;	// First vertex
+		uint32_t	base_index;		// First index
+		uint32_t	material_index;		// Material slot
+	};
+
+	// A node of the flattened hierarchy
+	struct Node
+	{
+		int32_t		parent;		// Parent node index (always lower than this node's) or SKM_NO_PARENT
+		int32_t		bone;	// Bone index or SKM_NO_BONE
+		int32_t		channel;	// Channel index or SKM_NO_CHANNEL
+		uint32_t	name;	// Offset of the name in SECTION_NAMES
+		Matrix		local;	// Bind pose transform relative to the parent
+	};
+
+	// The key ranges of one animated node
+	struct Channel
+	{
+		uint32_t	first_position, num_positions;	// Range in SECTION_POSITION_KEYS
+		uint32_t	first_rotation, num_rotations;	// Range in SECTION_ROTATION_KEYS
+		uint32_t	first_scaling, num_scalings;	// Range in SECTION_SCALING_KEYS
+		float		position_min[3];	// Translations are min + value * step...
+		float		position_step[3];
+		float		scaling_min[3];		// Scales are min + value * step...
+		float		scaling_step[3];
+	};
+
+	// A compressed key
+	struct PackedKey
+	{
+		uint16_t	time;	// Fraction of the clip (0 - SKM_KEY_TIME_STEPS)
+		uint16_t	value[3];	// Quantised x, y, z or the smallest three quaternion components
+	};
+
+	// A translation or scale key as imported (cooker side only)
+	struct Vec3Key
+	{
+		float		time;	// Time in ticks
+		float		value[3];	// x, y, z
+	};
+
+	// A rotation key as imported (cooker side only)
+	struct QuatKey
+	{
+		float		time;	// Time in ticks
+		float		value[4];	// w, x, y, z
+	};
+
+	// Quantises a key time
+	inline uint16_t EncodeTime(float ticks, float duration)
+	{
+		float t = duration > 0.0f ? ticks / duration * SKM_KEY_TIME_STEPS : 0.0f;	// Scale to the 16 bit range
+		return (uint16_t)(t < 0.0f ? 0.0f : (t > SKM_KEY_TIME_STEPS ? SKM_KEY_TIME_STEPS : t + 0.5f));
+	}
+
+	// Quantises one component into [min, min + 65535 * step]
+	inline uint16_t EncodeRange(float value, float min, float step)
+	{
+		float q = step > 0.0f ? (value - min) / step : 0.0f;	// Steps from the minimum
+		return (uint16_t)(q < 0.0f ? 0.0f : (q > 65535.0f ? 65535.0f : q + 0.5f));
+	}
+
+	// Packs a unit quaternion (w, x, y, z) into 48 bits: the index of the largest component in 2 bits, then the other
+	// three in 15 bits each. The largest is made positive and rebuilt from the rest, which lie within +-1/sqrt(2)
+	inline void EncodeQuat(const float q[4], uint16_t out[3])
+	{
+		int largest = 0;	// The biggest component
+		for (int i = 1; i < 4; i++)
+			if (std::fabs(q[i]) > std::fabs(q[largest]))
+				largest = i;
+		float sign = q[largest] < 0.0f ? -1.0f : 1.0f;	// q and -q are the same rotation
+
+		for (int i = 0, k = 0; i < 4; i++)	// For each of the small three...
+		{
+			if (i == largest)
+				continue;
+			float c = q[i] * sign * 0.70710678f + 0.5f;		// Map [-1/sqrt(2), 1/sqrt(2)] to [0, 1]
+			c = c < 0.0f ? 0.0f : (c > 1.0f ? 1.0f : c);
+			out[k++] = (uint16_t)(c * 32767.0f + 0.5f);
+		}
+		out[0] |= (uint16_t)((largest >> 1) << 15);		// Spread the index over the spare top bits
+		out[1] |= (uint16_t)((largest & 1) << 15);
+	}
+
+	// Unpacks a quaternion written by EncodeQuat (w, x, y, z)
+	inline void DecodeQuat(const uint16_t in[3], float q[4])
+	{
+		int largest = ((in[0] >> 15) << 1) | (in[1] >> 15);		// The missing component
+		float sum = 0.0f;	// Squared length of the small three
+		for (int i = 0, k = 0; i < 4; i++)
+		{
+			if (i == largest)
+				continue;
+			float c = ((in[k++] & 0x7FFF) * (1.0f / 32767.0f) - 0.5f) * 1.41421356f;	// Back to [-1/sqrt(2), 1/sqrt(2)]
+			q[i] = c;
+			sum += c * c;
+		}
+		q[largest] = std::sqrt(sum < 1.0f ? 1.0f - sum : 0.0f);		// The largest is positive by construction
+	}
+
+	// The element size of each section, used for validation
+	inline uint32_t ElementSize(unsigned int section)
+	{
+		static const uint32_t sizes[NUM_SECTIONS] =
+		{
+			sizeof(Entry), sizeof(float) * 3, sizeof(float) * 3, sizeof(float) * 3, sizeof(float) * 2, sizeof(PackedBoneData),
+			sizeof(uint32_t), sizeof(Node), sizeof(Matrix), sizeof(Channel), sizeof(PackedKey), sizeof(PackedKey), sizeof(PackedKey), 1
+		};
+		return sizes[section];	// Return the size
+	}
+
+	// Typed, zero-copy access to a validated file in memory
+	class View
+	{
+	private:
+		const unsigned char*	_data;	// The file contents
+		const Header*			_header;	// The header
+
+	public:
+		inline View() : _data(NULL), _header(NULL) {}
+
+		// Checks the header, every section range and every cross reference, returns false if the file can't be trusted
+		inline bool Open(const unsigned char* data, size_t size)
+		{
+			_data = NULL;	// Start invalid
+			_header = NULL;		// Start invalid
+
+			if (!data || size < sizeof(Header))		// If the file is too small...
+			{
+				std::cout << "Skm Error: The file is truncated!\n";		// Print out error message
+				return false;	// Return false as failed
+			}
+
+			const Header* h = (const Header*)data;	// The header
+			if (h->magic != SKM_MAGIC || h->version != SKM_VERSION || h->file_size != size)		// If it's the wrong file or version...
+			{
+				std::cout << "Skm Error: The file is not a version " << SKM_VERSION << " cooked mesh, re-cook it!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+
+			for (unsigned int s = 0; s < NUM_SECTIONS; s++)		// For each section...
+			{
+				uint64_t end = (uint64_t)h->sections[s].offset + (uint64_t)h->sections[s].count * ElementSize(s);	// Its end
+				if (h->sections[s].offset % SKM_ALIGNMENT || h->sections[s].offset < sizeof(Header) || end > size)
+				{
+					std::cout << "Skm Error: Section " << s << " is out of bounds!\n";	// Print out error message
+					return false;	// Return false as failed
+				}
+			}
+
+			_data = data;	// Accept the data for the typed accessors
+			_header = h;	// Accept the header
+
+			uint32_t num_vertices = Count(SECTION_POSITIONS);	// The vertex count
+			bool valid = Count(SECTION_NORMALS) == num_vertices && Count(SECTION_TANGENTS) == num_vertices &&
+				Count(SECTION_TEXCOORDS) == num_vertices && Count(SECTION_BONE_DATA) == num_vertices &&
+				Count(SECTION_BONE_OFFSETS) == h->num_bones && h->num_bones <= 256;		// Per vertex and per bone arrays must line up
+
+			for (uint32_t i = 0; valid && i < Count(SECTION_ENTRIES); i++)	// For each entry...
+			{
+				const Entry &e = Entries()[i];	// The entry
+				valid = (uint64_t)e.base_index + e.num_indices <= Count(SECTION_INDICES) && e.base_vertex <= num_vertices;
+				for (uint32_t k = 0; valid && k < e.num_indices; k++)	// For each of its indices...
+					valid = (uint64_t)e.base_vertex + Indices()[e.base_index + k] < num_vertices;
+			}
+
+			for (uint32_t v = 0; valid && v < num_vertices; v++)	// For each vertex...
+				for (unsigned int k = 0; valid && k < NUM_BONES_PER_VERTEX; k++)
+					valid = BoneData()[v].Weights[k] == 0 || BoneData()[v].IDs[k] < h->num_bones;
+
+			for (uint32_t n = 0; valid && n < Count(SECTION_NODES); n++)	// For each node...
+			{
+				const Node &node = Nodes()[n];	// The node
+				valid = node.parent < (int32_t)n && node.parent >= SKM_NO_PARENT && node.bone < (int32_t)h->num_bones &&
+					node.channel < (int32_t)Count(SECTION_CHANNELS) && node.name < Count(SECTION_NAMES);
+			}
+
+			for (uint32_t c = 0; valid && c < Count(SECTION_CHANNELS); c++)	// For each channel...
+			{
+				const Channel &ch = Channels()[c];	// The channel
+				valid = (uint64_t)ch.first_position + ch.num_positions <= Count(SECTION_POSITION_KEYS) &&
+					(uint64_t)ch.first_rotation + ch.num_rotations <= Count(SECTION_ROTATION_KEYS) &&
+					(uint64_t)ch.first_scaling + ch.num_scalings <= Count(SECTION_SCALING_KEYS);
+			}
+
+			valid = valid && (Count(SECTION_NAMES) == 0 || Names()[Count(SECTION_NAMES) - 1] == '\0');	// The name table must be terminated
+
+			if (!valid)		// If any check failed...
+			{
+				std::cout << "Skm Error: The file contains invalid references!\n";	// Print out error message
+				_data = NULL;	// Reject the data
+				_header = NULL;		// Reject the header
+				return false;	// Return false as failed
+			}
+
+			return true;	// Return success
+		}
+
+		inline bool IsValid() const { return _header != NULL; }		// Return whether the view is usable
+		inline const Header& GetHeader() const { return *_header; }		// Return the header
+		inline uint32_t Count(SectionType s) const { return _header->sections[s].count; }	// Return a section's element count
+
+		template <typename T>
+		inline const T* Get(SectionType s) const { return (const T*)(_data + _header->sections[s].offset); }	// Return a section's first element
+
+		inline const Entry* Entries() const { return Get<Entry>(SECTION_ENTRIES); }
+		inline const glm::vec3* Positions() const { return Get<glm::vec3>(SECTION_POSITIONS); }
+		inline const glm::vec3* Normals() const { return Get<glm::vec3>(SECTION_NORMALS); }
+		inline const glm::vec3* Tangents() const { return Get<glm::vec3>(SECTION_TANGENTS); }
+		inline const glm::vec2* TexCoords() const { return Get<glm::vec2>(SECTION_TEXCOORDS); }
+		inline const PackedBoneData* BoneData() const { return Get<PackedBoneData>(SECTION_BONE_DATA); }
+		inline const uint32_t* Indices() const { return Get<uint32_t>(SECTION_INDICES); }
+		inline const Node* Nodes() const { return Get<Node>(SECTION_NODES); }
+		inline const Matrix* BoneOffsets() const { return Get<Matrix>(SECTION_BONE_OFFSETS); }
+		inline const Channel* Channels() const { return Get<Channel>(SECTION_CHANNELS); }
+		inline const PackedKey* PositionKeys() const { return Get<PackedKey>(SECTION_POSITION_KEYS); }
+		inline const PackedKey* RotationKeys() const { return Get<PackedKey>(SECTION_ROTATION_KEYS); }
+		inline const PackedKey* ScalingKeys() const { return Get<PackedKey>(SECTION_SCALING_KEYS); }
+		inline const char* Names() const { return Get<char>(SECTION_NAMES); }
+		inline const char* NodeName(uint32_t node) const { return Names() + Nodes()[node].name; }	// Return a node's name
+	};
+	// The contents of a cooked file before it is written, filled in by the offline cooker
+	struct Data
+	{
+		float						ticks_per_second;	// Animation clock rate
+		float						duration;	// Animation length in ticks
+		glm::mat4					global_inverse;		// Inverse of the scene root transform
+		std::vector<Entry>			entries;	// Sub-meshes
+		std::vector<glm::vec3>		positions;	// Per vertex positions
+		std::vector<glm::vec3>		normals;	// Per vertex normals
+		std::vector<glm::vec3>		tangents;	// Per vertex tangents
+		std::vector<glm::vec2>		texcoords;	// Per vertex texcoords
+		std::vector<PackedBoneData>	bone_data;	// Per vertex bone ids and weights
+		std::vector<uint32_t>		indices;	// Triangle indices
+		std::vector<Node>			nodes;	// Parent-first hierarchy
+		std::vector<Matrix>			bone_offsets;	// Per bone inverse bind pose
+		std::vector<Channel>		channels;	// Per animated node key ranges
+		std::vector<PackedKey>		position_keys;	// All translation keys
+		std::vector<PackedKey>		rotation_keys;	// All rotation keys
+		std::vector<PackedKey>		scaling_keys;	// All scale keys
+		std::string					names;	// Null terminated node names
+
+		inline Data() : ticks_per_second(25.0f), duration(0.0f), global_inverse(1.0f) {}
+	};
+
+	// Lays the data out as a cooked file and writes it to 'uri'
+	inline bool Write(const Data &data, const char* uri)
+	{
+		std::vector<unsigned char> file(sizeof(Header), 0);		// The output bytes, header first
+		Header header;	// The header
+		std::memset(&header, 0, sizeof(header));	// Clear padding so cooks are reproducible
+
+		auto add = [&](SectionType s, const void* src, size_t count)	// Appends one aligned section
+		{
+			file.resize((file.size() + SKM_ALIGNMENT - 1) / SKM_ALIGNMENT * SKM_ALIGNMENT, 0);	// Align the section
+			header.sections[s].offset = (uint32_t)file.size();	// Record where it starts
+			header.sections[s].count = (uint32_t)count;		// Record its length
+			size_t bytes = count * ElementSize(s);	// Its size in bytes
+			file.resize(file.size() + bytes);	// Make room
+			if (bytes) std::memcpy(&file[header.sections[s].offset], src, bytes);	// Copy it
+		};
+
+		add(SECTION_ENTRIES, data.entries.data(), data.entries.size());
+		add(SECTION_POSITIONS, data.positions.data(), data.positions.size());
+		add(SECTION_NORMALS, data.normals.data(), data.normals.size());
+		add(SECTION_TANGENTS, data.tangents.data(), data.tangents.size());
+		add(SECTION_TEXCOORDS, data.texcoords.data(), data.texcoords.size());
+		add(SECTION_BONE_DATA, data.bone_data.data(), data.bone_data.size());
+		add(SECTION_INDICES, data.indices.data(), data.indices.size());
+		add(SECTION_NODES, data.nodes.data(), data.nodes.size());
+		add(SECTION_BONE_OFFSETS, data.bone_offsets.data(), data.bone_offsets.size());
+		add(SECTION_CHANNELS, data.channels.data(), data.channels.size());
+		add(SECTION_POSITION_KEYS, data.position_keys.data(), data.position_keys.size());
+		add(SECTION_ROTATION_KEYS, data.rotation_keys.data(), data.rotation_keys.size());
+		add(SECTION_SCALING_KEYS, data.scaling_keys.data(), data.scaling_keys.size());
+		add(SECTION_NAMES, data.names.c_str(), data.names.size() + 1);	// Keep the final terminator
+
+		header.magic = SKM_MAGIC;	// Stamp the file
+		header.version = SKM_VERSION;	// Stamp the version
+		header.file_size = (uint32_t)file.size();	// Record the size
+		header.num_bones = (uint32_t)data.bone_offsets.size();	// Record the bone count
+		header.ticks_per_second = data.ticks_per_second;	// Record the clock rate
+		header.duration = data.duration;	// Record the length
+		header.global_inverse = Matrix::FromGlm(data.global_inverse);	// Record the root transform
+		std::memcpy(&file[0], &header, sizeof(header));		// Write the header
+
+		std::ofstream out(uri, std::ios::binary | std::ios::trunc);		// Create the file
+		if (!out.write((const char*)&file[0], file.size()))		// Write it in one go
+		{
+			std::cout << "Skm Error: Failed to write '" << uri << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		return true;	// Return success
+	}
+}
+
+#endif
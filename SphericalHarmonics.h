@@ -0,0 +1,227 @@
+#ifndef __SPHERICAL_HARMONICS_H__
+#define __SPHERICAL_HARMONICS_H__
+
+#include <iostream>		// Get error output
+#include <fstream>	// Get coefficient files
+#include <sstream>	// Parse coefficient files
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <cmath>	// Get trig
+#include <glm/glm.hpp>	// Get vectors
+#include <stb_image.h>	// Decode hdr files
+#include "Vfs.h"	// Read hdr / coefficient files
+#include "Parallel.h"	// Project rows in parallel
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>	// Get SSE2
+#define SH_SIMD 1	// Project four texels at a time
+#endif
+
+#define SH_COEFFICIENTS 9	// Third order (bands 0 - 2)
+
+// Third order spherical harmonics for diffuse ambient light. An equirectangular hdr is projected onto the 9 real
+// SH basis functions, then convolved with the clamped cosine so the lighting shader gets irradiance / pi (what the
+// irradiance cubemap stored) for a normal n as a dot product of the coefficients with the basis:
+//   Y0 = 0.282095, Y1 = 0.488603 y, Y2 = 0.488603 z, Y3 = 0.488603 x, Y4 = 1.092548 xy,
+//   Y5 = 1.092548 yz, Y6 = 0.315392 (3z^2 - 1), Y7 = 1.092548 xz, Y8 = 0.546274 (x^2 - y^2)
+namespace SphericalHarmonics
+{
+	// 9 rgb coefficients (27 floats, uploaded as a vec3[9] uniform)
+	struct SH9
+	{
+		glm::vec3 coefficients[SH_COEFFICIENTS];	// One rgb weight per basis function
+
+		inline SH9() { for (glm::vec3 &c : coefficients) c = glm::vec3(0.0f); }
+		inline const float* Data() const { return &coefficients[0].x; }		// Return the floats for glUniform3fv
+	};
+
+	// Evaluates the 9 basis functions for a unit direction
+	inline void Basis(const glm::vec3 &d, float out[SH_COEFFICIENTS])
+	{
+		out[0] = 0.282095f;
+		out[1] = 0.488603f * d.y;
+		out[2] = 0.488603f * d.z;
+		out[3] = 0.488603f * d.x;
+		out[4] = 1.092548f * d.x * d.y;
+		out[5] = 1.092548f * d.y * d.z;
+		out[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+		out[7] = 1.092548f * d.x * d.z;
+		out[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+	}
+
+	// Evaluates the function an SH9 represents in direction d (irradiance / pi once convolved)
+	inline glm::vec3 Evaluate(const SH9 &sh, const glm::vec3 &d)
+	{
+		float basis[SH_COEFFICIENTS];	// The basis
+		Basis(d, basis);
+		glm::vec3 result(0.0f);		// The sum
+		for (int i = 0; i < SH_COEFFICIENTS; i++)
+			result += sh.coefficients[i] * basis[i];
+		return result;	// Return it
+	}
+
+	// Evaluates an SH9 over the six faces of a size x size cubemap (GL face order, rgb floats), for shaders that
+	// still sample the old irradiance cubemap
+	inline std::vector<float> ToCubemap(const SH9 &sh, uint32_t size)
+	{
+		std::vector<float> faces((size_t)6 * size * size * 3);	// The texels
+		float* out = faces.data();	// The current texel
+		for (int f = 0; f < 6; f++)		// For each face (+x, -x, +y, -y, +z, -z)...
+			for (uint32_t y = 0; y < size; y++)
+				for (uint32_t x = 0; x < size; x++, out += 3)
+				{
+					float s = 2.0f * (x + 0.5f) / size - 1.0f, t = 2.0f * (y + 0.5f) / size - 1.0f;		// Face coordinates
+					glm::vec3 d = f == 0 ? glm::vec3(1.0f, -t, -s) : f == 1 ? glm::vec3(-1.0f, -t, s) :
+						f == 2 ? glm::vec3(s, 1.0f, t) : f == 3 ? glm::vec3(s, -1.0f, -t) :
+						f == 4 ? glm::vec3(s, -t, 1.0f) : glm::vec3(-s, -t, -1.0f);		// The texel's direction
+					glm::vec3 e = glm::max(Evaluate(sh, glm::normalize(d)), glm::vec3(0.0f));	// Ringing can dip below zero
+					out[0] = e.x;
+					out[1] = e.y;
+					out[2] = e.z;
+				}
+		return faces;	// Return them
+	}
+
+	// Projects the radiance of an equirectangular rgb image (the layout TextureHDR and the capture shader use:
+	// u = atan(z, x) / 2pi + 0.5, v = asin(y) / pi + 0.5) onto the basis. Each row is summed on its own and the rows
+	// are added in order afterwards, so the result doesn't depend on the thread count
+	inline SH9 ProjectEquirectangular(const float* rgb, uint32_t width, uint32_t height)
+	{
+		std::vector<float> cos_phi(width + 3), sin_phi(width + 3);	// Per column azimuth (padded to a multiple of 4)
+		for (uint32_t x = 0; x < width; x++)
+		{
+			float phi = ((x + 0.5f) / width - 0.5f) * 6.28318531f;	// u back to the angle
+			cos_phi[x] = std::cos(phi);
+			sin_phi[x] = std::sin(phi);
+		}
+
+		std::vector<float> rows((size_t)height * SH_COEFFICIENTS * 3, 0.0f);	// Per row sums
+		Parallel::For(0, height, 16, [&](size_t from, size_t to)
+		{
+			for (size_t y = from; y < to; y++)	// For each row...
+			{
+				float lat = ((y + 0.5f) / height - 0.5f) * 3.14159265f;		// v back to the latitude
+				float dy = std::sin(lat), cl = std::cos(lat);	// Height / radius of the ring
+				float weight = cl * (6.28318531f / width) * (3.14159265f / height);		// Solid angle of a texel in this row
+				const float* row = rgb + (size_t)y * width * 3;		// The texels
+				float* sum = &rows[y * SH_COEFFICIENTS * 3];	// This row's result (coefficient major, then rgb)
+				uint32_t x = 0;		// The current column
+
+#ifdef SH_SIMD
+				__m128 acc[SH_COEFFICIENTS][3];		// Four lanes of every sum
+				for (int k = 0; k < SH_COEFFICIENTS; k++)
+					for (int c = 0; c < 3; c++)
+						acc[k][c] = _mm_setzero_ps();
+
+				__m128 vy = _mm_set1_ps(dy), vcl = _mm_set1_ps(cl);		// Row constants
+				__m128 b1 = _mm_set1_ps(0.488603f * dy);	// The basis terms that only depend on y
+				__m128 b6c = _mm_set1_ps(0.315392f), b6a = _mm_set1_ps(3.0f * 0.315392f);
+				__m128 k4 = _mm_set1_ps(1.092548f), k8 = _mm_set1_ps(0.546274f), k1 = _mm_set1_ps(0.488603f);
+				for (; x + 4 <= width; x += 4)	// Four texels at a time...
+				{
+					__m128 dx = _mm_mul_ps(vcl, _mm_loadu_ps(&cos_phi[x]));		// Their directions
+					__m128 dz = _mm_mul_ps(vcl, _mm_loadu_ps(&sin_phi[x]));
+
+					__m128 basis[SH_COEFFICIENTS];	// The basis per lane
+					basis[0] = _mm_set1_ps(0.282095f);
+					basis[1] = b1;
+					basis[2] = _mm_mul_ps(k1, dz);
+					basis[3] = _mm_mul_ps(k1, dx);
+					basis[4] = _mm_mul_ps(k4, _mm_mul_ps(dx, vy));
+					basis[5] = _mm_mul_ps(k4, _mm_mul_ps(vy, dz));
+					basis[6] = _mm_sub_ps(_mm_mul_ps(b6a, _mm_mul_ps(dz, dz)), b6c);
+					basis[7] = _mm_mul_ps(k4, _mm_mul_ps(dx, dz));
+					basis[8] = _mm_mul_ps(k8, _mm_sub_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(vy, vy)));
+
+					const float* p = row + x * 3;	// Deinterleave rgbrgbrgbrgb
+					__m128 r = _mm_setr_ps(p[0], p[3], p[6], p[9]);
+					__m128 g = _mm_setr_ps(p[1], p[4], p[7], p[10]);
+					__m128 b = _mm_setr_ps(p[2], p[5], p[8], p[11]);
+
+					for (int k = 0; k < SH_COEFFICIENTS; k++)	// Accumulate
+					{
+						acc[k][0] = _mm_add_ps(acc[k][0], _mm_mul_ps(basis[k], r));
+						acc[k][1] = _mm_add_ps(acc[k][1], _mm_mul_ps(basis[k], g));
+						acc[k][2] = _mm_add_ps(acc[k][2], _mm_mul_ps(basis[k], b));
+					}
+				}
+
+				for (int k = 0; k < SH_COEFFICIENTS; k++)	// Fold the lanes
+					for (int c = 0; c < 3; c++)
+					{
+						float lanes[4];
+						_mm_storeu_ps(lanes, acc[k][c]);
+						sum[k * 3 + c] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+					}
+#endif
+
+				for (; x < width; x++)	// The rest one at a time
+				{
+					float basis[SH_COEFFICIENTS];	// The basis
+					Basis(glm::vec3(cl * cos_phi[x], dy, cl * sin_phi[x]), basis);
+					for (int k = 0; k < SH_COEFFICIENTS; k++)
+						for (int c = 0; c < 3; c++)
+							sum[k * 3 + c] += basis[k] * row[x * 3 + c];
+				}
+
+				for (int i = 0; i < SH_COEFFICIENTS * 3; i++)	// Weight the row by its solid angle
+					sum[i] *= weight;
+			}
+		});
+
+		SH9 sh;		// The radiance
+		for (uint32_t y = 0; y < height; y++)	// Add the rows in order
+			for (int k = 0; k < SH_COEFFICIENTS; k++)
+				sh.coefficients[k] += glm::vec3(rows[(y * SH_COEFFICIENTS + k) * 3], rows[(y * SH_COEFFICIENTS + k) * 3 + 1], rows[(y * SH_COEFFICIENTS + k) * 3 + 2]);
+		return sh;	// Return it
+	}
+
+	// Convolves radiance with the clamped cosine and divides by pi, giving what the irradiance cubemap held
+	inline SH9 ToIrradiance(const SH9 &radiance)
+	{
+		static const float band[SH_COEFFICIENTS] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };	// A_l / pi
+		SH9 sh;		// The result
+		for (int k = 0; k < SH_COEFFICIENTS; k++)
+			sh.coefficients[k] = radiance.coefficients[k] * band[k];
+		return sh;	// Return it
+	}
+
+	// Decodes an hdr and returns its irradiance coefficients
+	inline bool Project(const std::string &hdr, SH9 &out)
+	{
+		VfsFile file;	// The hdr
+		int w, h, c;	// Its size
+		float* rgb = Vfs::Open(hdr, file) ? stbi_loadf_from_memory(file.Data(), (int)file.Size(), &w, &h, &c, 3) : NULL;	// Decode it as rgb
+		if (!rgb)	// If it failed...
+		{
+			std::cout << "SH Error: Failed to decode '" << hdr << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+		out = ToIrradiance(ProjectEquirectangular(rgb, (uint32_t)w, (uint32_t)h));		// Project it
+		stbi_image_free(rgb);	// Free the pixels
+		return true;	// Return success
+	}
+
+	// Writes coefficients as text (27 floats)
+	inline bool Save(const std::string &uri, const SH9 &sh)
+	{
+		std::ofstream file(uri, std::ios::trunc);	// The file
+		file.precision(9);	// Round trip floats exactly
+		for (const glm::vec3 &c : sh.coefficients)
+			file << c.x << " " << c.y << " " << c.z << "\n";
+		return (bool)file;	// Return whether it was written
+	}
+
+	// Reads coefficients written by Save
+	inline bool Load(const std::string &uri, SH9 &sh)
+	{
+		std::istringstream file;	// The file
+		if (!Vfs::OpenText(uri, file))	// If it can't be read...
+			return false;	// Return false as failed
+		for (glm::vec3 &c : sh.coefficients)
+			file >> c.x >> c.y >> c.z;
+		return !file.fail();	// Return whether all 27 were read
+	}
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef __SPLINE_H__
+#define __SPLINE_H__
+
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get upper_bound / min / max
+#include <cmath>	// Get sqrt
+#include <glm/glm.hpp>	// Get glm variables
+#include <glm/gtx/quaternion.hpp>	// Get quaternions
+
+#define SPLINE_TABLE_STEPS	8	// Arc-length samples per segment
+#define SPLINE_NEWTON_STEPS	2	// Refinements of a table lookup
+
+// Analytic cubic paths that are walked by distance instead of by parameter. Every segment (Bézier, Hermite or
+// Catmull-Rom) is stored as its polynomial, and a small table of arc lengths (SPLINE_TABLE_STEPS per segment,
+// integrated with Gauss-Legendre quadrature) maps a distance to a parameter with a binary search and a few Newton
+// steps. Movers then travel at constant speed for a few hundred bytes a path, without sampling or scanning
+namespace Spline
+{
+	// One cubic piece, p(t) = c0 + c1 t + c2 t^2 + c3 t^3 with t in [0, 1]
+	struct Segment
+	{
+		glm::vec3	c[4];	// The coefficients
+
+		inline glm::vec3 Position(float t) const { return ((c[3] * t + c[2]) * t + c[1]) * t + c[0]; }		// Return p(t)
+		inline glm::vec3 Derivative(float t) const { return (c[3] * (3.0f * t) + c[2] * 2.0f) * t + c[1]; }	// Return p'(t)
+
+		// Returns the arc length between two parameters (5 point Gauss-Legendre, exact enough for a cubic's speed)
+		inline float Length(float a, float b) const
+		{
+			static const float x[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };	// Nodes
+			static const float w[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };	// Weights
+			float half = 0.5f * (b - a), mid = 0.5f * (a + b), sum = 0.0f;
+			for (int i = 0; i < 5; i++)
+				sum += w[i] * glm::length(Derivative(mid + half * x[i]));
+			return sum * half;	// Return it
+		}
+
+		// Cubic Bézier through p0 and p3, pulled towards p1 and p2
+		static inline Segment Bezier(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3)
+		{
+			Segment s;
+			s.c[0] = p0;
+			s.c[1] = 3.0f * (p1 - p0);
+			s.c[2] = 3.0f * (p0 - 2.0f * p1 + p2);
+			s.c[3] = p3 - p0 + 3.0f * (p1 - p2);
+			return s;
+		}
+
+		// Hermite from p0 to p1 leaving with tangent m0 and arriving with m1
+		static inline Segment Hermite(const glm::vec3 &p0, const glm::vec3 &m0, const glm::vec3 &p1, const glm::vec3 &m1)
+		{
+			Segment s;
+			s.c[0] = p0;
+			s.c[1] = m0;
+			s.c[2] = 3.0f * (p1 - p0) - 2.0f * m0 - m1;
+			s.c[3] = 2.0f * (p0 - p1) + m0 + m1;
+			return s;
+		}
+	};
+
+	// An orientation the path passes through at some distance
+	struct OrientationKey
+	{
+		float		distance;	// Where along the path
+		glm::quat	rotation;	// The orientation there
+	};
+
+	// A chain of segments with its arc-length table and orientation track
+	class Path
+	{
+	private:
+		std::vector<Segment>		_segments;	// The pieces, end to end
+		std::vector<float>			_table;		// Distance at every table step (SPLINE_TABLE_STEPS per segment, plus the end)
+		std::vector<OrientationKey>	_orientations;	// Sorted by distance
+
+		// Finds the segment and parameter at a distance (clamped to the path)
+		inline void Locate(float distance, size_t &segment, float &t) const
+		{
+			if (_table.size() < 2)	// If it hasn't been built...
+			{
+				segment = 0;
+				t = 0.0f;
+				return;
+			}
+
+			distance = std::min(std::max(distance, 0.0f), _table.back());	// Stay on the path
+			size_t i = std::upper_bound(_table.begin(), _table.end(), distance) - _table.begin();	// First step past it
+			i = std::min(std::max<size_t>(i, 1), _table.size() - 1) - 1;	// The step it's in
+			segment = std::min(i / SPLINE_TABLE_STEPS, _segments.size() - 1);
+			float t0 = (float)(i - segment * SPLINE_TABLE_STEPS) / SPLINE_TABLE_STEPS, t1 = t0 + 1.0f / SPLINE_TABLE_STEPS;	// The step's parameters
+			float span = _table[i + 1] - _table[i];
+			t = span > 0.0f ? t0 + (distance - _table[i]) / span * (t1 - t0) : t0;	// Linear guess inside the step
+
+			const Segment &s = _segments[segment];
+			for (int n = 0; n < SPLINE_NEWTON_STEPS; n++)	// Newton on length(t0, t) = distance - table
+			{
+				float speed = glm::length(s.Derivative(t));
+				if (speed <= 1e-8f)
+					break;
+				t = std::min(std::max(t - (s.Length(t0, t) - (distance - _table[i])) / speed, t0), t1);
+			}
+		}
+
+	public:
+		// Removes every segment and key
+		inline void Clear()
+		{
+			_segments.clear();
+			_table.clear();
+			_orientations.clear();
+		}
+
+		inline void AddSegment(const Segment &s) { _segments.push_back(s); }	// Append a segment (call Build after)
+		inline void AddBezier(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3) { AddSegment(Segment::Bezier(p0, p1, p2, p3)); }	// Append a cubic Bézier
+		inline void AddHermite(const glm::vec3 &p0, const glm::vec3 &m0, const glm::vec3 &p1, const glm::vec3 &m1) { AddSegment(Segment::Hermite(p0, m0, p1, m1)); }	// Append a Hermite segment
+
+		// Appends a uniform Catmull-Rom curve through every point (the ends reuse their neighbour as the tangent)
+		inline void AddCatmullRom(const std::vector<glm::vec3> &points)
+		{
+			for (size_t i = 0; i + 1 < points.size(); i++)	// For each pair of points...
+			{
+				const glm::vec3 &before = points[i ? i - 1 : i], &after = points[i + 2 < points.size() ? i + 2 : i + 1];
+				AddHermite(points[i], 0.5f * (points[i + 1] - before), points[i + 1], 0.5f * (after - points[i]));
+			}
+		}
+
+		// Adds an orientation at a distance along the path
+		inline void AddOrientation(float distance, const glm::quat &rotation)
+		{
+			OrientationKey key = { distance, rotation };
+			_orientations.insert(std::upper_bound(_orientations.begin(), _orientations.end(), key,
+				[](const OrientationKey &a, const OrientationKey &b) { return a.distance < b.distance; }), key);
+		}
+
+		// Integrates the arc-length table, call after adding segments
+		inline void Build()
+		{
+			_table.assign(1, 0.0f);
+			_table.reserve(_segments.size() * SPLINE_TABLE_STEPS + 1);
+			for (const Segment &s : _segments)	// For each segment...
+				for (int k = 0; k < SPLINE_TABLE_STEPS; k++)
+					_table.push_back(_table.back() + s.Length((float)k / SPLINE_TABLE_STEPS, (float)(k + 1) / SPLINE_TABLE_STEPS));
+		}
+
+		inline float Length() const { return _table.empty() ? 0.0f : _table.back(); }	// Return the path's length
+		inline size_t NumSegments() const { return _segments.size(); }	// Return the segment count
+		inline size_t MemoryUsed() const { return _segments.size() * sizeof(Segment) + _table.size() * sizeof(float) + _orientations.size() * sizeof(OrientationKey); }	// Return the bytes held
+
+		// Returns the position a distance along the path
+		inline glm::vec3 PositionAt(float distance) const
+		{
+			if (_segments.empty())
+				return glm::vec3(0.0f);
+			size_t segment;
+			float t;
+			Locate(distance, segment, t);
+			return _segments[segment].Position(t);
+		}
+
+		// Returns the unit direction of travel a distance along the path
+		inline glm::vec3 TangentAt(float distance) const
+		{
+			if (_segments.empty())
+				return glm::vec3(0.0f, 0.0f, 1.0f);
+			size_t segment;
+			float t;
+			Locate(distance, segment, t);
+			glm::vec3 d = _segments[segment].Derivative(t);
+			float l = glm::length(d);
+			return l > 1e-8f ? d / l : glm::vec3(0.0f, 0.0f, 1.0f);
+		}
+
+		// Returns the orientation a distance along the path, slerped between the nearest keys
+		inline glm::quat OrientationAt(float distance) const
+		{
+			if (_orientations.empty())	// If there's no track...
+				return glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+			OrientationKey key = { distance, glm::quat() };
+			size_t i = std::upper_bound(_orientations.begin(), _orientations.end(), key,
+				[](const OrientationKey &a, const OrientationKey &b) { return a.distance < b.distance; }) - _orientations.begin();
+			if (i == 0)		// Before the first key
+				return _orientations.front().rotation;
+			if (i == _orientations.size())	// After the last
+				return _orientations.back().rotation;
+			const OrientationKey &a = _orientations[i - 1], &b = _orientations[i];
+			float span = b.distance - a.distance;
+			return glm::slerp(a.rotation, b.rotation, span > 0.0f ? (distance - a.distance) / span : 0.0f);
+		}
+	};
+}
+
+#endif
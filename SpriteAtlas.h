@@ -0,0 +1,443 @@
+#ifndef __SPRITE_ATLAS_H__
+#define __SPRITE_ATLAS_H__
+
+#include <iostream>		// Get error output
+#include <fstream>	// Get table output
+#include <sstream>	// Get table parsing
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <filesystem>	// Compare baked atlases with their sources
+#include <glm/glm.hpp>	// Get vec4
+#include "RectPacker.h"		// Pack sprites onto pages
+#include "TextureCooker.h"	// Mip filtering / block compression / dds output
+#include "DdsLoader.h"	// Upload the pages
+
+#define SPRITE_ATLAS_URI		"Res/Atlases/"	// Where baked atlases live
+#define SPRITE_ATLAS_SIZE		1024	// Page width / height in pixels
+#define SPRITE_ATLAS_PADDING	16	// Extruded border around every sprite (the mip chain stops before it gets too thin)
+#define SPRITE_ATLAS_ALIGNMENT	32	// Grid compressed pages place sprites on, so blocks keep to one sprite down the chain
+#define SPRITE_ATLAS_EFFECTS	"Effects"	// Particle sprites / flipbook frames
+#define SPRITE_ATLAS_HUD		"Hud"	// Inventory icons
+#define SPRITE_ATLAS_FONTS		"Fonts"		// Glyph bitmaps (linear and uncompressed, see PageFormat)
+
+// Where a sprite ended up: shaders sample texture(atlas, vec3(uv * _uv.zw + _uv.xy, _layer))
+struct AtlasRegion
+{
+	std::string		_name;	// The source uri
+	glm::vec4		_uv;	// Offset (xy) and scale (zw) in page uvs
+	float			_layer;		// The page
+	uint32_t		_width;		// Width in pixels
+	uint32_t		_height;	// Height in pixels
+};
+
+// Many small textures merged onto the pages of one GL_TEXTURE_2D_ARRAY so the particle sprites, flipbook frames, font
+// bitmaps and icons that share an atlas can be drawn with a single bind. Consumers Add their files and keep the index
+// they get back; the atlas packs (skyline), extrudes, filters mips and compresses the pages when BuildAll runs after
+// loading (or on the next bind for sprites added later), or loads a baked atlas (dds array + .atlas table) made
+// offline with Save, unless its sources changed since. Indices are stable across rebuilds. Use falls back to one
+// texture per sprite for shaders that haven't moved to the sampler2DArray yet
+class SpriteAtlas
+{
+private:
+	struct Source { uint32_t width, height; std::vector<uint8_t> rgba; };	// Decoded pixels, kept for rebuilds
+
+	std::string							_name;	// The atlas name
+	TextureContainer::Format			_format;	// Page format
+	std::vector<AtlasRegion>			_regions;	// The uv remap table
+	std::vector<Source>					_sources;	// One per region (empty while a baked atlas is in use)
+	std::vector<GLuint>					_singles;	// Standalone sprite textures for shaders without the atlas uniforms
+	GLuint								_texture_id;	// The array texture
+	uint32_t							_pages;		// Layers in use
+	bool								_dirty;		// Whether the pages are out of date
+	bool								_baked;		// Whether the regions came from a baked table
+
+	static std::vector<SpriteAtlas*>	_atlases;	// The shared atlases
+
+	// Decodes an image (dds / ktx2 in a format we can decode, or anything stb reads) to rgba8. A container with a
+	// source image beside it (same name, png or tga) is read from the source, so the pages aren't compressed twice
+	inline static bool Decode(const std::string &uri, Source &out)
+	{
+		std::string ext = uri.substr(uri.find_last_of('.') + 1);	// The extension
+		if (ext == "dds" || ext == "ktx2")	// If it's a container...
+		{
+			std::string base = uri.substr(0, uri.find_last_of('.') + 1);	// The name without its extension
+			for (const char* source : { "png", "tga" })		// Prefer the image it was cooked from
+				if (Vfs::Exists(base + source))
+					return Decode(base + source, out);
+
+			TextureContainer::File file;	// The parsed file
+			if (!file.Open(uri))	// If it can't be read...
+				return false;	// Return false as failed
+
+			const TextureContainer::Subresource &top = file.GetImage().Get(0);	// Only the top level is used
+			TextureContainer::Format f = file.GetImage().format;	// Its format
+			out.width = top.width; out.height = top.height;
+			if (BlockCompression::CanEncode(f))		// If it's block compressed...
+				return BlockCompression::Decompress(top.data, top.width, top.height, f, out.rgba);	// Decode it
+
+			bool swizzled = f == TextureContainer::FORMAT_BGRA8 || f == TextureContainer::FORMAT_BGRA8_SRGB || f == TextureContainer::FORMAT_BGRX8 || f == TextureContainer::FORMAT_BGRX8_SRGB;
+			bool opaque = f == TextureContainer::FORMAT_RGBX8 || f == TextureContainer::FORMAT_BGRX8 || f == TextureContainer::FORMAT_BGRX8_SRGB;	// The fourth byte is unused
+			if (f != TextureContainer::FORMAT_RGBA8 && f != TextureContainer::FORMAT_RGBA8_SRGB && !swizzled && !opaque)
+			{
+				std::cout << "Atlas Error: Can't decode " << TextureContainer::GetFormatInfo(f).name << " in '" << uri << "'!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+			out.rgba.resize((size_t)top.width * top.height * 4);	// Make room
+			for (uint32_t y = 0; y < top.height; y++)	// Copy row by row (rows may be padded)
+				std::memcpy(&out.rgba[(size_t)y * top.width * 4], top.data + y * top.row_pitch, (size_t)top.width * 4);
+			for (size_t i = 0; (swizzled || opaque) && i < out.rgba.size(); i += 4)	// For each pixel that needs fixing...
+			{
+				if (swizzled) std::swap(out.rgba[i], out.rgba[i + 2]);	// Swap red / blue
+				if (opaque) out.rgba[i + 3] = 255;	// Ignore the unused byte
+			}
+			return true;	// Return success
+		}
+
+		VfsFile file;	// The source
+		int w, h, c;	// Its size
+		unsigned char* data = Vfs::Open(uri, file) ? stbi_load_from_memory(file.Data(), (int)file.Size(), &w, &h, &c, 4) : NULL;	// Decode as rgba
+		if (!data)	// If it failed...
+		{
+			std::cout << "Atlas Error: Failed to decode '" << uri << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+		out.width = (uint32_t)w; out.height = (uint32_t)h;
+		out.rgba.assign(data, data + (size_t)w * h * 4);	// Keep the pixels
+		stbi_image_free(data);	// Free them
+		return true;	// Return success
+	}
+
+	// Returns whether a source on disk is newer than the baked pages at 'uri'. A container is also compared with the
+	// images beside it, which Decode prefers. Files only found in an archive can't be dated and count as up to date
+	inline static bool IsStale(const std::string &uri, const std::vector<AtlasRegion> &regions)
+	{
+		std::error_code ec;		// Missing files are skipped
+		std::filesystem::file_time_type baked = std::filesystem::last_write_time(uri + ".dds", ec);	// When it was baked
+		if (ec)		// If the pages aren't a loose file...
+			return false;	// Trust them
+
+		for (const AtlasRegion &r : regions)	// For each sprite...
+		{
+			size_t dot = r._name.find_last_of('.');		// Where its extension starts
+			std::string base = r._name.substr(0, dot + 1);	// The name without its extension
+			for (const std::string &file : { r._name, base + "png", base + "tga" })		// For the file and its sources...
+			{
+				if (dot == std::string::npos && file != r._name)	// If it has no extension (pixels added by name)...
+					break;	// There are no sources to compare
+				std::filesystem::file_time_type t = std::filesystem::last_write_time(file, ec);	// When it changed
+				if (!ec && t > baked)	// If it changed after the bake...
+					return true;	// The pages are out of date
+			}
+		}
+		return false;	// Return up to date
+	}
+
+	// Decodes the sources of a baked table so the atlas can be rebuilt with new sprites
+	inline void Unbake()
+	{
+		_baked = false;		// The table no longer matches the pages
+		_sources.resize(_regions.size());	// One source per region
+		for (size_t i = 0; i < _regions.size(); i++)	// For each region...
+			if (!Decode(_regions[i]._name, _sources[i]))	// Decode its file
+				_sources[i] = Source{ 1, 1, std::vector<uint8_t>(4, 0) };	// Keep the index valid with a blank texel
+	}
+
+public:
+	inline SpriteAtlas(const std::string &name, TextureContainer::Format format = TextureContainer::FORMAT_BC3_SRGB) :
+		_name(name), _format(format), _texture_id(0), _pages(0), _dirty(false), _baked(false) {}
+
+	inline ~SpriteAtlas()
+	{
+		glDeleteTextures(1, &_texture_id);	// Delete the pages
+		for (GLuint single : _singles)	// And any standalone sprites
+			glDeleteTextures(1, &single);
+	}
+
+	// Returns the page format of a shared atlas: glyphs are coverage, not colour, so the font atlas stays linear and
+	// uncompressed (its bitmaps usually arrive block compressed already); everything else is BC3 in sRGB
+	inline static TextureContainer::Format PageFormat(const std::string &name)
+	{
+		return name == SPRITE_ATLAS_FONTS ? TextureContainer::FORMAT_RGBA8 : TextureContainer::FORMAT_BC3_SRGB;
+	}
+
+	// Returns the shared atlas called 'name', loading its baked version the first time if there is one
+	inline static SpriteAtlas* Get(const std::string &name)
+	{
+		for (SpriteAtlas* a : _atlases)		// Look for it...
+			if (a->_name == name)
+				return a;
+
+		_atlases.push_back(new SpriteAtlas(name, PageFormat(name)));	// Otherwise create it
+		if (Vfs::Exists(SPRITE_ATLAS_URI + name + ".atlas"))	// If it was baked...
+			_atlases.back()->Load(SPRITE_ATLAS_URI + name);		// Use it
+		return _atlases.back();		// Return it
+	}
+
+	// Builds every shared atlas that has new sprites. Called once loading has added them, so the pages aren't packed
+	// and compressed inside the first frame that binds them
+	inline static void BuildAll()
+	{
+		for (SpriteAtlas* a : _atlases)		// For each atlas...
+			if (a->_dirty)	// If sprites were added...
+				a->Build();		// Build it now
+	}
+
+	// Deletes the shared atlases
+	inline static void Destroy()
+	{
+		for (SpriteAtlas* a : _atlases)
+			delete a;
+		_atlases.clear();
+	}
+
+	// Adds an image file, returns its region index (the same index if it's already in)
+	inline unsigned int Add(const std::string &uri)
+	{
+		int found = Find(uri);	// Whether it's already in
+		if (found >= 0)		// If it is...
+			return (unsigned int)found;		// Return it
+
+		Source source;	// The pixels
+		if (!Decode(uri, source))	// If it can't be decoded...
+			source = Source{ 1, 1, std::vector<uint8_t>(4, 0) };	// Keep the index valid with a blank texel
+		return Add(uri, source.width, source.height, source.rgba.data());	// Add them
+	}
+
+	// Adds rgba8 pixels under 'name', returns its region index
+	inline unsigned int Add(const std::string &name, uint32_t width, uint32_t height, const uint8_t* rgba)
+	{
+		if (_baked)		// If the pages came from disk...
+			Unbake();	// We need the other sprites' pixels to repack
+
+		AtlasRegion region = { name, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), 0.0f, width, height };	// Placed on Build
+		_regions.push_back(region);		// Store it
+		_sources.push_back(Source{ width, height, std::vector<uint8_t>(rgba, rgba + (size_t)width * height * 4) });		// Keep the pixels
+		_dirty = true;	// Repack before the next bind
+		return (unsigned int)_regions.size() - 1;	// Return the index
+	}
+
+	// Returns the index of 'name' or -1
+	inline int Find(const std::string &name) const
+	{
+		for (size_t i = 0; i < _regions.size(); i++)	// For each region...
+			if (_regions[i]._name == name)
+				return (int)i;
+		return -1;	// Not found
+	}
+
+	// Packs the sources and builds the pages on the CPU, 'levels' is layer major (every mip of page 0 first)
+	inline bool Pack(std::vector<std::vector<uint8_t>> &levels, uint32_t &num_mips)
+	{
+		bool srgb = TextureCooker::IsSrgb(_format);		// Whether to filter in linear space
+		bool premultiply = TextureCooker::HasAlpha(_format);	// Whether to filter colour weighted by alpha
+		bool compress = BlockCompression::CanEncode(_format);	// Whether to block compress
+		uint32_t align = compress ? SPRITE_ATLAS_ALIGNMENT : 4;		// The grid sprites are placed on
+
+		std::vector<std::pair<uint32_t, uint32_t>> sizes;	// Padded sizes
+		for (const Source &s : _sources)	// Round up to the grid, the packer then places every sprite on it
+			sizes.push_back({ (s.width + SPRITE_ATLAS_PADDING * 2 + align - 1) & ~(align - 1), (s.height + SPRITE_ATLAS_PADDING * 2 + align - 1) & ~(align - 1) });
+
+		std::vector<RectPacker::Rect> rects;	// Where they went
+		if (!RectPacker::Pack(sizes, SPRITE_ATLAS_SIZE, SPRITE_ATLAS_SIZE, rects, _pages))	// If something is too big...
+		{
+			std::cout << "Atlas Error: A sprite in '" << _name << "' is larger than a page!\n";		// Print out error message
+			return false;	// Return false as failed
+		}
+
+		std::vector<std::vector<uint8_t>> pages(_pages, std::vector<uint8_t>((size_t)SPRITE_ATLAS_SIZE * SPRITE_ATLAS_SIZE * 4, 0));	// Clear pages
+		for (size_t i = 0; i < _sources.size(); i++)	// For each sprite...
+		{
+			const Source &s = _sources[i];	// Its pixels
+			const RectPacker::Rect &r = rects[i];	// Its place
+			uint8_t* page = pages[r.page].data();	// Its page
+			for (uint32_t y = 0; y < r.height; y++)		// Copy it with its edges extruded into the padding
+				for (uint32_t x = 0; x < r.width; x++)
+				{
+					int sx = std::min(std::max((int)x - SPRITE_ATLAS_PADDING, 0), (int)s.width - 1);	// Clamped source texel
+					int sy = std::min(std::max((int)y - SPRITE_ATLAS_PADDING, 0), (int)s.height - 1);
+					std::memcpy(page + (((size_t)r.y + y) * SPRITE_ATLAS_SIZE + r.x + x) * 4, &s.rgba[((size_t)sy * s.width + sx) * 4], 4);
+				}
+
+			AtlasRegion &region = _regions[i];	// Its remap entry
+			region._uv = glm::vec4((float)(r.x + SPRITE_ATLAS_PADDING) / SPRITE_ATLAS_SIZE, (float)(r.y + SPRITE_ATLAS_PADDING) / SPRITE_ATLAS_SIZE,
+				(float)s.width / SPRITE_ATLAS_SIZE, (float)s.height / SPRITE_ATLAS_SIZE);
+			region._layer = (float)r.page;
+		}
+
+		// Stop the chain once the padding reserved around the sprites gets too thin: filtering needs 2 texels of it,
+		// and on compressed pages the grid must still fall on 4 texel block boundaries so no block mixes two sprites
+		num_mips = 1;
+		while ((SPRITE_ATLAS_PADDING >> num_mips) >= 2 && (!compress || (align >> num_mips) >= 4)) num_mips++;
+		levels.clear();		// Fresh chain
+		for (uint32_t p = 0; p < _pages; p++)	// For each page...
+		{
+			std::vector<uint8_t> bytes = pages[p];	// The current level
+			TextureCooker::Image level = TextureCooker::ToFloat(bytes.data(), SPRITE_ATLAS_SIZE, SPRITE_ATLAS_SIZE, srgb);	// In float
+			if (premultiply)	// If alpha is coverage...
+				TextureCooker::Premultiply(level);	// Filter premultiplied
+			for (uint32_t m = 0; m < num_mips; m++)		// For each level...
+			{
+				if (m > 0)	// If it's a mip...
+				{
+					level = TextureCooker::Downsample(level, false);	// Filter it
+					TextureCooker::ToBytes(premultiply ? TextureCooker::Unpremultiply(level) : level, srgb, bytes);		// Back to 8 bits, straight alpha
+				}
+				levels.push_back(std::vector<uint8_t>());	// Make room
+				if (compress)	// Encode it...
+					BlockCompression::Compress(bytes.data(), level.width, level.height, _format, levels.back());
+				else
+					levels.back() = bytes;
+			}
+		}
+		return true;	// Return success
+	}
+
+	// Packs and uploads the pages
+	inline bool Build()
+	{
+		_dirty = false;		// Don't retry every bind if it fails
+		std::vector<std::vector<uint8_t>> levels;	// The pages
+		uint32_t num_mips;	// Levels per page
+		if (_sources.empty() || !Pack(levels, num_mips))	// If there's nothing to pack...
+			return false;	// Return false as failed
+
+		std::vector<uint8_t> data;	// The pages back to back, in dds order
+		for (const std::vector<uint8_t> &l : levels)
+			data.insert(data.end(), l.begin(), l.end());
+
+		TextureContainer::Image image;	// Describe them for the uploader
+		image.format = _format;
+		image.width = image.height = SPRITE_ATLAS_SIZE;
+		image.mips = num_mips;
+		image.layers = _pages;
+		image.faces = 1;
+		TextureContainer::LayoutSequential(data.data(), data.size(), 0, image);		// Point at them
+
+		glDeleteTextures(1, &_texture_id);	// Release the old pages
+		size_t w, h, m;		// The uploaded size
+		_texture_id = UploadTexture({ &image }, w, h, m, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_TEXTURE_2D_ARRAY, false);	// Upload them
+
+#ifdef SPRITE_ATLAS_BAKE_ON_BUILD
+		Save(SPRITE_ATLAS_URI + _name);		// Bake it for the next run (tools / editor builds)
+#endif
+		return _texture_id != 0;	// Return whether it worked
+	}
+
+	// Bakes the atlas to 'uri'.dds (the pages) and 'uri'.atlas (the remap table)
+	inline bool Save(const std::string &uri)
+	{
+		if (_baked)		// If it came from disk...
+			Unbake();	// Rebuild it from the sources
+
+		std::vector<std::vector<uint8_t>> levels;	// The pages
+		uint32_t num_mips;	// Levels per page
+		if (_sources.empty() || !Pack(levels, num_mips) || !TextureCooker::WriteDds(uri + ".dds", _format, SPRITE_ATLAS_SIZE, SPRITE_ATLAS_SIZE, levels, _pages))	// If it can't be written...
+			return false;	// Return false as failed
+
+		std::ofstream table(uri + ".atlas", std::ios::trunc);	// The remap table
+		for (const AtlasRegion &r : _regions)	// One line per sprite
+			table << r._name << " " << r._uv.x << " " << r._uv.y << " " << r._uv.z << " " << r._uv.w << " " << r._layer << " " << r._width << " " << r._height << "\n";
+		std::cout << "Atlas: " << _name << " " << _regions.size() << " sprites on " << _pages << " pages\n";	// Report it
+		return (bool)table;		// Return whether it was written
+	}
+
+	// Loads a baked atlas
+	inline bool Load(const std::string &uri)
+	{
+		std::istringstream table;	// The remap table
+		if (!Vfs::OpenText(uri + ".atlas", table))	// If it can't be read...
+			return false;	// Return false as failed
+
+		std::vector<AtlasRegion> regions;	// The entries
+		AtlasRegion r;	// One entry
+		while (table >> r._name >> r._uv.x >> r._uv.y >> r._uv.z >> r._uv.w >> r._layer >> r._width >> r._height)
+			regions.push_back(r);
+
+		if (IsStale(uri, regions))	// If a sprite was edited since the bake...
+		{
+			std::cout << "Atlas: '" << uri << "' is older than its sprites, rebuilding it\n";	// Report it
+			_regions = regions;		// Keep the indices
+			Unbake();	// Decode the current sources
+			_dirty = true;	// Build them with the others
+			return true;	// Return success
+		}
+
+		size_t w, h, m;		// The loaded size
+		GLuint id = LoadDds({ uri + ".dds" }, w, h, m, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_TEXTURE_2D_ARRAY, false);	// Load the pages
+		if (!id)	// If they failed...
+			return false;	// Return false as failed
+
+		glDeleteTextures(1, &_texture_id);	// Release the old pages
+		_texture_id = id;	// Use the baked ones
+		_regions = regions;		// And their table
+		_pages = 0;		// Count the pages it uses
+		for (const AtlasRegion &region : _regions)
+			_pages = std::max(_pages, (uint32_t)region._layer + 1);
+		_sources.clear();	// Decoded on demand if a sprite is added later
+		_baked = true;
+		_dirty = false;
+		return true;	// Return success
+	}
+
+	// Binds the pages to 'unit', building them first if sprites were added after BuildAll
+	inline void Bind(unsigned int unit)
+	{
+		if (_dirty)		// If they're out of date...
+			Build();	// Rebuild them
+		glActiveTexture(GL_TEXTURE0 + unit);	// Select the unit
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _texture_id);	// Bind the pages
+	}
+
+	inline const AtlasRegion& GetRegion(unsigned int index) const { return _regions[index]; }	// Return a remap entry
+	inline size_t GetRegionCount() const { return _regions.size(); }	// Return the number of sprites
+	inline uint32_t GetPageCount() const { return _pages; }		// Return the number of pages
+	inline GLuint GetTexture() const { return _texture_id; }	// Return the array texture
+
+	// Sets a region's uv rect / layer uniforms
+	inline void SetRegion(unsigned int index, GLuint u_rect, GLuint u_layer) const
+	{
+		const AtlasRegion &r = _regions[index];		// The entry
+		glUniform4f(u_rect, r._uv.x, r._uv.y, r._uv.z, r._uv.w);	// Offset / scale
+		glUniform1f(u_layer, r._layer);		// Page
+	}
+
+	// Binds a region to 'unit' for drawing. Shaders that sample the atlas (they declare the layer uniform) get the
+	// pages and the region's rect / layer; shaders still sampling a plain sampler2D get the sprite on its own, made
+	// the first time it's asked for
+	inline void Use(unsigned int index, unsigned int unit, GLint u_rect, GLint u_layer)
+	{
+		if (u_layer != -1)	// If the shader samples the pages...
+		{
+			Bind(unit);
+			SetRegion(index, u_rect, u_layer);
+			return;
+		}
+
+		if (_singles.size() < _regions.size())	// Make room for sprites added since
+			_singles.resize(_regions.size(), 0);
+		glActiveTexture(GL_TEXTURE0 + unit);	// Select the unit
+		if (!_singles[index])	// If it hasn't been needed alone before...
+		{
+			Source source;	// Its pixels
+			if (index < _sources.size() && !_sources[index].rgba.empty())	// Kept from the build
+				source = _sources[index];
+			else if (!Decode(_regions[index]._name, source))	// Or read again for baked atlases
+				source = Source{ 1, 1, std::vector<uint8_t>(4, 0) };
+
+			glGenTextures(1, &_singles[index]);
+			glBindTexture(GL_TEXTURE_2D, _singles[index]);
+			glTexImage2D(GL_TEXTURE_2D, 0, _format == TextureContainer::FORMAT_RGBA8 ? GL_RGBA8 : GL_SRGB8_ALPHA8,
+				source.width, source.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source.rgba.data());
+			glGenerateMipmap(GL_TEXTURE_2D);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			return;
+		}
+		glBindTexture(GL_TEXTURE_2D, _singles[index]);	// Bind the sprite
+	}
+};
+
+// Static definitions
+std::vector<SpriteAtlas*> SpriteAtlas::_atlases;
+
+#endif
@@ -32,13 +32,19 @@ public:
 
 		_vis = true;
 
-		_u_sel = glGetUniformLocation(shader_program, "selected");	// Get our model matrix uniform
-		_u_mod = glGetUniformLocation(shader_program, "mod");	// Get our model matrix uniform
-		_u_rig = glGetUniformLocation(shader_program, "isRigged");
+		GetUniforms(shader_program);	// Locate our uniforms
 
 		_query = new Query(GL_SAMPLES_PASSED);
 	}
 
+	// Locates the model, selection and rig uniforms (again after the shader is relinked)
+	inline virtual void GetUniforms(unsigned int shader_program)
+	{
+		_u_sel = glGetUniformLocation(shader_program, "selected");	// Get our selected uniform
+		_u_mod = glGetUniformLocation(shader_program, "mod");	// Get our model matrix uniform
+		_u_rig = glGetUniformLocation(shader_program, "isRigged");
+	}
+
 	// Virtual functions
 	inline virtual void Update(double &delta) 
 	{
@@ -0,0 +1,145 @@
+#ifndef __STREAM_BUFFER_H__
+#define __STREAM_BUFFER_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <iostream>		// Get cout
+#include <glew.h>	// Get GL
+
+#define STREAM_BUFFER_REGIONS	3		// Frames the CPU may run ahead of the GPU
+#define STREAM_BUFFER_TIMEOUT	1000000000ull	// Nanoseconds to wait on a region before reporting a stall
+
+// A vertex buffer rewritten every frame without stalling or reallocating. It is allocated once with room for
+// STREAM_BUFFER_REGIONS frames; each frame writes the next region while the GPU may still be reading the others,
+// and a fence per region makes the CPU wait only if it laps the GPU. With GL_ARB_buffer_storage the whole store is
+// mapped persistently (and coherently) at creation, so a frame's write is a plain memcpy into it. Without it (the
+// context only asks for 4.2) each frame maps just its own region unsynchronized, which the fences make safe
+class StreamBuffer
+{
+private:
+	GLuint		_buffer;	// The store
+	GLsync		_fences[STREAM_BUFFER_REGIONS];		// Signalled once the GPU is done with each region
+	uint8_t*	_mapped;	// The persistent mapping (NULL when mapping per frame)
+	uint8_t*	_writing;	// The region being written (between Begin and End)
+	uint32_t	_region_size;	// Bytes per region
+	uint32_t	_region;	// The region of the current frame
+
+	// Waits until the GPU has finished reading a region
+	inline void Wait(uint32_t region)
+	{
+		if (!_fences[region])	// If it was never drawn from...
+			return;		// Return as normal
+		GLenum result;
+		while ((result = glClientWaitSync(_fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_TIMEOUT)) == GL_TIMEOUT_EXPIRED)
+			std::cout << "StreamBuffer Error: Waited over a second on the GPU!\n";	// Print out error message
+		glDeleteSync(_fences[region]);
+		_fences[region] = 0;
+	}
+
+public:
+	inline StreamBuffer() : _buffer(0), _mapped(NULL), _writing(NULL), _region_size(0), _region(0)
+	{
+		for (uint32_t r = 0; r < STREAM_BUFFER_REGIONS; r++)
+			_fences[r] = 0;
+	}
+	inline ~StreamBuffer() { Destroy(); }
+
+	// Allocates the store with 'region_size' bytes a frame, returns false if it can't be mapped
+	inline bool Create(uint32_t region_size)
+	{
+		Destroy();
+		_region_size = (region_size + 255) & ~255u;	// Keep every region's offset aligned
+		GLsizeiptr size = (GLsizeiptr)_region_size * STREAM_BUFFER_REGIONS;
+
+		glGenBuffers(1, &_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+		if (glewIsSupported("GL_ARB_buffer_storage"))	// If the store can stay mapped...
+		{
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+			_mapped = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+			if (!_mapped)	// If it couldn't be mapped...
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+				Destroy();
+				std::cout << "StreamBuffer Error: Failed to map the buffer!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+		}
+		else
+			glBufferData(GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		_region = STREAM_BUFFER_REGIONS - 1;	// The first Begin moves to region 0
+		return true;	// Return success
+	}
+
+	// Moves to the next region and returns where to write this frame's data (NULL if it can't be written)
+	inline void* Begin()
+	{
+		if (!_buffer)	// If it was never created...
+			return NULL;
+		_region = (_region + 1) % STREAM_BUFFER_REGIONS;
+		Wait(_region);	// The GPU may still be drawing from it
+		if (_mapped)
+			_writing = _mapped + (size_t)_region * _region_size;
+		else
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+			_writing = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)_region * _region_size, _region_size,
+				GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		return _writing;	// Return it
+	}
+
+	// Finishes writing the current region (call before drawing from it)
+	inline void End()
+	{
+		if (_writing && !_mapped)	// Per frame mappings are released before the draw
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		_writing = NULL;
+	}
+
+	// Marks the current region as in use by the draws issued since End
+	inline void Fence()
+	{
+		if (_fences[_region])
+			glDeleteSync(_fences[_region]);
+		_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	// Releases the store, waiting for nothing (the GL objects outlive pending draws)
+	inline void Destroy()
+	{
+		for (uint32_t r = 0; r < STREAM_BUFFER_REGIONS; r++)
+			if (_fences[r])
+			{
+				glDeleteSync(_fences[r]);
+				_fences[r] = 0;
+			}
+		if (_buffer)
+		{
+			if (_mapped || _writing)	// Unmap before deleting
+			{
+				glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+				glUnmapBuffer(GL_ARRAY_BUFFER);
+				glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+			glDeleteBuffers(1, &_buffer);
+		}
+		_buffer = 0;
+		_mapped = _writing = NULL;
+		_region_size = _region = 0;
+	}
+
+	inline GLuint GetBuffer() const { return _buffer; }		// Return the GL buffer
+	inline uint32_t GetRegionSize() const { return _region_size; }		// Return the bytes per frame
+	inline uint32_t GetRegion() const { return _region; }	// Return the current frame's region
+	inline GLintptr GetOffset() const { return (GLintptr)_region * _region_size; }	// Return where the current region starts
+	inline bool IsPersistent() const { return _mapped != NULL; }	// Return whether the store stays mapped
+};
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef __TANGENT_SPACE_H__
+#define __TANGENT_SPACE_H__
+
+#include <vector>	// Get dynamic array
+#include <cmath>	// Get acos / sqrt
+#include <iostream>		// Get error output
+#include <glm\glm.hpp>	// Get glm variables
+#include "Parallel.h"	// Get parallel loops
+
+#define TANGENT_SPACE_GRAIN		4096	// The minimum number of triangles / vertices handed to one worker
+
+// This namespace generates per-vertex tangent frames following the MikkTSpace conventions:
+// angle weighted face contributions, projection onto each vertex normal and a bitangent sign in w.
+// Every vertex sums its own corners in triangle order, so the output is deterministic and does not
+// depend on how the work is split between threads
+namespace TangentSpace
+{
+	// The contribution of one triangle corner to its vertex
+	struct Corner
+	{
+		glm::vec3	tangent;	// Angle weighted tangent, already projected onto the vertex normal
+		glm::vec3	bitangent;	// Angle weighted bitangent, already projected onto the vertex normal
+	};
+
+	// Projects v onto the plane with normal n and normalises it (returns zero for degenerate input)
+	inline glm::vec3 ProjectNormalised(const glm::vec3 &v, const glm::vec3 &n)
+	{
+		glm::vec3 p = v - n * glm::dot(n, v);	// Remove the normal component
+		float len = glm::dot(p, p);		// Squared length
+		return len > 1e-20f ? p / std::sqrt(len) : glm::vec3(0.0f);	// Normalise if possible
+	}
+
+	// Returns any unit vector perpendicular to n (used when a vertex only touches degenerate uv triangles)
+	inline glm::vec3 AnyPerpendicular(const glm::vec3 &n)
+	{
+		glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);	// Pick the least parallel axis
+		return ProjectNormalised(axis, n);	// Project it onto the tangent plane
+	}
+
+	// This function calculates one tangent per vertex (xyz) with the bitangent sign in w.
+	// 'texcoords' and 'normals' must be indexed exactly like 'positions'. Returns false (leaving every tangent
+	// zero) if an index is out of range
+	inline bool Generate(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &texcoords, const std::vector<glm::vec3> &normals,
+		const std::vector<unsigned int> &indices, std::vector<glm::vec4> &out_tangents)
+	{
+		size_t num_vertices = positions.size();		// The vertex count
+		size_t num_triangles = indices.size() / 3;	// The triangle count
+
+		out_tangents.assign(num_vertices, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));	// One tangent per vertex
+
+		if (!num_vertices || texcoords.size() < num_vertices || normals.size() < num_vertices)	// If the attributes don't line up...
+			return true;	// Return as normal
+
+		for (size_t c = 0; c < num_triangles * 3; c++)	// Check the indices before any worker reads through them
+			if (indices[c] >= num_vertices)
+			{
+				std::cout << "TangentSpace Error: Index " << indices[c] << " is past the " << num_vertices << " vertices!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+
+		std::vector<Corner> corners(num_triangles * 3);		// The contribution of each corner
+
+		// 1. Per triangle: face tangent frame, projected and angle weighted for each of its corners
+		Parallel::For(0, num_triangles, TANGENT_SPACE_GRAIN, [&](size_t from, size_t to)
+		{
+			for (size_t t = from; t < to; t++)	// For each triangle in range...
+			{
+				const unsigned int *tri = &indices[t * 3];	// The triangle's indices
+
+				const glm::vec3 &p0 = positions[tri[0]], &p1 = positions[tri[1]], &p2 = positions[tri[2]];	// Corner positions
+				const glm::vec3 &t0 = texcoords[tri[0]], &t1 = texcoords[tri[1]], &t2 = texcoords[tri[2]];	// Corner texcoords
+
+				glm::vec3 d1 = p1 - p0;		// First edge
+				glm::vec3 d2 = p2 - p0;		// Second edge
+				float s1 = t1.x - t0.x, v1 = t1.y - t0.y;	// First uv edge
+				float s2 = t2.x - t0.x, v2 = t2.y - t0.y;	// Second uv edge
+
+				float area = s1 * v2 - s2 * v1;		// Signed uv area (x2)
+				glm::vec3 os = v2 * d1 - v1 * d2;	// Unnormalised face tangent
+				glm::vec3 ot = -s2 * d1 + s1 * d2;	// Unnormalised face bitangent
+
+				if (area < 0.0f)	// If the uv orientation is mirrored...
+				{
+					os = -os;	// Keep the tangent pointing along +u
+					ot = -ot;	// Keep the bitangent pointing along +v
+				}
+
+				for (unsigned int c = 0; c < 3; c++)	// For each corner...
+				{
+					unsigned int i = tri[c];	// Corner vertex
+					glm::vec3 e0 = positions[tri[(c + 1) % 3]] - positions[i];	// Outgoing edge
+					glm::vec3 e1 = positions[tri[(c + 2) % 3]] - positions[i];	// Incoming edge
+
+					float l0 = glm::dot(e0, e0), l1 = glm::dot(e1, e1);		// Squared edge lengths
+					float angle = 0.0f;		// Corner angle used as the weight
+					if (l0 > 1e-20f && l1 > 1e-20f)		// If the corner isn't degenerate...
+					{
+						float cos_a = glm::dot(e0, e1) / std::sqrt(l0 * l1);	// Cosine of the corner
+						angle = std::acos(cos_a < -1.0f ? -1.0f : (cos_a > 1.0f ? 1.0f : cos_a));	// Clamped angle
+					}
+
+					const glm::vec3 &n = normals[i];	// The vertex normal
+					corners[t * 3 + c].tangent = ProjectNormalised(os, n) * angle;		// Weighted tangent
+					corners[t * 3 + c].bitangent = ProjectNormalised(ot, n) * angle;	// Weighted bitangent
+				}
+			}
+		});
+
+		// 2. Build a vertex -> corner table (counting sort keeps each vertex's corners in triangle order)
+		std::vector<unsigned int> first(num_vertices + 1, 0);	// Offset of each vertex's corner list
+		for (size_t c = 0; c < corners.size(); c++)		// For each corner...
+			first[indices[c] + 1]++;	// Count it against its vertex
+		for (size_t v = 0; v < num_vertices; v++)	// For each vertex...
+			first[v + 1] += first[v];	// Prefix sum the counts
+
+		std::vector<unsigned int> fill(first.begin(), first.end() - 1);	// Running insert position per vertex
+		std::vector<unsigned int> vertex_corners(corners.size());	// Corner ids grouped by vertex
+		for (size_t c = 0; c < corners.size(); c++)		// For each corner...
+			vertex_corners[fill[indices[c]]++] = (unsigned int)c;	// Insert it
+
+		// 3. Per vertex: sum the corners, then orthogonalise against the normal once
+		Parallel::For(0, num_vertices, TANGENT_SPACE_GRAIN, [&](size_t from, size_t to)
+		{
+			for (size_t v = from; v < to; v++)	// For each vertex in range...
+			{
+				glm::vec3 t(0.0f), b(0.0f);		// Accumulated frame
+
+				for (unsigned int k = first[v]; k < first[v + 1]; k++)	// For each of its corners...
+				{
+					t += corners[vertex_corners[k]].tangent;	// Accumulate tangent
+					b += corners[vertex_corners[k]].bitangent;	// Accumulate bitangent
+				}
+
+				const glm::vec3 &n = normals[v];	// The vertex normal
+				glm::vec3 tangent = ProjectNormalised(t, n);	// Gram-Schmidt against the normal
+				if (tangent == glm::vec3(0.0f))		// If the uvs gave us nothing to work with...
+					tangent = AnyPerpendicular(n);	// Use any valid frame
+
+				float sign = glm::dot(glm::cross(n, tangent), b) < 0.0f ? -1.0f : 1.0f;	// Bitangent handedness
+				out_tangents[v] = glm::vec4(tangent, sign);		// Store the result
+			}
+		});
+		return true;	// Return success
+	}
+
+	// Convenience overload for vertex formats that only store the tangent direction
+	inline bool Generate(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &texcoords, const std::vector<glm::vec3> &normals,
+		const std::vector<unsigned int> &indices, std::vector<glm::vec3> &out_tangents)
+	{
+		std::vector<glm::vec4> tangents;	// The full tangent frame
+		bool result = Generate(positions, texcoords, normals, indices, tangents);	// Generate it
+
+		out_tangents.resize(tangents.size());	// One tangent per vertex
+		for (size_t i = 0; i < tangents.size(); i++)	// For each vertex...
+			out_tangents[i] = glm::vec3(tangents[i]);	// Drop the sign
+		return result;	// Return whether the indices were valid
+	}
+}
+
+#endif
@@ -7,8 +7,15 @@
 
 #include "Object.h"		// Get object class
 #include "DdsLoader.h"	// Get dds loader
+#include "HotReload.h"	// Reload textures when their files change
+#include "Vfs.h"	// Read images through the content archive
+#include <memory>	// Get shared_ptr for reload results
 #include <stb_image.h>
 
+#ifdef TEXTURE_COOK_ON_LOAD
+#include "TextureCooker.h"	// Cook missing sprites on first use (tools / editor builds, see LoadSprite)
+#endif
+
 #define NORMAL			0	// Texture mep index definition
 #define ALBEDO			1	// Texture mep index definition
 #define SPECROUGH		2	// Texture map index definition
@@ -48,6 +55,47 @@ namespace Texture
 		return id;	// Return single texture id
 	}
 
+	// The cooked file for a source image ("Res/x.png" -> "Res/x.dds")
+	static inline std::string CookedPath(const std::string &src)
+	{
+		size_t dot = src.find_last_of('.');		// Find the extension
+		size_t slash = src.find_last_of("/\\");	// Don't mistake a dotted folder for one
+		return (dot == std::string::npos || (slash != std::string::npos && dot < slash) ? src : src.substr(0, dot)) + ".dds";
+	}
+
+	// Loads a sprite / flipbook frame: the block compressed DDS cooked next to the source image if there is one,
+	// otherwise the source image uncompressed. Sprites are cooked offline by Tools/TextureCook.cpp (texture_cook);
+	// tools / editor builds can also define TEXTURE_COOK_ON_LOAD to cook missing files on first use
+	static inline GLuint LoadSprite(const std::string &file)
+	{
+		std::string cooked = CookedPath(file);	// The cooked file
+#ifdef TEXTURE_COOK_ON_LOAD
+		if (!Vfs::Exists(cooked))	// If it hasn't been cooked yet...
+			TextureCooker::Cook(file, cooked);	// Cook it now
+#endif
+
+		size_t w, h, m;		// The loaded size
+		GLuint id = Vfs::Exists(cooked) ? LoadDds({ cooked }, w, h, m, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, GL_TEXTURE_2D, false) : 0;	// Load it
+		if (id)		// If it loaded...
+			return id;	// Return it
+
+		VfsFile src;	// Fall back to the source image
+		int width = 0, height = 0, nr_comp = 0;		// Its size
+		unsigned char* data = Vfs::Open(file, src) ? stbi_load_from_memory(src.Data(), (int)src.Size(), &width, &height, &nr_comp, 4) : NULL;	// Decode as rgba
+
+		glGenTextures(1, &id);	// Create the texture
+		glBindTexture(GL_TEXTURE_2D, id);	// Bind it
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);	// Upload uncompressed
+
+		if (data) stbi_image_free(data);	// Free the pixels
+		else std::cout << "Texture Error: Failed to load sprite '" << file << "'!\n";	// Print out error message
+		return id;	// Return the texture
+	}
+
 	// This will be our abstract texture map class
 	struct TextureBase : public Object
 	{
@@ -63,9 +111,10 @@ namespace Texture
 		GLint		mag_filter;		// Mag filter
 		GLubyte**	data;	// Texture data
 
-							// Deconstructor
-		inline ~TextureBase()
+							// Deconstructor (virtual, the cache deletes streamed textures through the base)
+		inline virtual ~TextureBase()
 		{
+			HotReload::Unwatch(this);	// Stop watching our file
 			glDeleteTextures(1, &id);	// Delete texture object
 			if (data) delete data;	// Delete buffer data
 		}
@@ -120,10 +169,31 @@ namespace Texture
 			min_filter = min_mag_filter;	// Assign min filter
 			mag_filter = min_mag_filter;	// Assign mag filter
 
-			id = LoadDds({ static_cast<std::string>(__TEXTURE_2D_URI__) + file }, 
-				width, height, num_mips, data, 
+			std::string uri = static_cast<std::string>(__TEXTURE_2D_URI__) + file;	// The full path
+
+			id = LoadDds({ uri }, 
+				width, height, num_mips, 
 				wrap_filter, wrap_filter, 
 				GL_LINEAR_MIPMAP_LINEAR, min_mag_filter, GL_TEXTURE_2D, true);	// Load dds file and store texture data
+
+			Texture2d* texture = this;	// The texture to reload
+			HotReload::Watch(uri, this, [texture, uri]() -> HotReload::Apply
+			{
+				std::shared_ptr<TextureContainer::File> file = std::make_shared<TextureContainer::File>();	// Map and parse here
+				if (!file->Open(uri))	// If it's invalid or only partly written...
+					return HotReload::Apply();	// Skip this change
+
+				return [texture, file]()	// Upload on the main thread
+				{
+					GLuint new_id = UploadTexture({ &file->GetImage() }, texture->width, texture->height, texture->num_mips,
+						texture->wrap_s, texture->wrap_t, GL_LINEAR_MIPMAP_LINEAR, texture->mag_filter, GL_TEXTURE_2D, true);	// Upload the new texture
+					if (!new_id)	// If it failed...
+						return;		// Keep the old one
+
+					glDeleteTextures(1, &texture->id);	// Delete the old texture
+					texture->id = new_id;	// Materials bind through the texture object, so they see the new id
+				};
+			});
 		}
 
 		// Update virtual void
@@ -183,7 +253,8 @@ namespace Texture
 			int width, height, nrComponents;
 			for (unsigned int i = 0; i < faces.size(); i++)
 			{
-				unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrComponents, 0);
+				VfsFile file;	// The face image
+				unsigned char *data = Vfs::Open(faces[i], file) ? stbi_load_from_memory(file.Data(), (int)file.Size(), &width, &height, &nrComponents, 0) : NULL;
 				if (data)
 				{
 					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
@@ -204,8 +275,8 @@ namespace Texture
 			return textureID;
 		}
 
-		// generate a empty cubemap texture with no textures within it 
-		unsigned int GenerateEmptyCubemap(GLsizei width, GLsizei height, bool mipmap = false)
+		// generate a empty cubemap texture with no textures within it (needs no cubemap object)
+		static inline unsigned int GenerateEmptyCubemap(GLsizei width, GLsizei height, bool mipmap = false)
 		{
 			unsigned int textureID;
 
@@ -241,7 +312,7 @@ namespace Texture
 			min_filter = GL_LINEAR_MIPMAP_LINEAR;		// Assign min filter
 			mag_filter = GL_LINEAR;		// Assign mag filter
 
-			id = loadCubemap(files);// LoadDds(files, width, height, num_mips, 0, wrap_s, wrap_t, min_filter, mag_filter, GL_TEXTURE_CUBE_MAP, true);	// Load dds files and store texture data
+			id = loadCubemap(files);// LoadDds(files, width, height, num_mips, wrap_s, wrap_t, min_filter, mag_filter, GL_TEXTURE_CUBE_MAP, true);	// Load dds files and store texture data
 		}
 
 		// Update virtual void
@@ -265,7 +336,8 @@ namespace Texture
 			int img_height;
 			int num_components;
 
-			float * img_data = stbi_loadf(file, &img_width, &img_height, &num_components, 0);
+			VfsFile hdr;	// The image file
+			float * img_data = Vfs::Open(file, hdr) ? stbi_loadf_from_memory(hdr.Data(), (int)hdr.Size(), &img_width, &img_height, &num_components, 0) : NULL;
 
 			if (img_data)
 			{
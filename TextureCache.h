@@ -9,6 +9,7 @@
 #include <assert.h>
 #include <map>
 #include "Content.h"
+#include "TextureStreamer.h"
 #include "dirent.h"
 
 #define MAT_EXTENSION ((char*)"_mat.mat")
@@ -51,11 +52,12 @@ public:
 		{
 			std::cout << "texture loaded : file" << "\n" << std::endl;
 
-			Content::_textures.push_back(new Texture2d({ file + "_n.dds" }, NORMAL, GL_REPEAT, GL_LINEAR));	// Push back default texture normal
-			Content::_textures.push_back(new Texture2d({ file + "_a.dds" }, ALBEDO, GL_REPEAT, GL_LINEAR));	// Push back default texture albedo
-			Content::_textures.push_back(new Texture2d({ file + "_sr.dds" }, SPECROUGH, GL_REPEAT, GL_LINEAR));	// Push back default texture spec
-			Content::_textures.push_back(new Texture2d({ file + "_m.dds" }, METALIC, GL_REPEAT, GL_LINEAR));	// Push back default texture metalic
-			Content::_textures.push_back(new Texture2d({ file + "_e.dds" }, EMISSIVE, GL_REPEAT, GL_LINEAR));	// Push back default texture metalic
+			// Only the small mips are loaded here, the rest stream in as the material is drawn larger
+			Content::_textures.push_back(new StreamedTexture({ file + "_n.dds" }, NORMAL, GL_REPEAT, GL_LINEAR));	// Push back default texture normal
+			Content::_textures.push_back(new StreamedTexture({ file + "_a.dds" }, ALBEDO, GL_REPEAT, GL_LINEAR));	// Push back default texture albedo
+			Content::_textures.push_back(new StreamedTexture({ file + "_sr.dds" }, SPECROUGH, GL_REPEAT, GL_LINEAR));	// Push back default texture spec
+			Content::_textures.push_back(new StreamedTexture({ file + "_m.dds" }, METALIC, GL_REPEAT, GL_LINEAR));	// Push back default texture metalic
+			Content::_textures.push_back(new StreamedTexture({ file + "_e.dds" }, EMISSIVE, GL_REPEAT, GL_LINEAR));	// Push back default texture metalic
 
 			Content::_materials.push_back(new Material(shader_program, file + static_cast<std::string>(MAT_EXTENSION),
 				{ Content::_textures[ids[0]], Content::_textures[ids[1]], Content::_textures[ids[2]], Content::_textures[ids[3]], Content::_textures[ids[4]] }));
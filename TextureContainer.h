@@ -0,0 +1,454 @@
+#ifndef __TEXTURE_CONTAINER_H__
+#define __TEXTURE_CONTAINER_H__
+
+#include <iostream>		// Get error output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <cstring>	// Get memcmp / memcpy
+#include <cstdint>	// Get fixed size integers
+#include "Vfs.h"	// Map the file
+
+// Pure CPU parsing of DDS (legacy and DX10 headers) and KTX2 texture containers. Nothing here touches GL:
+// parsing only validates the layout and records where every mip / face / array layer lives in the file,
+// so it runs on any thread and the pixel data is never copied. Uploading is done separately (see DdsLoader.h)
+namespace TextureContainer
+{
+	// The pixel formats we understand
+	enum Format
+	{
+		FORMAT_UNKNOWN,
+		FORMAT_BC1, FORMAT_BC1_SRGB,	// DXT1
+		FORMAT_BC2, FORMAT_BC2_SRGB,	// DXT3
+		FORMAT_BC3, FORMAT_BC3_SRGB,	// DXT5
+		FORMAT_BC4, FORMAT_BC4_SNORM,	// ATI1 / RGTC1
+		FORMAT_BC5, FORMAT_BC5_SNORM,	// ATI2 / RGTC2
+		FORMAT_BC6H_UF16, FORMAT_BC6H_SF16,		// BPTC float
+		FORMAT_BC7, FORMAT_BC7_SRGB,	// BPTC
+		FORMAT_RGBA8, FORMAT_RGBA8_SRGB,	// 8 bit uncompressed
+		FORMAT_BGRA8, FORMAT_BGRA8_SRGB,	// 8 bit uncompressed, swizzled
+		FORMAT_RGBX8, FORMAT_BGRX8, FORMAT_BGRX8_SRGB,	// 8 bit uncompressed, the fourth byte is unused (alpha is 1)
+		FORMAT_RGBA16F,		// Half float
+		FORMAT_RGBA32F,		// Float
+		NUM_FORMATS
+	};
+
+	// The storage layout of a format
+	struct FormatInfo
+	{
+		const char*		name;	// Readable name
+		uint32_t		block_bytes;	// Bytes per block (or per pixel)
+		uint32_t		block_dim;	// Block width / height in pixels (4 for BCn, 1 for uncompressed)
+	};
+
+	// Returns the layout of a format
+	inline const FormatInfo& GetFormatInfo(Format f)
+	{
+		static const FormatInfo info[NUM_FORMATS] =
+		{
+			{ "unknown", 0, 1 },
+			{ "BC1", 8, 4 }, { "BC1_SRGB", 8, 4 },
+			{ "BC2", 16, 4 }, { "BC2_SRGB", 16, 4 },
+			{ "BC3", 16, 4 }, { "BC3_SRGB", 16, 4 },
+			{ "BC4", 8, 4 }, { "BC4_SNORM", 8, 4 },
+			{ "BC5", 16, 4 }, { "BC5_SNORM", 16, 4 },
+			{ "BC6H_UF16", 16, 4 }, { "BC6H_SF16", 16, 4 },
+			{ "BC7", 16, 4 }, { "BC7_SRGB", 16, 4 },
+			{ "RGBA8", 4, 1 }, { "RGBA8_SRGB", 4, 1 },
+			{ "BGRA8", 4, 1 }, { "BGRA8_SRGB", 4, 1 },
+			{ "RGBX8", 4, 1 }, { "BGRX8", 4, 1 }, { "BGRX8_SRGB", 4, 1 },
+			{ "RGBA16F", 8, 1 },
+			{ "RGBA32F", 16, 1 }
+		};
+		return info[f < NUM_FORMATS ? f : FORMAT_UNKNOWN];	// Return the entry
+	}
+
+	inline bool IsCompressed(Format f) { return GetFormatInfo(f).block_dim > 1; }	// Return whether a format is block compressed
+
+	// The row pitch of one mip level
+	inline size_t RowPitch(Format f, uint32_t width)
+	{
+		const FormatInfo &fi = GetFormatInfo(f);	// The layout
+		return (size_t)((width + fi.block_dim - 1) / fi.block_dim) * fi.block_bytes;	// Whole blocks per row
+	}
+
+	// The size of one mip level of one face / layer
+	inline size_t ImageSize(Format f, uint32_t width, uint32_t height)
+	{
+		const FormatInfo &fi = GetFormatInfo(f);	// The layout
+		return RowPitch(f, width) * ((height + fi.block_dim - 1) / fi.block_dim);	// Whole block rows
+	}
+
+	// The largest mip count a size can have
+	inline uint32_t MaxMips(uint32_t width, uint32_t height)
+	{
+		uint32_t mips = 1;	// The top level
+		for (uint32_t size = width > height ? width : height; size > 1; size >>= 1)	// Halve until 1x1
+			mips++;
+		return mips;	// Return the count
+	}
+
+	// A view of one mip of one face of one array layer (points into the file, valid while it's open)
+	struct Subresource
+	{
+		const unsigned char*	data;	// The first byte
+		size_t					size;	// The size in bytes
+		size_t					row_pitch;	// Bytes per row of pixels / blocks
+		uint32_t				width;	// Width in pixels
+		uint32_t				height;		// Height in pixels
+	};
+
+	// A parsed texture
+	struct Image
+	{
+		Format						format;		// Pixel format
+		uint32_t					width;	// Top level width
+		uint32_t					height;		// Top level height
+		uint32_t					mips;	// Mip levels
+		uint32_t					layers;		// Array layers (1 for plain textures)
+		uint32_t					faces;	// 6 for cubemaps, otherwise 1
+		std::vector<Subresource>	subresources;	// Layer major, then face, then mip
+
+		inline Image() : format(FORMAT_UNKNOWN), width(0), height(0), mips(0), layers(0), faces(0) {}
+
+		// Returns a subresource
+		inline const Subresource& Get(uint32_t mip, uint32_t layer = 0, uint32_t face = 0) const
+		{
+			return subresources[((size_t)layer * faces + face) * mips + mip];	// Return the view
+		}
+
+		inline bool IsCubemap() const { return faces == 6; }	// Return whether it's a cubemap
+	};
+
+	// Reads a little endian value from an unaligned position
+	template <typename T> inline T Read(const unsigned char* at)
+	{
+		T value;	// The result
+		std::memcpy(&value, at, sizeof(T));		// Copy it out
+		return value;	// Return it
+	}
+
+	// Fills in the subresource table for data stored layer by layer, face by face, mip by mip (the dds order)
+	inline bool LayoutSequential(const unsigned char* data, size_t size, size_t offset, Image &out)
+	{
+		out.subresources.clear();	// Fresh table
+		out.subresources.reserve((size_t)out.layers * out.faces * out.mips);	// One entry per subresource
+
+		for (uint32_t l = 0; l < out.layers; l++)	// For each layer...
+			for (uint32_t f = 0; f < out.faces; f++)	// For each face...
+				for (uint32_t m = 0; m < out.mips; m++)		// For each mip...
+				{
+					Subresource s;	// The view
+					s.width = out.width >> m ? out.width >> m : 1;	// Assign width
+					s.height = out.height >> m ? out.height >> m : 1;	// Assign height
+					s.row_pitch = RowPitch(out.format, s.width);	// Assign pitch
+					s.size = ImageSize(out.format, s.width, s.height);	// Assign size
+					if (offset + s.size > size)		// If the file is too short...
+						return false;	// Return false as failed
+					s.data = data + offset;		// Point into the file
+					offset += s.size;	// Advance
+					out.subresources.push_back(s);	// Store it
+				}
+
+		return true;	// Return success
+	}
+
+	// Maps a DXGI_FORMAT to ours
+	inline Format FromDxgi(uint32_t dxgi)
+	{
+		switch (dxgi)
+		{
+		case 70: case 71: return FORMAT_BC1;	// BC1_TYPELESS / UNORM
+		case 72: return FORMAT_BC1_SRGB;
+		case 73: case 74: return FORMAT_BC2;
+		case 75: return FORMAT_BC2_SRGB;
+		case 76: case 77: return FORMAT_BC3;
+		case 78: return FORMAT_BC3_SRGB;
+		case 79: case 80: return FORMAT_BC4;
+		case 81: return FORMAT_BC4_SNORM;
+		case 82: case 83: return FORMAT_BC5;
+		case 84: return FORMAT_BC5_SNORM;
+		case 94: case 95: return FORMAT_BC6H_UF16;
+		case 96: return FORMAT_BC6H_SF16;
+		case 97: case 98: return FORMAT_BC7;
+		case 99: return FORMAT_BC7_SRGB;
+		case 27: case 28: return FORMAT_RGBA8;	// R8G8B8A8_TYPELESS / UNORM
+		case 29: return FORMAT_RGBA8_SRGB;
+		case 87: case 90: return FORMAT_BGRA8;	// B8G8R8A8_UNORM / TYPELESS
+		case 91: return FORMAT_BGRA8_SRGB;
+		case 88: case 92: return FORMAT_BGRX8;	// B8G8R8X8_UNORM / TYPELESS
+		case 93: return FORMAT_BGRX8_SRGB;
+		case 10: return FORMAT_RGBA16F;		// R16G16B16A16_FLOAT
+		case 2: return FORMAT_RGBA32F;	// R32G32B32A32_FLOAT
+		default: return FORMAT_UNKNOWN;
+		}
+	}
+
+	// Maps a VkFormat to ours
+	inline Format FromVk(uint32_t vk)
+	{
+		switch (vk)
+		{
+		case 131: case 133: return FORMAT_BC1;	// BC1_RGB / RGBA_UNORM_BLOCK
+		case 132: case 134: return FORMAT_BC1_SRGB;
+		case 135: return FORMAT_BC2;
+		case 136: return FORMAT_BC2_SRGB;
+		case 137: return FORMAT_BC3;
+		case 138: return FORMAT_BC3_SRGB;
+		case 139: return FORMAT_BC4;
+		case 140: return FORMAT_BC4_SNORM;
+		case 141: return FORMAT_BC5;
+		case 142: return FORMAT_BC5_SNORM;
+		case 143: return FORMAT_BC6H_UF16;
+		case 144: return FORMAT_BC6H_SF16;
+		case 145: return FORMAT_BC7;
+		case 146: return FORMAT_BC7_SRGB;
+		case 37: return FORMAT_RGBA8;	// R8G8B8A8_UNORM
+		case 43: return FORMAT_RGBA8_SRGB;
+		case 44: return FORMAT_BGRA8;	// B8G8R8A8_UNORM
+		case 50: return FORMAT_BGRA8_SRGB;
+		case 97: return FORMAT_RGBA16F;		// R16G16B16A16_SFLOAT
+		case 109: return FORMAT_RGBA32F;	// R32G32B32A32_SFLOAT
+		default: return FORMAT_UNKNOWN;
+		}
+	}
+
+	// Checks the size fields shared by both containers
+	inline bool ValidateSize(const Image &image, std::string &error)
+	{
+		error.clear();	// No problems yet
+		if (!image.width || !image.height)	// If it's empty...
+			error = "zero size";
+		else if (image.width > 16384 || image.height > 16384 || image.layers > 2048)	// If it's unreasonable...
+			error = "size out of range";
+		else if (image.mips > MaxMips(image.width, image.height))	// If the chain is too long...
+			error = "mip chain longer than the size allows";
+		else if (image.IsCubemap() && image.width != image.height)	// If the faces aren't square...
+			error = "cubemap faces aren't square";
+		else if (image.format == FORMAT_UNKNOWN)	// If we can't read the pixels...
+			error = "unsupported pixel format";
+		return error.empty();	// Return whether it passed
+	}
+
+	// Parses a dds file (legacy and DX10 headers)
+	inline bool ParseDds(const unsigned char* data, size_t size, Image &out, std::string &error)
+	{
+		if (size < 128 || std::memcmp(data, "DDS ", 4) != 0 || Read<uint32_t>(data + 4) != 124 || Read<uint32_t>(data + 76) != 32)	// If the header is missing...
+		{
+			error = "not a dds file";
+			return false;	// Return false as failed
+		}
+
+		uint32_t flags = Read<uint32_t>(data + 8);	// DDSD_ flags
+		uint32_t pf_flags = Read<uint32_t>(data + 80);	// DDPF_ flags
+		uint32_t fourcc = Read<uint32_t>(data + 84);	// Compression code
+		uint32_t caps2 = Read<uint32_t>(data + 112);	// Cubemap / volume caps
+		size_t offset = 128;	// Start of the pixels
+
+		out.height = Read<uint32_t>(data + 12);		// Assign height
+		out.width = Read<uint32_t>(data + 16);	// Assign width
+		out.mips = (flags & 0x20000) ? Read<uint32_t>(data + 28) : 1;	// DDSD_MIPMAPCOUNT
+		if (!out.mips) out.mips = 1;	// Some writers store 0 for "just the top level"
+		out.layers = 1;		// Not an array
+		out.faces = 1;	// Not a cubemap
+		out.format = FORMAT_UNKNOWN;	// Resolved below
+
+		if ((caps2 & 0x200000) || ((flags & 0x800000) && Read<uint32_t>(data + 24) > 1))	// If it's a volume texture...
+		{
+			error = "volume textures aren't supported";
+			return false;	// Return false as failed
+		}
+
+		if (caps2 & 0x200)	// DDSCAPS2_CUBEMAP
+		{
+			if ((caps2 & 0xFC00) != 0xFC00)		// If some faces are missing...
+			{
+				error = "partial cubemaps aren't supported";
+				return false;	// Return false as failed
+			}
+			out.faces = 6;	// All six faces
+		}
+
+		if ((pf_flags & 0x4) && fourcc == 0x30315844)	// "DX10"
+		{
+			if (size < 148)		// If the extended header is missing...
+			{
+				error = "truncated DX10 header";
+				return false;	// Return false as failed
+			}
+
+			out.format = FromDxgi(Read<uint32_t>(data + 128));		// DXGI format
+			uint32_t dimension = Read<uint32_t>(data + 132);	// Resource dimension
+			uint32_t misc = Read<uint32_t>(data + 136);		// Misc flags
+			uint32_t array_size = Read<uint32_t>(data + 140);	// Array size
+			offset = 148;	// Pixels follow the extended header
+
+			if (dimension != 3)		// D3D10_RESOURCE_DIMENSION_TEXTURE2D
+			{
+				error = "only 2d textures are supported";
+				return false;	// Return false as failed
+			}
+
+			out.layers = array_size ? array_size : 1;	// Assign layers
+			out.faces = (misc & 0x4) ? 6 : 1;	// RESOURCE_MISC_TEXTURECUBE
+		}
+		else if (pf_flags & 0x4)	// DDPF_FOURCC
+		{
+			switch (fourcc)
+			{
+			case 0x31545844: out.format = FORMAT_BC1; break;	// "DXT1"
+			case 0x32545844: case 0x33545844: out.format = FORMAT_BC2; break;	// "DXT2" / "DXT3"
+			case 0x34545844: case 0x35545844: out.format = FORMAT_BC3; break;	// "DXT4" / "DXT5"
+			case 0x31495441: case 0x55344342: out.format = FORMAT_BC4; break;	// "ATI1" / "BC4U"
+			case 0x53344342: out.format = FORMAT_BC4_SNORM; break;	// "BC4S"
+			case 0x32495441: case 0x55354342: out.format = FORMAT_BC5; break;	// "ATI2" / "BC5U"
+			case 0x53354342: out.format = FORMAT_BC5_SNORM; break;	// "BC5S"
+			case 113: out.format = FORMAT_RGBA16F; break;	// D3DFMT_A16B16G16R16F
+			case 116: out.format = FORMAT_RGBA32F; break;	// D3DFMT_A32B32G32R32F
+			}
+		}
+		else if ((pf_flags & 0x40) && Read<uint32_t>(data + 88) == 32)	// DDPF_RGB at 32 bits
+		{
+			uint32_t r_mask = Read<uint32_t>(data + 92);	// Red channel mask
+			bool alpha = (pf_flags & 0x1) && Read<uint32_t>(data + 104) != 0;		// DDPF_ALPHAPIXELS with an alpha mask (X8R8G8B8 has neither)
+			if (r_mask == 0x000000FF) out.format = alpha ? FORMAT_RGBA8 : FORMAT_RGBX8;	// Red in the low byte
+			else if (r_mask == 0x00FF0000) out.format = alpha ? FORMAT_BGRA8 : FORMAT_BGRX8;	// Red in the third byte
+		}
+
+		if (!ValidateSize(out, error))	// If the sizes are broken...
+			return false;	// Return false as failed
+
+		if (!LayoutSequential(data, size, offset, out))		// If the chain doesn't fit in the file...
+		{
+			error = "file is shorter than its mip chain";
+			return false;	// Return false as failed
+		}
+
+		return true;	// Return success
+	}
+
+	// Parses a KTX2 file (supercompressed files aren't supported)
+	inline bool ParseKtx2(const unsigned char* data, size_t size, Image &out, std::string &error)
+	{
+		static const unsigned char identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };	// The file code
+
+		if (size < 80 || std::memcmp(data, identifier, 12) != 0)	// If the header is missing...
+		{
+			error = "not a ktx2 file";
+			return false;	// Return false as failed
+		}
+
+		out.format = FromVk(Read<uint32_t>(data + 12));		// vkFormat
+		out.width = Read<uint32_t>(data + 20);	// pixelWidth
+		out.height = Read<uint32_t>(data + 24);		// pixelHeight
+		uint32_t depth = Read<uint32_t>(data + 28);		// pixelDepth
+		out.layers = Read<uint32_t>(data + 32);		// layerCount
+		out.faces = Read<uint32_t>(data + 36);	// faceCount
+		out.mips = Read<uint32_t>(data + 40);	// levelCount
+		uint32_t supercompression = Read<uint32_t>(data + 44);	// supercompressionScheme
+
+		if (supercompression != 0)	// If the levels are zstd / basis compressed...
+		{
+			error = "supercompressed ktx2 isn't supported";
+			return false;	// Return false as failed
+		}
+		if (depth > 1)	// If it's a volume texture...
+		{
+			error = "volume textures aren't supported";
+			return false;	// Return false as failed
+		}
+		if (out.faces != 1 && out.faces != 6)	// If the face count is invalid...
+		{
+			error = "face count must be 1 or 6";
+			return false;	// Return false as failed
+		}
+
+		if (!out.layers) out.layers = 1;	// 0 means not an array
+		if (!out.mips) out.mips = 1;	// 0 means "generate mips on load"
+
+		if (!ValidateSize(out, error))	// If the sizes are broken...
+			return false;	// Return false as failed
+		if (80 + (size_t)out.mips * 24 > size)	// If the level index is cut off...
+		{
+			error = "truncated level index";
+			return false;	// Return false as failed
+		}
+
+		out.subresources.assign((size_t)out.layers * out.faces * out.mips, Subresource());	// One entry per subresource
+
+		for (uint32_t m = 0; m < out.mips; m++)		// For each level...
+		{
+			const unsigned char* level = data + 80 + m * 24;	// Its index entry
+			uint64_t offset = Read<uint64_t>(level);	// byteOffset
+			uint64_t length = Read<uint64_t>(level + 8);	// byteLength
+
+			uint32_t w = out.width >> m ? out.width >> m : 1;	// Level width
+			uint32_t h = out.height >> m ? out.height >> m : 1;		// Level height
+			size_t image = ImageSize(out.format, w, h);		// One face of one layer
+			if (length != (uint64_t)image * out.layers * out.faces || offset > size || length > size - offset)	// If the level is broken...
+			{
+				error = "level " + std::to_string(m) + " doesn't match its size";
+				return false;	// Return false as failed
+			}
+
+			for (uint32_t l = 0; l < out.layers; l++)	// For each layer...
+				for (uint32_t f = 0; f < out.faces; f++)	// For each face...
+				{
+					Subresource &s = out.subresources[((size_t)l * out.faces + f) * out.mips + m];	// The view
+					s.width = w;	// Assign width
+					s.height = h;	// Assign height
+					s.row_pitch = RowPitch(out.format, w);	// Assign pitch
+					s.size = image;		// Assign size
+					s.data = data + offset + ((size_t)l * out.faces + f) * image;	// Levels hold every layer and face
+				}
+		}
+
+		return true;	// Return success
+	}
+
+	// Parses either container, picked by its file code
+	inline bool Parse(const unsigned char* data, size_t size, Image &out, std::string &error)
+	{
+		if (size >= 4 && std::memcmp(data, "DDS ", 4) == 0)		// If it's a dds...
+			return ParseDds(data, size, out, error);	// Parse it
+		if (size >= 1 && data[0] == 0xAB)	// If it could be a ktx...
+			return ParseKtx2(data, size, out, error);	// Parse it
+		error = "unknown container";
+		return false;	// Return false as failed
+	}
+
+	// An opened texture file: the mapped bytes plus the parsed layout pointing into them
+	class File
+	{
+	private:
+		VfsFile		_file;	// The mapped file
+		Image		_image;		// The parsed layout
+
+	public:
+		// Maps and parses 'uri', safe on any thread
+		inline bool Open(const std::string &uri)
+		{
+			_image = Image();	// Forget the previous layout
+			if (!Vfs::Open(uri, _file))		// If it can't be opened...
+			{
+				std::cout << "Texture Error: Failed to open '" << uri << "'!\n";	// Print out error message
+				return false;	// Return false as failed
+			}
+
+			std::string error;	// The reason it failed
+			if (!Parse(_file.Data(), _file.Size(), _image, error))	// If it's invalid...
+			{
+				std::cout << "Texture Error: '" << uri << "': " << error << "!\n";	// Print out error message
+				_file.Close();	// Release it
+				return false;	// Return false as failed
+			}
+
+			return true;	// Return success
+		}
+
+		inline void Close() { _file.Close(); _image = Image(); }	// Release the file
+		inline bool IsOpen() const { return _file.IsOpen(); }	// Return whether a file is open
+		inline const Image& GetImage() const { return _image; }		// Return the layout
+	};
+}
+
+#endif
@@ -0,0 +1,365 @@
+#ifndef __TEXTURE_COOKER_H__
+#define __TEXTURE_COOKER_H__
+
+#include <iostream>		// Get error / report output
+#include <fstream>	// Get file output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <cmath>	// Get pow / sin / sqrt
+#include <stb_image.h>	// Decode source images
+#include "Vfs.h"	// Read source images
+#include "Parallel.h"	// Filter rows in parallel
+#include "BlockCompression.h"	// Get the encoders
+#include "TextureContainer.h"	// Get formats / sizes
+
+#define TEXTURE_COOK_KAISER_ALPHA	4.0f	// Kaiser window shape (higher is smoother, less ringing)
+#define TEXTURE_COOK_KAISER_WIDTH	3.0f	// Filter radius in destination pixels
+
+// The offline half of the sprite / flipbook pipeline: decodes a source image, builds a gamma correct mip chain
+// with a Kaiser windowed sinc filter (on premultiplied alpha), block compresses every level in parallel and writes
+// a DDS (DX10 header) that the runtime loads with LoadDds. The PSNR of every texture is reported so quality
+// regressions are visible. Tools/TextureCook.cpp (texture_cook) runs it over source images
+namespace TextureCooker
+{
+	// Cook settings for one texture
+	struct Settings
+	{
+		TextureContainer::Format	format;		// BC1 / BC3 / BC5 (sRGB variants filter in linear space)
+		bool						wrap;	// Whether the filter wraps at the edges (tiling textures)
+
+		inline Settings() : format(TextureContainer::FORMAT_BC3_SRGB), wrap(false) {}
+	};
+
+	// An rgba float image
+	struct Image
+	{
+		uint32_t			width;	// Width in pixels
+		uint32_t			height;		// Height in pixels
+		std::vector<float>	pixels;		// rgba, row major
+	};
+
+	// Whether a format stores srgb colour
+	inline bool IsSrgb(TextureContainer::Format f)
+	{
+		return f == TextureContainer::FORMAT_BC1_SRGB || f == TextureContainer::FORMAT_BC3_SRGB;	// Return the result
+	}
+
+	// sRGB -> linear for an 8 bit value
+	inline float ToLinear(uint8_t v)
+	{
+		static const std::vector<float> table = []()	// Built once, thread safe
+		{
+			std::vector<float> t(256);	// One entry per value
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.0f;	// Normalise
+				t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return t;
+		}();
+		return table[v];	// Return the conversion
+	}
+
+	// linear -> sRGB, rounded to 8 bits
+	inline uint8_t ToSrgb(float c)
+	{
+		c = std::min(1.0f, std::max(0.0f, c));	// Clamp the filter overshoot
+		float s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;	// Encode
+		return (uint8_t)(s * 255.0f + 0.5f);	// Round
+	}
+
+	// Modified Bessel function of the first kind, order 0 (for the Kaiser window)
+	inline float BesselI0(float x)
+	{
+		float sum = 1.0f, term = 1.0f;	// Series sum / current term
+		for (int k = 1; k < 32; k++)	// Converges quickly for the alphas we use
+		{
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+			if (term < sum * 1e-8f)
+				break;
+		}
+		return sum;		// Return the sum
+	}
+
+	// Kaiser windowed sinc filter weight at distance 'x' (destination pixels)
+	inline float Kaiser(float x)
+	{
+		float t = x / TEXTURE_COOK_KAISER_WIDTH;	// Position in the window
+		if (t <= -1.0f || t >= 1.0f)	// If it's outside...
+			return 0.0f;	// No contribution
+		float sinc = x == 0.0f ? 1.0f : std::sin(3.14159265f * x) / (3.14159265f * x);	// Low pass at the destination Nyquist
+		return sinc * BesselI0(TEXTURE_COOK_KAISER_ALPHA * std::sqrt(1.0f - t * t)) / BesselI0(TEXTURE_COOK_KAISER_ALPHA);
+	}
+
+	// Precomputed taps for resampling one axis
+	struct Taps
+	{
+		std::vector<int>	first;	// First source pixel per destination pixel
+		std::vector<int>	count;	// Tap count per destination pixel
+		std::vector<float>	weights;	// Normalised weights, 'stride' per destination pixel
+		int					stride;		// Maximum taps
+	};
+
+	// Builds the taps that shrink 'src' pixels to 'dst' pixels
+	inline Taps BuildTaps(uint32_t src, uint32_t dst)
+	{
+		Taps taps;	// The result
+		float scale = (float)src / (float)dst;	// Source pixels per destination pixel
+		float radius = TEXTURE_COOK_KAISER_WIDTH * scale;	// Support in source pixels
+		taps.stride = (int)std::ceil(radius * 2.0f) + 1;	// Enough for any phase
+		taps.first.resize(dst);
+		taps.count.resize(dst);
+		taps.weights.assign((size_t)dst * taps.stride, 0.0f);
+
+		for (uint32_t d = 0; d < dst; d++)	// For each destination pixel...
+		{
+			float centre = (d + 0.5f) * scale;	// Its centre in source space
+			int first = (int)std::floor(centre - radius);	// First source pixel that could contribute
+			int last = (int)std::ceil(centre + radius);		// Last one
+			int count = std::min(last - first, taps.stride);	// Taps used
+
+			float total = 0.0f;		// For normalising
+			for (int k = 0; k < count; k++)		// For each tap...
+			{
+				float w = Kaiser(((first + k) + 0.5f - centre) / scale);	// Distance in destination pixels
+				taps.weights[d * taps.stride + k] = w;
+				total += w;
+			}
+			for (int k = 0; k < count; k++)		// Normalise so flat areas stay flat
+				taps.weights[d * taps.stride + k] /= total;
+
+			taps.first[d] = first;
+			taps.count[d] = count;
+		}
+
+		return taps;	// Return the taps
+	}
+
+	// Maps a source coordinate into the image
+	inline int Address(int x, int size, bool wrap)
+	{
+		if (wrap)	// If it tiles...
+			return ((x % size) + size) % size;	// Wrap around
+		return std::min(size - 1, std::max(0, x));	// Otherwise clamp
+	}
+
+	// Halves an image (separable Kaiser filter, rows then columns, both in parallel)
+	inline Image Downsample(const Image &src, bool wrap)
+	{
+		Image dst;	// The result
+		dst.width = std::max(1u, src.width / 2);	// Half width
+		dst.height = std::max(1u, src.height / 2);	// Half height
+
+		Taps tx = BuildTaps(src.width, dst.width);	// Horizontal taps
+		Taps ty = BuildTaps(src.height, dst.height);	// Vertical taps
+
+		std::vector<float> rows((size_t)dst.width * src.height * 4);	// Horizontally filtered
+		Parallel::For(0, src.height, 16, [&](size_t from, size_t to)
+		{
+			for (size_t y = from; y < to; y++)	// For each source row...
+				for (uint32_t x = 0; x < dst.width; x++)	// For each destination column...
+				{
+					float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };	// The filtered pixel
+					for (int k = 0; k < tx.count[x]; k++)	// For each tap...
+					{
+						const float* p = &src.pixels[((size_t)y * src.width + Address(tx.first[x] + k, src.width, wrap)) * 4];
+						float w = tx.weights[x * tx.stride + k];
+						for (int c = 0; c < 4; c++) sum[c] += p[c] * w;
+					}
+					std::memcpy(&rows[((size_t)y * dst.width + x) * 4], sum, sizeof(sum));
+				}
+		});
+
+		dst.pixels.resize((size_t)dst.width * dst.height * 4);	// Vertically filtered
+		Parallel::For(0, dst.height, 16, [&](size_t from, size_t to)
+		{
+			for (size_t y = from; y < to; y++)	// For each destination row...
+				for (uint32_t x = 0; x < dst.width; x++)	// For each column...
+				{
+					float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };	// The filtered pixel
+					for (int k = 0; k < ty.count[y]; k++)	// For each tap...
+					{
+						const float* p = &rows[((size_t)Address(ty.first[y] + k, src.height, wrap) * dst.width + x) * 4];
+						float w = ty.weights[y * ty.stride + k];
+						for (int c = 0; c < 4; c++) sum[c] += p[c] * w;
+					}
+					std::memcpy(&dst.pixels[((size_t)y * dst.width + x) * 4], sum, sizeof(sum));
+				}
+		});
+
+		return dst;		// Return the result
+	}
+
+	// Whether a format's alpha is coverage, so its colour is filtered premultiplied (BC5 stores two data channels)
+	inline bool HasAlpha(TextureContainer::Format f)
+	{
+		return f != TextureContainer::FORMAT_BC5 && f != TextureContainer::FORMAT_BC5_SNORM;	// Return the result
+	}
+
+	// Scales colour by alpha so the filter weighs every texel by its coverage, otherwise the colour of transparent
+	// texels bleeds into the edges of the mips
+	inline void Premultiply(Image &image)
+	{
+		for (size_t i = 0; i < image.pixels.size(); i += 4)		// For each pixel...
+			for (int c = 0; c < 3; c++)		// For each colour channel...
+				image.pixels[i + c] *= image.pixels[i + 3];		// Scale it
+	}
+
+	// Undoes Premultiply for storage (sprites are blended with straight alpha). Texels whose alpha rounds to 0
+	// are left black rather than dividing the filter's ringing by almost nothing
+	inline Image Unpremultiply(const Image &image)
+	{
+		Image straight = image;		// The result
+		for (size_t i = 0; i < straight.pixels.size(); i += 4)	// For each pixel...
+		{
+			float a = straight.pixels[i + 3];	// Its coverage
+			for (int c = 0; c < 3; c++)		// For each colour channel...
+				straight.pixels[i + c] = a >= 0.5f / 255.0f ? straight.pixels[i + c] / a : 0.0f;	// Restore it
+		}
+		return straight;	// Return the result
+	}
+
+	// Converts 8 bit rgba to float, linearising colour for srgb formats
+	inline Image ToFloat(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb)
+	{
+		Image image;	// The result
+		image.width = width;	// Assign width
+		image.height = height;	// Assign height
+		image.pixels.resize((size_t)width * height * 4);	// Make room
+		for (size_t i = 0; i < (size_t)width * height; i++)		// For each pixel...
+			for (int c = 0; c < 4; c++)		// For each channel...
+				image.pixels[i * 4 + c] = (srgb && c < 3) ? ToLinear(rgba[i * 4 + c]) : rgba[i * 4 + c] / 255.0f;
+		return image;	// Return the result
+	}
+
+	// Converts float back to 8 bit rgba
+	inline void ToBytes(const Image &image, bool srgb, std::vector<uint8_t> &rgba)
+	{
+		rgba.resize((size_t)image.width * image.height * 4);	// Make room
+		for (size_t i = 0; i < rgba.size(); i++)	// For each value...
+		{
+			float v = image.pixels[i];	// The value
+			rgba[i] = (srgb && (i & 3) != 3) ? ToSrgb(v) : (uint8_t)(std::min(1.0f, std::max(0.0f, v)) * 255.0f + 0.5f);
+		}
+	}
+
+	// Maps a format to its DXGI code for the DX10 header
+	inline uint32_t ToDxgi(TextureContainer::Format f)
+	{
+		switch (f)
+		{
+		case TextureContainer::FORMAT_BC1: return 71;
+		case TextureContainer::FORMAT_BC1_SRGB: return 72;
+		case TextureContainer::FORMAT_BC3: return 77;
+		case TextureContainer::FORMAT_BC3_SRGB: return 78;
+		case TextureContainer::FORMAT_BC5: return 83;
+		case TextureContainer::FORMAT_RGBA8: return 28;
+		case TextureContainer::FORMAT_RGBA8_SRGB: return 29;
+		case TextureContainer::FORMAT_RGBA16F: return 10;
+		default: return 0;
+		}
+	}
+
+	// Writes a DDS with a DX10 header, 'levels' holds every mip of layer (or cubemap face) 0, then every mip of the next
+	inline bool WriteDds(const std::string &uri, TextureContainer::Format format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>> &levels, uint32_t layers = 1, bool cubemap = false)
+	{
+		uint32_t header[37] = { 0 };	// Magic + DDS_HEADER + DDS_HEADER_DXT10, as words
+		std::memcpy(&header[0], "DDS ", 4);		// File code
+		header[1] = 124;	// dwSize
+		header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;	// CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+		header[3] = height;		// dwHeight
+		header[4] = width;	// dwWidth
+		header[5] = (uint32_t)levels[0].size();		// dwPitchOrLinearSize
+		header[7] = (uint32_t)levels.size() / (layers * (cubemap ? 6 : 1));	// dwMipMapCount
+		header[19] = 32;	// ddspf.dwSize
+		header[20] = 0x4;	// DDPF_FOURCC
+		std::memcpy(&header[21], "DX10", 4);	// Extended header follows
+		header[27] = 0x1000 | 0x8 | 0x400000;	// TEXTURE | COMPLEX | MIPMAP
+		header[28] = cubemap ? 0xFE00 : 0;	// CUBEMAP | every face
+		header[32] = ToDxgi(format);	// dxgiFormat
+		header[33] = 3;		// D3D10_RESOURCE_DIMENSION_TEXTURE2D
+		header[34] = cubemap ? 0x4 : 0;		// RESOURCE_MISC_TEXTURECUBE
+		header[35] = layers;	// arraySize
+
+		std::ofstream file(uri, std::ios::binary | std::ios::trunc);	// Create the file
+		file.write((const char*)header, sizeof(header));	// Write the headers
+		for (const std::vector<uint8_t> &level : levels)	// For each level...
+			file.write((const char*)level.data(), level.size());	// Write it
+		if (!file)	// If anything failed...
+		{
+			std::cout << "Texture Cook Error: Failed to write '" << uri << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+		return true;	// Return success
+	}
+
+	// Cooks an rgba8 image already in memory, reports the PSNR of the top level (and the worst level)
+	inline bool CookImage(const uint8_t* rgba, uint32_t width, uint32_t height, const std::string &name, const std::string &dst, const Settings &settings)
+	{
+		if (!BlockCompression::CanEncode(settings.format))	// If we can't encode it...
+		{
+			std::cout << "Texture Cook Error: No encoder for " << TextureContainer::GetFormatInfo(settings.format).name << "!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		bool srgb = IsSrgb(settings.format);	// Whether to filter in linear space
+		bool premultiply = HasAlpha(settings.format);	// Whether to filter colour weighted by alpha
+		std::vector<std::vector<uint8_t>> levels;	// The compressed chain
+		std::vector<uint8_t> bytes(rgba, rgba + (size_t)width * height * 4), decoded;	// The current level / its round trip
+		Image level = ToFloat(rgba, width, height, srgb);	// The current level in float
+		if (premultiply)	// If alpha is coverage...
+			Premultiply(level);		// Filter premultiplied
+
+		double top_psnr = 0.0, worst_psnr = 1e9;	// Quality metrics
+		for (uint32_t m = 0; m < TextureContainer::MaxMips(width, height); m++)		// For each level...
+		{
+			if (m > 0)	// If it's a mip...
+			{
+				level = Downsample(level, settings.wrap);	// Filter it from the previous level (in float, no requantising)
+				ToBytes(premultiply ? Unpremultiply(level) : level, srgb, bytes);	// Back to 8 bits, straight alpha
+			}
+
+			levels.push_back(std::vector<uint8_t>());	// Make room
+			BlockCompression::Compress(bytes.data(), level.width, level.height, settings.format, levels.back());	// Encode it
+			BlockCompression::Decompress(levels.back().data(), level.width, level.height, settings.format, decoded);	// Decode it
+			double psnr = BlockCompression::Psnr(bytes.data(), decoded.data(), (size_t)level.width * level.height, settings.format);	// Measure it
+			if (m == 0) top_psnr = psnr;
+			worst_psnr = std::min(worst_psnr, psnr);
+		}
+
+		size_t compressed = 0;	// Total size
+		for (const std::vector<uint8_t> &l : levels)
+			compressed += l.size();
+
+		std::cout << "Texture Cook: " << name << " " << width << "x" << height << " " << TextureContainer::GetFormatInfo(settings.format).name
+			<< " " << levels.size() << " mips, " << compressed / 1024 << " KB, PSNR " << top_psnr << " dB (worst mip " << worst_psnr << " dB)\n";	// Report it
+
+		return WriteDds(dst, settings.format, width, height, levels);	// Write it
+	}
+
+	// Cooks a source image (png / tga / jpg ...) into a compressed DDS
+	inline bool Cook(const std::string &src, const std::string &dst, const Settings &settings = Settings())
+	{
+		VfsFile file;	// The source
+		if (!Vfs::Open(src, file))	// If it can't be read...
+		{
+			std::cout << "Texture Cook Error: Failed to open '" << src << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		int width, height, components;	// The decoded size
+		unsigned char* rgba = stbi_load_from_memory(file.Data(), (int)file.Size(), &width, &height, &components, 4);	// Decode as rgba
+		if (!rgba)	// If it failed...
+		{
+			std::cout << "Texture Cook Error: Failed to decode '" << src << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		bool ok = CookImage(rgba, (uint32_t)width, (uint32_t)height, src, dst, settings);	// Cook it
+		stbi_image_free(rgba);	// Free the pixels
+		return ok;	// Return the result
+	}
+}
+
+#endif
@@ -0,0 +1,466 @@
+#ifndef __TEXTURE_STREAMER_H__
+#define __TEXTURE_STREAMER_H__
+
+#include <iostream>		// Get error output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <map>	// Get id lookups
+#include <deque>	// Get the job queue
+#include <memory>	// Get shared_ptr
+#include <algorithm>	// Get sort / min / max
+#include <thread>	// Get the loader thread
+#include <mutex>	// Get mutex
+#include <condition_variable>	// Get the job signal
+#include <cfloat>	// Get FLT_MAX
+#include <cmath>	// Get log2
+#include <glm/glm.hpp>	// Get vectors / matrices
+#include "Texture.h"	// Derive from Texture2d
+#include "DdsLoader.h"	// Get GL formats / sampler state
+#include "TextureContainer.h"	// Parse the files
+#include "HotReload.h"	// Restart streaming when a file changes
+
+#define TEXTURE_STREAM_BUDGET			(256u << 20)	// Default GPU bytes for all streamed textures
+#define TEXTURE_STREAM_TAIL_SIZE		64	// Mips this size and smaller are loaded with the texture
+#define TEXTURE_STREAM_UPLOAD_BYTES		(8u << 20)	// Upload at most this much per frame
+#define TEXTURE_STREAM_MAX_JOBS			4	// Files being read at once (bounds the ram used by streaming)
+#define TEXTURE_STREAM_EVICT_FRAMES		8	// A texture unused for this many frames drops back to its tail
+#define TEXTURE_STREAM_FULL_SIZE		FLT_MAX		// Draw size that asks for the top mip
+
+namespace Texture
+{
+	// A 2d texture whose mips are made resident on demand. The texture object only ever holds levels
+	// [resident, mips); the streamer recreates it with more (or fewer) levels and swaps the id, so
+	// materials keep binding the same object
+	struct StreamedTexture : public Texture2d
+	{
+		std::string					uri;	// The file
+		TextureContainer::Format	format;		// Pixel format
+		uint32_t					file_width;		// Top level width in the file
+		uint32_t					file_height;	// Top level height in the file
+		uint32_t					file_mips;	// Mips in the file
+		uint32_t					tail;	// First level of the always resident tail
+		uint32_t					resident;	// First resident level
+		uint32_t					wanted;		// First level the last frame asked for
+		uint64_t					last_used;	// The frame it was last bound
+		size_t						bytes;	// GPU bytes currently resident
+		unsigned int				stream_id;	// Streamer registration
+		bool						busy;	// Whether a job is in flight
+
+		inline StreamedTexture(const std::string &file, GLenum m_type, GLint wrap_filter, GLint min_mag_filter);
+		inline ~StreamedTexture();
+
+		// Size of levels [level, mips)
+		inline size_t ChainBytes(uint32_t level) const
+		{
+			size_t total = 0;	// The running total
+			for (uint32_t m = level; m < file_mips; m++)	// For each level...
+				total += TextureContainer::ImageSize(format, std::max(1u, file_width >> m), std::max(1u, file_height >> m));
+			return total;	// Return the size
+		}
+
+		// Creates the texture object from levels [level, mips) of a parsed file (main thread)
+		inline bool Upload(const TextureContainer::Image &image, uint32_t level)
+		{
+			GLenum internal_format, fmt, type;	// The GL formats
+			if (!GetGlFormat(image.format, internal_format, fmt, type))		// If GL can't take it...
+				return false;	// Return false as failed
+
+			uint32_t count = image.mips - level;	// Levels to create
+			const TextureContainer::Subresource &top = image.Get(level);	// The new top level
+
+			GLuint new_id;	// The replacement texture
+			glGenTextures(1, &new_id);	// Create it
+			glBindTexture(GL_TEXTURE_2D, new_id);	// Bind it
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);	// Rows are tightly packed
+			glTexStorage2D(GL_TEXTURE_2D, count, internal_format, top.width, top.height);	// Allocate exactly the resident levels
+
+			for (uint32_t m = 0; m < count; m++)	// For each resident level...
+			{
+				const TextureContainer::Subresource &s = image.Get(level + m);	// Its data (read in place)
+				if (TextureContainer::IsCompressed(image.format))	// Upload it
+					glCompressedTexSubImage2D(GL_TEXTURE_2D, m, 0, 0, s.width, s.height, internal_format, (GLsizei)s.size, s.data);
+				else
+					glTexSubImage2D(GL_TEXTURE_2D, m, 0, 0, s.width, s.height, fmt, type, s.data);
+			}
+
+			SetTextureParameters(GL_TEXTURE_2D, count, TextureContainer::IsCompressed(image.format), wrap_s, wrap_t, GL_LINEAR_MIPMAP_LINEAR, mag_filter, true);	// Apply sampler state
+
+			if (id) glDeleteTextures(1, &id);	// Drop the old levels
+			id = new_id;	// Materials bind through this object, so they see the new id
+			width = top.width;	// Assign resident width
+			height = top.height;	// Assign resident height
+			num_mips = count;	// Assign resident mips
+			resident = level;	// Assign first level
+			bytes = ChainBytes(level);	// Assign size
+			return true;	// Return success
+		}
+
+		// Reads the header and uploads the tail (main thread)
+		inline void LoadTail(const TextureContainer::File &file)
+		{
+			const TextureContainer::Image &image = file.GetImage();		// The layout
+			if (image.faces != 1 || image.layers != 1)	// If it isn't a plain 2d texture...
+			{
+				std::cout << "Texture Stream Error: '" << uri << "' isn't a 2d texture!\n";		// Print out error message
+				return;		// Return
+			}
+
+			format = image.format;	// Assign format
+			file_width = image.width;	// Assign width
+			file_height = image.height;		// Assign height
+			file_mips = image.mips;		// Assign mip count
+
+			tail = 0;	// Find the first small level
+			while (tail + 1 < file_mips && std::max(file_width >> tail, file_height >> tail) > TEXTURE_STREAM_TAIL_SIZE)
+				tail++;
+			wanted = tail;	// Nothing asked for more yet
+			if (!Upload(image, tail))	// If GL can't take the format...
+				std::cout << "Texture Stream Error: '" << uri << "' can't be uploaded!\n";	// Print out error message
+		}
+
+		inline virtual void Render();	// Binds the texture and tells the streamer it's in use
+	};
+}
+
+
+// This class streams texture mips under a memory budget. Textures start with only their small tail levels resident.
+// Every bind records how large the texture is on screen (see SetDrawSize), and Update() asks for one more level for
+// textures that are blurrier than they're drawn: a worker thread maps the file and pages the level in, then the main
+// thread uploads it. When the budget is exceeded the least recently used textures drop levels again. Files are only
+// open while a job is in flight, so system memory is bounded by TEXTURE_STREAM_MAX_JOBS and VRAM by the budget
+class TextureStreamer
+{
+private:
+	// A residency change
+	struct Job
+	{
+		unsigned int							id;		// Texture registration
+		std::string								uri;	// The file
+		uint32_t								level;	// First level to make resident
+		std::shared_ptr<TextureContainer::File>	file;	// The mapped file (null if it failed to open)
+	};
+
+	static std::map<unsigned int, Texture::StreamedTexture*>	_textures;	// Registered textures
+	static std::mutex					_mutex;		// Guards the queues
+	static std::condition_variable		_signal;	// Wakes the worker
+	static std::deque<Job>				_queued;	// Jobs waiting for the worker
+	static std::vector<Job>				_done;	// Jobs waiting for the main thread
+	static std::thread					_worker;	// The loader thread
+	static bool							_running;	// Whether the worker should keep going
+	static unsigned int					_next_id;	// The next registration id
+	static uint64_t						_frame;		// The current frame
+	static size_t						_budget;	// GPU byte budget
+	static size_t						_resident_bytes;	// GPU bytes resident
+	static size_t						_jobs;	// Jobs in flight
+	static float						_draw_size;		// Screen size of what's being drawn
+
+	// The worker loop: map files and touch the requested levels so the upload doesn't stall on the disk
+	static inline void Run()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);	// Lock the queues
+		while (true)
+		{
+			_signal.wait(lock, []() { return !_running || !_queued.empty(); });		// Wait for work
+			if (!_running)	// If we're shutting down...
+				return;		// Return
+
+			Job job = _queued.front();	// Take a job
+			_queued.pop_front();
+			lock.unlock();	// Do the IO unlocked
+
+			job.file = std::make_shared<TextureContainer::File>();	// The file
+			if (job.file->Open(job.uri))	// If it opened...
+			{
+				const TextureContainer::Image &image = job.file->GetImage();	// The layout
+				unsigned char sink = 0;		// Keeps the reads
+				for (uint32_t m = std::min(job.level, image.mips); m < image.mips; m++)		// For each level to upload...
+				{
+					const TextureContainer::Subresource &s = image.Get(m);	// Its bytes
+					for (size_t b = 0; b < s.size; b += 4096)	// Touch every page
+						sink ^= ((volatile const unsigned char*)s.data)[b];
+				}
+				(void)sink;
+			}
+			else
+				job.file.reset();	// Report the failure
+
+			lock.lock();	// Lock the queues
+			_done.push_back(job);	// Hand it to the main thread
+		}
+	}
+
+	// Queues a residency change
+	static inline void Request(Texture::StreamedTexture* t, uint32_t level)
+	{
+		Job job;	// The job
+		job.id = t->stream_id;	// Assign texture
+		job.uri = t->uri;	// Assign file
+		job.level = level;	// Assign level
+
+		t->busy = true;		// One job per texture
+		_jobs++;	// Count it
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the queue
+			_queued.push_back(job);		// Queue it
+		}
+		_signal.notify_one();	// Wake the worker
+	}
+
+	// Uploads finished jobs, at most TEXTURE_STREAM_UPLOAD_BYTES per frame
+	static inline void ApplyDone()
+	{
+		std::vector<Job> done;	// The finished jobs
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the queue
+			done.swap(_done);	// Take them
+		}
+
+		size_t uploaded = 0;	// Bytes uploaded this frame
+		for (size_t j = 0; j < done.size(); j++)	// For each finished job...
+		{
+			std::map<unsigned int, Texture::StreamedTexture*>::iterator it = _textures.find(done[j].id);	// Its texture
+			if (it == _textures.end())	// If the texture was deleted meanwhile...
+			{
+				_jobs--;	// Forget it
+				continue;
+			}
+
+			Texture::StreamedTexture* t = it->second;	// The texture
+			const TextureContainer::Image* image = done[j].file ? &done[j].file->GetImage() : NULL;		// The new layout
+			if (!image || image->format != t->format || image->width != t->file_width || image->height != t->file_height || image->mips != t->file_mips)
+			{
+				t->busy = false;	// The file changed or vanished, hot reload handles that
+				_jobs--;	// Done
+				continue;
+			}
+
+			size_t size = t->ChainBytes(done[j].level);		// What the upload costs
+			if (uploaded && uploaded + size > TEXTURE_STREAM_UPLOAD_BYTES)	// If this frame is already busy...
+			{
+				std::lock_guard<std::mutex> lock(_mutex);	// Lock the queue
+				_done.insert(_done.end(), done.begin() + j, done.end());	// Keep the rest for next frame
+				break;
+			}
+
+			_resident_bytes -= t->bytes;	// Release the old levels
+			t->Upload(*image, done[j].level);	// Swap in the new ones
+			_resident_bytes += t->bytes;	// Account for them
+			uploaded += size;	// Count the upload
+			t->busy = false;	// Done
+			_jobs--;	// Done
+		}
+	}
+
+	// Drops levels from the least recently used textures until 'excess' bytes will be released, returns the bytes released
+	static inline size_t Evict(size_t excess)
+	{
+		std::vector<Texture::StreamedTexture*> lru;		// Textures that could shrink
+		for (std::pair<const unsigned int, Texture::StreamedTexture*> &t : _textures)	// For each texture...
+			if (!t.second->busy && t.second->resident < t.second->tail)		// If it has more than its tail...
+				lru.push_back(t.second);	// It's a candidate
+		std::sort(lru.begin(), lru.end(), [](const Texture::StreamedTexture* a, const Texture::StreamedTexture* b) { return a->last_used < b->last_used; });
+
+		size_t freed = 0;	// Bytes that will be released
+		for (Texture::StreamedTexture* t : lru)		// Oldest first...
+		{
+			if (freed >= excess || _jobs >= TEXTURE_STREAM_MAX_JOBS)	// If that's enough (or the worker is busy)...
+				break;	// Stop
+
+			bool unused = _frame - t->last_used >= TEXTURE_STREAM_EVICT_FRAMES;		// Whether it's been off screen a while
+			if (!unused && t->wanted <= t->resident)	// If it's visible and needs every level it has...
+				continue;	// Keep it
+
+			uint32_t level = unused ? t->tail : std::min(t->wanted, t->tail);	// Visible textures only lose levels they don't show
+			freed += t->bytes - t->ChainBytes(level);	// Count the saving
+			Request(t, level);	// Shrink it
+		}
+		return freed;	// Return the saving
+	}
+
+public:
+	// Starts the loader thread with a GPU budget in bytes
+	static inline void Initialise(size_t budget = TEXTURE_STREAM_BUDGET)
+	{
+		_budget = budget;	// Assign budget
+		if (_running)	// If it's already running...
+			return;		// Return as normal
+
+		_running = true;	// Let the worker run
+		_worker = std::thread(Run);		// Start it
+	}
+
+	// Stops the loader thread
+	static inline void Destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);	// Lock the queues
+			if (!_running)	// If it isn't running...
+				return;		// Return as normal
+			_running = false;	// Ask the worker to finish
+		}
+		_signal.notify_one();	// Wake it
+		_worker.join();		// Wait for it
+
+		_queued.clear();	// Drop pending jobs
+		_done.clear();	// Drop finished jobs
+		_jobs = 0;	// Nothing in flight
+		for (std::pair<const unsigned int, Texture::StreamedTexture*> &t : _textures)	// For each texture...
+			t.second->busy = false;		// Nothing pending
+	}
+
+	inline static void SetBudget(size_t bytes) { _budget = bytes; }		// Assign the GPU budget
+	inline static size_t GetResidentBytes() { return _resident_bytes; }		// Return the GPU bytes in use
+
+	// Sets the screen size in pixels of what's about to be drawn, textures bound afterwards want the mip that matches.
+	// Reset to TEXTURE_STREAM_FULL_SIZE after drawing so other passes get full detail
+	inline static void SetDrawSize(float pixels) { _draw_size = pixels; }
+
+	// Projected diameter in pixels of a sphere
+	static inline float ProjectedSize(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &centre, float radius, float viewport_height)
+	{
+		glm::vec4 p = view * glm::vec4(centre, 1.0f);	// View space centre
+		float depth = std::max(-p.z - radius, 0.001f);	// Distance to its nearest point
+		return radius * projection[1][1] * viewport_height / depth;		// Diameter over the visible height at that depth
+	}
+
+	// Records that a texture was bound at the current draw size
+	static inline void Touch(Texture::StreamedTexture* t)
+	{
+		uint32_t level = 0;		// The level that matches the draw size
+		float size = (float)std::max(t->file_width, t->file_height);	// The top level size
+		if (_draw_size <= 0.0f)		// If it's not visible...
+			level = t->tail;	// The tail is enough
+		else if (_draw_size < size)		// If it's drawn smaller than the top level...
+			level = std::min((uint32_t)std::log2(size / _draw_size), t->tail);	// Skip the levels it can't show
+
+		t->wanted = t->last_used == _frame ? std::min(t->wanted, level) : level;	// The sharpest request this frame wins
+		t->last_used = _frame;	// Assign frame
+	}
+
+	// Registers a texture and loads its tail
+	static inline void Add(Texture::StreamedTexture* t)
+	{
+		t->stream_id = _next_id++;	// Assign id
+		t->last_used = _frame;	// It's new
+		_textures[t->stream_id] = t;	// Store it
+
+		TextureContainer::File file;	// Only the header and tail are read now
+		if (file.Open(t->uri))	// If it opened...
+			t->LoadTail(file);	// Upload the tail
+		_resident_bytes += t->bytes;	// Account for it
+	}
+
+	// Unregisters a texture (jobs in flight are dropped when they finish)
+	static inline void Remove(Texture::StreamedTexture* t)
+	{
+		_resident_bytes -= t->bytes;	// Release its levels
+		_textures.erase(t->stream_id);	// Forget it
+	}
+
+	// Reloads a texture whose file changed (main thread)
+	static inline void Reload(Texture::StreamedTexture* t, const TextureContainer::File &file)
+	{
+		_resident_bytes -= t->bytes;	// Release its levels
+		t->LoadTail(file);	// Start again from the tail
+		_resident_bytes += t->bytes;	// Account for it
+	}
+
+	// Uploads finished levels, evicts over budget and requests the next levels, call once per frame on the GL thread
+	static inline void Update()
+	{
+		ApplyDone();	// Upload what's ready
+
+		std::vector<Texture::StreamedTexture*> grow;	// Textures drawn larger than they're resident
+		for (std::pair<const unsigned int, Texture::StreamedTexture*> &t : _textures)	// For each texture...
+			if (!t.second->busy && t.second->last_used + 1 >= _frame && t.second->wanted < t.second->resident)	// If it's visible and blurry...
+				grow.push_back(t.second);	// It wants more
+		std::sort(grow.begin(), grow.end(), [](const Texture::StreamedTexture* a, const Texture::StreamedTexture* b)
+			{ return a->resident - a->wanted > b->resident - b->wanted; });		// Blurriest first
+
+		size_t projected = _resident_bytes;		// Resident bytes once this frame's requests land
+		for (Texture::StreamedTexture* t : grow)	// For each request...
+		{
+			if (_jobs >= TEXTURE_STREAM_MAX_JOBS)	// If the worker is busy...
+				break;	// Try next frame
+			if (t->busy)	// If eviction just picked it...
+				continue;	// Leave it
+
+			uint32_t level = t->resident - 1;	// One level at a time, so low mips arrive first
+			size_t growth = t->ChainBytes(level) - t->bytes;	// What it costs
+			if (projected + growth > _budget)	// If it doesn't fit...
+				projected -= Evict(projected + growth - _budget);	// Make room
+			if (projected + growth > _budget)	// If it still doesn't fit...
+				continue;	// Leave it blurry
+
+			projected += growth;	// Reserve it
+			Request(t, level);	// Load it
+		}
+
+		if (projected > _budget)	// If a budget change left us over...
+			Evict(projected - _budget);		// Shrink
+
+		_frame++;	// Next frame
+	}
+};
+
+// Streamed texture definitions (need the streamer)
+inline Texture::StreamedTexture::StreamedTexture(const std::string &file, GLenum m_type, GLint wrap_filter, GLint min_mag_filter)
+{
+	SetName(file + "-t2d");	// Set texture name to file name
+	type_2d = true;		// Assign type to sampler2d
+	unit = m_type;	// Assign texture unit
+	id = 0;		// Nothing resident yet
+	data = NULL;	// Pixels live in the file
+	width = height = num_mips = 0;	// Assigned by the tail
+	wrap_s = wrap_filter;	// Assign wrap s filter
+	wrap_t = wrap_filter;	// Assign wrap t filter
+	min_filter = GL_LINEAR_MIPMAP_LINEAR;	// Assign min filter
+	mag_filter = min_mag_filter;	// Assign mag filter
+
+	uri = static_cast<std::string>(__TEXTURE_2D_URI__) + file;	// The full path
+	format = TextureContainer::FORMAT_UNKNOWN;	// Assigned by the tail
+	file_width = file_height = file_mips = 0;	// Assigned by the tail
+	tail = resident = wanted = 0;	// Assigned by the tail
+	bytes = 0;	// Nothing resident yet
+	busy = false;	// No job yet
+
+	TextureStreamer::Add(this);		// Register and load the tail
+
+	StreamedTexture* texture = this;	// The texture to reload
+	std::string path = uri;		// The file to watch
+	HotReload::Watch(path, this, [texture, path]() -> HotReload::Apply
+	{
+		std::shared_ptr<TextureContainer::File> file = std::make_shared<TextureContainer::File>();	// Map and parse here
+		if (!file->Open(path))	// If it's invalid or only partly written...
+			return HotReload::Apply();	// Skip this change
+		return [texture, file]() { TextureStreamer::Reload(texture, *file); };	// Restart streaming on the main thread
+	});
+}
+
+inline Texture::StreamedTexture::~StreamedTexture()
+{
+	TextureStreamer::Remove(this);	// Stop streaming (the base deletes the texture object)
+}
+
+inline void Texture::StreamedTexture::Render()
+{
+	TextureStreamer::Touch(this);	// Record the draw size
+	Texture2d::Render();	// Bind it
+}
+
+// Static definitions
+std::map<unsigned int, Texture::StreamedTexture*>	TextureStreamer::_textures;
+std::mutex							TextureStreamer::_mutex;
+std::condition_variable				TextureStreamer::_signal;
+std::deque<TextureStreamer::Job>	TextureStreamer::_queued;
+std::vector<TextureStreamer::Job>	TextureStreamer::_done;
+std::thread							TextureStreamer::_worker;
+bool								TextureStreamer::_running = false;
+unsigned int						TextureStreamer::_next_id = 1;
+uint64_t							TextureStreamer::_frame = 0;
+size_t								TextureStreamer::_budget = TEXTURE_STREAM_BUDGET;
+size_t								TextureStreamer::_resident_bytes = 0;
+size_t								TextureStreamer::_jobs = 0;
+float								TextureStreamer::_draw_size = TEXTURE_STREAM_FULL_SIZE;
+
+#endif
@@ -0,0 +1,541 @@
+// Standalone checks for the CPU side of the engine: each section reproduces the numbers quoted when its system went
+// in. Nothing in it needs a GL context or any asset, every input is synthetic and seeded, so runs can be compared
+// between machines. It's the checks target of the tools project:
+//
+//		cmake -S Tools -B build -DTOOLS_INCLUDE_DIRS="<glm>;<glew>;<stb>" && cmake --build build --target checks
+//
+// It prints one line per check (timings are informative, only the correctness bounds fail) and returns the number of
+// failed checks
+#include <cstdio>	// Get printf / remove
+#include <cstdint>	// Get fixed size integers
+#include <cmath>	// Get sin / cos / fabs
+#include <cfloat>	// Get FLT_MAX
+#include <vector>	// Get dynamic array
+#include <fstream>	// Read the cooked file back
+#include <chrono>	// Time the checks
+#include <algorithm>	// Get min / max
+#include <glm/glm.hpp>	// Get glm variables
+#include "../SphericalHarmonics.h"	// Check the projection
+#include "../AnimCompression.h"		// Compress the synthetic clip
+#include "../AnimSystem.h"	// Check packed palettes through an update
+#include "../BonePalette.h"		// Check packing
+#include "../CpuSkinning.h"	// Time the kernels
+#include "../VertexAnimation.h"		// Check bakes
+#include "../ParticleSimulation.h"	// Get the generator, kernels and sorter
+
+#define CHECKS_SKM			"Checks.skm"	// Scratch file for the synthetic rig (removed afterwards)
+#define CHECKS_BONES		50		// Bones in the synthetic rig
+#define CHECKS_FRAMES		121		// Keys per track of its clip
+#define CHECKS_VERTICES		3000	// Vertices skinned to it
+#define CHECKS_PARTICLES	4000000		// Particles in the kernel timing
+
+static uint32_t _failed = 0;	// Checks that missed their bound
+
+// Prints a check's outcome and counts it if it failed
+static inline bool Check(const char* name, bool passed)
+{
+	std::printf("%-44s %s\n", name, passed ? "ok" : "FAILED");
+	if (!passed)
+		_failed++;
+	return passed;
+}
+
+// Returns the milliseconds since 'start'
+static inline double Milliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Direction of an equirectangular texel centre, matching SphericalHarmonics::ProjectEquirectangular
+static inline glm::vec3 Direction(uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+	float latitude = ((y + 0.5f) / height - 0.5f) * 3.14159265f, longitude = ((x + 0.5f) / width - 0.5f) * 6.28318531f;
+	return glm::vec3(std::cos(latitude) * std::cos(longitude), std::sin(latitude), std::cos(latitude) * std::sin(longitude));
+}
+
+// SH9 projection of a 2048x1024 sky with a sun against a brute force cosine integral of the same image
+static inline void CheckSphericalHarmonics()
+{
+	const uint32_t width = 2048, height = 1024;
+	const glm::vec3 sun = glm::normalize(glm::vec3(0.3f, 0.8f, 0.2f));
+	std::vector<float> rgb((size_t)width * height * 3);
+	for (uint32_t y = 0; y < height; y++)
+		for (uint32_t x = 0; x < width; x++)
+		{
+			glm::vec3 d = Direction(x, y, width, height);
+			float sky = std::max(d.y, 0.0f) * 1.5f + 0.2f, disc = glm::dot(d, sun) > 0.98f ? 20.0f : 0.0f;
+			float* t = &rgb[((size_t)y * width + x) * 3];
+			t[0] = sky + disc;
+			t[1] = sky * 0.8f + disc;
+			t[2] = sky * 0.5f + disc * 0.9f;
+		}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	SphericalHarmonics::SH9 sh = SphericalHarmonics::ToIrradiance(SphericalHarmonics::ProjectEquirectangular(rgb.data(), width, height));
+	double ms = Milliseconds(start);
+
+	const glm::vec3 normals[] = { glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), sun, glm::vec3(0.0f, 0.0f, -1.0f) };
+	float worst = 0.0f, peak = 0.0f;	// Largest error over the normals and channels, and the brightest irradiance
+	for (const glm::vec3 &n : normals)
+	{
+		double reference[3] = { 0.0, 0.0, 0.0 };
+		for (uint32_t y = 0; y < height; y++)
+			for (uint32_t x = 0; x < width; x++)
+			{
+				glm::vec3 d = Direction(x, y, width, height);
+				float c = glm::dot(n, d);
+				if (c <= 0.0f)
+					continue;
+				double w = c * std::sqrt(std::max(0.0f, 1.0f - d.y * d.y)) * (6.28318531 / width) * (3.14159265 / height);
+				for (int k = 0; k < 3; k++)
+					reference[k] += rgb[((size_t)y * width + x) * 3 + k] * w;
+			}
+		glm::vec3 e = SphericalHarmonics::Evaluate(sh, n);
+		for (int k = 0; k < 3; k++)
+		{
+			worst = std::max(worst, (float)std::fabs(e[k] - reference[k] / 3.14159265));
+			peak = std::max(peak, (float)(reference[k] / 3.14159265));
+		}
+	}
+	std::printf("  2048x1024 projected in %.2f ms on %u threads, worst irradiance error %.2f%% of the brightest\n", ms, Parallel::Jobs().NumWorkers(), worst / peak * 100.0f);
+	Check("SH9 irradiance within 3% of the peak", worst < 0.03f * peak);
+}
+
+// Builds a rig of CHECKS_BONES bones swaying over CHECKS_FRAMES keys, compresses it and skins CHECKS_VERTICES to it
+static inline void BuildRig(Skm::Data &data, std::vector<AnimCompression::Track> &tracks, ParticleSimulation::Random &random)
+{
+	data.duration = CHECKS_FRAMES - 1;
+	data.ticks_per_second = 30.0f;
+	const float axis[3] = { 0.3f / std::sqrt(0.98f), 0.8f / std::sqrt(0.98f), 0.5f / std::sqrt(0.98f) };	// Every bone sways about it
+	for (uint32_t i = 0; i < CHECKS_BONES; i++)
+	{
+		Skm::Node n;
+		n.parent = i == 0 ? SKM_NO_PARENT : (int32_t)(random.Next() % i);
+		n.bone = (int32_t)data.bone_offsets.size();
+		n.name = 0;
+		glm::mat4 local(1.0f);
+		local[3] = glm::vec4(random.Range(-0.3f, 0.3f), random.Range(0.2f, 0.4f), random.Range(-0.3f, 0.3f), 1.0f);
+		n.local = Skm::Matrix::FromGlm(local);
+		data.bone_offsets.push_back(Skm::Matrix::FromGlm(glm::mat4(1.0f)));
+
+		AnimCompression::Track t;	// A quarter of the bones hold still
+		float rate = random.Range(0.1f, 0.9f), phase = random.Range(-3.0f, 3.0f), amplitude = random.Range(0.0f, 0.4f);
+		bool still = random.Next() % 4 == 0;
+		for (uint32_t k = 0; k < CHECKS_FRAMES; k++)
+		{
+			float tick = (float)k, a = still ? 0.1f : amplitude * std::sin(rate * tick * 0.1f + phase);
+			t.positions.push_back(Skm::Vec3Key{ tick, { local[3].x, local[3].y + (i == 0 ? 0.05f * std::sin(tick * 0.2f) : 0.0f), local[3].z } });
+			t.rotations.push_back(Skm::QuatKey{ tick, { std::cos(a * 0.5f), std::sin(a * 0.5f) * axis[0], std::sin(a * 0.5f) * axis[1], std::sin(a * 0.5f) * axis[2] } });
+			t.scalings.push_back(Skm::Vec3Key{ tick, { 1.0f, 1.0f, 1.0f } });
+		}
+		n.channel = (int32_t)tracks.size();
+		tracks.push_back(t);
+		data.nodes.push_back(n);
+	}
+	data.names = std::string(1, '\0');
+
+	for (uint32_t v = 0; v < CHECKS_VERTICES; v++)	// A cloud of vertices, each on two bones
+	{
+		data.positions.push_back(glm::vec3(random.Range(-0.5f, 0.5f), random.Range(0.0f, 1.0f), random.Range(-0.5f, 0.5f)));
+		data.normals.push_back(glm::normalize(glm::vec3(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(0.01f, 1.0f))));
+		data.tangents.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
+		data.texcoords.push_back(glm::vec2(0.0f));
+		VertexBoneData weights;
+		weights.AddBoneData(random.Next() % CHECKS_BONES, 0.7f);
+		weights.AddBoneData(random.Next() % CHECKS_BONES, 0.3f);
+		data.bone_data.push_back(PackedBoneData::Pack(weights));
+	}
+	for (uint32_t t = 0; t + 2 < CHECKS_VERTICES; t++)
+		for (uint32_t k = 0; k < 3; k++)
+			data.indices.push_back(t + k);
+	Skm::Entry entry = { (uint32_t)data.indices.size(), 0, 0, 0 };
+	data.entries.push_back(entry);
+}
+
+// Clip compression size and joint error against the full precision keys
+static inline void CheckCompression(const Skm::Data &data, const std::vector<AnimCompression::Track> &tracks, const AnimCompression::Stats &stats,
+	const AnimRuntime::Skeleton &skeleton)
+{
+	float size = AnimCompression::Reach(data.nodes)[0];		// The skeleton's size
+	AnimRuntime::Instance instance;
+	std::vector<glm::mat4> globals(CHECKS_BONES);
+	float worst = 0.0f;		// Largest joint error
+	for (uint32_t frame = 0; frame < 2000; frame++)		// Sample between keys as well as on them
+	{
+		float seconds = frame / 97.0f;
+		skeleton.Evaluate(seconds, instance);
+		float tick = skeleton.ClipTime(seconds);
+		uint32_t k = std::min((uint32_t)tick, (uint32_t)CHECKS_FRAMES - 2);
+		float f = tick - k;
+		for (uint32_t i = 0; i < CHECKS_BONES; i++)
+		{
+			const AnimCompression::Track &t = tracks[i];
+			const float* p0 = t.positions[k].value, *p1 = t.positions[k + 1].value, *r0 = t.rotations[k].value, *r1 = t.rotations[k + 1].value;
+			glm::vec3 p(p0[0] + (p1[0] - p0[0]) * f, p0[1] + (p1[1] - p0[1]) * f, p0[2] + (p1[2] - p0[2]) * f);
+			glm::quat r = AnimRuntime::Slerp(glm::quat(r0[0], r0[1], r0[2], r0[3]), glm::quat(r1[0], r1[1], r1[2], r1[3]), f);
+			glm::mat4 local = AnimRuntime::Compose(p, r, glm::vec3(1.0f));
+			globals[i] = data.nodes[i].parent < 0 ? local : AnimRuntime::MulAffine(globals[data.nodes[i].parent], local);
+			worst = std::max(worst, glm::length(glm::vec3(globals[i][3]) - glm::vec3(instance.GetPalette()[i][3])));
+		}
+	}
+	std::printf("  %zu keys in %zu bytes became %zu keys in %zu bytes, worst joint error %.3f%% of the skeleton\n",
+		stats.source_keys, stats.source_bytes, stats.packed_keys, stats.packed_bytes, 100.0f * worst / size);
+	Check("Compressed clip at least 10x smaller", stats.packed_bytes * 10 <= stats.source_bytes);
+	Check("Compressed joints within 0.5% of the skeleton", worst <= 0.005f * size);
+}
+
+// Pack / Unpack round trips, alone and through AnimSystem's packed buffer
+static inline void CheckBonePalette(const AnimRuntime::Skeleton &skeleton, ParticleSimulation::Random &random)
+{
+	std::vector<glm::mat4> matrices(1000, glm::mat4(1.0f));	// Affine, like skinning matrices
+	for (glm::mat4 &m : matrices)
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 3; r++)
+				m[c][r] = random.Range(-10.0f, 10.0f);
+	std::vector<float> packed(matrices.size() * BONE_PALETTE_FLOATS);
+	BonePalette::Pack(matrices.data(), (uint32_t)matrices.size(), packed.data());
+	bool exact = true;
+	for (size_t i = 0; i < matrices.size(); i++)
+		exact = exact && BonePalette::Unpack(&packed[i * BONE_PALETTE_FLOATS]) == matrices[i];
+	Check("BonePalette Pack / Unpack exact", exact);
+
+	std::vector<uint32_t> handles;
+	for (uint32_t i = 0; i < 64; i++)
+		handles.push_back(AnimSystem::Add(&skeleton, 1.0f + i * 0.01f));
+	exact = true;
+	for (uint32_t frame = 0; frame < 30; frame++)
+	{
+		AnimSystem::Update(1.0 / 60.0);
+		for (uint32_t h : handles)
+		{
+			const glm::mat4* palette = AnimSystem::GetPalette(h);
+			const float* rows = AnimSystem::GetPackedPalette(h);
+			exact = exact && palette && rows;
+			for (uint32_t b = 0; exact && b < skeleton.NumPaletteSlots(); b++)
+				exact = BonePalette::Unpack(rows + (size_t)b * BONE_PALETTE_FLOATS) == palette[b];
+		}
+	}
+	for (uint32_t h : handles)
+		AnimSystem::Remove(h);
+	Check("AnimSystem packed palettes exact", exact);
+}
+
+// Far characters with no sampling budget left must still move: none may hold one palette for longer than the
+// ANIM_MAX_MISSED intervals after which it's sampled regardless (a looping hold lasts until then as well)
+static inline void CheckBudget(const AnimRuntime::Skeleton &skeleton)
+{
+	std::vector<uint32_t> handles;
+	for (uint32_t i = 0; i < 200; i++)
+	{
+		handles.push_back(AnimSystem::Add(&skeleton, 1.0f + i * 0.01f));
+		AnimSystem::SetPosition(handles.back(), glm::vec3(ANIM_LOD_FAR * 2.0f, 0.0f, 0.0f));	// Sampled every eighth frame at most
+	}
+	AnimSystem::SetBudget(0.0);
+	std::vector<glm::mat4> last(handles.size());
+	std::vector<uint32_t> held(handles.size(), 0);
+	uint32_t longest = 0;	// Most frames a character showed the same palette
+	for (uint32_t frame = 0; frame < 240; frame++)
+	{
+		AnimSystem::Update(1.0 / 60.0);
+		for (size_t i = 0; i < handles.size(); i++)
+		{
+			const glm::mat4* palette = AnimSystem::GetPalette(handles[i]);
+			held[i] = frame && palette[1] == last[i] ? held[i] + 1 : 0;
+			last[i] = palette[1];
+			longest = std::max(longest, held[i]);
+		}
+	}
+	AnimSystem::SetBudget(ANIM_FRAME_BUDGET);
+	for (uint32_t h : handles)
+		AnimSystem::Remove(h);
+	std::printf("  200 far characters without a budget: longest held palette %u frames\n", longest);
+	Check("Starved characters keep moving", longest < (uint32_t)(ANIM_MAX_MISSED * 8.0f));
+}
+
+// Skins a synthetic rig of 'num_vertices' vertices over 'num_bones' bones 'runs' times, returns the vertices skinned
+// per second
+static inline double SkinningRate(CpuSkinning::Method method, uint32_t num_vertices, uint32_t num_bones, uint32_t runs)
+{
+	std::vector<glm::vec3> positions(num_vertices), normals(num_vertices), out_positions(num_vertices), out_normals(num_vertices);
+	std::vector<PackedBoneData> bones(num_vertices);
+	std::vector<glm::mat4> palette(num_bones);
+	ParticleSimulation::Random random(12345);
+	for (uint32_t i = 0; i < num_vertices; i++)	// Scatter the vertices over four bones each
+	{
+		positions[i] = glm::vec3(random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f), random.Range(-1.0f, 1.0f));
+		normals[i] = glm::normalize(positions[i] + glm::vec3(0.0f, 0.0f, 1e-3f));
+		VertexBoneData vb;
+		for (int k = 0; k < NUM_BONES_PER_VERTEX; k++)
+			vb.AddBoneData(random.Next() % num_bones, random.Range(0.05f, 1.05f));
+		bones[i] = PackedBoneData::Pack(vb);
+	}
+	for (uint32_t i = 0; i < num_bones; i++)	// Rotate and move every bone a little
+	{
+		float a = random.Range(0.0f, 3.0f), c = std::cos(a), s = std::sin(a);
+		palette[i] = glm::mat4(1.0f);
+		palette[i][0] = glm::vec4(c, s, 0.0f, 0.0f);
+		palette[i][1] = glm::vec4(-s, c, 0.0f, 0.0f);
+		palette[i][3] = glm::vec4(random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f), random.Range(0.0f, 1.0f), 1.0f);
+	}
+
+	CpuSkinning::Skin(method, palette.data(), num_bones, positions.data(), normals.data(), bones.data(), num_vertices, out_positions.data(), out_normals.data());	// Warm up
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t r = 0; r < runs; r++)
+		CpuSkinning::Skin(method, palette.data(), num_bones, positions.data(), normals.data(), bones.data(), num_vertices, out_positions.data(), out_normals.data());
+	double ms = Milliseconds(start);
+	return ms > 0.0 ? (double)num_vertices * runs / ms * 1000.0 : 0.0;
+}
+
+// Linear and dual quaternion skinning rates for 100k vertices on 64 bones
+static inline void CheckSkinning()
+{
+	double linear = SkinningRate(CpuSkinning::LINEAR, 100000, 64, 20), dual = SkinningRate(CpuSkinning::DUAL_QUATERNION, 100000, 64, 20);
+	std::printf("  100k vertices on 64 bones: linear %.1f, dual quaternion %.1f million vertices a second on %u threads\n",
+		linear / 1e6, dual / 1e6, Parallel::Jobs().NumWorkers());
+}
+
+// Bakes at 30 fps, and wrapped into columns, compared with direct CPU skinning
+static inline void CheckVertexAnimation(const Skm::View &skm, const AnimRuntime::Skeleton &skeleton)
+{
+	std::vector<Vat::ClipRange> ranges;		// The whole clip
+	Vat::Data bake;
+	float position_error = 0.0f, normal_error = 0.0f;
+	bool baked = Vat::Bake(skm, skeleton, ranges, 30.0f, bake);
+	if (baked)
+		Vat::Verify(skm, skeleton, ranges, bake, 20, position_error, normal_error);
+	std::printf("  30 fps bake of %u vertices: position error %.2g world units, normal error %.2f degrees\n",
+		bake.num_vertices, position_error, glm::degrees(normal_error));
+	Check("VAT bake within 1e-3 units and 2 degrees", baked && position_error < 1e-3f && normal_error < glm::radians(2.0f));
+
+	ranges.assign(16, Vat::ClipRange{ 0.0f, 4.0f });	// More frames than 4096 rows hold
+	baked = Vat::Bake(skm, skeleton, ranges, 60.0f, bake, 4096);
+	if (baked)
+		Vat::Verify(skm, skeleton, ranges, bake, 20, position_error, normal_error);
+	std::printf("  wrapped bake: %ux%u texels in %u columns, position error %.2g\n", bake.TextureWidth(), bake.Height(), bake.Columns(), position_error);
+	Check("VAT wrapped bake within 1e-3 units", baked && bake.Columns() > 1 && position_error < 1e-3f);
+}
+
+// Fills 'n' particles with seeded values
+static inline void Fill(ParticleSimulation::Pool &p, uint32_t n, uint64_t seed)
+{
+	ParticleSimulation::Random random(seed);
+	p.Reserve(n);
+	p.count = n;
+	for (uint32_t i = 0; i < n; i++)
+	{
+		p.x[i] = random.Range(-1.0f, 1.0f);
+		p.z[i] = random.Range(-1.0f, 1.0f);
+		p.dir_x[i] = random.Range(-0.2f, 0.2f);
+		p.dir_y[i] = 1.0f;
+		p.dir_z[i] = random.Range(-0.2f, 0.2f);
+		p.radius[i] = random.Range(0.1f, 0.3f);
+		p.speed[i] = random.Range(0.5f, 1.0f);
+		p.life[i] = random.Range(1.0f, 3.0f);
+		p.wave[i] = i % 3 ? random.Range(0.0f, 0.01f) : 0.0f;
+		p.fade[i] = random.Range(0.5f, 1.0f);
+	}
+	p.Bound(0, n);
+}
+
+// Returns whether two pools hold exactly the same particles
+static inline bool Same(const ParticleSimulation::Pool &a, const ParticleSimulation::Pool &b)
+{
+	return a.count == b.count && a.x == b.x && a.y == b.y && a.z == b.z && a.age == b.age && a.phase == b.phase && a.alpha == b.alpha;
+}
+
+// The SIMD kernels against their scalar tails, replays and the 4M particle timing
+static inline void CheckParticleKernels()
+{
+	bool same = true;	// Each of 7 particles updated in a pool of 7 (SIMD) and alone (scalar tail)
+	for (uint32_t k = 0; k < 7; k++)
+	{
+		ParticleSimulation::Pool all, one;
+		Fill(all, 7, 42);
+		one.Reserve(1);
+		one.count = 1;
+		for (std::vector<float> ParticleSimulation::Pool::* a : { &ParticleSimulation::Pool::x, &ParticleSimulation::Pool::y, &ParticleSimulation::Pool::z,
+			&ParticleSimulation::Pool::dir_x, &ParticleSimulation::Pool::dir_y, &ParticleSimulation::Pool::dir_z, &ParticleSimulation::Pool::radius,
+			&ParticleSimulation::Pool::speed, &ParticleSimulation::Pool::life, &ParticleSimulation::Pool::wave, &ParticleSimulation::Pool::fade })
+			(one.*a)[0] = (all.*a)[k];
+		for (uint32_t frame = 0; frame < 50; frame++)
+		{
+			ParticleSimulation::UpdatePoint(all, 0.016f);
+			ParticleSimulation::UpdatePoint(one, 0.016f);
+			ParticleSimulation::UpdateDirectional(all, 0.016f);
+			ParticleSimulation::UpdateDirectional(one, 0.016f);
+		}
+		same = same && all.x[k] == one.x[0] && all.y[k] == one.y[0] && all.z[k] == one.z[0] && all.alpha[k] == one.alpha[0];
+	}
+	Check("Particle SIMD lanes match the scalar tail", same);
+
+	ParticleSimulation::Pool a, b;	// Two runs of one seed over 600 frames
+	Fill(a, 1000, 7);
+	Fill(b, 1000, 7);
+	for (uint32_t frame = 0; frame < 600; frame++)
+	{
+		ParticleSimulation::UpdateDirectional(a, 0.016f);
+		ParticleSimulation::UpdateDirectional(b, 0.016f);
+		a.Compact();
+		b.Compact();
+	}
+	Check("Seeded particles replay exactly", Same(a, b));
+
+	ParticleSimulation::Pool big;
+	Fill(big, CHECKS_PARTICLES, 1);
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint32_t frame = 0; frame < 10; frame++)
+		ParticleSimulation::UpdateDirectional(big, 0.016f);
+	double directional = Milliseconds(start) / 10.0;
+	start = std::chrono::high_resolution_clock::now();
+	for (uint32_t frame = 0; frame < 10; frame++)
+		ParticleSimulation::UpdatePoint(big, 0.016f);
+	std::printf("  4M particles: directional %.1f ms, point %.1f ms a frame on one thread\n", directional, Milliseconds(start) / 10.0);
+}
+
+// Emitters updated on the job pool against serial updates. ParticleManager's culling and budget need live emitters,
+// which create GL uniforms, so only the job side of it is covered here
+static inline void CheckThreadedEmitters()
+{
+	std::vector<ParticleSimulation::Pool> serial(8), threaded(8);	// Eight emitters on the job pool against serial updates
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		Fill(serial[i], 5000 + i * 1000, i + 1);
+		Fill(threaded[i], 5000 + i * 1000, i + 1);
+	}
+	ParticleSimulation::Pool* pools = threaded.data();
+	for (uint32_t frame = 0; frame < 300; frame++)
+	{
+		for (ParticleSimulation::Pool &p : serial)
+			(&p - serial.data()) % 2 ? ParticleSimulation::UpdatePoint(p, 0.016f) : ParticleSimulation::UpdateDirectional(p, 0.016f);
+		Parallel::Jobs().For(0, threaded.size(), 1, [=](size_t from, size_t to)
+		{
+			for (size_t i = from; i < to; i++)
+				i % 2 ? ParticleSimulation::UpdatePoint(pools[i], 0.016f) : ParticleSimulation::UpdateDirectional(pools[i], 0.016f);
+		});
+	}
+	bool same = true;
+	for (uint32_t i = 0; i < 8; i++)
+		same = same && Same(serial[i], threaded[i]);
+	Check("Threaded emitters match serial updates", same);
+}
+
+// Returns whether a sort is a permutation ordered far to near, allowing one quantisation step of the pool's depth range
+static inline bool Ordered(const ParticleSimulation::Pool &p, const ParticleSimulation::DepthSorter &sorter, const glm::vec3 &eye, const glm::vec3 &front)
+{
+	const uint32_t* order = sorter.GetOrder();
+	float step = glm::length(p.upper - p.lower) / (1 << (PARTICLE_SORT_DEPTH - 2));
+	std::vector<bool> seen(p.count, false);
+	for (uint32_t i = 0; i < p.count; i++)
+	{
+		if (order[i] >= p.count || seen[order[i]])
+			return false;
+		seen[order[i]] = true;
+		if (i && glm::dot(glm::vec3(p.x[order[i - 1]], p.y[order[i - 1]], p.z[order[i - 1]]) - eye, front) <
+			glm::dot(glm::vec3(p.x[order[i]], p.y[order[i]], p.z[order[i]]) - eye, front) - step)
+			return false;
+	}
+	return true;
+}
+
+// Depth orders for several counts (with ties), the repaired path and the 100k timings
+static inline void CheckDepthSorter()
+{
+	ParticleSimulation::Random random(9);
+	bool ordered = true;
+	for (uint32_t count : { 0u, 1u, 3u, 7u, 1000u })
+	{
+		ParticleSimulation::Pool p;		// Every fifth particle shares a depth
+		p.Reserve(count);
+		p.count = count;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			p.x[i] = random.Range(-5.0f, 5.0f);
+			p.y[i] = random.Range(-5.0f, 5.0f);
+			p.z[i] = i % 5 ? random.Range(-5.0f, 5.0f) : 1.0f;
+		}
+		p.Bound(0, count);
+		ParticleSimulation::DepthSorter sorter;
+		sorter.Sort(p, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+		ordered = ordered && Ordered(p, sorter, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f));
+	}
+	Check("Depth orders for 0 to 1000 particles", ordered);
+
+	const uint32_t n = 100000;
+	ParticleSimulation::Pool p;
+	p.Reserve(n);
+	p.count = n;
+	for (uint32_t i = 0; i < n; i++)
+	{
+		p.x[i] = random.Range(-50.0f, 50.0f);
+		p.y[i] = random.Range(-50.0f, 50.0f);
+		p.z[i] = random.Range(-50.0f, 50.0f);
+	}
+	p.Bound(0, n);
+	glm::vec3 eye(0.0f, 0.0f, 100.0f), front = glm::normalize(glm::vec3(0.1f, 0.0f, -1.0f));
+	ParticleSimulation::DepthSorter sorter;
+	double full = 1e9;
+	for (uint32_t run = 0; run < 20; run++)
+	{
+		sorter.Invalidate();
+		auto start = std::chrono::high_resolution_clock::now();
+		sorter.Sort(p, eye, front);
+		full = std::min(full, Milliseconds(start));
+	}
+	Check("Depth order for 100k particles", Ordered(p, sorter, eye, front) && !sorter.WasIncremental());
+
+	double repaired = 1e9;	// Walking forward while the particles rise and drift repairs last frame's order
+	uint32_t incremental = 0;
+	ordered = true;
+	for (uint32_t frame = 0; frame < 20; frame++)
+	{
+		eye -= front * 0.05f;
+		for (uint32_t i = 0; i < n; i++)
+		{
+			p.y[i] += 0.01f;
+			p.z[i] += 0.00002f * (i % 7);
+		}
+		p.lower = glm::vec3(FLT_MAX);
+		p.upper = glm::vec3(-FLT_MAX);
+		p.Bound(0, n);
+		auto start = std::chrono::high_resolution_clock::now();
+		sorter.Sort(p, eye, front);
+		repaired = std::min(repaired, Milliseconds(start));
+		incremental += sorter.WasIncremental();
+		ordered = ordered && Ordered(p, sorter, eye, front);
+	}
+	Check("Repaired depth orders for 100k particles", ordered && incremental == 20);
+	std::printf("  100k particles: full sort %.2f ms, repaired %.2f ms (%u of 20 frames repaired)\n", full, repaired, incremental);
+}
+
+int main()
+{
+	CheckSphericalHarmonics();
+
+	ParticleSimulation::Random random(3);	// The rig
+	Skm::Data data;
+	std::vector<AnimCompression::Track> tracks;
+	BuildRig(data, tracks, random);
+	AnimCompression::Stats stats = AnimCompression::Compress(tracks, data);
+	if (!Check("Synthetic rig written", Skm::Write(data, CHECKS_SKM)))
+		return (int)_failed;
+	std::ifstream file(CHECKS_SKM, std::ios::binary);
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	std::remove(CHECKS_SKM);
+	Skm::View skm;
+	AnimRuntime::Skeleton skeleton;
+	if (!Check("Synthetic rig loaded", skm.Open(bytes.data(), bytes.size()) && skeleton.Compile(skm)))
+		return (int)_failed;
+
+	CheckCompression(data, tracks, stats, skeleton);
+	CheckBonePalette(skeleton, random);
+	CheckBudget(skeleton);
+	CheckSkinning();
+	CheckVertexAnimation(skm, skeleton);
+	CheckParticleKernels();
+	CheckThreadedEmitters();
+	CheckDepthSorter();
+
+	std::printf("%u check(s) failed\n", _failed);
+	return (int)_failed;
+}
@@ -0,0 +1,71 @@
+// Packs the game's content into the archive Vfs mounts at startup. Every file under the given directories (or the
+// given files) is stored under the path loaders ask for, which is its path relative to where the tool is run, so run
+// it from the game's root:
+//
+//		pak_build [-u] [-o Res/Content.pak] [Res/ | file ...]
+//
+// -u stores every entry uncompressed. Returns 0 on success
+#include <iostream>		// Get output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get sort
+#include <filesystem>	// Walk directories
+#include "../Vfs.h"		// Get the archive writer and the default archive path
+
+#define PAK_BUILD_DIRECTORY	"Res/"	// What is packed when nothing is named
+
+// Adds 'path' (a file, or every file under a directory) to 'files', skipping archives
+static inline void Collect(const std::filesystem::path &path, std::vector<std::pair<std::string, std::string>> &files)
+{
+	std::vector<std::filesystem::path> found;	// The files under 'path'
+	if (std::filesystem::is_directory(path))	// Directories are searched recursively
+	{
+		for (const std::filesystem::directory_entry &e : std::filesystem::recursive_directory_iterator(path))
+			if (e.is_regular_file() && e.path().extension() != ".pak")
+				found.push_back(e.path());
+	}
+	else
+		found.push_back(path);
+
+	for (const std::filesystem::path &f : found)	// For each file...
+	{
+		std::string name = f.lexically_normal().generic_string();	// The path loaders ask for
+		files.push_back(std::make_pair(name, f.string()));	// Pack it from disk
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool compress = true;	// Whether entries are compressed
+	std::string output = __CONTENT_ARCHIVE__;	// The archive to write
+	std::vector<std::pair<std::string, std::string>> files;		// Archive path -> file on disk
+	for (int i = 1; i < argc; i++)	// For each argument...
+	{
+		std::string arg = argv[i];
+		if (arg == "-u")
+			compress = false;
+		else if (arg == "-o" && i + 1 < argc)
+			output = argv[++i];
+		else
+			Collect(arg, files);
+	}
+	if (files.empty())	// If nothing was named, pack the game's content
+		Collect(PAK_BUILD_DIRECTORY, files);
+
+	std::string archive = std::filesystem::path(output).lexically_normal().generic_string();	// The archive's own path
+	files.erase(std::remove_if(files.begin(), files.end(), [&](const std::pair<std::string, std::string> &f)
+		{ return f.first == archive; }), files.end());	// Never pack the archive into itself
+	std::sort(files.begin(), files.end());	// The same content always gives the same archive
+
+	if (!Archive::Write(files, output.c_str(), compress))	// If packing failed...
+	{
+		std::cout << "Pak Build Error: Failed to write '" << output << "'!\n";	// Print out error message
+		return 1;
+	}
+
+	Archive::Reader check;	// Read it back so a broken archive never ships
+	if (!check.Open(output.c_str()))
+		return 1;
+	std::cout << "Pak Build: " << files.size() << " files packed into '" << output << "'\n";
+	return 0;
+}
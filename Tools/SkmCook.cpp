@@ -0,0 +1,65 @@
+// Cooks skinned meshes for the runtime: every source .dae under the given directories (or the given files) is
+// imported with SkmCooker and written as the .skm that SkinnedMesh::LoadAnimatedMesh maps. Sources whose .skm is
+// already newer are skipped unless -f is given. Run it from the game's root, so the default directory resolves:
+//
+//		skm_cook [-f] [Res/Content/AnimMesh/ | mesh.dae ...]
+//
+// Returns the number of meshes that failed to cook
+#include <iostream>		// Get output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <filesystem>	// Walk directories and compare times
+#include "../SkmCooker.h"	// Cook the meshes
+
+#define SKM_COOK_SOURCE		".dae"	// The source extension that is cooked
+#define SKM_COOK_DIRECTORY	"Res/Content/AnimMesh/"		// Where the game looks for skinned meshes
+
+// Returns whether 'dst' is missing or older than 'src'
+static inline bool IsStale(const std::filesystem::path &src, const std::filesystem::path &dst)
+{
+	std::error_code ec;		// Missing files count as stale
+	std::filesystem::file_time_type cooked = std::filesystem::last_write_time(dst, ec);
+	return ec || cooked < std::filesystem::last_write_time(src, ec);	// Return whether it needs cooking
+}
+
+int main(int argc, char** argv)
+{
+	bool force = false;		// Whether up to date meshes are cooked again
+	std::vector<std::filesystem::path> sources;		// The .dae files to cook
+	for (int i = 1; i < argc; i++)	// For each argument...
+	{
+		std::string arg = argv[i];
+		if (arg == "-f")
+			force = true;
+		else if (std::filesystem::is_directory(arg))	// Directories are searched recursively
+		{
+			for (const std::filesystem::directory_entry &e : std::filesystem::recursive_directory_iterator(arg))
+				if (e.is_regular_file() && e.path().extension() == SKM_COOK_SOURCE)
+					sources.push_back(e.path());
+		}
+		else
+			sources.push_back(arg);
+	}
+	if (sources.empty() && std::filesystem::is_directory(SKM_COOK_DIRECTORY))	// If nothing was named, cook the game's meshes
+		for (const std::filesystem::directory_entry &e : std::filesystem::recursive_directory_iterator(SKM_COOK_DIRECTORY))
+			if (e.is_regular_file() && e.path().extension() == SKM_COOK_SOURCE)
+				sources.push_back(e.path());
+
+	int failed = 0, cooked = 0;		// Outcome counts
+	for (const std::filesystem::path &src : sources)	// For each source...
+	{
+		std::filesystem::path dst = src;
+		dst.replace_extension(__COOKED_SKINNED_MESH_EXTENSION__);
+		if (!force && !IsStale(src, dst))	// If its .skm is up to date...
+			continue;
+		if (SkmCooker::Cook(src.generic_string(), dst.generic_string()))
+			cooked++;
+		else
+		{
+			std::cout << "Skm Cook Error: Failed to cook '" << src.generic_string() << "'!\n";	// Print out error message
+			failed++;
+		}
+	}
+	std::cout << "Skm Cook: " << cooked << " cooked, " << failed << " failed, " << sources.size() - cooked - failed << " up to date\n";
+	return failed;	// Return the failures
+}
@@ -0,0 +1,86 @@
+// Cooks sprite and flipbook images for the runtime: every source image under the given directories (or the given
+// files) is filtered, block compressed with TextureCooker and written as the .dds beside it that
+// Texture::LoadSprite loads. Sources whose .dds is already newer are skipped unless -f is given:
+//
+//		texture_cook [-f] [-bc1 | -bc3 | -bc5] [-linear] [-wrap] dir | image ...
+//
+// BC3 in sRGB is the default; -linear keeps colour formats linear, -wrap filters tiling textures across their
+// edges. Returns the number of images that failed to cook
+#include <iostream>		// Get output
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <filesystem>	// Walk directories and compare times
+#define STB_IMAGE_IMPLEMENTATION	// A standalone program, so it compiles the decoder itself
+#include <stb_image.h>
+#include "../TextureCooker.h"	// Cook the images
+
+// Returns whether 'path' is an image stb can decode
+static inline bool IsSource(const std::filesystem::path &path)
+{
+	std::string ext = path.extension().string();	// The extension
+	return ext == ".png" || ext == ".tga" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" || ext == ".psd";
+}
+
+// Returns whether 'dst' is missing or older than 'src'
+static inline bool IsStale(const std::filesystem::path &src, const std::filesystem::path &dst)
+{
+	std::error_code ec;		// Missing files count as stale
+	std::filesystem::file_time_type cooked = std::filesystem::last_write_time(dst, ec);
+	return ec || cooked < std::filesystem::last_write_time(src, ec);	// Return whether it needs cooking
+}
+
+int main(int argc, char** argv)
+{
+	bool force = false, linear = false;		// Options
+	TextureCooker::Settings settings;	// BC3 sRGB, clamped
+	std::vector<std::filesystem::path> sources;		// The images to cook
+	for (int i = 1; i < argc; i++)	// For each argument...
+	{
+		std::string arg = argv[i];
+		if (arg == "-f")
+			force = true;
+		else if (arg == "-bc1")
+			settings.format = TextureContainer::FORMAT_BC1_SRGB;
+		else if (arg == "-bc3")
+			settings.format = TextureContainer::FORMAT_BC3_SRGB;
+		else if (arg == "-bc5")
+			settings.format = TextureContainer::FORMAT_BC5;
+		else if (arg == "-linear")
+			linear = true;
+		else if (arg == "-wrap")
+			settings.wrap = true;
+		else if (std::filesystem::is_directory(arg))	// Directories are searched recursively
+		{
+			for (const std::filesystem::directory_entry &e : std::filesystem::recursive_directory_iterator(arg))
+				if (e.is_regular_file() && IsSource(e.path()))
+					sources.push_back(e.path());
+		}
+		else
+			sources.push_back(arg);
+	}
+	if (linear && settings.format == TextureContainer::FORMAT_BC1_SRGB)		// Drop sRGB from the colour formats
+		settings.format = TextureContainer::FORMAT_BC1;
+	else if (linear && settings.format == TextureContainer::FORMAT_BC3_SRGB)
+		settings.format = TextureContainer::FORMAT_BC3;
+
+	if (sources.empty())	// If nothing was named...
+	{
+		std::cout << "Usage: texture_cook [-f] [-bc1 | -bc3 | -bc5] [-linear] [-wrap] dir | image ...\n";
+		return 1;
+	}
+
+	int failed = 0, cooked = 0;		// Outcome counts
+	for (const std::filesystem::path &src : sources)	// For each source...
+	{
+		std::filesystem::path dst = src;	// Where LoadSprite looks (Texture::CookedPath)
+		dst.replace_extension(".dds");
+		if (!force && !IsStale(src, dst))	// If its .dds is up to date...
+			continue;
+		if (TextureCooker::Cook(src.generic_string(), dst.generic_string(), settings))
+			cooked++;
+		else
+			failed++;
+	}
+	std::cout << "Texture Cook: " << cooked << " cooked, " << failed << " failed, " << sources.size() - cooked - failed << " up to date\n";
+	return failed;	// Return the failures
+}
@@ -0,0 +1,101 @@
+// Bakes vertex animation textures for crowds: every cooked .skm under the given directories (or the given files) has
+// its animation skinned on the CPU with Vat::Bake, checked against direct skinning with Vat::Verify and written as
+// the .vat beside it that VatCrowd draws. Each -clip adds a span (in seconds) baked as its own clip; with none the
+// whole animation is one clip. Bakes newer than their mesh are skipped unless -f is given:
+//
+//		vat_bake [-f] [-fps 30] [-size 16384] [-clip start end ...] [Res/Content/AnimMesh/ | mesh.skm ...]
+//
+// Returns the number of meshes that failed to bake
+#include <iostream>		// Get output
+#include <fstream>	// Read the meshes
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include <cstdlib>	// Get atof / atoi
+#include <filesystem>	// Walk directories and compare times
+#include "../VertexAnimation.h"		// Bake the clips
+
+#define VAT_BAKE_DIRECTORY	"Res/Content/AnimMesh/"		// Where the game looks for skinned meshes
+#define VAT_BAKE_SAMPLES	20	// Verify samples per clip
+
+// Returns whether 'dst' is missing or older than 'src'
+static inline bool IsStale(const std::filesystem::path &src, const std::filesystem::path &dst)
+{
+	std::error_code ec;		// Missing files count as stale
+	std::filesystem::file_time_type baked = std::filesystem::last_write_time(dst, ec);
+	return ec || baked < std::filesystem::last_write_time(src, ec);	// Return whether it needs baking
+}
+
+// Bakes one mesh, returns false if it couldn't be
+static inline bool BakeMesh(const std::filesystem::path &src, const std::filesystem::path &dst, const std::vector<Vat::ClipRange> &ranges,
+	float frames_per_second, uint32_t max_size)
+{
+	std::ifstream file(src, std::ios::binary);	// The cooked mesh
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Skm::View skm;	// Its sections
+	AnimRuntime::Skeleton skeleton;		// Its animation
+	if (!skm.Open(bytes.data(), bytes.size()) || !skeleton.Compile(skm))	// If it isn't a cooked mesh...
+		return false;	// Return false as failed
+
+	Vat::Data data;		// The bake
+	if (!Vat::Bake(skm, skeleton, ranges, frames_per_second, data, max_size))
+		return false;	// Return false as failed
+	float position_error, normal_error;		// How far it is from direct skinning
+	Vat::Verify(skm, skeleton, ranges, data, VAT_BAKE_SAMPLES, position_error, normal_error);
+	std::cout << "Vat Bake: '" << dst.generic_string() << "' " << data.TextureWidth() << "x" << data.Height() << ", " << data.num_frames
+		<< " frames, max error " << position_error << " units / " << normal_error << " rad\n";
+	return Vat::Write(data, dst.generic_string().c_str());	// Write it
+}
+
+int main(int argc, char** argv)
+{
+	bool force = false;		// Whether up to date bakes are made again
+	float frames_per_second = 30.0f;	// Baked frame rate
+	uint32_t max_size = VAT_MAX_SIZE;	// Texture size limit
+	std::vector<Vat::ClipRange> ranges;		// The clips (empty bakes the whole animation)
+	std::vector<std::filesystem::path> sources;		// The .skm files to bake
+	for (int i = 1; i < argc; i++)	// For each argument...
+	{
+		std::string arg = argv[i];
+		if (arg == "-f")
+			force = true;
+		else if (arg == "-fps" && i + 1 < argc)
+			frames_per_second = (float)std::atof(argv[++i]);
+		else if (arg == "-size" && i + 1 < argc)
+			max_size = (uint32_t)std::atoi(argv[++i]);
+		else if (arg == "-clip" && i + 2 < argc)
+		{
+			float start = (float)std::atof(argv[++i]);
+			ranges.push_back(Vat::ClipRange{ start, (float)std::atof(argv[++i]) });
+		}
+		else if (std::filesystem::is_directory(arg))	// Directories are searched recursively
+		{
+			for (const std::filesystem::directory_entry &e : std::filesystem::recursive_directory_iterator(arg))
+				if (e.is_regular_file() && e.path().extension() == __COOKED_SKINNED_MESH_EXTENSION__)
+					sources.push_back(e.path());
+		}
+		else
+			sources.push_back(arg);
+	}
+	if (sources.empty() && std::filesystem::is_directory(VAT_BAKE_DIRECTORY))	// If nothing was named, bake the game's meshes
+		for (const std::filesystem::directory_entry &e : std::filesystem::recursive_directory_iterator(VAT_BAKE_DIRECTORY))
+			if (e.is_regular_file() && e.path().extension() == __COOKED_SKINNED_MESH_EXTENSION__)
+				sources.push_back(e.path());
+
+	int failed = 0, baked = 0;	// Outcome counts
+	for (const std::filesystem::path &src : sources)	// For each mesh...
+	{
+		std::filesystem::path dst = src;
+		dst.replace_extension(__VERTEX_ANIMATION_EXTENSION__);
+		if (!force && !IsStale(src, dst))	// If its .vat is up to date...
+			continue;
+		if (BakeMesh(src, dst, ranges, frames_per_second, max_size))
+			baked++;
+		else
+		{
+			std::cout << "Vat Bake Error: Failed to bake '" << src.generic_string() << "'!\n";	// Print out error message
+			failed++;
+		}
+	}
+	std::cout << "Vat Bake: " << baked << " baked, " << failed << " failed, " << sources.size() - baked - failed << " up to date\n";
+	return failed;	// Return the failures
+}
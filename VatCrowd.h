@@ -0,0 +1,184 @@
+#ifndef __VAT_CROWD_H__
+#define __VAT_CROWD_H__
+
+#include <vector>	// Get dynamic array
+#include <glew.h>	// Get GL
+#include <glm/glm.hpp>	// Get glm variables
+#include "VertexAnimation.h"	// Get baked clips
+#include "SkmFormat.h"	// Get the mesh's texcoords / indices
+
+#define VAT_TEXTURE_UNIT		8	// Where the crowd shader reads gVat
+#define VAT_INSTANCE_LOCATION	6	// vec4 placement (xyz position, w yaw in radians)
+#define VAT_CLIP_LOCATION		7	// vec2 clip (x clip index, y start time in seconds)
+
+// Draws thousands of characters from a vertex animation texture with one call. Each instance is 24 bytes (where it
+// stands, which clip and when it started), uploaded only when the crowd changes; the clock is a single uniform, so
+// the CPU does no per-character animation work at all. The mesh's indices are rebased into one buffer, so every
+// sub-mesh goes out in the same draw (with the one material bound by the caller).
+// The crowd shader (Res/Shaders/vat_crowd.v) reads, per vertex (gl_VertexID is the vertex index):
+//   uniform sampler2D gVat; uniform vec3 gVatMin, gVatExtent; uniform int gVatWidth, gVatRows, gVatFrames;
+//   uniform vec4 gVatClips[VAT_MAX_CLIPS];		// first frame, frames, frames per second, unused
+//   uniform float gTime;
+// frame f = mod((gTime - start) * fps, frames), k = first + f, texel ((k / gVatFrames) * gVatWidth + v % gVatWidth,
+// (k % gVatFrames) * gVatRows + v / gVatWidth), blending floor(f) and the next frame. Positions are gVatMin +
+// texel.xyz * gVatExtent; the normal is texel.w unpacked as two octahedral bytes, exactly as Vat::Sample does
+class VatCrowd
+{
+public:
+	// One character of the crowd
+	struct Instance
+	{
+		glm::vec4	placement;	// xyz position, w yaw in radians
+		glm::vec2	clip;	// x clip index, y start time in seconds
+	};
+
+private:
+	GLuint		_vao;	// The mesh with the instance attributes
+	GLuint		_texcoords;		// Per vertex texcoords
+	GLuint		_indices;	// Every sub-mesh's indices, rebased
+	GLuint		_instances;		// Per instance data
+	GLuint		_texture;	// The baked frames
+	uint32_t	_num_indices;	// Indices drawn per instance
+	uint32_t	_num_instances;		// Characters in the crowd
+	Vat::Data	_data;	// The bake's layout (its texels are released once uploaded)
+
+	GLint		_u_vat, _u_min, _u_extent, _u_width, _u_rows, _u_frames, _u_clips, _u_time;	// Uniforms of the crowd shader
+
+public:
+	inline VatCrowd() : _vao(0), _texcoords(0), _indices(0), _instances(0), _texture(0), _num_indices(0), _num_instances(0),
+		_u_vat(-1), _u_min(-1), _u_extent(-1), _u_width(-1), _u_rows(-1), _u_frames(-1), _u_clips(-1), _u_time(-1) {}
+	inline ~VatCrowd() { Destroy(); }
+
+	// Uploads a bake and the mesh it was baked from
+	inline bool Create(const Vat::Data &data, const Skm::View &skm)
+	{
+		Destroy();
+		if (!skm.IsValid() || data.num_vertices != skm.Count(Skm::SECTION_POSITIONS) || data.texels.empty())	// If they don't match...
+		{
+			std::cout << "Vat Error: The bake doesn't match the mesh!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+		GLint max_size = 0;		// What this GPU can hold
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+		if (data.TextureWidth() > (uint32_t)max_size || data.Height() > (uint32_t)max_size)	// If the bake is too big for it...
+		{
+			std::cout << "Vat Error: The bake is " << data.TextureWidth() << "x" << data.Height() << " texels, over this GPU's " << max_size << ", re-bake it with a smaller max_size!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		std::vector<uint32_t> indices;	// Rebase every sub-mesh's indices into one range
+		for (uint32_t e = 0; e < skm.Count(Skm::SECTION_ENTRIES); e++)
+		{
+			const Skm::Entry &entry = skm.Entries()[e];
+			for (uint32_t i = 0; i < entry.num_indices; i++)
+				indices.push_back(entry.base_vertex + skm.Indices()[entry.base_index + i]);
+		}
+		_num_indices = (uint32_t)indices.size();
+
+		glGenTextures(1, &_texture);	// The frames, fetched without filtering
+		glBindTexture(GL_TEXTURE_2D, _texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16, data.TextureWidth(), data.Height(), 0, GL_RGBA, GL_UNSIGNED_SHORT, data.texels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		glGenVertexArrays(1, &_vao);
+		glBindVertexArray(_vao);
+
+		glGenBuffers(1, &_texcoords);	// Texcoords are the only mesh attribute left
+		glBindBuffer(GL_ARRAY_BUFFER, _texcoords);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec2) * data.num_vertices, skm.TexCoords(), GL_STATIC_DRAW);
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+		glGenBuffers(1, &_instances);	// Filled by SetInstances
+		glBindBuffer(GL_ARRAY_BUFFER, _instances);
+		glEnableVertexAttribArray(VAT_INSTANCE_LOCATION);
+		glVertexAttribPointer(VAT_INSTANCE_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+		glVertexAttribDivisor(VAT_INSTANCE_LOCATION, 1);
+		glEnableVertexAttribArray(VAT_CLIP_LOCATION);
+		glVertexAttribPointer(VAT_CLIP_LOCATION, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)sizeof(glm::vec4));
+		glVertexAttribDivisor(VAT_CLIP_LOCATION, 1);
+
+		glGenBuffers(1, &_indices);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indices);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		_data = data;	// Keep the layout for the uniforms
+		_data.texels.clear();
+		_data.texels.shrink_to_fit();
+		return true;	// Return success
+	}
+
+	// Finds the crowd shader's uniforms
+	inline void Resolve(GLuint program)
+	{
+		_u_vat = glGetUniformLocation(program, "gVat");
+		_u_min = glGetUniformLocation(program, "gVatMin");
+		_u_extent = glGetUniformLocation(program, "gVatExtent");
+		_u_width = glGetUniformLocation(program, "gVatWidth");
+		_u_rows = glGetUniformLocation(program, "gVatRows");
+		_u_frames = glGetUniformLocation(program, "gVatFrames");
+		_u_clips = glGetUniformLocation(program, "gVatClips");
+		_u_time = glGetUniformLocation(program, "gTime");
+	}
+
+	// Replaces the crowd (only needed when characters are added, removed or change clip)
+	inline void SetInstances(const std::vector<Instance> &instances)
+	{
+		_num_instances = (uint32_t)instances.size();
+		glBindBuffer(GL_ARRAY_BUFFER, _instances);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * instances.size(), instances.empty() ? NULL : instances.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	// Draws every character at 'time' seconds with one call (the crowd shader must be bound)
+	inline void Render(float time) const
+	{
+		if (!_vao || !_num_instances)	// If there's nothing to draw...
+			return;		// Return as normal
+
+		glm::vec4 clips[VAT_MAX_CLIPS];		// The clip table
+		for (size_t c = 0; c < _data.clips.size(); c++)
+			clips[c] = glm::vec4((float)_data.clips[c].first_frame, (float)_data.clips[c].num_frames, _data.clips[c].frames_per_second, 0.0f);
+
+		glActiveTexture(GL_TEXTURE0 + VAT_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D, _texture);
+		glUniform1i(_u_vat, VAT_TEXTURE_UNIT);
+		glUniform3fv(_u_min, 1, &_data.bounds_min.x);
+		glUniform3fv(_u_extent, 1, &_data.bounds_extent.x);
+		glUniform1i(_u_width, (GLint)_data.width);
+		glUniform1i(_u_rows, (GLint)_data.rows_per_frame);
+		glUniform1i(_u_frames, (GLint)_data.frames_per_column);
+		glUniform4fv(_u_clips, (GLsizei)_data.clips.size(), &clips[0].x);
+		glUniform1f(_u_time, time);
+
+		glBindVertexArray(_vao);
+		glDrawElementsInstanced(GL_TRIANGLES, _num_indices, GL_UNSIGNED_INT, 0, _num_instances);
+		glBindVertexArray(0);
+	}
+
+	// Releases the GL objects
+	inline void Destroy()
+	{
+		if (_texture) glDeleteTextures(1, &_texture);
+		if (_texcoords) glDeleteBuffers(1, &_texcoords);
+		if (_indices) glDeleteBuffers(1, &_indices);
+		if (_instances) glDeleteBuffers(1, &_instances);
+		if (_vao) glDeleteVertexArrays(1, &_vao);
+		_texture = _texcoords = _indices = _instances = _vao = 0;
+		_num_indices = _num_instances = 0;
+	}
+
+	inline uint32_t NumInstances() const { return _num_instances; }		// Return the crowd size
+	inline const Vat::Data& GetLayout() const { return _data; }	// Return the bake's layout
+};
+
+#endif
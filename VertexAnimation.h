@@ -0,0 +1,314 @@
+#ifndef __VERTEX_ANIMATION_H__
+#define __VERTEX_ANIMATION_H__
+
+#include <cstdint>	// Get fixed size integers
+#include <cstring>	// Get memcpy
+#include <cmath>	// Get floor / fabs
+#include <iostream>		// Get error output
+#include <fstream>	// Get file output
+#include <vector>	// Get dynamic array
+#include <algorithm>	// Get min / max
+#include <glm/glm.hpp>	// Get glm variables
+#include "SkmFormat.h"	// Get the cooked mesh
+#include "AnimRuntime.h"	// Pose the skeleton
+#include "CpuSkinning.h"	// Skin the frames
+#include "Vfs.h"	// Read baked files
+
+#ifndef __VERTEX_ANIMATION_EXTENSION__
+#define __VERTEX_ANIMATION_EXTENSION__	((char*)".vat")
+#endif
+
+#define VAT_MAGIC		0x31544156	// "VAT1"
+#define VAT_VERSION		2	// Bump whenever the layout below changes
+#define VAT_MAX_WIDTH	2048	// Widest texture row (a frame wraps onto more rows beyond this)
+#define VAT_MAX_SIZE	16384	// Default texture size limit of a bake (what GL 4 guarantees for GL_MAX_TEXTURE_SIZE)
+#define VAT_MAX_CLIPS	16	// Clips a crowd shader can address
+
+// Vertex animation textures: a clip's skinned vertices baked offline so crowds animate with no skeleton at all.
+// Every vertex of every frame is one RGBA16 texel, 8 bytes: xyz is the position quantised to the bake's bounds and
+// w the normal, octahedral encoded in two bytes. A frame is 'rows_per_frame' rows of 'width' texels (vertex v at
+// column v % width, row v / width) and frames are stacked below each other, every clip after the previous one.
+// Once 'frames_per_column' frames fill the texture's height, the next ones wrap into another column of 'width'
+// texels beside it, so long clips stay inside the GPU's texture size limit. Clips loop, so a clip of n frames
+// samples frames k and (k + 1) % n and blends them. Sample() decodes exactly like the crowd shader, so a bake can
+// be checked against CpuSkinning without a GPU (Verify)
+namespace Vat
+{
+	// A span of the skeleton's animation to bake as one clip
+	struct ClipRange
+	{
+		float		start;	// First second
+		float		end;	// Last second (the clip loops back to start)
+	};
+
+	// A baked clip
+	struct Clip
+	{
+		uint32_t	first_frame;	// Its first frame in the texture
+		uint32_t	num_frames;		// How many it has
+		float		frames_per_second;	// How fast they play
+		float		duration;	// Its length in seconds
+	};
+
+	// The file header
+	struct Header
+	{
+		uint32_t	magic;	// VAT_MAGIC
+		uint32_t	version;	// VAT_VERSION
+		uint32_t	file_size;	// Total size in bytes, used to detect truncated files
+		uint32_t	num_vertices;	// Vertices per frame
+		uint32_t	width;	// Texels per row
+		uint32_t	rows_per_frame;		// Rows per frame
+		uint32_t	frames_per_column;	// Frames stacked before wrapping to the next column
+		uint32_t	num_frames;		// Frames of every clip together
+		uint32_t	num_clips;	// Clips that follow the header
+		float		bounds_min[3];	// Positions are min + texel / 65535 * extent
+		float		bounds_extent[3];
+	};
+
+	// A bake in memory
+	struct Data
+	{
+		uint32_t				num_vertices;	// Vertices per frame
+		uint32_t				width;	// Texels per row
+		uint32_t				rows_per_frame;		// Rows per frame
+		uint32_t				frames_per_column;	// Frames stacked before wrapping to the next column
+		uint32_t				num_frames;		// Frames of every clip together
+		glm::vec3				bounds_min;		// Corner of every baked position
+		glm::vec3				bounds_extent;	// Size of the bounds
+		std::vector<Clip>		clips;	// The clips
+		std::vector<uint16_t>	texels;		// 4 per texel, TextureWidth() x Height()
+
+		inline Data() : num_vertices(0), width(0), rows_per_frame(0), frames_per_column(0), num_frames(0), bounds_min(0.0f), bounds_extent(0.0f) {}
+		inline uint32_t Columns() const { return frames_per_column ? (num_frames + frames_per_column - 1) / frames_per_column : 0; }	// Return the frame columns
+		inline uint32_t TextureWidth() const { return width * Columns(); }	// Return the texture width
+		inline uint32_t Height() const { return rows_per_frame * frames_per_column; }	// Return the texture height
+	};
+
+	// Packs a unit normal into 8:8 octahedral coordinates
+	inline uint16_t EncodeNormal(const glm::vec3 &n)
+	{
+		float l = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+		float x = l > 0.0f ? n.x / l : 0.0f, y = l > 0.0f ? n.y / l : 0.0f;		// Onto the octahedron
+		if (n.z < 0.0f)		// Fold the lower half over the diagonals
+		{
+			float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f), fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = fx;
+			y = fy;
+		}
+		uint32_t u = (uint32_t)std::min(std::max((x * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f), 255.0f);
+		uint32_t v = (uint32_t)std::min(std::max((y * 0.5f + 0.5f) * 255.0f + 0.5f, 0.0f), 255.0f);
+		return (uint16_t)(u | (v << 8));
+	}
+
+	// Unpacks an octahedral normal (what the crowd shader does with the texel's w)
+	inline glm::vec3 DecodeNormal(uint16_t packed)
+	{
+		float x = (packed & 0xFF) / 255.0f * 2.0f - 1.0f, y = (packed >> 8) / 255.0f * 2.0f - 1.0f;
+		glm::vec3 n(x, y, 1.0f - std::fabs(x) - std::fabs(y));
+		float t = std::max(-n.z, 0.0f);		// Unfold the lower half
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+
+	// Returns the first of a vertex's four texel components for a frame
+	inline size_t TexelIndex(const Data &data, uint32_t frame, uint32_t vertex)
+	{
+		size_t column = (size_t)(frame / data.frames_per_column) * data.width + vertex % data.width;
+		size_t row = (size_t)(frame % data.frames_per_column) * data.rows_per_frame + vertex / data.width;
+		return (row * data.TextureWidth() + column) * 4;
+	}
+
+	// Samples a vertex of a clip at a time in seconds, blending the two nearest frames like the crowd shader
+	inline void Sample(const Data &data, uint32_t clip, float time, uint32_t vertex, glm::vec3 &position, glm::vec3 &normal)
+	{
+		const Clip &c = data.clips[clip];	// The clip
+		float f = time * c.frames_per_second;	// Frames in
+		f -= std::floor(f / c.num_frames) * c.num_frames;	// Looped into the clip
+		uint32_t a = std::min((uint32_t)f, c.num_frames - 1), b = (a + 1) % c.num_frames;	// The frames either side
+		float t = f - (float)a;
+		const uint16_t* ta = &data.texels[TexelIndex(data, c.first_frame + a, vertex)], *tb = &data.texels[TexelIndex(data, c.first_frame + b, vertex)];
+		glm::vec3 pa(ta[0], ta[1], ta[2]), pb(tb[0], tb[1], tb[2]);
+		position = data.bounds_min + (pa + (pb - pa) * t) * (1.0f / 65535.0f) * data.bounds_extent;
+		glm::vec3 na = DecodeNormal(ta[3]), nb = DecodeNormal(tb[3]);
+		normal = glm::normalize(na + (nb - na) * t);
+	}
+
+	// Bakes clips of a cooked mesh's animation at 'frames_per_second'. An empty 'ranges' bakes the whole animation.
+	// Neither side of the texture exceeds 'max_size' (frames wrap into columns); returns false if they can't fit
+	inline bool Bake(const Skm::View &skm, const AnimRuntime::Skeleton &skeleton, std::vector<ClipRange> ranges, float frames_per_second, Data &out,
+		uint32_t max_size = VAT_MAX_SIZE)
+	{
+		if (!skm.IsValid() || !skm.Count(Skm::SECTION_POSITIONS) || frames_per_second <= 0.0f)	// If there's nothing to bake...
+		{
+			std::cout << "Vat Error: Nothing to bake!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+		if (ranges.empty())		// Default to the whole animation
+			ranges.push_back({ 0.0f, skeleton.GetDuration() / std::max(skeleton.GetTicksPerSecond(), 1e-6f) });
+		if (ranges.size() > VAT_MAX_CLIPS)
+		{
+			std::cout << "Vat Error: At most " << VAT_MAX_CLIPS << " clips can be baked together!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		out = Data();
+		out.num_vertices = skm.Count(Skm::SECTION_POSITIONS);
+		out.width = std::min<uint32_t>(std::min<uint32_t>(out.num_vertices, VAT_MAX_WIDTH), max_size);
+		out.rows_per_frame = (out.num_vertices + out.width - 1) / out.width;
+		for (const ClipRange &r : ranges)	// Lay the clips out
+		{
+			Clip c;
+			c.first_frame = out.num_frames;
+			c.duration = std::max(r.end - r.start, 0.0f);
+			c.num_frames = std::max<uint32_t>((uint32_t)(c.duration * frames_per_second + 0.5f), 1);
+			c.frames_per_second = c.duration > 0.0f ? c.num_frames / c.duration : frames_per_second;	// Fit the frames to the loop exactly
+			out.clips.push_back(c);
+			out.num_frames += c.num_frames;
+		}
+		out.frames_per_column = std::min(out.num_frames, max_size / std::max(out.rows_per_frame, 1u));	// As many as the height allows
+		if (!out.frames_per_column || (uint64_t)out.width * out.Columns() > max_size)	// If a frame, or the columns, won't fit...
+		{
+			std::cout << "Vat Error: " << out.num_vertices << " vertices x " << out.num_frames << " frames don't fit in a " << max_size << " texture!\n";	// Print out error message
+			out = Data();
+			return false;	// Return false as failed
+		}
+
+		std::vector<glm::vec3> positions((size_t)out.num_vertices * out.num_frames), normals(positions.size());	// Every frame at full precision
+		AnimRuntime::Instance instance;		// The pose
+		for (size_t ci = 0; ci < out.clips.size(); ci++)	// For each clip...
+			for (uint32_t f = 0; f < out.clips[ci].num_frames; f++)		// For each frame...
+			{
+				skeleton.Evaluate(ranges[ci].start + f / out.clips[ci].frames_per_second, instance);
+				size_t at = (size_t)(out.clips[ci].first_frame + f) * out.num_vertices;
+				CpuSkinning::Skin(CpuSkinning::LINEAR, instance.GetPalette().data(), skeleton.NumPaletteSlots(), skm.Positions(), skm.Normals(),
+					skm.BoneData(), out.num_vertices, &positions[at], &normals[at]);
+			}
+
+		glm::vec3 hi = positions[0];	// The bounds
+		out.bounds_min = positions[0];
+		for (const glm::vec3 &p : positions)
+		{
+			out.bounds_min = glm::min(out.bounds_min, p);
+			hi = glm::max(hi, p);
+		}
+		out.bounds_extent = glm::max(hi - out.bounds_min, glm::vec3(1e-6f));
+
+		out.texels.assign((size_t)out.TextureWidth() * out.Height() * 4, 0);		// Quantise
+		for (uint32_t f = 0; f < out.num_frames; f++)
+			for (uint32_t v = 0; v < out.num_vertices; v++)
+			{
+				const glm::vec3 &p = positions[(size_t)f * out.num_vertices + v];
+				uint16_t* t = &out.texels[TexelIndex(out, f, v)];
+				for (int c = 0; c < 3; c++)
+					t[c] = (uint16_t)std::min(std::max((p[c] - out.bounds_min[c]) / out.bounds_extent[c] * 65535.0f + 0.5f, 0.0f), 65535.0f);
+				t[3] = EncodeNormal(normals[(size_t)f * out.num_vertices + v]);
+			}
+		return true;	// Return success
+	}
+
+	// Compares a bake with direct CPU skinning at 'samples' times per clip, between the baked frames as well as on
+	// them. Returns the largest position error (world units) and the largest normal error (radians)
+	inline void Verify(const Skm::View &skm, const AnimRuntime::Skeleton &skeleton, const std::vector<ClipRange> &ranges, const Data &data,
+		uint32_t samples, float &position_error, float &normal_error)
+	{
+		position_error = normal_error = 0.0f;
+		std::vector<glm::vec3> positions(data.num_vertices), normals(data.num_vertices);	// The reference
+		AnimRuntime::Instance instance;		// Its pose
+		for (size_t ci = 0; ci < data.clips.size(); ci++)	// For each clip...
+			for (uint32_t s = 0; s < samples; s++)
+			{
+				float t = data.clips[ci].duration * (s + 0.37f) / samples;	// Land between frames too
+				float start = ci < ranges.size() ? ranges[ci].start : 0.0f;
+				skeleton.Evaluate(start + t, instance);
+				CpuSkinning::Skin(CpuSkinning::LINEAR, instance.GetPalette().data(), skeleton.NumPaletteSlots(), skm.Positions(), skm.Normals(),
+					skm.BoneData(), data.num_vertices, positions.data(), normals.data());
+				for (uint32_t v = 0; v < data.num_vertices; v++)
+				{
+					glm::vec3 p, n;
+					Sample(data, (uint32_t)ci, t, v, p, n);
+					position_error = std::max(position_error, glm::length(p - positions[v]));
+					normal_error = std::max(normal_error, std::acos(std::min(std::max(glm::dot(n, normals[v]), -1.0f), 1.0f)));
+				}
+			}
+	}
+
+	// Writes a bake to 'uri'
+	inline bool Write(const Data &data, const char* uri)
+	{
+		Header header;	// The header
+		std::memset(&header, 0, sizeof(header));	// Clear padding so bakes are reproducible
+		header.magic = VAT_MAGIC;
+		header.version = VAT_VERSION;
+		header.num_vertices = data.num_vertices;
+		header.width = data.width;
+		header.rows_per_frame = data.rows_per_frame;
+		header.frames_per_column = data.frames_per_column;
+		header.num_frames = data.num_frames;
+		header.num_clips = (uint32_t)data.clips.size();
+		for (int c = 0; c < 3; c++)
+		{
+			header.bounds_min[c] = data.bounds_min[c];
+			header.bounds_extent[c] = data.bounds_extent[c];
+		}
+		header.file_size = (uint32_t)(sizeof(Header) + data.clips.size() * sizeof(Clip) + data.texels.size() * sizeof(uint16_t));
+
+		std::ofstream out(uri, std::ios::binary | std::ios::trunc);		// Create the file
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)data.clips.data(), data.clips.size() * sizeof(Clip));
+		if (!out.write((const char*)data.texels.data(), data.texels.size() * sizeof(uint16_t)))
+		{
+			std::cout << "Vat Error: Failed to write '" << uri << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+		return true;	// Return success
+	}
+
+	// Reads a bake written by Write
+	inline bool Load(const std::string &uri, Data &out)
+	{
+		VfsFile file;	// The file
+		if (!Vfs::Open(uri, file) || file.Size() < sizeof(Header))	// If it can't be read...
+		{
+			std::cout << "Vat Error: Failed to open '" << uri << "'!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		Header header;	// The header
+		std::memcpy(&header, file.Data(), sizeof(header));
+		uint32_t columns = header.frames_per_column ? (header.num_frames + header.frames_per_column - 1) / header.frames_per_column : 0;
+		size_t texels = (size_t)header.width * columns * header.rows_per_frame * header.frames_per_column * 4;	// Expected texel count
+		if (header.magic != VAT_MAGIC || header.version != VAT_VERSION || header.file_size != file.Size() || header.num_clips > VAT_MAX_CLIPS ||
+			!header.width || !header.frames_per_column || (uint64_t)header.width * header.rows_per_frame < header.num_vertices ||
+			file.Size() != sizeof(Header) + header.num_clips * sizeof(Clip) + texels * sizeof(uint16_t))
+		{
+			std::cout << "Vat Error: '" << uri << "' is not a version " << VAT_VERSION << " bake, re-bake it!\n";	// Print out error message
+			return false;	// Return false as failed
+		}
+
+		out = Data();
+		out.num_vertices = header.num_vertices;
+		out.width = header.width;
+		out.rows_per_frame = header.rows_per_frame;
+		out.frames_per_column = header.frames_per_column;
+		out.num_frames = header.num_frames;
+		out.bounds_min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+		out.bounds_extent = glm::vec3(header.bounds_extent[0], header.bounds_extent[1], header.bounds_extent[2]);
+		out.clips.resize(header.num_clips);
+		std::memcpy(out.clips.data(), file.Data() + sizeof(Header), header.num_clips * sizeof(Clip));
+		out.texels.resize(texels);
+		std::memcpy(out.texels.data(), file.Data() + sizeof(Header) + header.num_clips * sizeof(Clip), texels * sizeof(uint16_t));
+
+		for (const Clip &c : out.clips)		// Every clip must lie inside the frames
+			if (!c.num_frames || (uint64_t)c.first_frame + c.num_frames > out.num_frames || c.frames_per_second <= 0.0f)
+			{
+				std::cout << "Vat Error: '" << uri << "' has an invalid clip!\n";	// Print out error message
+				out = Data();
+				return false;	// Return false as failed
+			}
+		return true;	// Return success
+	}
+}
+
+#endif
@@ -7,6 +7,7 @@
 
 // the needed c++ internal classes
 #include <iostream> // file streaming and handling
+#include <cassert> // assert on overflowing weights
 #include <glm/glm.hpp> // maths library
 
 // animation marcros
@@ -55,5 +56,36 @@ struct VertexBoneData
 	}
 };
 
+// The cooked form of VertexBoneData: four bone ids and four unorm8 weights in 8 bytes instead of 32.
+// The weights are quantised so they always sum to exactly 255
+struct PackedBoneData
+{
+	unsigned char IDs[NUM_BONES_PER_VERTEX];	// bone indices (max 256 bones)
+	unsigned char Weights[NUM_BONES_PER_VERTEX];	// bone weights, 0-255 maps to 0.0-1.0
+
+	// Packs the four strongest influences of a vertex
+	static PackedBoneData Pack(const VertexBoneData& bones)
+	{
+		PackedBoneData out;
+		float total = 0.0f;
+		for (uint i = 0; i < NUM_BONES_PER_VERTEX; i++)
+			total += bones.Weights[i];
+
+		int sum = 0, strongest = 0;
+		for (uint i = 0; i < NUM_BONES_PER_VERTEX; i++) {
+			float w = total > 0.0f ? bones.Weights[i] / total : (i == 0 ? 1.0f : 0.0f);
+			out.IDs[i] = (unsigned char)(bones.IDs[i] < 255 ? bones.IDs[i] : 255);
+			out.Weights[i] = (unsigned char)(w * 255.0f + 0.5f);
+			sum += out.Weights[i];
+			if (out.Weights[i] > out.Weights[strongest])
+				strongest = i;
+		}
+
+		// push the rounding error onto the strongest weight so the vertex doesn't shrink
+		out.Weights[strongest] = (unsigned char)(out.Weights[strongest] + (255 - sum));
+		return out;
+	}
+};
+
 // end of class
 #endif
\ No newline at end of file
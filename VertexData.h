@@ -4,6 +4,7 @@
 #include <vector>	// Get dynamic array
 #include <map>	// Get map variable
 #include <glm\glm.hpp>	// Get glm variables
+#include "TangentSpace.h"	// Get the tangent frame generator
 
 // This struct contains vertex data
 struct VertexData
@@ -62,42 +63,13 @@ static inline void IndexVertexData(std::vector<glm::vec3> & in_vertices, std::ve
 		}
 	}
 
-	out_tangents.assign(out_indices.size(), glm::vec3(0.0f));	// Assign empty tangents ready for further calculation
+	out_tangents.assign(out_vertices.size(), glm::vec3(0.0f));	// Assign one empty tangent per vertex ready for further calculation
 }
 
-// This function will calculate tangent vectors using linear algebra
+// This function will calculate one tangent per vertex (see TangentSpace.h)
 static inline void CalculateTangents(VertexData &vd)
 {
-	for (unsigned int i = 0; i < vd.indices.size(); i += 3)	// For each triangle...
-	{
-		unsigned int i_0 = vd.indices[i];	// Get index offset of 0
-		unsigned int i_1 = vd.indices[i + 1];	// Get index offset of 1
-		unsigned int i_2 = vd.indices[i + 2];	// Get index offset of 2
-
-		glm::vec3 edge_0 = vd.positions[i_1] - vd.positions[i_0];	// Calculate first edge
-		glm::vec3 edge_1 = vd.positions[i_2] - vd.positions[i_0];	// Calculate second edge
-
-		float delta_u_0 = vd.texcoords[i_1].x - vd.texcoords[i_0].x;	// Calculate u 0 with texcoord x
-		float delta_v_0 = vd.texcoords[i_1].y - vd.texcoords[i_0].y;	// Calculate v 0 with texcoord y
-		float delta_u_1 = vd.texcoords[i_2].x - vd.texcoords[i_0].x;	// Calculate u 1 with texcoord x
-		float delta_v_1 = vd.texcoords[i_2].y - vd.texcoords[i_0].y;	// Calculate v 1 with texcoord y
-
-		float f = 1.0f / (delta_u_0 * delta_v_1 - delta_u_1 * delta_v_0);	// Calculate fraction
-
-		glm::vec3 t;	// Temp tangent variable
-
-		t.x = f * (delta_v_1 * edge_0.x - delta_v_0 * edge_1.x);	// Calculate tangent x
-		t.y = f * (delta_v_1 * edge_0.y - delta_v_0 * edge_1.y);	// Calculate tangent y
-		t.z = f * (delta_v_1 * edge_0.z - delta_v_0 * edge_1.z);	// Calculate tangent z
-
-		vd.tangents[i_0] += glm::normalize(t);	// Assign tangent for point 0 + i
-		vd.tangents[i_1] += glm::normalize(t);	// Assign tangent for point 1 + i
-		vd.tangents[i_2] += glm::normalize(t);	// Assign tangent for point 2 + i
-
-		vd.tangents[i_0] = glm::normalize(vd.tangents[i_0] - glm::dot(vd.tangents[i_0], vd.normals[i_0]) * vd.normals[i_0]); 	// Calculate tangent with normal 0
-		vd.tangents[i_1] = glm::normalize(vd.tangents[i_1] - glm::dot(vd.tangents[i_1], vd.normals[i_1]) * vd.normals[i_1]); 	// Calculate tangent with normal 1
-		vd.tangents[i_2] = glm::normalize(vd.tangents[i_2] - glm::dot(vd.tangents[i_2], vd.normals[i_2]) * vd.normals[i_2]); 	// Calculate tangent with normal 2
-	}
+	TangentSpace::Generate(vd.positions, vd.texcoords, vd.normals, vd.indices, vd.tangents);	// Generate the tangent frames
 }
 
 #endif
\ No newline at end of file
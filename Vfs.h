@@ -0,0 +1,177 @@
+#ifndef __VFS_H__
+#define __VFS_H__
+
+#include <iostream>		// Get error output
+#include <fstream>	// Get loose file fallback
+#include <sstream>	// Get string streams for text loaders
+#include <string>	// Get string
+#include <vector>	// Get dynamic array
+#include "Archive.h"	// Get packed archives
+#include "MappedFile.h"		// Map loose files
+
+#define __CONTENT_ARCHIVE__ "Res/Content.pak"	// The archive mounted at startup, loose files are used when it's missing
+
+// An opened file. Uncompressed archive entries and loose files are viewed in place (archive entries are
+// page aligned), compressed entries are decompressed into a buffer owned by the file
+class VfsFile
+{
+private:
+	MappedFile					_mapped;	// Backing for loose files
+	std::vector<unsigned char>	_buffer;	// Backing for compressed entries
+	const unsigned char*		_data;	// The contents
+	size_t						_size;	// The size in bytes
+
+	VfsFile(const VfsFile&);	// Files can't be copied
+	VfsFile& operator=(const VfsFile&);		// Files can't be copied
+
+	friend class Vfs;
+
+public:
+	inline VfsFile() : _data(NULL), _size(0) {}
+
+	// Releases the contents
+	inline void Close()
+	{
+		_mapped.Close();	// Unmap any loose file
+		std::vector<unsigned char>().swap(_buffer);		// Free any buffer
+		_data = NULL;	// Reset the view
+		_size = 0;	// Reset the size
+	}
+
+	inline bool IsOpen() const { return _data != NULL; }	// Return whether the file is open
+	inline const unsigned char* Data() const { return _data; }	// Return the first byte
+	inline size_t Size() const { return _size; }	// Return the size in bytes
+	inline std::string Text() const { return std::string((const char*)_data, _size); }	// Return the contents as text
+};
+
+// This class is the single place assets are read from. Paths are the same ones loaders always used ("Res/Models/x.obj"):
+// they're looked up in the mounted archives first (newest mount wins) and fall back to loose files on disk
+class Vfs
+{
+private:
+	static std::vector<Archive::Reader*>	_archives;	// Mounted archives, newest last
+	static bool								_prefer_loose;	// Whether loose files override the archives (hot reload while editing)
+
+	// Opens a loose file
+	static inline bool OpenLoose(const std::string &path, VfsFile &out)
+	{
+		if (out._mapped.Open(path.c_str()))		// If it could be mapped...
+		{
+			out._data = out._mapped.Data();		// View it in place
+			out._size = out._mapped.Size();		// Assign size
+			return true;	// Return success
+		}
+
+		std::ifstream in(path, std::ios::binary);	// Empty files can't be mapped, so check it exists
+		if (!in)	// If it doesn't...
+			return false;	// Return false as failed
+
+		out._buffer.assign(1, 0);	// Give empty files a valid pointer
+		out._data = &out._buffer[0];	// Assign the view
+		out._size = 0;	// It's empty
+		return true;	// Return success
+	}
+
+	// Opens an archive entry
+	static inline bool OpenPacked(const std::string &path, VfsFile &out)
+	{
+		for (size_t a = _archives.size(); a-- > 0;)		// For each archive, newest first...
+		{
+			const Archive::Entry* e = _archives[a]->Find(path);		// Look the path up
+			if (!e)		// If it isn't in this one...
+				continue;	// Try the next
+
+			out._data = _archives[a]->View(*e);		// Try to use it in place
+			out._size = (size_t)e->size;	// Assign size
+			if (out._data && out._size)		// If it's stored uncompressed...
+				return true;	// Return success
+
+			if (!_archives[a]->Read(*e, out._buffer))	// If it couldn't be decompressed...
+				return false;	// Return false as failed
+			if (out._buffer.empty())	// If it's empty...
+				out._buffer.assign(1, 0);	// Give it a valid pointer
+			out._data = &out._buffer[0];	// Assign the view
+			return true;	// Return success
+		}
+
+		return false;	// Return false by default
+	}
+
+public:
+	// Mounts an archive, returns false if it doesn't exist or is invalid
+	static inline bool Mount(const char* uri)
+	{
+		Archive::Reader* archive = new Archive::Reader();	// Create the reader
+		if (!archive->Open(uri))	// If it can't be opened...
+		{
+			delete archive;		// Free it
+			return false;	// Return false as failed
+		}
+
+		_archives.push_back(archive);	// Store it
+		return true;	// Return success
+	}
+
+	// Unmounts every archive (files opened from them must be closed first)
+	static inline void Unmount()
+	{
+		for (Archive::Reader* archive : _archives)	// For each archive...
+			delete archive;		// Free it
+		_archives.clear();	// Forget them
+	}
+
+	// Makes loose files take priority over the archives, so edited files on disk are picked up
+	static inline void PreferLooseFiles(bool prefer)
+	{
+		_prefer_loose = prefer;		// Assign
+	}
+
+	// Returns whether a path can be opened
+	static inline bool Exists(const std::string &path)
+	{
+		for (Archive::Reader* archive : _archives)	// For each archive...
+			if (archive->Find(path))	// If it's in there...
+				return true;	// Return true
+		std::ifstream in(path, std::ios::binary);	// Otherwise check the disk
+		return (bool)in;	// Return the result
+	}
+
+	// Opens a file
+	static inline bool Open(const std::string &path, VfsFile &out)
+	{
+		out.Close();	// Release any previous contents
+
+		if (_prefer_loose && OpenLoose(path, out))	// If loose files win and there is one...
+			return true;	// Return success
+		if (OpenPacked(path, out))	// If it's packed...
+			return true;	// Return success
+		return !_prefer_loose && OpenLoose(path, out);	// Fall back to the disk
+	}
+
+	// Reads a whole file as text
+	static inline bool ReadText(const std::string &path, std::string &out)
+	{
+		VfsFile file;	// The file
+		if (!Open(path, file))	// If it can't be opened...
+			return false;	// Return false as failed
+		out = file.Text();	// Copy the contents
+		return true;	// Return success
+	}
+
+	// Opens a file as a stream for line based loaders
+	static inline bool OpenText(const std::string &path, std::istringstream &out)
+	{
+		std::string text;	// The contents
+		if (!ReadText(path, text))	// If it can't be read...
+			return false;	// Return false as failed
+		out.clear();	// Reset the stream state
+		out.str(text);	// Assign the contents
+		return true;	// Return success
+	}
+};
+
+// Static definitions
+std::vector<Archive::Reader*>	Vfs::_archives;
+bool							Vfs::_prefer_loose = false;
+
+#endif